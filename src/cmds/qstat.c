@@ -2405,6 +2405,69 @@ tcl_run(int f_opt)
 #endif /* localmod 071 */
 #endif /* TCL_QSTAT */
 
+/* display state of a job status read with pbs_statjob_iter() */
+struct statjob_stream {
+	struct batch_status *prtheader; /* server status for the header, until the first job */
+	int full;
+	int how_opt;
+	int alt_opt;
+	int wide;
+	int count; /* jobs displayed */
+};
+
+/**
+ * @brief
+ *	check if the jobs can be displayed as they are read from the server,
+ *	the output does not depend on the whole list of jobs.
+ *
+ * @param[in] f_opt - full display
+ * @param[in] alt_opt - alternate display options
+ * @param[in] wide - wide display
+ *
+ * @return	int
+ * @retval	1	- jobs can be streamed
+ * @retval	0	- the whole status is needed
+ */
+static int
+can_stream_statjob(int f_opt, int alt_opt, int wide)
+{
+#ifdef NAS /* localmod 071 */
+	return 0;
+#else
+	if ((alt_opt & ~ALT_DISPLAY_w) != 0 && !(wide && f_opt))
+		return 0; /* altdsp_statjob() */
+	if (output_format == FORMAT_JSON)
+		return 0;
+#if TCL_QSTAT
+	if (f_opt && interp != NULL)
+		return 0;
+#endif
+	return 1;
+#endif /* localmod 071 */
+}
+
+/**
+ * @brief
+ *	display the status of a job as it is read, see pbs_statjob_iter()
+ *
+ * @param[in] bs - status of the job, or an Array job and its subjobs
+ * @param[in,out] arg - display state, struct statjob_stream
+ *
+ * @return	int
+ * @retval	0	- go on with the next job
+ */
+static int
+display_statjob_part(struct batch_status *bs, void *arg)
+{
+	struct statjob_stream *st = (struct statjob_stream *) arg;
+
+	if (display_statjob(bs, st->prtheader, st->full, st->how_opt, st->alt_opt, st->wide))
+		exit_qstat("out of memory");
+	st->prtheader = NULL;
+	st->count++;
+	return 0;
+}
+
 int
 main(int argc, char **argv, char **envp) /* qstat */
 {
@@ -2442,6 +2505,8 @@ main(int argc, char **argv, char **envp) /* qstat */
 	int f_opt, B_opt, Q_opt, how_opt, E_opt;
 	int p_header = TRUE;
 	int stat_single_job = 0;
+	int streamed;
+	struct statjob_stream stream;
 	int new_remote_server = 0;
 	enum { JOBS,
 	       QUEUES,
@@ -3026,11 +3091,25 @@ qstat -B [-f] [-F format] [-D delim] [ server_name... ]\n";
 					}
 				}
 
+				streamed = 0;
 				if ((stat_single_job == 1) || (new_atropl == 0)) {
-					if (E_opt == 1)
-						p_status = pbs_statjob(conn, query_job_list, display_attribs, extend);
-					else
-						p_status = pbs_statjob(conn, job_id_out, display_attribs, extend);
+					char *query_id = (E_opt == 1) ? query_job_list : job_id_out;
+
+					if (can_stream_statjob(f_opt, alt_opt, wide)) {
+						/* display each job as it comes in, don't hold them all */
+						stream.prtheader = p_server;
+						stream.full = f_opt;
+						stream.how_opt = how_opt;
+						stream.alt_opt = alt_opt;
+						stream.wide = wide;
+						stream.count = 0;
+						p_status = NULL;
+						if (pbs_statjob_iter(conn, query_id, display_attribs, extend,
+								     display_statjob_part, &stream) == PBSE_NONE &&
+						    stream.count > 0)
+							streamed = 1;
+					} else
+						p_status = pbs_statjob(conn, query_id, display_attribs, extend);
 				} else {
 					p_status = pbs_selstat(conn, new_atropl, NULL, extend);
 				}
@@ -3042,7 +3121,9 @@ qstat -B [-f] [-F format] [-D delim] [ server_name... ]\n";
 					new_atropl = p_atropl;
 					added_queue = 0;
 				}
-				if (p_status == NULL) {
+				if (streamed) {
+					p_header = FALSE;
+				} else if (p_status == NULL) {
 					if ((pbs_errno == PBSE_UNKJOBID) && !located) {
 						located = TRUE;
 						if (locate_job(job_id_out, server_out, rmt_server)) {
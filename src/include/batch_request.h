@@ -309,6 +309,7 @@ struct batch_request {
 	int prot;			   /* PROT_TCP or PROT_TPP */
 	int tpp_ack;			   /* send acks for this tpp stream? */
 	char *tppcmd_msgid;		   /* msg id for tpp commands */
+	int rq_stream;			   /* status is encoded as it is built, see status_stream() */
 	struct batch_reply rq_reply;	   /* the reply area for this request */
 	union indep_request {
 		struct rq_register_sched rq_register_sched;
@@ -365,6 +366,11 @@ extern void reply_badattr_msg(int, int, svrattrl *, struct batch_request *, int)
 extern int reply_text(struct batch_request *, int, char *);
 extern int reply_send(struct batch_request *);
 extern int reply_send_status_part(struct batch_request *);
+#ifndef PBS_MOM
+extern int init_reply_pool(void);
+extern void shutdown_reply_pool(void);
+extern int reply_pool_send(struct batch_request *, int);
+#endif /* PBS_MOM */
 extern int reply_jobid(struct batch_request *, char *, int);
 extern int reply_jobid_msg(struct batch_request *, char *, int, int);
 extern void reply_free(struct batch_reply *);
@@ -446,7 +452,9 @@ extern int encode_DIS_Register(int, struct batch_request *);
 extern int encode_DIS_TrackJob(int, struct batch_request *);
 extern int encode_DIS_reply(int, struct batch_reply *);
 extern int encode_DIS_replyTPP(int, char *, struct batch_reply *);
+extern int encode_DIS_status_part(int, int, char *, unsigned int);
 extern int encode_DIS_svrattrl(int, svrattrl *);
+extern int encode_DIS_svrattrl_entry(int, svrattrl *);
 extern int encode_DIS_Cred(int, char *, char *, int, char *, size_t, long);
 extern int dis_request_read(int, struct batch_request *);
 extern int dis_reply_read(int, struct batch_reply *, int);
@@ -71,6 +71,13 @@ extern "C" {
 #define DIS_NOCOMMIT 10 /* Protocol failure in commit */
 #define DIS_EOF 11	/* End of File */
 
+/*
+ * Peers which both understand it send integers, and so string counts, as
+ * binary varints rather than counted digit strings, see dis_set_binary()
+ */
+#define DIS_BINARY_EXTEND "DISBIN" /* Connect request extend offering it */
+#define DIS_BINARY_VERSION 1	   /* optional last IS_HELLOSVR field offering it */
+
 unsigned long disrul(int stream, int *retval);
 
 /*#if UINT_MAX == ULONG_MAX*/
@@ -212,6 +219,7 @@ typedef struct pbs_dis_buf {
 	size_t tdis_len;
 	char *tdis_pos;
 	char *tdis_data;
+	int tdis_binary; /* current packet carries binary integers */
 } pbs_dis_buf_t;
 
 typedef struct pbs_tcp_auth_data {
@@ -224,6 +232,7 @@ typedef struct pbs_tcp_chan {
 	pbs_dis_buf_t readbuf;
 	pbs_dis_buf_t writebuf;
 	int is_old_client; /* This is just for backward compatibility */
+	int dis_binary;	   /* peer reads binary integers, see dis_set_binary() */
 	pbs_tcp_auth_data_t auths[2];
 } pbs_tcp_chan_t;
 
@@ -236,6 +245,8 @@ int dis_puts(int, const char *, size_t);
 int dis_flush(int);
 void dis_setup_chan(int, pbs_tcp_chan_t *(*) (int) );
 void dis_destroy_chan(int);
+void dis_set_binary(int, int);
+int dis_is_binary(int);
 
 void transport_chan_set_ctx_status(int, int, int);
 int transport_chan_get_ctx_status(int, int);
@@ -251,9 +262,31 @@ extern int (*pfn_transport_set_chan)(int, pbs_tcp_chan_t *);
 extern int (*pfn_transport_recv)(int, void *, int);
 extern int (*pfn_transport_send)(int, void *, int);
 
+/*
+ * A thread which was handed a socket by the thread owning the connection
+ * table does its DIS I/O on that socket through its own channel and send
+ * function, so it neither looks at the connection table nor depends on
+ * which transport the owner has currently selected, see dis_set_thread_chan()
+ */
+typedef struct dis_thread_chan {
+	int fd;				 /* socket the channel is for */
+	pbs_tcp_chan_t *chan;		 /* channel to use for fd */
+	int (*send)(int, void *, int);	 /* send function to use for fd */
+	time_t timeout;			 /* timeout in seconds for sends on fd */
+	int tcp_errno;			 /* errno of the last failed send on fd */
+} dis_thread_chan_t;
+
+extern int dis_thread_chans;
+int dis_set_thread_chan(int, pbs_tcp_chan_t *, int (*)(int, void *, int), time_t);
+dis_thread_chan_t *dis_get_thread_chan(int);
+pbs_tcp_chan_t *dis_thread_get_transport_chan(int);
+int dis_thread_transport_send(int, void *, int);
+extern int DIS_tcp_set_thread_chan(int, pbs_tcp_chan_t *, time_t);
+extern int DIS_tcp_thread_errno(int);
+
 #define transport_recv(x, y, z) (*pfn_transport_recv)(x, y, z)
-#define transport_send(x, y, z) (*pfn_transport_send)(x, y, z)
-#define transport_get_chan(x) (*pfn_transport_get_chan)(x)
+#define transport_send(x, y, z) (dis_thread_chans ? dis_thread_transport_send(x, y, z) : (*pfn_transport_send)(x, y, z))
+#define transport_get_chan(x) (dis_thread_chans ? dis_thread_get_transport_chan(x) : (*pfn_transport_get_chan)(x))
 #define transport_set_chan(x, y) (*pfn_transport_set_chan)(x, y)
 
 #ifdef __cplusplus
@@ -526,6 +526,7 @@ struct job {
 	struct preempt_ordering *preempt_order;
 	int preempt_order_index;
 	struct work_task *ji_prov_startjob_task;
+	long ji_modseq; /* sv_status_seq when job last changed, see update_job_modseq() */
 
 #endif /* END SERVER ONLY */
 
@@ -606,6 +607,12 @@ struct job {
 	attribute ji_wattr[JOB_ATR_LAST]; /* decoded attributes  */
 
 	short newobj; /* newly created job? */
+#ifndef PBS_MOM
+	unsigned long ji_saveseq; /* sequence of the last write-behind save queued */
+	void *ji_savepend;	  /* that save while the DB thread has not taken it */
+	int ji_histidx;		  /* position in the history expiry heap, -1 if not in it */
+	long ji_histtime;	  /* history_timestamp the job is ordered by in that heap */
+#endif
 };
 
 typedef struct job job;
@@ -1072,6 +1079,11 @@ extern int job_save_fs(job *);
 
 extern job *job_recov_db(char *, job *pjob);
 extern int job_save_db(job *);
+extern int job_save_db_async(job *);
+extern void job_save_wait(job *);
+extern void job_save_check(void);
+extern int init_job_save_queue(void);
+extern void shutdown_job_save_queue(void);
 
 #define job_save job_save_db
 #define job_recov job_recov_db
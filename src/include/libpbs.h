@@ -196,6 +196,7 @@ struct batch_reply {
 	int brp_count;
 	int brp_type;
 	struct batch_status *last;
+	struct pbs_arena *brp_arena; /* server: holds the status entries, see reply_free() */
 	union {
 		char brp_jid[PBS_MAXSVRJOBID + 1];
 		struct brp_select *brp_select;	/* select replies */
@@ -318,6 +319,9 @@ struct batch_reply {
 #define EXTEND_OPT_IMPLICIT_COMMIT ":C:" /* option added to pbs_submit() extend parameter to request implicit commit */
 #define EXTEND_OPT_NEXT_MSG_TYPE "next_msg_type"
 #define EXTEND_OPT_NEXT_MSG_PARAM "next_msg_param"
+#define EXTEND_OPT_SCHED_JOBS 'S' /* option added to pbs_selstat() extend, select real jobs and running subjobs the way the scheduler does */
+#define EXTEND_OPT_DELTA 'D' /* option added to pbs_selstat() extend, followed by a status sequence number */
+#define EXTEND_OPT_STREAM 'I' /* option added to pbs_statjob() extend, the server sends one job per reply part (iterate) */
 
 int is_compose(int, int);
 int is_compose_cmd(int, int, char **);
@@ -341,14 +345,17 @@ int PBSD_select_put(int, int, struct attropl *, struct attrl *, const char *);
 char **PBSD_select_get(int);
 struct batch_reply *PBSD_rdrpy(int);
 struct batch_reply *PBSD_rdrpy_sock(int, int *, int prot);
+struct batch_reply *PBSD_rdrpy_iter(int, int (*)(struct batch_status *, void *), void *);
 void PBSD_FreeReply(struct batch_reply *);
 struct batch_status *PBSD_status(int, int, const char *, struct attrl *, const char *);
 struct batch_status *PBSD_status_get(int c);
+int PBSD_status_iter(int, int, const char *, struct attrl *, const char *, int (*)(struct batch_status *, void *), void *);
 char *PBSD_queuejob(int, char *, const char *, struct attropl *, const char *, int, char **, int *);
 int decode_DIS_svrattrl(int, pbs_list_head *);
 int decode_DIS_attrl(int, struct attrl **);
 int decode_DIS_JobId(int, char *);
 int decode_DIS_replyCmd(int, struct batch_reply *, int);
+int decode_DIS_replyCmd_iter(int, struct batch_reply *, int (*)(struct batch_status *, void *), void *);
 int encode_DIS_JobCred(int, int, const char *, int);
 int encode_DIS_UserCred(int, const char *, int, const char *, int);
 int encode_DIS_JobFile(int, int, const char *, int, const char *, int);
@@ -145,7 +145,11 @@ extern int will_log_event(int type);
 extern void log_suspect_file(const char *func, const char *text, const char *file, struct stat *sb);
 extern int log_open(char *name, char *directory);
 extern int log_open_main(char *name, char *directory, int silent);
+extern int log_reopen(char *name, char *directory);
 extern void log_record(int type, int objclass, int severity, const char *objname, const char *text);
+extern int log_async_start(void);
+extern void log_async_stop(void);
+extern void log_async_signal_stop(void);
 extern char log_buffer[LOG_BUF_SIZE];
 extern int log_level_2_etype(int level);
 
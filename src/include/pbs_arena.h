@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+#ifndef _PBS_ARENA_H
+#define _PBS_ARENA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/*
+ * An arena hands out memory from large chunks and gives it all back at
+ * once when it is destroyed, for data living exactly as long as one piece
+ * of work (e.g. a status reply).  Functions may be registered to run when
+ * the arena is destroyed, to release what the memory refers to.
+ * An arena is not thread safe.
+ */
+typedef struct pbs_arena pbs_arena;
+
+/* default size of the chunks of an arena */
+#define PBS_ARENA_CHUNK 65536
+
+pbs_arena *pbs_arena_create(size_t chunksz);
+void *pbs_arena_alloc(pbs_arena *arena, size_t size);
+int pbs_arena_on_destroy(pbs_arena *arena, void (*func)(void *), void *arg);
+void pbs_arena_destroy(pbs_arena *arena);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* _PBS_ARENA_H */
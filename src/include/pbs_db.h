@@ -345,6 +345,50 @@ int pbs_db_disconnect(void *conn);
  */
 int pbs_db_save_obj(void *conn, pbs_db_obj_info_t *obj, int savetype);
 
+/**
+ * @brief
+ *	Start a transaction on the connection, saves up to the matching
+ *	pbs_db_end_trx() are committed together.  A nested call joins the
+ *	transaction already open.
+ *
+ * @param[in]	conn - Connected database handle
+ *
+ * @return      int
+ * @retval      -1  - Failure
+ * @retval       0  - success
+ *
+ */
+int pbs_db_begin_trx(void *conn);
+
+/**
+ * @brief
+ *	Commit or roll back the transaction started by pbs_db_begin_trx().
+ *	Only the outermost call ends the transaction; a nested roll back
+ *	makes it roll back.
+ *
+ * @param[in]	conn - Connected database handle
+ * @param[in]	commit - 1 to commit, 0 to roll back
+ *
+ * @return      int
+ * @retval      -1  - Failure, a commit was asked for but nothing was committed
+ * @retval       0  - success
+ *
+ */
+int pbs_db_end_trx(void *conn, int commit);
+
+/**
+ * @brief
+ *	Has a statement failed in the transaction open on the connection
+ *
+ * @param[in]	conn - Connected database handle
+ *
+ * @return      int
+ * @retval       1  - a statement failed, the transaction can only be rolled back
+ * @retval       0  - no statement failed, or no transaction is open
+ *
+ */
+int pbs_db_trx_failed(void *conn);
+
 /**
  * @brief
  *	Delete an existing object from the database
@@ -166,6 +166,50 @@ extern void pbs_idx_free_ctx(void *ctx);
  */
 extern bool pbs_idx_is_empty(void *idx);
 
+/**
+ * @brief
+ *	Create a static index over a fixed set of string keys, looked up
+ *	through a minimal perfect hash.  The keys are not copied and must
+ *	outlive the index.  If a key appears more than once, its first
+ *	occurrence is indexed.
+ *
+ * @param[in] - keys  - the keys
+ * @param[in] - data  - data of each key
+ * @param[in] - nkeys - number of keys
+ * @param[in] - flags - PBS_IDX_ICASE_CMP for case-insensitive keys
+ *
+ * @return void *
+ * @retval !NULL - success
+ * @retval NULL  - failure
+ *
+ */
+extern void *pbs_phash_create(char **keys, void **data, int nkeys, int flags);
+
+/**
+ * @brief
+ *	destroy a static index
+ *
+ * @param[in] - idx - pointer to static index
+ *
+ * @return void
+ *
+ */
+extern void pbs_phash_destroy(void *idx);
+
+/**
+ * @brief
+ *	find the data of a key in a static index
+ *
+ * @param[in] - idx - pointer to static index, can be NULL
+ * @param[in] - key - key to find
+ *
+ * @return void *
+ * @retval !NULL - data of the key
+ * @retval NULL  - key is not in index
+ *
+ */
+extern void *pbs_phash_find(void *idx, const char *key);
+
 #ifdef __cplusplus
 }
 #endif
@@ -164,6 +164,7 @@ extern "C" {
 #define ATTR_max_run_soft "max_run_soft"
 #define ATTR_max_run_res_soft "max_run_res_soft"
 #define ATTR_total "total_jobs"
+#define ATTR_status_seq "status_sequence"
 #define ATTR_comment "comment"
 #define ATTR_cookie "cookie"
 #define ATTR_qrank "queue_rank"
@@ -352,6 +353,7 @@ extern "C" {
 #define ATTR_job_sort_formula_threshold "job_sort_formula_threshold"
 #define ATTR_throughput_mode "throughput_mode"
 #define ATTR_opt_backfill_fuzzy "opt_backfill_fuzzy"
+#define ATTR_sched_profile "sched_profile"
 #define ATTR_partition "partition"
 #define ATTR_sched_priv "sched_priv"
 #define ATTR_sched_log "sched_log"
@@ -670,6 +672,8 @@ DECLDIR struct batch_status *pbs_statrsc(int, char *, struct attrl *, char *);
 
 DECLDIR struct batch_status *pbs_statjob(int, char *, struct attrl *, char *);
 
+DECLDIR int pbs_statjob_iter(int, char *, struct attrl *, char *, int (*)(struct batch_status *, void *), void *);
+
 DECLDIR struct batch_status *pbs_selstat(int, struct attropl *, struct attrl *, char *);
 
 DECLDIR struct batch_status *pbs_statque(int, char *, struct attrl *, char *);
@@ -774,6 +778,8 @@ extern struct batch_status *pbs_statrsc(int, const char *, struct attrl *, const
 
 extern struct batch_status *pbs_statjob(int, const char *, struct attrl *, const char *);
 
+extern int pbs_statjob_iter(int, const char *, struct attrl *, const char *, int (*)(struct batch_status *, void *), void *);
+
 extern struct batch_status *pbs_selstat(int, struct attropl *, struct attrl *, const char *);
 
 extern struct batch_status *pbs_statque(int, const char *, struct attrl *, const char *);
@@ -109,6 +109,7 @@ struct server {
 	int sv_provtracksize;		     /* total number of sv_prov_track entries */
 	struct prov_tracking *sv_prov_track; /* array of provision records */
 	int sv_cur_prov_records;	     /* number of provisiong requests currently running */
+	long sv_status_seq;		     /* last job status sequence number handed out */
 };
 
 extern struct server server;
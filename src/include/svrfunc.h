@@ -186,6 +186,8 @@ extern char *subst_array_index(job *, char *);
 #ifndef PBS_MOM
 extern void svr_setjob_histinfo(job *, histjob_type);
 extern void svr_histjob_update(job *, char, int);
+extern void svr_histjob_index(job *);
+extern void svr_histjob_unindex(job *);
 extern char *form_attr_comment(const char *, const char *);
 extern void complete_running(job *);
 extern void am_jobs_add(job *);
@@ -390,6 +392,8 @@ struct stat_cntl {
 
 extern int status_job(job *, struct batch_request *, svrattrl *, pbs_list_head *, int *, int);
 extern int status_subjob(job *, struct batch_request *, svrattrl *, int, pbs_list_head *, int *, int);
+extern int status_job_unchanged(job *, struct batch_request *, pbs_list_head *);
+extern void update_job_modseq(job *);
 extern int stat_to_mom(job *, struct stat_cntl *);
 
 #endif /* STAT_CNTL */
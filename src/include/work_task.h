@@ -88,6 +88,10 @@ struct work_task {
 	void *wt_parm3;			     /* used to store reply for deferred cmds TPP */
 	int wt_aux;			     /* optional info: e.g. child status */
 	int wt_aux2;			     /* optional info 2: e.g. *real* child pid (windows), tpp msgid etc */
+	pbs_list_link wt_linkparm1;	     /* link to others of same wt_parm1 */
+	pbs_list_head *wt_list;		     /* work list the task was put on */
+	unsigned long wt_seq;		     /* order in which tasks were put on work lists */
+	int wt_heapidx;			     /* position in heap of timed tasks, -1 if not in it */
 };
 
 extern struct work_task *set_task(enum work_type, long event, void (*func)(), void *param);
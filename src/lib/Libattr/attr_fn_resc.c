@@ -92,7 +92,8 @@ int comp_resc_gt; /* count of resources compared > */
 int comp_resc_eq; /* count of resources compared = */
 int comp_resc_lt; /* count of resources compared < */
 int comp_resc_nc; /* count of resources not compared  */
-void *resc_attrdef_idx = NULL;
+void *resc_attrdef_idx = NULL;	 /* index of the custom resources */
+static void *resc_builtin_idx = NULL; /* perfect hash of the built-in resources */
 
 /**
  * @brief
@@ -459,6 +460,10 @@ free_resc(attribute *pattr)
  * @brief
  * 	 create the search index for resource deinitions
  *
+ *	The built-in resources are indexed by a perfect hash of their names.
+ *	resc_attrdef_idx starts out empty and indexes the custom resources
+ *	added and removed later on.
+ *
  * @param[in] rscdf - address of array of resource_def structs
  * @param[in] limit - number of members in resource_def array
  *
@@ -471,6 +476,9 @@ int
 cr_rescdef_idx(resource_def *resc_def, int limit)
 {
 	int i;
+	int n = 0;
+	char **names;
+	void **defs;
 
 	if (!resc_def)
 		return -1;
@@ -479,15 +487,26 @@ cr_rescdef_idx(resource_def *resc_def, int limit)
 	if ((resc_attrdef_idx = pbs_idx_create(PBS_IDX_ICASE_CMP, 0)) == NULL)
 		return -1;
 
-	/* add all attributes to the tree with key as the attr name */
+	names = (char **) malloc((limit + 1) * sizeof(char *));
+	defs = (void **) malloc((limit + 1) * sizeof(void *));
+	if (names == NULL || defs == NULL) {
+		free(names);
+		free(defs);
+		return -1;
+	}
 	for (i = 0; i < limit; i++) {
-		if (strcmp(resc_def->rs_name, RESC_NOOP_DEF) != 0) {
-			if (pbs_idx_insert(resc_attrdef_idx, resc_def->rs_name, resc_def) != PBS_IDX_RET_OK)
-				return -1;
+		if (strcmp(resc_def[i].rs_name, RESC_NOOP_DEF) != 0) {
+			names[n] = resc_def[i].rs_name;
+			defs[n] = &resc_def[i];
+			n++;
 		}
-		resc_def++;
 	}
-	return 0;
+	pbs_phash_destroy(resc_builtin_idx);
+	resc_builtin_idx = pbs_phash_create(names, defs, n, PBS_IDX_ICASE_CMP);
+	free(names);
+	free(defs);
+
+	return resc_builtin_idx == NULL ? -1 : 0;
 }
 
 /**
@@ -507,7 +526,8 @@ find_resc_def(resource_def *resc_def, char *name)
 {
 	resource_def *found_def = NULL, *def = NULL;
 
-	if (pbs_idx_find(resc_attrdef_idx, (void **) &name, (void **) &found_def, NULL) == PBS_IDX_RET_OK)
+	if ((found_def = (resource_def *) pbs_phash_find(resc_builtin_idx, name)) != NULL ||
+	    pbs_idx_find(resc_attrdef_idx, (void **) &name, (void **) &found_def, NULL) == PBS_IDX_RET_OK)
 		def = &resc_def[found_def - resc_def];
 
 	return def;
@@ -94,6 +94,9 @@ clear_attr(attribute *pattr, attribute_def *pdef)
  * @brief
  * 	Create the search index for the provided attribute def array
  *
+ *	The set of attributes is fixed once the tables are generated, so the
+ *	index is a perfect hash of their names rather than a tree.
+ *
  * @param[in] attr_def - ptr to attribute definitions
  * @param[in] limit - limit on size of def array
  *
@@ -106,22 +109,24 @@ void *
 cr_attrdef_idx(attribute_def *adef, int limit)
 {
 	int i;
+	char **names;
+	void **defs;
 	void *attrdef_idx = NULL;
 
 	if (!adef)
 		return NULL;
 
-	/* create the attribute index */
-	if ((attrdef_idx = pbs_idx_create(PBS_IDX_ICASE_CMP, 0)) == NULL)
-		return NULL;
-
-	/* add all attributes to the tree with key as the attr name */
-	for (i = 0; i < limit; i++) {
-		if (pbs_idx_insert(attrdef_idx, adef->at_name, adef) != PBS_IDX_RET_OK)
-			return NULL;
-
-		adef++;
+	names = (char **) malloc((limit + 1) * sizeof(char *));
+	defs = (void **) malloc((limit + 1) * sizeof(void *));
+	if (names != NULL && defs != NULL) {
+		for (i = 0; i < limit; i++) {
+			names[i] = adef[i].at_name;
+			defs[i] = &adef[i];
+		}
+		attrdef_idx = pbs_phash_create(names, defs, limit, PBS_IDX_ICASE_CMP);
 	}
+	free(names);
+	free(defs);
 	return attrdef_idx;
 }
 
@@ -145,9 +150,9 @@ int
 find_attr(void *attrdef_idx, attribute_def *attr_def, char *name)
 {
 	int index = -1;
-	attribute_def *found_def = NULL;
+	attribute_def *found_def;
 
-	if (pbs_idx_find(attrdef_idx, (void **) &name, (void **) &found_def, NULL) == PBS_IDX_RET_OK)
+	if ((found_def = (attribute_def *) pbs_phash_find(attrdef_idx, name)) != NULL)
 		index = (found_def - attr_def);
 
 	return index;
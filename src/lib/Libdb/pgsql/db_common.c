@@ -63,9 +63,9 @@
 
 #define IPV4_STR_LEN 15
 
-char *errmsg_cache = NULL;
-pg_conn_data_t *conn_data = NULL;
-pg_conn_trx_t *conn_trx = NULL;
+__thread char *errmsg_cache = NULL;
+__thread pg_conn_data_t *conn_data = NULL;
+__thread pg_conn_trx_t *conn_trx = NULL;
 static char pg_ctl[MAXPATHLEN + 1] = "";
 static char *pg_user = NULL;
 
@@ -891,6 +891,107 @@ pbs_db_save_obj(void *conn, pbs_db_obj_info_t *obj, int savetype)
 	return (db_fn_arr[obj->pbs_db_obj_type].pbs_db_save_obj(conn, obj, savetype));
 }
 
+/**
+ * @brief
+ *	Start a transaction, the following saves are committed or rolled
+ *	back together by pbs_db_end_trx()
+ *
+ * @par
+ *	A transaction started while one is open on the connection is flattened
+ *	into the open one: no BEGIN is sent and its saves are committed or
+ *	rolled back with the outer transaction.
+ *
+ * @param[in]	conn - Connected database handle
+ *
+ * @return      Error code
+ * @retval	-1  - Failure
+ * @retval	 0  - Success
+ *
+ */
+int
+pbs_db_begin_trx(void *conn)
+{
+	if (conn_trx->conn_trx_nest > 0) {
+		conn_trx->conn_trx_nest++;
+		return 0;
+	}
+	if (db_execute_str(conn, "BEGIN") == -1)
+		return -1;
+	conn_trx->conn_trx_nest = 1;
+	conn_trx->conn_trx_rollback = 0;
+	return 0;
+}
+
+/**
+ * @brief
+ *	End the transaction started by pbs_db_begin_trx()
+ *
+ * @par
+ *	Only the outermost call sends COMMIT or ROLLBACK.  A nested call which
+ *	asks for a roll back makes the outermost call roll back.  If a
+ *	statement failed in the transaction, the database rolls it back on
+ *	COMMIT; that is reported as a failure.
+ *
+ * @param[in]	conn - Connected database handle
+ * @param[in]	commit - 1 to commit, 0 to roll back
+ *
+ * @return      Error code
+ * @retval	-1  - Failure: no transaction is open, or a commit was asked
+ *		      for and nothing was committed
+ * @retval	 0  - Success (for a nested call: left to the outermost call)
+ *
+ */
+int
+pbs_db_end_trx(void *conn, int commit)
+{
+	PGresult *res;
+	int rc = 0;
+
+	if (conn_trx->conn_trx_nest <= 0)
+		return -1;
+	if (!commit)
+		conn_trx->conn_trx_rollback = 1;
+	if (--conn_trx->conn_trx_nest > 0)
+		return 0;
+
+	if (conn_trx->conn_trx_rollback) {
+		conn_trx->conn_trx_rollback = 0;
+		if (db_execute_str(conn, "ROLLBACK") == -1 || commit)
+			return -1;
+		return 0;
+	}
+
+	res = PQexec((PGconn *) conn, "COMMIT");
+	if (PQresultStatus(res) != PGRES_COMMAND_OK) {
+		char *sql_error = PQresultErrorField(res, PG_DIAG_SQLSTATE);
+		db_set_error(conn, &errmsg_cache, "Execution of string statement\n", "COMMIT", sql_error);
+		rc = -1;
+	} else if (strcmp(PQcmdStatus(res), "COMMIT") != 0) {
+		/* the transaction was aborted by an earlier failed statement */
+		rc = -1;
+	}
+	PQclear(res);
+	return rc;
+}
+
+/**
+ * @brief
+ *	Has a statement failed in the transaction open on the connection.
+ *	If so, the transaction can only be rolled back.
+ *
+ * @param[in]	conn - Connected database handle
+ *
+ * @return      int
+ * @retval	 1  - a statement failed
+ * @retval	 0  - no statement failed, or no transaction is open
+ *
+ */
+int
+pbs_db_trx_failed(void *conn)
+{
+	return (PQtransactionStatus((PGconn *) conn) == PQTRANS_INERROR);
+}
+
 /**
  * @brief
  *	Delete attributes of an object from the database
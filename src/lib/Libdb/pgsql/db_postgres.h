@@ -192,8 +192,12 @@ struct pg_conn_trx {
 };
 typedef struct pg_conn_trx pg_conn_trx_t;
 
-extern pg_conn_data_t *conn_data;
-extern pg_conn_trx_t *conn_trx;
+/*
+ * A connection is used by the thread which made it, so the statement
+ * parameters and the last error are kept per thread
+ */
+extern __thread pg_conn_data_t *conn_data;
+extern __thread pg_conn_trx_t *conn_trx;
 
 /**
  * @brief
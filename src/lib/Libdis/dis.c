@@ -39,6 +39,8 @@
 
 #include <pbs_config.h> /* the master config generated by configure */
 
+#include <pthread.h>
+#include <stdlib.h>
 #include "dis_.h"
 
 const char *dis_emsg[] = {"No error",
@@ -59,6 +61,12 @@ int (*pfn_transport_set_chan)(int, pbs_tcp_chan_t *);
 int (*pfn_transport_recv)(int, void *, int);
 int (*pfn_transport_send)(int, void *, int);
 
+/* set once some thread did its DIS I/O through its own channel */
+int dis_thread_chans = 0;
+static pthread_key_t dis_thread_chan_key;
+static pthread_once_t dis_thread_chan_once = PTHREAD_ONCE_INIT;
+static int dis_thread_chan_key_ok = 0;
+
 /* this is for our client threading functionlity to get the DIS_BUFSZ */
 long dis_buffsize = DIS_BUFSIZ;
 
@@ -79,3 +87,130 @@ dis_init_tables(void)
 		disiui_();
 	init_ulmax();
 }
+
+/**
+ * @brief
+ *	create the key of the per thread channels
+ */
+static void
+create_thread_chan_key(void)
+{
+	if (pthread_key_create(&dis_thread_chan_key, free) == 0)
+		dis_thread_chan_key_ok = 1;
+}
+
+/**
+ * @brief
+ *	make the DIS I/O of the calling thread on a socket use the given
+ *	channel and send function instead of the current transport.  This lets
+ *	a thread other than the one owning the connection table send on a
+ *	socket the owner is not using meanwhile.
+ *
+ * @param[in] fd - socket descriptor
+ * @param[in] chan - channel of fd, NULL to stop using a thread channel
+ * @param[in] send - function to send data on fd
+ * @param[in] timeout - timeout in seconds for sends on fd
+ *
+ * @return	int
+ * @retval	0 - success
+ * @retval	-1 - failure
+ *
+ * @par MT-safe: Yes
+ */
+int
+dis_set_thread_chan(int fd, pbs_tcp_chan_t *chan, int (*send)(int, void *, int), time_t timeout)
+{
+	dis_thread_chan_t *tc;
+
+	pthread_once(&dis_thread_chan_once, create_thread_chan_key);
+	if (!dis_thread_chan_key_ok)
+		return -1;
+
+	tc = (dis_thread_chan_t *) pthread_getspecific(dis_thread_chan_key);
+	if (tc == NULL) {
+		if (chan == NULL)
+			return 0;
+		tc = (dis_thread_chan_t *) calloc(1, sizeof(dis_thread_chan_t));
+		if (tc == NULL)
+			return -1;
+		if (pthread_setspecific(dis_thread_chan_key, tc) != 0) {
+			free(tc);
+			return -1;
+		}
+	}
+	tc->fd = fd;
+	tc->chan = chan;
+	tc->send = send;
+	tc->timeout = timeout;
+	tc->tcp_errno = 0;
+	if (chan != NULL)
+		dis_thread_chans = 1;
+	return 0;
+}
+
+/**
+ * @brief
+ *	get the calling thread's own channel for a socket
+ *
+ * @param[in] fd - socket descriptor
+ *
+ * @return	dis_thread_chan_t *
+ * @retval	the thread's channel if it has one set for fd
+ * @retval	NULL otherwise
+ *
+ * @par MT-safe: Yes
+ */
+dis_thread_chan_t *
+dis_get_thread_chan(int fd)
+{
+	dis_thread_chan_t *tc;
+
+	if (!dis_thread_chan_key_ok)
+		return NULL;
+	tc = (dis_thread_chan_t *) pthread_getspecific(dis_thread_chan_key);
+	if (tc == NULL || tc->chan == NULL || tc->fd != fd)
+		return NULL;
+	return tc;
+}
+
+/**
+ * @brief
+ *	transport_get_chan() once some thread has used its own channel
+ *
+ * @param[in] fd - socket descriptor
+ *
+ * @return	pbs_tcp_chan_t *
+ *
+ * @par MT-safe: Yes
+ */
+pbs_tcp_chan_t *
+dis_thread_get_transport_chan(int fd)
+{
+	dis_thread_chan_t *tc = dis_get_thread_chan(fd);
+
+	if (tc != NULL)
+		return tc->chan;
+	return (*pfn_transport_get_chan)(fd);
+}
+
+/**
+ * @brief
+ *	transport_send() once some thread has used its own channel
+ *
+ * @param[in] fd - socket descriptor
+ * @param[in] data - data to send
+ * @param[in] len - length of data
+ *
+ * @return	int
+ *
+ * @par MT-safe: Yes
+ */
+int
+dis_thread_transport_send(int fd, void *data, int len)
+{
+	dis_thread_chan_t *tc = dis_get_thread_chan(fd);
+
+	if (tc != NULL)
+		return (*tc->send)(fd, data, len);
+	return (*pfn_transport_send)(fd, data, len);
+}
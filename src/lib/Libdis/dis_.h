@@ -46,6 +46,8 @@
 /* define a limit for the number of times DIS will recurse when      */
 /* processing a sequence of character counts;  prvent stack overflow */
 #define DIS_RECURSIVE_LIMIT 30
+/* returned by the binary integer helpers when the data is in ASCII */
+#define DIS_TEXT -1
 
 char *discui_(char *cp, unsigned value, unsigned *ndigs);
 char *discul_(char *cp, unsigned long value, unsigned *ndigs);
@@ -66,6 +68,8 @@ disrsl_(int stream, int *negate, unsigned long *value,
 	unsigned long count, int recursv);
 int disrsll_(int stream, int *negate, u_Long *value, unsigned long count, int recursv);
 int diswui_(int stream, unsigned value);
+int dis_put_int(int stream, int negate, u_Long value);
+int dis_get_int(int stream, int *negate, u_Long *value);
 
 extern unsigned dis_dmx10;
 extern double *dis_dp10;
@@ -43,17 +43,29 @@
 #include <stdlib.h>
 #include "auth.h"
 #include "dis.h"
+#include "dis_.h"
 #include "pbs_error.h"
 #include "pbs_internal.h"
 
 #define PKT_MAGIC "PKTV1"
+#define PKT_MAGIC_BIN "PKTB1" /* data pkt with binary integers, same size as PKT_MAGIC */
 #define PKT_MAGIC_SZ sizeof(PKT_MAGIC)
 #define PKT_HDR_SZ (PKT_MAGIC_SZ + 1 + sizeof(int))
 
+/*
+ * A binary integer is a varint: the first byte holds a continuation bit,
+ * the sign and the low 6 bits of the magnitude, each following byte a
+ * continuation bit and the next 7 bits, least significant first
+ */
+#define DIS_INT_MORE 0x80
+#define DIS_INT_NEG 0x40
+#define DIS_INT_MAXSZ 10 /* enough bytes for the 64 bits of a u_Long */
+
 static pbs_dis_buf_t *dis_get_readbuf(int);
 static pbs_dis_buf_t *dis_get_writebuf(int);
 static int dis_resize_buf(pbs_dis_buf_t *, size_t);
 static int transport_chan_is_encrypted(int);
+static void dis_start_pkt(pbs_dis_buf_t *, int);
 
 /**
  * @brief
@@ -388,6 +400,7 @@ static int
 __recv_pkt(int fd, int *type, pbs_dis_buf_t *tp)
 {
 	int i;
+	int binary;
 	size_t datasz;
 	char pkthdr[PKT_HDR_SZ];
 
@@ -395,7 +408,11 @@ __recv_pkt(int fd, int *type, pbs_dis_buf_t *tp)
 	i = transport_recv(fd, (void *) &pkthdr, PKT_HDR_SZ);
 	if (i != PKT_HDR_SZ)
 		return (i < 0 ? i : -1);
-	if (strncmp(pkthdr, PKT_MAGIC, PKT_MAGIC_SZ) != 0) {
+	if (strncmp(pkthdr, PKT_MAGIC, PKT_MAGIC_SZ) == 0)
+		binary = 0;
+	else if (strncmp(pkthdr, PKT_MAGIC_BIN, PKT_MAGIC_SZ) == 0)
+		binary = 1;
+	else {
 		/* no pkt magic match, reject data/connection */
 		return -1;
 	}
@@ -427,6 +444,14 @@ __recv_pkt(int fd, int *type, pbs_dis_buf_t *tp)
 	}
 	tp->tdis_pos = tp->tdis_data;
 	tp->tdis_len = datasz;
+	tp->tdis_binary = binary;
+	if (binary) {
+		/* the peer reads binary integers since it sends them */
+		pbs_tcp_chan_t *chan = transport_get_chan(fd);
+
+		if (chan != NULL)
+			chan->dis_binary = 1;
+	}
 	return datasz;
 }
 
@@ -754,16 +779,16 @@ dis_gets(int fd, char *str, size_t ct)
 int
 dis_puts(int fd, const char *str, size_t ct)
 {
-	pbs_dis_buf_t *tp = dis_get_writebuf(fd);
+	pbs_tcp_chan_t *chan = transport_get_chan(fd);
+	pbs_dis_buf_t *tp;
 
-	if (tp == NULL)
+	if (chan == NULL)
 		return -1;
+	tp = &(chan->writebuf);
 	if (tp->tdis_len <= 0) {
 		if (dis_resize_buf(tp, ct + PKT_HDR_SZ) != 0)
 			return -1;
-		strcpy(tp->tdis_data, PKT_MAGIC);
-		tp->tdis_pos = tp->tdis_data + PKT_HDR_SZ;
-		tp->tdis_len = PKT_HDR_SZ;
+		dis_start_pkt(tp, chan->dis_binary);
 	} else {
 		if (dis_resize_buf(tp, ct) != 0)
 			return -1;
@@ -774,6 +799,195 @@ dis_puts(int fd, const char *str, size_t ct)
 	return ct;
 }
 
+/**
+ * @brief
+ * 	dis_start_pkt - start a new data pkt in given (empty) dis write buffer
+ *
+ * @param[in] tp - dis buffer
+ * @param[in] binary - whether integers in the pkt are binary
+ *
+ * @return void
+ *
+ * @par MT-safe: Yes
+ *
+ */
+static void
+dis_start_pkt(pbs_dis_buf_t *tp, int binary)
+{
+	strcpy(tp->tdis_data, binary ? PKT_MAGIC_BIN : PKT_MAGIC);
+	tp->tdis_binary = binary;
+	tp->tdis_pos = tp->tdis_data + PKT_HDR_SZ;
+	tp->tdis_len = PKT_HDR_SZ;
+}
+
+/**
+ * @brief
+ * 	dis_put_int - dis support routine to put an integer into the write
+ *	buffer as a binary varint, if the pkt being built is a binary one
+ *
+ *	A pkt is binary if the peer has been found to read binary integers,
+ *	see dis_set_binary(), when the first datum is put into it.
+ *
+ * @param[in] fd - file descriptor
+ * @param[in] negate - whether the value is negative
+ * @param[in] value - magnitude of the value
+ *
+ * @return	int
+ *
+ * @retval	DIS_SUCCESS	value placed
+ * @retval	DIS_TEXT	pkt is ASCII, caller has to put the value
+ * @retval	DIS_PROTO	if error
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+int
+dis_put_int(int fd, int negate, u_Long value)
+{
+	pbs_tcp_chan_t *chan = transport_get_chan(fd);
+	pbs_dis_buf_t *tp;
+	unsigned char *cp;
+
+	if (chan == NULL)
+		return DIS_PROTO;
+	tp = &(chan->writebuf);
+	if (tp->tdis_len > 0 ? !tp->tdis_binary : !chan->dis_binary)
+		return DIS_TEXT;
+	if (dis_resize_buf(tp, DIS_INT_MAXSZ + PKT_HDR_SZ) != 0)
+		return DIS_PROTO;
+	if (tp->tdis_len <= 0)
+		dis_start_pkt(tp, 1);
+
+	cp = (unsigned char *) tp->tdis_pos;
+	*cp = (value & 0x3f) | (negate ? DIS_INT_NEG : 0);
+	value >>= 6;
+	while (value != 0) {
+		*cp++ |= DIS_INT_MORE;
+		*cp = value & 0x7f;
+		value >>= 7;
+	}
+	cp++;
+	tp->tdis_len += (char *) cp - tp->tdis_pos;
+	tp->tdis_pos = (char *) cp;
+	return DIS_SUCCESS;
+}
+
+/**
+ * @brief
+ * 	dis_get_int - dis support routine to get a binary varint integer from
+ *	the read buffer, if the pkt being read is a binary one
+ *
+ * @param[in] fd - file descriptor
+ * @param[out] negate - whether the value is negative
+ * @param[out] value - magnitude of the value
+ *
+ * @return	int
+ *
+ * @retval	DIS_SUCCESS	value read
+ * @retval	DIS_TEXT	pkt is ASCII, caller has to read the value
+ * @retval	DIS_OVERFLOW	value does not fit in a u_Long
+ * @retval	DIS_EOD		premature end of message
+ * @retval	DIS_EOF		stream closed
+ * @retval	DIS_PROTO	if error
+ *
+ * @par Side Effects:
+ *	None
+ *
+ * @par MT-safe: Yes
+ *
+ */
+int
+dis_get_int(int fd, int *negate, u_Long *value)
+{
+	pbs_dis_buf_t *tp = dis_get_readbuf(fd);
+	unsigned char *cp;
+	unsigned char *end;
+	u_Long locval;
+	int shift;
+
+	if (tp == NULL)
+		return DIS_PROTO;
+	if (tp->tdis_len <= 0) {
+		/* not enought data, try to get more */
+		int unused;
+		int c;
+
+		if ((c = __recv_pkt(fd, &unused, tp)) <= 0) {
+			dis_clear_buf(tp);
+			return (c == -2 ? DIS_EOF : DIS_EOD);
+		}
+	}
+	if (!tp->tdis_binary)
+		return DIS_TEXT;
+
+	cp = (unsigned char *) tp->tdis_pos;
+	end = cp + (tp->tdis_len < DIS_INT_MAXSZ ? tp->tdis_len : DIS_INT_MAXSZ);
+	*negate = (*cp & DIS_INT_NEG) != 0;
+	locval = *cp & 0x3f;
+	shift = 6;
+	while (*cp++ & DIS_INT_MORE) {
+		if (cp == end)
+			return (tp->tdis_len < DIS_INT_MAXSZ ? DIS_EOD : DIS_PROTO);
+		if (shift > 57 && (*cp & 0x7f) >> (64 - shift) != 0)
+			return DIS_OVERFLOW;
+		locval |= (u_Long) (*cp & 0x7f) << shift;
+		shift += 7;
+	}
+	tp->tdis_len -= (char *) cp - tp->tdis_pos;
+	tp->tdis_pos = (char *) cp;
+	*value = locval;
+	return DIS_SUCCESS;
+}
+
+/**
+ * @brief
+ * 	dis_set_binary - set whether integers sent on a connection are binary
+ *
+ *	Called once the peer is known to read them, i.e. it offered them
+ *	during connection setup.  A peer which receives a binary pkt switches
+ *	to sending binary integers itself.
+ *
+ * @param[in] fd - file descriptor
+ * @param[in] on - whether to send binary integers
+ *
+ * @return void
+ *
+ * @par MT-safe: Yes
+ *
+ */
+void
+dis_set_binary(int fd, int on)
+{
+	pbs_tcp_chan_t *chan = transport_get_chan(fd);
+
+	if (chan != NULL)
+		chan->dis_binary = on;
+}
+
+/**
+ * @brief
+ * 	dis_is_binary - are integers sent on a connection binary?
+ *
+ * @param[in] fd - file descriptor
+ *
+ * @return int
+ * @retval 1 - binary
+ * @retval 0 - ASCII
+ *
+ * @par MT-safe: Yes
+ *
+ */
+int
+dis_is_binary(int fd)
+{
+	pbs_tcp_chan_t *chan = transport_get_chan(fd);
+
+	return (chan != NULL && chan->dis_binary);
+}
+
 /**
  * @brief
  *	flush dis write buffer
@@ -73,6 +73,22 @@ disrsi_(int stream, int *negate, unsigned *value, unsigned count, int recursv)
 	assert(count);
 	assert(stream >= 0);
 
+	if (recursv == 0) {
+		/* a binary integer comes without counts, see dis_get_int() */
+		u_Long binval;
+
+		if ((c = dis_get_int(stream, negate, &binval)) != DIS_TEXT) {
+			if (c == DIS_SUCCESS && binval <= UINT_MAX) {
+				*value = binval;
+				return (DIS_SUCCESS);
+			}
+			if (c == DIS_SUCCESS || c == DIS_OVERFLOW) {
+				*value = UINT_MAX;
+				return (DIS_OVERFLOW);
+			}
+			return (c);
+		}
+	}
 	if (++recursv > DIS_RECURSIVE_LIMIT)
 		return (DIS_PROTO);
 	/* dis_umaxd would be initialized by prior call to dis_init_tables */
@@ -75,6 +75,22 @@ disrsl_(int stream, int *negate, unsigned long *value, unsigned long count, int
 	assert(count);
 	assert(stream >= 0);
 
+	if (recursv == 0) {
+		/* a binary integer comes without counts, see dis_get_int() */
+		u_Long binval;
+
+		if ((c = dis_get_int(stream, negate, &binval)) != DIS_TEXT) {
+			if (c == DIS_SUCCESS && binval <= ULONG_MAX) {
+				*value = binval;
+				return (DIS_SUCCESS);
+			}
+			if (c == DIS_SUCCESS || c == DIS_OVERFLOW) {
+				*value = ULONG_MAX;
+				return (DIS_OVERFLOW);
+			}
+			return (c);
+		}
+	}
 	if (++recursv > DIS_RECURSIVE_LIMIT)
 		return (DIS_PROTO);
 
@@ -91,6 +91,14 @@ disrsll_(int stream, int *negate, u_Long *value, unsigned long count, int recurs
 	assert(count);
 	assert(stream >= 0);
 
+	if (recursv == 0) {
+		/* a binary integer comes without counts, see dis_get_int() */
+		if ((c = dis_get_int(stream, negate, value)) != DIS_TEXT) {
+			if (c == DIS_OVERFLOW)
+				*value = UlONG_MAX;
+			return (c);
+		}
+	}
 	if (++recursv > DIS_RECURSIVE_LIMIT)
 		return (DIS_PROTO);
 
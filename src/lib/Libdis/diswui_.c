@@ -66,9 +66,12 @@ diswui_(int stream, unsigned value)
 {
 	unsigned ndigs;
 	char *cp;
+	int rc;
 
 	assert(stream >= 0);
 
+	if ((rc = dis_put_int(stream, FALSE, value)) != DIS_TEXT)
+		return rc;
 	cp = discui_(&dis_buffer[DIS_BUFSIZ], value, &ndigs);
 	*--cp = '+';
 	while (ndigs > 1)
@@ -96,6 +96,8 @@ diswull(int stream, u_Long value)
 
 	assert(stream >= 0);
 
+	if ((retval = dis_put_int(stream, FALSE, value)) != DIS_TEXT)
+		return retval;
 	cp = discull_(&dis_buffer[DIS_BUFSIZ], value, &ndigs);
 	*--cp = '+';
 	while (ndigs > 1)
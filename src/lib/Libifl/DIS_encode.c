@@ -1087,7 +1087,6 @@ int
 encode_DIS_svrattrl(int sock, svrattrl *psattl)
 {
 	unsigned int ct = 0;
-	unsigned int name_len;
 	svrattrl *ps;
 	int rc;
 
@@ -1101,28 +1100,54 @@ encode_DIS_svrattrl(int sock, svrattrl *psattl)
 		return rc;
 
 	for (ps = psattl; ps; ps = (svrattrl *) GET_NEXT(ps->al_link)) {
-		/* length of three strings */
-		name_len = (int) strlen(ps->al_atopl.name) +
-			   (int) strlen(ps->al_atopl.value) + 2;
-		if (ps->al_atopl.resource)
-			name_len += strlen(ps->al_atopl.resource) + 1;
-
-		if ((rc = diswui(sock, name_len)) != 0)
-			break;
-		if ((rc = diswst(sock, ps->al_atopl.name)) != 0)
-			break;
-		if (ps->al_rescln) { /* has a resource name */
-			if ((rc = diswui(sock, 1)) != 0)
-				break;
-			if ((rc = diswst(sock, ps->al_atopl.resource)) != 0)
-				break;
-		} else {
-			if ((rc = diswui(sock, 0)) != 0) /* no resource name */
-				break;
-		}
-		if ((rc = diswst(sock, ps->al_atopl.value)) ||
-		    (rc = diswui(sock, (unsigned int) ps->al_op)))
+		if ((rc = encode_DIS_svrattrl_entry(sock, ps)) != 0)
 			break;
 	}
 	return rc;
 }
+
+/**
+ * @brief
+ *	-encode a single "svrattrl" entry as described for encode_DIS_svrattrl(),
+ *	without the count.  Used by the server to stream a status reply, see
+ *	encode_DIS_status_part().
+ *
+ * @param[in] sock - socket descriptor
+ * @param[in] ps - svrattrl entry to encode
+ *
+ * @return      int
+ * @retval      DIS_SUCCESS(0)  success
+ * @retval      error code      error
+ *
+ */
+
+int
+encode_DIS_svrattrl_entry(int sock, svrattrl *ps)
+{
+	unsigned int name_len;
+	int rc;
+
+	/* length of three strings */
+	name_len = (int) strlen(ps->al_atopl.name) +
+		   (int) strlen(ps->al_atopl.value) + 2;
+	if (ps->al_atopl.resource)
+		name_len += strlen(ps->al_atopl.resource) + 1;
+
+	if ((rc = diswui(sock, name_len)) != 0)
+		return rc;
+	if ((rc = diswst(sock, ps->al_atopl.name)) != 0)
+		return rc;
+	if (ps->al_rescln) { /* has a resource name */
+		if ((rc = diswui(sock, 1)) != 0)
+			return rc;
+		if ((rc = diswst(sock, ps->al_atopl.resource)) != 0)
+			return rc;
+	} else {
+		if ((rc = diswui(sock, 0)) != 0) /* no resource name */
+			return rc;
+	}
+	if ((rc = diswst(sock, ps->al_atopl.value)) ||
+	    (rc = diswui(sock, (unsigned int) ps->al_op)))
+		return rc;
+	return 0;
+}
@@ -418,7 +418,8 @@ again:
 					pstcx = &pstcmd->next;
 				}
 			}
-			if (pstcmd_ja != NULL) {
+			/* subjobs may follow their parent in later parts, see status_stream() */
+			if (pstcmd_ja != NULL && !reply->brp_is_part) {
 				pstcmd_ja->next = bs_isort(pstcmd_ja->next, cmp_sj_name);
 				for (pstcmd_last = pstcmd_ja; pstcmd_last->next; pstcmd_last = pstcmd_last->next)
 					;
@@ -541,3 +542,159 @@ again:
 
 	return rc;
 }
+
+/**
+ * @brief	Hand a status object to the callback of decode_DIS_replyCmd_iter()
+ *		and free it.
+ *
+ * @param[in]  bs - status object, or array parent followed by its subjobs
+ * @param[in]  stop - non-zero if the callback asked to stop already
+ * @param[in]  func - callback
+ * @param[in]  arg - argument for the callback
+ *
+ * @return int
+ * @retval !0 - the callback asked to stop
+ * @retval  0 - go on
+ */
+static int
+status_iter_call(struct batch_status *bs, int stop, int (*func)(struct batch_status *, void *), void *arg)
+{
+	if (bs->next != NULL)
+		bs->next = bs_isort(bs->next, cmp_sj_name);
+	if (!stop)
+		stop = func(bs, arg);
+	pbs_statfree(bs);
+	return stop;
+}
+
+/**
+ * @brief-
+ *	decode a status reply for a command one object at a time
+ *
+ * @par	Functionality:
+ *		Same as decode_DIS_replyCmd() for a status reply, except that the
+ *		objects are not collected in the reply.  Each one is passed to func
+ *		as a batch_status list of its own as soon as it is decoded, an
+ *		Array parent along with its subjobs, and freed on return.  Once func
+ *		returns non-zero, the rest of the reply is read and dropped.
+ *		A reply which is not a status, an error, is decoded into reply.
+ *
+ * @param[in] sock - socket descriptor
+ * @param[in] reply - pointer to batch_reply structure
+ * @param[in] func - called with each status object
+ * @param[in] arg - argument for func
+ *
+ * @return	int
+ * @retval	-1	error
+ * @retval	0	Success
+ *
+ */
+int
+decode_DIS_replyCmd_iter(int sock, struct batch_reply *reply, int (*func)(struct batch_status *, void *), void *arg)
+{
+	int ct;
+	int i;
+	struct batch_status *pstcmd;
+	struct batch_status *pstcmd_ja = NULL;
+	int stop = 0;
+	int rc = 0;
+	size_t txtlen;
+
+	/* first decode "header" consisting of protocol type and version */
+again:
+	i = disrui(sock, &rc);
+	if (rc != 0)
+		goto err;
+	if (i != PBS_BATCH_PROT_TYPE) {
+		rc = DIS_PROTO;
+		goto err;
+	}
+	i = disrui(sock, &rc);
+	if (rc != 0)
+		goto err;
+	if (i != PBS_BATCH_PROT_VER) {
+		rc = DIS_PROTO;
+		goto err;
+	}
+
+	/* next decode code, auxcode and choice (union type identifier) */
+
+	reply->brp_code = disrsi(sock, &rc);
+	if (rc)
+		goto err;
+	reply->brp_auxcode = disrsi(sock, &rc);
+	if (rc)
+		goto err;
+	reply->brp_choice = disrui(sock, &rc);
+	if (rc)
+		goto err;
+	reply->brp_is_part = disrui(sock, &rc);
+	if (rc)
+		goto err;
+
+	switch (reply->brp_choice) {
+
+		case BATCH_REPLY_CHOICE_NULL:
+			break; /* no more to do */
+
+		case BATCH_REPLY_CHOICE_Text:
+
+			/* text reply */
+
+			reply->brp_un.brp_txt.brp_str = disrcs(sock, &txtlen, &rc);
+			reply->brp_un.brp_txt.brp_txtlen = txtlen;
+			break;
+
+		case BATCH_REPLY_CHOICE_Status:
+
+			reply->brp_un.brp_statc = NULL;
+			ct = disrui(sock, &rc);
+			if (rc)
+				goto err;
+			reply->brp_count += ct;
+
+			while (ct--) {
+				rc = DIS_PROTO;
+				pstcmd = read_batch_status(sock, &reply->brp_type, &rc);
+				if (rc != DIS_SUCCESS || pstcmd == NULL) {
+					if (rc == DIS_SUCCESS)
+						rc = DIS_PROTO;
+					goto err;
+				}
+				if (reply->brp_type == MGR_OBJ_SUBJOB && pstcmd_ja != NULL) {
+					/* subjobs follow their parent, possibly in later parts */
+					pstcmd->next = pstcmd_ja->next;
+					pstcmd_ja->next = pstcmd;
+					continue;
+				}
+				if (pstcmd_ja != NULL) {
+					stop = status_iter_call(pstcmd_ja, stop, func, arg);
+					pstcmd_ja = NULL;
+				}
+				if (reply->brp_type == MGR_OBJ_JOBARRAY_PARENT) {
+					if (expand_remaining_subjob(pstcmd, &reply->brp_count) != 0) {
+						pbs_statfree(pstcmd);
+						rc = DIS_NOMALLOC;
+						goto err;
+					}
+					pstcmd_ja = pstcmd;
+				} else
+					stop = status_iter_call(pstcmd, stop, func, arg);
+			}
+			if (reply->brp_is_part)
+				goto again;
+			break;
+
+		default:
+			rc = DIS_PROTO;
+			goto err;
+	}
+
+	if (pstcmd_ja != NULL)
+		(void) status_iter_call(pstcmd_ja, stop, func, arg);
+	return rc;
+
+err:
+	pbs_statfree(pstcmd_ja);
+	return rc;
+}
@@ -244,6 +244,47 @@ encode_DIS_reply(int sock, struct batch_reply *reply)
 	return (encode_DIS_reply_inner(sock, reply));
 }
 
+/**
+ * @brief
+ *	encode the start of a partial status reply holding a single object,
+ *	up to and including the count of its attributes.  The caller follows
+ *	with that many entries, see encode_DIS_svrattrl_entry().
+ *
+ * @par
+ *	Lets the server stream a status reply one object at a time, straight
+ *	from the cached attribute encodings.  The client decodes it as any
+ *	reply sent in parts, see decode_DIS_replyCmd().
+ *
+ * @param[in] sock - socket descriptor
+ * @param[in] objtype - type of the object, MGR_OBJ_*
+ * @param[in] objname - name of the object
+ * @param[in] nattr - number of attribute entries that follow
+ *
+ * @return      int
+ * @retval      0       Success
+ * @retval      !0      error
+ */
+int
+encode_DIS_status_part(int sock, int objtype, char *objname, unsigned int nattr)
+{
+	int rc;
+
+	if ((rc = diswui(sock, PBS_BATCH_PROT_TYPE)) ||
+	    (rc = diswui(sock, PBS_BATCH_PROT_VER)) ||
+	    (rc = diswsi(sock, 0)) ||
+	    (rc = diswsi(sock, 0)) ||
+	    (rc = diswui(sock, BATCH_REPLY_CHOICE_Status)) ||
+	    (rc = diswui(sock, 1)) ||
+	    (rc = diswui(sock, 1)))
+		return rc;
+
+	if ((rc = diswui(sock, objtype)) ||
+	    (rc = diswst(sock, objname)) ||
+	    (rc = diswui(sock, nattr)))
+		return rc;
+	return 0;
+}
+
 int
 encode_DIS_replyTPP(int sock, char *tppcmd_msgid, struct batch_reply *reply)
 {
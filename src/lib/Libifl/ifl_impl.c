@@ -625,6 +625,28 @@ pbs_statjob(int c, const char *id, struct attrl *attrib, const char *extend)
 	return (*pfn_pbs_statjob)(c, id, attrib, extend);
 }
 
+/**
+ * @brief
+ *	-Pass-through call to get the status of jobs one at a time.
+ *
+ * @param[in] c - communication handle
+ * @param[in] id - job id
+ * @param[in] attrib - pointer to attribute list
+ * @param[in] extend - extend string for req
+ * @param[in] func - called with the status of each job
+ * @param[in] arg - argument for func
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	pbs_error(!0)	error
+ *
+ */
+int
+pbs_statjob_iter(int c, const char *id, struct attrl *attrib, const char *extend, int (*func)(struct batch_status *, void *), void *arg)
+{
+	return (*pfn_pbs_statjob_iter)(c, id, attrib, extend, func, arg);
+}
+
 /**
  * @brief
  *	-Pass-through call to SelectJob request
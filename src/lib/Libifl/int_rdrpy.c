@@ -60,19 +60,22 @@
 #include "tpp.h"
 
 /**
- * @brief read a batch reply from the given socket
+ * @brief read a batch reply from the given socket, status objects are
+ *	passed to func if it is set, see decode_DIS_replyCmd_iter()
  *
  * @param[in] sock - The socket fd to read from
  * @param[out] rc  - Return DIS error code
  * @param[in] prot - protocol type
+ * @param[in] func - status callback, or NULL
+ * @param[in] arg - argument for func
  *
  * @return Batch reply structure
  * @retval  !NULL - Success
  * @retval   NULL - Failure
  *
  */
-struct batch_reply *
-PBSD_rdrpy_sock(int sock, int *rc, int prot)
+static struct batch_reply *
+rdrpy_sock(int sock, int *rc, int prot, int (*func)(struct batch_status *, void *), void *arg)
 {
 	struct batch_reply *reply;
 	time_t old_timeout;
@@ -92,8 +95,15 @@ PBSD_rdrpy_sock(int sock, int *rc, int prot)
 	} else
 		DIS_tpp_funcs();
 
-	if ((*rc = decode_DIS_replyCmd(sock, reply, prot)) != 0) {
-		(void) free(reply);
+	if (func != NULL)
+		*rc = decode_DIS_replyCmd_iter(sock, reply, func, arg);
+	else
+		*rc = decode_DIS_replyCmd(sock, reply, prot);
+	if (*rc != 0) {
+		if (func != NULL)
+			PBSD_FreeReply(reply);
+		else
+			(void) free(reply);
 		pbs_errno = PBSE_PROTOCOL;
 		return NULL;
 	}
@@ -107,16 +117,37 @@ PBSD_rdrpy_sock(int sock, int *rc, int prot)
 }
 
 /**
- * @brief read a batch reply from the given connection index
+ * @brief read a batch reply from the given socket
  *
- * @param[in] c - The connection index to read from
+ * @param[in] sock - The socket fd to read from
+ * @param[out] rc  - Return DIS error code
+ * @param[in] prot - protocol type
+ *
+ * @return Batch reply structure
+ * @retval  !NULL - Success
+ * @retval   NULL - Failure
  *
- * @return DIS error code
- * @retval   DIS_SUCCESS  - Success
- * @retval  !DIS_SUCCESS  - Failure
  */
 struct batch_reply *
-PBSD_rdrpy(int c)
+PBSD_rdrpy_sock(int sock, int *rc, int prot)
+{
+	return rdrpy_sock(sock, rc, prot, NULL, NULL);
+}
+
+/**
+ * @brief read a batch reply from the given connection index, status
+ *	objects are passed to func if it is set
+ *
+ * @param[in] c - The connection index to read from
+ * @param[in] func - status callback, or NULL
+ * @param[in] arg - argument for func
+ *
+ * @return Batch reply structure
+ * @retval  !NULL - Success
+ * @retval   NULL - Failure
+ */
+static struct batch_reply *
+rdrpy_conn(int c, int (*func)(struct batch_status *, void *), void *arg)
 {
 	int rc;
 	struct batch_reply *reply;
@@ -127,8 +158,8 @@ PBSD_rdrpy(int c)
 		pbs_errno = PBSE_SYSTEM;
 		return NULL;
 	}
-	/* PBSD_rdrpy() only handles TCP, hence passing PROT_TCP as prot */
-	reply = PBSD_rdrpy_sock(c, &rc, PROT_TCP);
+	/* only TCP is handled here, hence passing PROT_TCP as prot */
+	reply = rdrpy_sock(c, &rc, PROT_TCP, func, arg);
 	if (reply == NULL) {
 		if (set_conn_errno(c, PBSE_PROTOCOL) != 0) {
 			pbs_errno = PBSE_SYSTEM;
@@ -157,6 +188,39 @@ PBSD_rdrpy(int c)
 	return reply;
 }
 
+/**
+ * @brief read a batch reply from the given connection index
+ *
+ * @param[in] c - The connection index to read from
+ *
+ * @return Batch reply structure
+ * @retval  !NULL - Success
+ * @retval   NULL - Failure
+ */
+struct batch_reply *
+PBSD_rdrpy(int c)
+{
+	return rdrpy_conn(c, NULL, NULL);
+}
+
+/**
+ * @brief read a status reply from the given connection index, passing each
+ *	status object to func as it is decoded, see decode_DIS_replyCmd_iter()
+ *
+ * @param[in] c - The connection index to read from
+ * @param[in] func - called with each status object
+ * @param[in] arg - argument for func
+ *
+ * @return Batch reply structure, without the status objects
+ * @retval  !NULL - Success
+ * @retval   NULL - Failure
+ */
+struct batch_reply *
+PBSD_rdrpy_iter(int c, int (*func)(struct batch_status *, void *), void *arg)
+{
+	return rdrpy_conn(c, func, arg);
+}
+
 /*
  * PBS_FreeReply - Free a batch_reply structure allocated in PBS_rdrpy()
  *
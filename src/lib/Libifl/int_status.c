@@ -46,6 +46,7 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <ctype.h>
 #include "libpbs.h"
 #include "pbs_ecl.h"
@@ -128,3 +129,61 @@ end:
 	PBSD_FreeReply(reply);
 	return rbsp;
 }
+
+/**
+ * @brief
+ *	-send a status batch request asking the server to stream the reply,
+ *	and pass each status object to func as it is read
+ *
+ * @param[in] c - socket descriptor
+ * @param[in] function - request type
+ * @param[in] objid - object id
+ * @param[in] attrib - pointer to attribute list
+ * @param[in] extend - extention string for req encode
+ * @param[in] func - called with each status object, see
+ *		     decode_DIS_replyCmd_iter()
+ * @param[in] arg - argument for func
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	pbs_error(!0)	error
+ *
+ */
+int
+PBSD_status_iter(int c, int function, const char *objid, struct attrl *attrib, const char *extend, int (*func)(struct batch_status *, void *), void *arg)
+{
+	int rc;
+	size_t len;
+	char *ext;
+	struct batch_reply *reply;
+
+	if (objid == NULL)
+		objid = ""; /* set to null string for encoding */
+
+	/* ask for the reply to be sent one object at a time */
+	len = extend ? strlen(extend) : 0;
+	if ((ext = malloc(len + 2)) == NULL)
+		return (pbs_errno = PBSE_SYSTEM);
+	if (len)
+		memcpy(ext, extend, len);
+	ext[len] = EXTEND_OPT_STREAM;
+	ext[len + 1] = '\0';
+
+	rc = PBSD_status_put(c, function, objid, attrib, ext, PROT_TCP, NULL);
+	free(ext);
+	if (rc)
+		return rc;
+
+	reply = PBSD_rdrpy_iter(c, func, arg);
+	if (reply == NULL) {
+		if (pbs_errno == PBSE_NONE)
+			pbs_errno = PBSE_PROTOCOL;
+	} else if (reply->brp_choice != BATCH_REPLY_CHOICE_NULL &&
+		   reply->brp_choice != BATCH_REPLY_CHOICE_Text &&
+		   reply->brp_choice != BATCH_REPLY_CHOICE_Status) {
+		if (pbs_errno == PBSE_NONE)
+			pbs_errno = PBSE_PROTOCOL;
+	}
+	PBSD_FreeReply(reply);
+	return pbs_errno;
+}
@@ -192,6 +192,7 @@ tcp_connect(const char *hostname, int server_port, const char *extend_data)
 	char errbuf[LOG_BUF_SIZE] = {'\0'};
 	bool noblk = false;
 	bool connect_err = false;
+	const char *connect_extend = extend_data;
 #ifdef WIN32
 	int non_block = 1;
 #else
@@ -202,6 +203,10 @@ tcp_connect(const char *hostname, int server_port, const char *extend_data)
 	if (extend_data != NULL && strcmp(NOBLK_FLAG, extend_data) == 0)
 		noblk = true;
 
+	/* offer binary DIS, a server which understands it acks in binary */
+	if (pbs_conf.pbs_dis_binary && (extend_data == NULL || noblk))
+		connect_extend = DIS_BINARY_EXTEND;
+
 		/* get socket	*/
 #ifdef WIN32
 	/* the following lousy hack is needed since the socket call needs */
@@ -332,7 +337,7 @@ tcp_connect(const char *hostname, int server_port, const char *extend_data)
 	 * socket, so will send a "dummy" message and discard the replyback.
 	 */
 		if ((i = encode_DIS_ReqHdr(sd, PBS_BATCH_Connect, pbs_current_user)) ||
-		    (i = encode_DIS_ReqExtend(sd, extend_data))) {
+		    (i = encode_DIS_ReqExtend(sd, connect_extend))) {
 			closesocket(sd);
 			pbs_errno = PBSE_SYSTEM;
 			return -1;
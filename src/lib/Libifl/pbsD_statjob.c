@@ -87,3 +87,52 @@ __pbs_statjob(int c, const char *id, struct attrl *attrib, const char *extend)
 
 	return ret;
 }
+
+/**
+ * @brief
+ *	-Return the status of jobs one at a time, the server sends each job as
+ *	soon as it is statused and the whole reply is never held in memory.
+ *
+ * @par
+ *	func is called with the status of each job, a single batch_status, or an
+ *	Array job followed by its subjobs when "t" is in extend.  The status is
+ *	freed when func returns, func must copy what it keeps.  If func returns
+ *	non-zero, it is not called again and the rest of the reply is dropped.
+ *
+ * @param[in] c - communication handle
+ * @param[in] id - job id
+ * @param[in] attrib - pointer to attribute list
+ * @param[in] extend - extend string for req
+ * @param[in] func - called with the status of each job
+ * @param[in] arg - argument for func
+ *
+ * @return	int
+ * @retval	0	success
+ * @retval	pbs_error(!0)	error
+ *
+ */
+int
+__pbs_statjob_iter(int c, const char *id, struct attrl *attrib, const char *extend, int (*func)(struct batch_status *, void *), void *arg)
+{
+	int rc;
+
+	/* initialize the thread context data, if not already initialized */
+	if (pbs_client_thread_init_thread_context() != 0)
+		return pbs_errno;
+
+	/* first verify the attributes, if verification is enabled */
+	if ((pbs_verify_attributes(c, PBS_BATCH_StatusJob,
+				   MGR_OBJ_JOB, MGR_CMD_NONE, (struct attropl *) attrib)))
+		return pbs_errno;
+
+	if (pbs_client_thread_lock_connection(c) != 0)
+		return pbs_errno;
+
+	rc = PBSD_status_iter(c, PBS_BATCH_StatusJob, id, attrib, extend, func, arg);
+
+	/* unlock the thread lock and update the thread context data */
+	if (pbs_client_thread_unlock_connection(c) != 0)
+		return pbs_errno;
+
+	return rc;
+}
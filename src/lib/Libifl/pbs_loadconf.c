@@ -130,6 +130,8 @@ struct pbs_config pbs_conf = {
 	NULL,			    /* mom short name override */
 	0,			    /* high resolution timestamp logging */
 	0,			    /* number of scheduler threads */
+	1,			    /* binary DIS encoding offered by default */
+	0,			    /* synchronous logging */
 	NULL,			    /* default scheduler user */
 	NULL,			    /* default scheduler auth user */
 	NULL,			    /* privileged auth user */
@@ -528,6 +530,12 @@ __pbs_loadconf(int reload)
 			} else if (!strcmp(conf_name, PBS_CONF_SCHED_THREADS)) {
 				if (sscanf(conf_value, "%u", &uvalue) == 1)
 					pbs_conf.pbs_sched_threads = uvalue;
+			} else if (!strcmp(conf_name, PBS_CONF_DIS_BINARY)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_dis_binary = ((uvalue > 0) ? 1 : 0);
+			} else if (!strcmp(conf_name, PBS_CONF_LOG_ASYNC)) {
+				if (sscanf(conf_value, "%u", &uvalue) == 1)
+					pbs_conf.pbs_log_async = ((uvalue > 0) ? 1 : 0);
 			}
 #ifdef WIN32
 			else if (!strcmp(conf_name, PBS_CONF_REMOTE_VIEWER)) {
@@ -791,6 +799,14 @@ __pbs_loadconf(int reload)
 		if (sscanf(gvalue, "%u", &uvalue) == 1)
 			pbs_conf.pbs_sched_threads = uvalue;
 	}
+	if ((gvalue = getenv(PBS_CONF_DIS_BINARY)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_dis_binary = ((uvalue > 0) ? 1 : 0);
+	}
+	if ((gvalue = getenv(PBS_CONF_LOG_ASYNC)) != NULL) {
+		if (sscanf(gvalue, "%u", &uvalue) == 1)
+			pbs_conf.pbs_log_async = ((uvalue > 0) ? 1 : 0);
+	}
 
 	if ((gvalue = getenv(PBS_CONF_DAEMON_SERVICE_USER)) != NULL) {
 		free(pbs_conf.pbs_daemon_service_user);
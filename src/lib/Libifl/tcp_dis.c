@@ -204,6 +204,8 @@ tcp_send(int fd, void *data, int len)
 	int j;
 	char *pb = (char *) data;
 	struct pollfd pollfds[1];
+	dis_thread_chan_t *tc = dis_get_thread_chan(fd);
+	int *tcp_errno = (tc != NULL) ? &tc->tcp_errno : &pbs_tcp_errno;
 
 #ifdef WIN32
 	while ((i = send(fd, pb, (int) ct, 0)) != (int) ct) {
@@ -223,7 +225,7 @@ tcp_send(int fd, void *data, int len)
 			}
 			if (errno != EAGAIN) {
 				/* fatal error on write, abort output */
-				pbs_tcp_errno = errno;
+				*tcp_errno = errno;
 				return (-1);
 			}
 
@@ -232,7 +234,13 @@ tcp_send(int fd, void *data, int len)
 			/* not ready in TIMEOUT_SHORT seconds, fail   */
 			/* redo the poll if EINTR		      */
 			do {
-				if (reply_timedout) {
+				if (tc != NULL) {
+					/* a thread's own channel has its own timeout */
+					pollfds[0].fd = fd;
+					pollfds[0].events = POLLOUT;
+					pollfds[0].revents = 0;
+					j = poll(pollfds, 1, tc->timeout * 1000);
+				} else if (reply_timedout) {
 					/* caught alarm - timeout spanning several writes for one reply */
 					/* alarm set up in dis_reply_write() */
 					/* treat identically to poll timeout */
@@ -249,11 +257,11 @@ tcp_send(int fd, void *data, int len)
 			if (j == 0) {
 				/* never came ready, return error */
 				/* pbs_tcp_errno will add to log message */
-				pbs_tcp_errno = EAGAIN;
+				*tcp_errno = EAGAIN;
 				return (-1);
 			} else if (j == -1) {
 				/* some other error - fatal */
-				pbs_tcp_errno = errno;
+				*tcp_errno = errno;
 				return (-1);
 			}
 			continue; /* socket ready, retry write */
@@ -279,3 +287,42 @@ DIS_tcp_funcs()
 	pfn_transport_recv = tcp_recv;
 	pfn_transport_send = tcp_send;
 }
+
+/**
+ * @brief
+ *	make the DIS I/O of the calling thread on a socket go over tcp through
+ *	the given channel, see dis_set_thread_chan()
+ *
+ * @param[in] fd - socket descriptor
+ * @param[in] chan - channel of fd, NULL to stop using a thread channel
+ * @param[in] timeout - timeout in seconds for sends on fd
+ *
+ * @return	int
+ * @retval	0 - success
+ * @retval	-1 - failure
+ *
+ * @par MT-safe: Yes
+ */
+int
+DIS_tcp_set_thread_chan(int fd, pbs_tcp_chan_t *chan, time_t timeout)
+{
+	return dis_set_thread_chan(fd, chan, tcp_send, timeout);
+}
+
+/**
+ * @brief
+ *	errno of the last failed send on the calling thread's own channel
+ *
+ * @param[in] fd - socket descriptor
+ *
+ * @return	int
+ *
+ * @par MT-safe: Yes
+ */
+int
+DIS_tcp_thread_errno(int fd)
+{
+	dis_thread_chan_t *tc = dis_get_thread_chan(fd);
+
+	return (tc != NULL) ? tc->tcp_errno : 0;
+}
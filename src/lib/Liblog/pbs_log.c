@@ -66,6 +66,9 @@
 #include <signal.h>
 #include <stddef.h>
 #include <stdarg.h>
+#ifndef WIN32
+#include <sys/uio.h>
+#endif
 
 #include "log.h"
 #include "pbs_ifl.h"
@@ -138,6 +141,75 @@ static int log_mutex_unlock();
 static void get_timestamp(ms_time *mst);
 static void log_record_inner(int eventtype, int objclass, int sev, const char *objname, const char *text, ms_time *mst);
 static void log_console_error(char *);
+static void log_close_file(int msg);
+
+#ifndef WIN32
+/*
+ * Asynchronous logging.  Once log_async_start() is called, log_record()
+ * formats each record into a ring buffer owned by the calling thread and
+ * returns without blocking signals, taking the log mutex or making a
+ * system call.  A writer thread drains the rings in record order and
+ * hands the records to the log file with writev().
+ *
+ * Whoever holds log_write_mutex is the consumer of the rings: the writer
+ * thread, a caller falling back to a synchronous write because its ring
+ * is full, and the fork handlers all drain them the same way, so records
+ * are never written out of order by a fallback.
+ *
+ * A thread takes the sequence number of a record before it publishes the
+ * record in its ring.  While it does, the ring's pending field holds a
+ * number no larger than that sequence number, and a drain stops before it.
+ * So a record is written only once every record numbered before it has
+ * been published.
+ */
+#define LOG_ASYNC_RING_SIZE (256 * 1024) /* bytes per thread, a power of two */
+#define LOG_ASYNC_REC_MAX (LOG_BUF_SIZE * 2) /* longer records are written synchronously */
+#define LOG_ASYNC_ALIGN 16		     /* records start on this boundary */
+#define LOG_ASYNC_WRAP 0xffffffffU	     /* header length marking the unused end of a ring */
+#define LOG_ASYNC_IOV 64		     /* records handed to one writev() */
+#define LOG_ASYNC_FLUSH_MS 20		     /* the writer wakes at least this often */
+#define LOG_ASYNC_IDLE (~0UL)		     /* pending of a ring no record is being added to */
+/* ring space taken by a record of len bytes */
+#define LOG_ASYNC_REC_SPACE(len) ((sizeof(log_rec_hdr) + (len) + LOG_ASYNC_ALIGN - 1) & ~((unsigned long) LOG_ASYNC_ALIGN - 1))
+
+typedef struct {
+	unsigned int len;  /* length of the record text or LOG_ASYNC_WRAP */
+	int yday;	   /* day of the year the record was made, for log switching */
+	unsigned long seq; /* order of the record across all rings */
+} log_rec_hdr;
+
+typedef struct log_ring {
+	struct log_ring *next;
+	unsigned long head;	    /* next byte the owning thread writes, published */
+	unsigned long tail;	    /* bytes before this are free again, published */
+	unsigned long rd;	    /* next byte the consumer reads */
+	unsigned long pending;	    /* at most the seq of the record being added, or LOG_ASYNC_IDLE */
+	volatile sig_atomic_t busy; /* owning thread is adding a record */
+	int orphaned;		    /* owning thread has exited */
+	time_t ts_sec;		    /* second the cached timestamp is for */
+	int ts_yday;
+	char ts_buf[32]; /* cached "mm/dd/yyyy hh:mm:ss" */
+	char data[LOG_ASYNC_RING_SIZE];
+} log_ring;
+
+static volatile int log_async_active = 0;
+static int log_async_stopping = 0;
+static pthread_t log_async_tid;
+static pthread_key_t log_async_key;
+static pthread_once_t log_async_once_ctl = PTHREAD_ONCE_INIT;
+static pthread_mutex_t log_async_wait_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t log_async_cond = PTHREAD_COND_INITIALIZER;
+static log_ring *log_rings = NULL; /* protected by log_write_mutex */
+static unsigned long log_async_seq = 0;
+
+/* fatal signals on which pending records are flushed before the daemon dies */
+static int log_async_crash_sigs[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+#define LOG_ASYNC_NUM_CRASH_SIGS (sizeof(log_async_crash_sigs) / sizeof(log_async_crash_sigs[0]))
+static struct sigaction log_async_crash_old[LOG_ASYNC_NUM_CRASH_SIGS];
+
+static void log_async_drain(void);
+static void log_async_free_rings(void);
+#endif /* WIN32 */
 
 void
 set_log_conf(char *leafname, char *nodename,
@@ -331,6 +403,9 @@ static void
 log_pre_fork_handler()
 {
 	log_mutex_lock();
+	/* write out what the other threads logged, the child has no writer */
+	if (log_rings != NULL)
+		log_async_drain();
 }
 
 /**
@@ -353,6 +428,18 @@ static void
 log_child_post_fork_handler()
 {
 	log_mutex_unlock();
+	/*
+	 * Only the forking thread exists in the child and the writer thread
+	 * is gone, so the child logs synchronously.  The rings were drained
+	 * before the fork and belong to the parent's threads.
+	 */
+	if (log_rings != NULL || log_async_active) {
+		log_async_active = 0;
+		log_async_free_rings();
+		pthread_setspecific(log_async_key, NULL);
+		pthread_mutex_init(&log_async_wait_mutex, NULL);
+		pthread_cond_init(&log_async_cond, NULL);
+	}
 }
 #endif
 
@@ -566,7 +653,7 @@ log_open_main(char *filename, char *directory, int silent)
 	pthread_once(&log_once_ctl, log_init); /* initialize mutex once */
 
 	if (log_opened > 0) /* Close existing log */
-		log_close(0);
+		log_close_file(0);
 
 	if (locallog != 0 || syslogfac == 0) {
 
@@ -963,6 +1050,571 @@ log_console_error(char *msg)
 	}
 }
 
+#ifndef WIN32
+/**
+ * @brief
+ *	Forget the log ring of a thread that is exiting.  The ring is freed
+ *	by the consumer once its records are written.
+ *
+ * @param[in] arg - the thread's log ring
+ *
+ */
+static void
+log_async_ring_exit(void *arg)
+{
+	log_ring *ring = (log_ring *) arg;
+
+	__atomic_store_n(&ring->orphaned, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief
+ *	Stop asynchronous logging when the process exits without log_close()
+ *
+ */
+static void
+log_async_atexit(void)
+{
+	log_async_stop();
+}
+
+/**
+ * @brief
+ *	Create the key the per-thread log rings hang off, once
+ *
+ */
+static void
+log_async_init(void)
+{
+	if (pthread_key_create(&log_async_key, log_async_ring_exit) != 0) {
+		fprintf(stderr, "log ring key create failed\n");
+		return;
+	}
+	atexit(log_async_atexit);
+}
+
+/**
+ * @brief
+ *	Return the log ring of the calling thread, creating it on the
+ *	thread's first record.
+ *
+ * @return log_ring *
+ * @retval NULL - no memory, the caller logs synchronously
+ *
+ */
+static log_ring *
+log_async_ring(void)
+{
+	log_ring *ring;
+	sigset_t block_mask;
+	sigset_t old_mask;
+
+	if ((ring = (log_ring *) pthread_getspecific(log_async_key)) != NULL)
+		return ring;
+
+	if ((ring = (log_ring *) calloc(1, sizeof(log_ring))) == NULL)
+		return NULL;
+	ring->pending = LOG_ASYNC_IDLE;
+
+	sigfillset(&block_mask);
+	sigprocmask(SIG_BLOCK, &block_mask, &old_mask);
+	if (log_mutex_lock() != 0) {
+		sigprocmask(SIG_SETMASK, &old_mask, NULL);
+		free(ring);
+		return NULL;
+	}
+	ring->next = log_rings;
+	log_rings = ring;
+	log_mutex_unlock();
+	sigprocmask(SIG_SETMASK, &old_mask, NULL);
+
+	pthread_setspecific(log_async_key, ring);
+	return ring;
+}
+
+/**
+ * @brief
+ *	Wake the log writer thread
+ *
+ */
+static void
+log_async_wake(void)
+{
+	pthread_cond_signal(&log_async_cond);
+}
+
+/**
+ * @brief
+ *	Format a record into the calling thread's log ring.  The timestamp
+ *	is only broken down again when the second changes.
+ *
+ * @param[in] ring - the calling thread's log ring
+ * @param[in] eventtype - event type
+ * @param[in] objclass - event object class
+ * @param[in] objname - object name stating log msg related to which object
+ * @param[in] text - log msg to be logged
+ *
+ * @return int
+ * @retval  0 - the record is queued
+ * @retval -1 - the record is too long or the ring is full, write it synchronously
+ *
+ */
+static int
+log_async_enqueue(log_ring *ring, int eventtype, int objclass, const char *objname, const char *text)
+{
+	char rec[LOG_ASYNC_REC_MAX];
+	char usec[8];
+	struct timeval tv;
+	struct tm ltm;
+	log_rec_hdr *hdr;
+	unsigned long head;
+	unsigned long tail;
+	unsigned long pos;
+	unsigned long need;
+	unsigned long skip = 0;
+	int len;
+
+	if (gettimeofday(&tv, NULL) == -1) {
+		tv.tv_sec = 0;
+		tv.tv_usec = 0;
+	}
+	if (ring->ts_buf[0] == '\0' || tv.tv_sec != ring->ts_sec) {
+		localtime_r(&tv.tv_sec, &ltm);
+		snprintf(ring->ts_buf, sizeof(ring->ts_buf), "%02d/%02d/%04d %02d:%02d:%02d",
+			 ltm.tm_mon + 1, ltm.tm_mday, ltm.tm_year + 1900,
+			 ltm.tm_hour, ltm.tm_min, ltm.tm_sec);
+		ring->ts_sec = tv.tv_sec;
+		ring->ts_yday = ltm.tm_yday;
+	}
+	if (pbs_log_highres_timestamp)
+		snprintf(usec, sizeof(usec), ".%06ld", (long) tv.tv_usec);
+	else
+		usec[0] = '\0';
+
+	len = snprintf(rec, sizeof(rec), "%s%s;%04x;%s;%s;%s;%s\n",
+		       ring->ts_buf, usec, eventtype & ~PBSEVENT_FORCE, msg_daemonname,
+		       class_names[objclass], objname, text);
+	if (len < 0 || len >= (int) sizeof(rec))
+		return -1;
+
+	need = LOG_ASYNC_REC_SPACE(len);
+	head = ring->head;
+	tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	pos = head & (LOG_ASYNC_RING_SIZE - 1);
+	/* a record never wraps, the end of the ring is skipped instead */
+	if (LOG_ASYNC_RING_SIZE - pos < need)
+		skip = LOG_ASYNC_RING_SIZE - pos;
+	if (LOG_ASYNC_RING_SIZE - (head - tail) < skip + need) {
+		log_async_wake();
+		return -1;
+	}
+
+	if (skip) {
+		((log_rec_hdr *) (ring->data + pos))->len = LOG_ASYNC_WRAP;
+		head += skip;
+		pos = 0;
+	}
+	hdr = (log_rec_hdr *) (ring->data + pos);
+	hdr->len = len;
+	hdr->yday = ring->ts_yday;
+	__atomic_store_n(&ring->pending, __atomic_load_n(&log_async_seq, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+	hdr->seq = __atomic_fetch_add(&log_async_seq, 1, __ATOMIC_SEQ_CST);
+	memcpy(hdr + 1, rec, len);
+	__atomic_store_n(&ring->head, head + need, __ATOMIC_RELEASE);
+	__atomic_store_n(&ring->pending, LOG_ASYNC_IDLE, __ATOMIC_RELEASE);
+
+	if (head + need - tail > LOG_ASYNC_RING_SIZE / 2)
+		log_async_wake();
+	return 0;
+}
+
+/**
+ * @brief
+ *	Return the next unread record of a log ring
+ *
+ * @param[in] ring - the log ring
+ *
+ * @return log_rec_hdr *
+ * @retval NULL - the ring has no unread records
+ *
+ */
+static log_rec_hdr *
+log_async_peek(log_ring *ring)
+{
+	unsigned long head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	unsigned long pos;
+	log_rec_hdr *hdr;
+
+	if (ring->rd == head)
+		return NULL;
+	pos = ring->rd & (LOG_ASYNC_RING_SIZE - 1);
+	hdr = (log_rec_hdr *) (ring->data + pos);
+	if (hdr->len == LOG_ASYNC_WRAP) {
+		ring->rd += LOG_ASYNC_RING_SIZE - pos;
+		if (ring->rd == head)
+			return NULL;
+		hdr = (log_rec_hdr *) ring->data;
+	}
+	return hdr;
+}
+
+/**
+ * @brief
+ *	Return the unread record with the lowest sequence number of all the
+ *	log rings
+ *
+ * @param[out] bestring - the ring the record is in
+ *
+ * @return log_rec_hdr *
+ * @retval NULL - no ring has unread records
+ *
+ */
+static log_rec_hdr *
+log_async_next(log_ring **bestring)
+{
+	log_ring *ring;
+	log_rec_hdr *hdr;
+	log_rec_hdr *besthdr = NULL;
+
+	for (ring = log_rings; ring != NULL; ring = ring->next) {
+		hdr = log_async_peek(ring);
+		if (hdr != NULL && (besthdr == NULL || hdr->seq < besthdr->seq)) {
+			*bestring = ring;
+			besthdr = hdr;
+		}
+	}
+	return besthdr;
+}
+
+/**
+ * @brief
+ *	Write records to the log file, and give the space they used in the
+ *	rings back to the threads that made them.
+ *
+ * @param[in] iov - the records
+ * @param[in] niov - number of records
+ *
+ */
+static void
+log_async_write(struct iovec *iov, int niov)
+{
+	log_ring *ring;
+	ssize_t n;
+
+	while (niov > 0 && log_opened > 0) {
+		n = writev(fileno(logfile), iov, niov);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			log_console_error("PBS cannot write to its log");
+			break;
+		}
+		while (niov > 0 && (size_t) n >= iov->iov_len) {
+			n -= iov->iov_len;
+			iov++;
+			niov--;
+		}
+		if (niov > 0) {
+			iov->iov_base = (char *) iov->iov_base + n;
+			iov->iov_len -= n;
+		}
+	}
+
+	for (ring = log_rings; ring != NULL; ring = ring->next)
+		__atomic_store_n(&ring->tail, ring->rd, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief
+ *	Write the queued records to the log file in sequence order across
+ *	the threads' rings, switching the log at midnight like log_record().
+ *	Stops before the first record a thread is still adding to its ring;
+ *	what follows it is written by the next drain.  Frees the rings of
+ *	threads that have exited once they are empty.
+ *	The caller holds log_write_mutex.
+ *
+ */
+static void
+log_async_drain(void)
+{
+	struct iovec iov[LOG_ASYNC_IOV];
+	int niov = 0;
+	log_ring *ring;
+	log_ring *best;
+	log_ring **prev;
+	log_rec_hdr *besthdr;
+	unsigned long limit;
+	unsigned long pending;
+
+	/* records numbered from limit on may have predecessors not yet published */
+	limit = __atomic_load_n(&log_async_seq, __ATOMIC_SEQ_CST);
+	for (ring = log_rings; ring != NULL; ring = ring->next) {
+		pending = __atomic_load_n(&ring->pending, __ATOMIC_SEQ_CST);
+		if (pending < limit)
+			limit = pending;
+	}
+
+	for (;;) {
+		if ((besthdr = log_async_next(&best)) == NULL || besthdr->seq >= limit)
+			break;
+
+		if (log_auto_switch && besthdr->yday != log_open_day) {
+			log_async_write(iov, niov);
+			niov = 0;
+			log_close_file(1);
+			log_open(NULL, log_directory);
+			if (log_opened < 1)
+				log_console_error("PBS cannot open its log");
+		}
+
+		iov[niov].iov_base = besthdr + 1;
+		iov[niov].iov_len = besthdr->len;
+		niov++;
+		best->rd += LOG_ASYNC_REC_SPACE(besthdr->len);
+		if (niov == LOG_ASYNC_IOV) {
+			log_async_write(iov, niov);
+			niov = 0;
+		}
+	}
+	log_async_write(iov, niov);
+
+	for (prev = &log_rings; (ring = *prev) != NULL;) {
+		if (__atomic_load_n(&ring->orphaned, __ATOMIC_ACQUIRE) &&
+		    ring->rd == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+			*prev = ring->next;
+			free(ring);
+		} else
+			prev = &ring->next;
+	}
+}
+
+/**
+ * @brief
+ *	Free every log ring, used in a child after fork
+ *
+ */
+static void
+log_async_free_rings(void)
+{
+	log_ring *ring;
+
+	while ((ring = log_rings) != NULL) {
+		log_rings = ring->next;
+		free(ring);
+	}
+}
+
+/**
+ * @brief
+ *	The log writer thread.  Drains the rings when a ring fills past half
+ *	or every LOG_ASYNC_FLUSH_MS, and once more when told to stop.
+ *
+ * @param[in] arg - unused
+ *
+ * @return void *
+ *
+ */
+static void *
+log_async_writer(void *arg)
+{
+	sigset_t block_mask;
+	struct timespec ts;
+	int stop;
+
+	/* signal handlers run on the daemon's own threads */
+	sigfillset(&block_mask);
+	pthread_sigmask(SIG_BLOCK, &block_mask, NULL);
+
+	do {
+		clock_gettime(CLOCK_REALTIME, &ts);
+		ts.tv_nsec += LOG_ASYNC_FLUSH_MS * 1000000L;
+		if (ts.tv_nsec >= 1000000000L) {
+			ts.tv_sec++;
+			ts.tv_nsec -= 1000000000L;
+		}
+		pthread_mutex_lock(&log_async_wait_mutex);
+		if (!log_async_stopping)
+			pthread_cond_timedwait(&log_async_cond, &log_async_wait_mutex, &ts);
+		stop = log_async_stopping;
+		pthread_mutex_unlock(&log_async_wait_mutex);
+
+		if (log_mutex_lock() == 0) {
+			log_async_drain();
+			log_mutex_unlock();
+		}
+	} while (!stop);
+
+	return NULL;
+}
+
+/**
+ * @brief
+ *	Write every published record out in sequence order without taking
+ *	log_write_mutex, for a process about to die: the thread holding the
+ *	mutex may be the one the signal interrupted.  Unlike a drain it does
+ *	not stop at a record still being added.  This is a best effort: such a
+ *	record is lost.
+ *
+ */
+static void
+log_async_flush_unlocked(void)
+{
+	log_ring *best;
+	log_rec_hdr *hdr;
+
+	if (log_opened <= 0)
+		return;
+	while ((hdr = log_async_next(&best)) != NULL) {
+		if (write(fileno(logfile), hdr + 1, hdr->len) == -1)
+			break;
+		best->rd += LOG_ASYNC_REC_SPACE(hdr->len);
+	}
+}
+
+/**
+ * @brief
+ *	Write the queued records out when the daemon is about to die of a
+ *	fatal signal, then let the signal take its previous course.
+ *
+ * @param[in] sig - the signal
+ *
+ */
+static void
+log_async_crash(int sig)
+{
+	int i;
+
+	log_async_flush_unlocked();
+
+	for (i = 0; i < (int) LOG_ASYNC_NUM_CRASH_SIGS; i++) {
+		if (log_async_crash_sigs[i] == sig) {
+			sigaction(sig, &log_async_crash_old[i], NULL);
+			break;
+		}
+	}
+	raise(sig);
+}
+
+/**
+ * @brief
+ *	Start logging asynchronously.  From now on log_record() queues the
+ *	records of each thread in a ring and a writer thread writes them to
+ *	the log file in batches.  Records that do not fit are written by the
+ *	calling thread, after what is queued.
+ *	Call it once the daemon has forked into the background; a child
+ *	process logs synchronously.  Not used when logging to syslog.
+ *
+ * @return int
+ * @retval  0 - success
+ * @retval -1 - the writer thread could not be started, logging stays synchronous
+ *
+ */
+int
+log_async_start(void)
+{
+	struct sigaction act;
+	int i;
+
+	pthread_once(&log_once_ctl, log_init);
+	pthread_once(&log_async_once_ctl, log_async_init);
+
+	if (log_async_active)
+		return 0;
+#if SYSLOG
+	if (syslogopen != 0)
+		return -1;
+#endif
+
+	log_async_stopping = 0;
+	if (pthread_create(&log_async_tid, NULL, log_async_writer, NULL) != 0)
+		return -1;
+
+	memset(&act, 0, sizeof(act));
+	act.sa_handler = log_async_crash;
+	sigfillset(&act.sa_mask);
+	for (i = 0; i < (int) LOG_ASYNC_NUM_CRASH_SIGS; i++) {
+		if (sigaction(log_async_crash_sigs[i], NULL, &log_async_crash_old[i]) == 0 &&
+		    log_async_crash_old[i].sa_handler != SIG_IGN)
+			sigaction(log_async_crash_sigs[i], &act, NULL);
+	}
+
+	log_async_active = 1;
+	return 0;
+}
+
+/**
+ * @brief
+ *	Stop logging asynchronously: stop the writer thread after it has
+ *	written everything queued.  Called by log_close().
+ *
+ */
+void
+log_async_stop(void)
+{
+	struct sigaction act;
+	sigset_t block_mask;
+	sigset_t old_mask;
+	int i;
+
+	if (!log_async_active || pthread_equal(pthread_self(), log_async_tid))
+		return;
+	log_async_active = 0;
+
+	pthread_mutex_lock(&log_async_wait_mutex);
+	log_async_stopping = 1;
+	pthread_cond_signal(&log_async_cond);
+	pthread_mutex_unlock(&log_async_wait_mutex);
+	pthread_join(log_async_tid, NULL);
+
+	for (i = 0; i < (int) LOG_ASYNC_NUM_CRASH_SIGS; i++) {
+		if (sigaction(log_async_crash_sigs[i], NULL, &act) == 0 && act.sa_handler == log_async_crash)
+			sigaction(log_async_crash_sigs[i], &log_async_crash_old[i], NULL);
+	}
+
+	/* records queued by threads that saw logging still asynchronous */
+	sigfillset(&block_mask);
+	sigprocmask(SIG_BLOCK, &block_mask, &old_mask);
+	if (log_mutex_lock() == 0) {
+		log_async_drain();
+		log_mutex_unlock();
+	}
+	sigprocmask(SIG_SETMASK, &old_mask, NULL);
+}
+
+/**
+ * @brief
+ *	Stop logging asynchronously from a signal handler that is going to
+ *	exit the process.  Unlike log_async_stop(), it does not wait for the
+ *	writer thread, which may be waiting for the log mutex held by the
+ *	thread the signal interrupted.  The queued records are written like on
+ *	a crash, all of them since a record the interrupted thread was adding
+ *	would hold up a drain, and under the mutex if it can be had within a
+ *	short while.  Later records are written synchronously.
+ *
+ */
+void
+log_async_signal_stop(void)
+{
+	struct timespec ts = {0, 1000000L}; /* 1ms */
+	int i;
+
+	if (!log_async_active || pthread_equal(pthread_self(), log_async_tid))
+		return;
+	log_async_active = 0;
+
+	/* the writer holds the mutex only briefly */
+	for (i = 0; i < 100; i++) {
+		if (pthread_mutex_trylock(&log_write_mutex) == 0) {
+			log_async_flush_unlocked();
+			log_mutex_unlock();
+			return;
+		}
+		nanosleep(&ts, NULL);
+	}
+	log_async_flush_unlocked();
+}
+#endif /* WIN32 */
+
 /**
  * @brief
  * 	log a message to the log file - this function acquires a lock
@@ -994,6 +1646,24 @@ log_record(int eventtype, int objclass, int sev, const char *objname, const char
 	sigset_t block_mask;
 	sigset_t old_mask;
 
+	if (log_async_active && log_opened > 0 && text != NULL && objname != NULL) {
+		log_ring *ring;
+		int rc;
+
+		/*
+		 * A busy ring means a signal handler is logging while the
+		 * thread it interrupted was adding a record: write it directly.
+		 * So is a record the ring has no room for.
+		 */
+		if ((ring = log_async_ring()) != NULL && !ring->busy) {
+			ring->busy = 1;
+			rc = log_async_enqueue(ring, eventtype, objclass, objname, text);
+			ring->busy = 0;
+			if (rc == 0)
+				return;
+		}
+	}
+
 	/* Block all signals to the process to make the function async-safe */
 	sigfillset(&block_mask);
 	sigprocmask(SIG_BLOCK, &block_mask, &old_mask);
@@ -1014,11 +1684,16 @@ log_record(int eventtype, int objclass, int sev, const char *objname, const char
 
 	/* lock the file mutex */
 	if (log_mutex_lock() == 0) {
+#ifndef WIN32
+		/* records queued before this one go first */
+		if (log_rings != NULL)
+			log_async_drain();
+#endif
 		get_timestamp(&mst);
 
 		/* Do we need to switch the log? */
 		if (log_auto_switch && (mst.ptm.tm_yday != log_open_day)) {
-			log_close(1);
+			log_close_file(1);
 			log_open(NULL, log_directory);
 			if (log_opened < 1) {
 				log_mutex_unlock();
@@ -1079,6 +1754,9 @@ log_record_inner(int eventtype, int objclass, int sev, const char *objname, cons
  * @brief
  * 	log_close - close the current open log file
  *
+ *	Stops the log writer thread first, so that every record queued
+ *	by asynchronous logging is in the file before it is closed.
+ *
  * @param[in] msg - indicating whether to log a message of closing log file before closing it
  *
  * @return	Void
@@ -1086,6 +1764,72 @@ log_record_inner(int eventtype, int objclass, int sev, const char *objname, cons
  */
 void
 log_close(int msg)
+{
+#ifndef WIN32
+	log_async_stop();
+#endif
+	log_close_file(msg);
+}
+
+/**
+ * @brief
+ *	Close the log file and open it again, e.g. on SIGHUP so that the old
+ *	file can be rotated.  Unlike log_close() followed by log_open(), the
+ *	log writer thread keeps running: what it has queued so far is written
+ *	to the old file under the log mutex before it is closed.
+ *
+ * @param[in] filename - the log file, as for log_open()
+ * @param[in] directory - the log directory, as for log_open()
+ *
+ * @return int	- return value of log_open().
+ *
+ */
+int
+log_reopen(char *filename, char *directory)
+{
+	int rc;
+#ifndef WIN32
+	sigset_t block_mask;
+	sigset_t old_mask;
+
+	/* may be called from a signal handler, holders of the mutex block signals */
+	sigfillset(&block_mask);
+	sigprocmask(SIG_BLOCK, &block_mask, &old_mask);
+#endif
+
+	pthread_once(&log_once_ctl, log_init); /* initialize mutex once */
+
+	if (log_mutex_lock() != 0) {
+		log_close_file(1);
+		rc = log_open(filename, directory);
+	} else {
+#ifndef WIN32
+		if (log_rings != NULL)
+			log_async_drain();
+#endif
+		log_close_file(1);
+		rc = log_open(filename, directory);
+		log_mutex_unlock();
+	}
+
+#ifndef WIN32
+	sigprocmask(SIG_SETMASK, &old_mask, NULL);
+#endif
+	return rc;
+}
+
+/**
+ * @brief
+ * 	close the current open log file without stopping the log writer,
+ *	used when the log is switched or reopened
+ *
+ * @param[in] msg - indicating whether to log a message of closing log file before closing it
+ *
+ * @return	Void
+ *
+ */
+static void
+log_close_file(int msg)
 {
 	if (log_opened == 1) {
 		log_auto_switch = 0;
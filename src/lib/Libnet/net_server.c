@@ -401,6 +401,8 @@ connection_idlecheck(void)
 			continue;
 		if (cp->cn_authen & PBS_NET_CONN_NOTIMEOUT)
 			continue; /* do not time-out this connection */
+		if (cp->cn_suspended)
+			continue; /* in use elsewhere, see suspend_conn() */
 
 		ipaddr = cp->cn_addr;
 		snprintf(logbuf, sizeof(logbuf),
@@ -788,6 +790,77 @@ set_conn_as_priority(conn_t *conn)
 	return 1;
 }
 
+/**
+ * @brief
+ *	suspend_conn - stop polling a connection, so another thread can use
+ *	the socket until resume_conn() is called for it.  The connection stays
+ *	in the connection table meanwhile.
+ *
+ * @param[in]	sd - socket descriptor
+ *
+ * @return int
+ * @retval 0 - success
+ * @retval -1 - failure
+ */
+int
+suspend_conn(int sd)
+{
+	int idx = conn_find_actual_index(sd);
+
+	if (idx < 0 || svr_conn[idx]->cn_suspended)
+		return -1;
+
+	if (tpp_em_del_fd(poll_context, sd) < 0) {
+		log_errf(errno, __func__, "could not remove socket %d from poll list", sd);
+		return -1;
+	}
+	if (svr_conn[idx]->cn_prio_flag) {
+		if (tpp_em_del_fd(priority_context, sd) < 0) {
+			log_errf(errno, __func__, "could not remove socket %d from priority poll list", sd);
+			(void) tpp_em_add_fd(poll_context, sd, EM_IN | EM_HUP | EM_ERR);
+			return -1;
+		}
+	}
+	svr_conn[idx]->cn_suspended = 1;
+	return 0;
+}
+
+/**
+ * @brief
+ *	resume_conn - poll a connection again after suspend_conn()
+ *
+ * @param[in]	sd - socket descriptor
+ *
+ * @return int
+ * @retval 0 - success
+ * @retval -1 - failure, the caller should close the connection
+ */
+int
+resume_conn(int sd)
+{
+	int idx = conn_find_actual_index(sd);
+
+	if (idx < 0 || !svr_conn[idx]->cn_suspended)
+		return -1;
+
+	svr_conn[idx]->cn_suspended = 0;
+	svr_conn[idx]->cn_lasttime = time(NULL);
+	if (tpp_em_add_fd(poll_context, sd, EM_IN | EM_HUP | EM_ERR) < 0) {
+		log_errf(errno, __func__, "could not add socket %d to the poll list", sd);
+		/* keep cleanup_conn() from removing it from the priority list */
+		svr_conn[idx]->cn_prio_flag = 0;
+		svr_conn[idx]->cn_suspended = 1;
+		return -1;
+	}
+	if (svr_conn[idx]->cn_prio_flag) {
+		if (tpp_em_add_fd(priority_context, sd, EM_IN | EM_HUP | EM_ERR) < 0) {
+			log_errf(errno, __func__, "could not add socket %d to the priority poll list", sd);
+			svr_conn[idx]->cn_prio_flag = 0;
+		}
+	}
+	return 0;
+}
+
 /**
  * @brief
  *	add_conn_data - add some data to a connection
@@ -930,13 +1003,15 @@ close_conn(int sd)
 static void
 cleanup_conn(int idx)
 {
-	if (tpp_em_del_fd(poll_context, svr_conn[idx]->cn_sock) < 0) {
+	if (svr_conn[idx]->cn_suspended) {
+		/* already out of the poll lists, see suspend_conn() */
+	} else if (tpp_em_del_fd(poll_context, svr_conn[idx]->cn_sock) < 0) {
 		int err = errno;
 		snprintf(logbuf, sizeof(logbuf),
 			 "could not remove socket %d from poll list", svr_conn[idx]->cn_sock);
 		log_err(err, __func__, logbuf);
 	}
-	if (svr_conn[idx]->cn_prio_flag) {
+	if (svr_conn[idx]->cn_prio_flag && !svr_conn[idx]->cn_suspended) {
 		if (tpp_em_del_fd(priority_context, svr_conn[idx]->cn_sock) < 0) {
 			int err = errno;
 			snprintf(logbuf, sizeof(logbuf),
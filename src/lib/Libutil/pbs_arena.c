@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file	pbs_arena.c
+ *
+ * @brief
+ * 	Arena allocator: memory is taken from large chunks by bumping a
+ * 	pointer and all of it is released in one go, see pbs_arena.h.
+ *
+ * 	The arena itself lives at the start of its first chunk.  Requests
+ * 	larger than a quarter of a chunk get a chunk of their own, which is
+ * 	linked behind the current one so the space left there is not lost.
+ */
+
+#include <pbs_config.h>
+#include <stdlib.h>
+#include "pbs_arena.h"
+
+/* alignment of everything handed out */
+#define ARENA_ALIGN 16
+#define ARENA_ROUND(x) (((x) + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1))
+
+typedef struct arena_chunk {
+	struct arena_chunk *next;
+	size_t size; /* usable bytes after the header */
+	size_t used;
+} arena_chunk;
+
+typedef struct arena_cleanup {
+	struct arena_cleanup *next;
+	void (*func)(void *);
+	void *arg;
+} arena_cleanup;
+
+struct pbs_arena {
+	arena_chunk *chunks; /* current chunk first */
+	size_t chunksz;
+	arena_cleanup *cleanups; /* most recent first */
+};
+
+#define CHUNK_HDR ARENA_ROUND(sizeof(arena_chunk))
+#define CHUNK_DATA(c) ((char *) (c) + CHUNK_HDR)
+
+/**
+ * @brief
+ * 	allocate a chunk with size usable bytes
+ *
+ * @param[in]	size - usable size
+ *
+ * @return	arena_chunk *
+ * @retval	NULL	- out of memory
+ */
+static arena_chunk *
+new_chunk(size_t size)
+{
+	arena_chunk *c;
+
+	c = malloc(CHUNK_HDR + size);
+	if (c == NULL)
+		return NULL;
+	c->next = NULL;
+	c->size = size;
+	c->used = 0;
+	return c;
+}
+
+/**
+ * @brief
+ * 	create an arena
+ *
+ * @param[in]	chunksz - size of the chunks, 0 for PBS_ARENA_CHUNK
+ *
+ * @return	pbs_arena *
+ * @retval	NULL	- out of memory
+ */
+pbs_arena *
+pbs_arena_create(size_t chunksz)
+{
+	arena_chunk *c;
+	pbs_arena *arena;
+
+	if (chunksz == 0)
+		chunksz = PBS_ARENA_CHUNK;
+	chunksz = ARENA_ROUND(chunksz);
+	if (chunksz < 4 * ARENA_ROUND(sizeof(pbs_arena)))
+		chunksz = 4 * ARENA_ROUND(sizeof(pbs_arena));
+
+	if ((c = new_chunk(chunksz)) == NULL)
+		return NULL;
+	arena = (pbs_arena *) CHUNK_DATA(c);
+	c->used = ARENA_ROUND(sizeof(pbs_arena));
+	arena->chunks = c;
+	arena->chunksz = chunksz;
+	arena->cleanups = NULL;
+	return arena;
+}
+
+/**
+ * @brief
+ * 	allocate memory from an arena.  It is aligned for any type and is not
+ * 	cleared.
+ *
+ * @param[in]	arena - the arena
+ * @param[in]	size - bytes wanted
+ *
+ * @return	void *
+ * @retval	NULL	- out of memory
+ */
+void *
+pbs_arena_alloc(pbs_arena *arena, size_t size)
+{
+	arena_chunk *c = arena->chunks;
+	void *p;
+
+	size = ARENA_ROUND(size == 0 ? 1 : size);
+	if (c->size - c->used >= size) {
+		p = CHUNK_DATA(c) + c->used;
+		c->used += size;
+		return p;
+	}
+
+	if (size > arena->chunksz / 4) {
+		/* a chunk of its own, keep using the current one */
+		if ((c = new_chunk(size)) == NULL)
+			return NULL;
+		c->used = size;
+		c->next = arena->chunks->next;
+		arena->chunks->next = c;
+		return CHUNK_DATA(c);
+	}
+
+	if ((c = new_chunk(arena->chunksz)) == NULL)
+		return NULL;
+	c->used = size;
+	c->next = arena->chunks;
+	arena->chunks = c;
+	return CHUNK_DATA(c);
+}
+
+/**
+ * @brief
+ * 	register a function to be called with arg when the arena is
+ * 	destroyed.  The functions are called in the reverse order of their
+ * 	registration, before any memory of the arena is released.
+ *
+ * @param[in]	arena - the arena
+ * @param[in]	func - function to call
+ * @param[in]	arg - its argument
+ *
+ * @return	int
+ * @retval	0	- success
+ * @retval	-1	- out of memory, func will not be called
+ */
+int
+pbs_arena_on_destroy(pbs_arena *arena, void (*func)(void *), void *arg)
+{
+	arena_cleanup *pc;
+
+	pc = pbs_arena_alloc(arena, sizeof(arena_cleanup));
+	if (pc == NULL)
+		return -1;
+	pc->func = func;
+	pc->arg = arg;
+	pc->next = arena->cleanups;
+	arena->cleanups = pc;
+	return 0;
+}
+
+/**
+ * @brief
+ * 	run the functions registered on an arena and release all its memory
+ *
+ * @param[in]	arena - the arena, may be NULL
+ */
+void
+pbs_arena_destroy(pbs_arena *arena)
+{
+	arena_cleanup *pc;
+	arena_chunk *c;
+	arena_chunk *next;
+
+	if (arena == NULL)
+		return;
+	for (pc = arena->cleanups; pc; pc = pc->next)
+		pc->func(pc->arg);
+
+	/* the arena lives in the last chunk of the list */
+	for (c = arena->chunks; c; c = next) {
+		next = c->next;
+		free(c);
+	}
+}
@@ -44,6 +44,7 @@
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 
 /* iteration context structure, opaque to application */
 typedef struct _iter_ctx {
@@ -314,3 +315,320 @@ pbs_idx_is_empty(void *idx)
 
 	return 1;
 }
+
+/*
+ * Static index: a minimal perfect hash in the "hash, displace and
+ * compress" style.  Keys are hashed into buckets of a few keys each, and
+ * every bucket gets a displacement pair (d0, d1) chosen at creation so that
+ * (f1 + d0 * f2 + d1) % nkeys puts each key into its own slot.  A lookup is
+ * one pass over the key to hash it and one compare to confirm it.
+ */
+#define PHASH_KEYS_PER_BUCKET 4
+#define PHASH_MAX_SEEDS 32
+
+/* static index structure, opaque to application */
+typedef struct _phash_idx {
+	int nkeys;	     /* number of slots, one per key */
+	int nbuckets;	     /* number of buckets */
+	int flags;	     /* PBS_IDX_ICASE_CMP */
+	unsigned int seed;   /* seed of the hash that gave a perfect hash */
+	unsigned int *disp;  /* displacement pair of each bucket, d0 * nkeys + d1 */
+	const char **keys;   /* key in each slot */
+	void **data;	     /* data in each slot */
+} phash_idx;
+
+/**
+ * @brief
+ *	hash a key for a static index
+ *
+ * @param[in] - key   - the key
+ * @param[in] - icase - fold upper case ASCII letters to lower case
+ * @param[in] - seed  - seed of the hash
+ *
+ * @return unsigned long long
+ *
+ */
+static unsigned long long
+phash_hash(const char *key, int icase, unsigned int seed)
+{
+	unsigned long long h = 14695981039346656037ULL ^ seed; /* FNV-1a */
+	unsigned char c;
+
+	while ((c = (unsigned char) *key++) != '\0') {
+		if (icase && c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		h ^= c;
+		h *= 1099511628211ULL;
+	}
+	/* spread the bits, the bucket and slot are taken from different ends */
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	return h;
+}
+
+/**
+ * @brief
+ *	slot of a key in a static index given its hash and displacement
+ *
+ * @param[in] - pidx - the static index
+ * @param[in] - h    - hash of the key
+ * @param[in] - disp - displacement pair of the key's bucket
+ *
+ * @return unsigned int
+ *
+ */
+static unsigned int
+phash_slot(phash_idx *pidx, unsigned long long h, unsigned int disp)
+{
+	unsigned long long m = pidx->nkeys;
+	unsigned long long f1 = h % m;
+	unsigned long long f2 = (h >> 32) % m;
+
+	return (unsigned int) ((f1 + (disp / m) * f2 + disp % m) % m);
+}
+
+/**
+ * @brief
+ *	try to place every key in a static index with one hash seed
+ *
+ * @param[in] - pidx   - the static index, with nkeys, nbuckets, flags and seed set
+ * @param[in] - keys   - the distinct keys
+ * @param[in] - data   - data of each key
+ * @param[in] - hashes - work array for the hash of each key
+ * @param[in] - order  - work array for the keys sorted by bucket
+ * @param[in] - start  - work array for the start of each bucket in order
+ *
+ * @return int
+ * @retval 0  - every key has its own slot
+ * @retval -1 - some bucket could not be placed, try another seed
+ *
+ */
+static int
+phash_place(phash_idx *pidx, char **keys, void **data, unsigned long long *hashes,
+	    int *order, int *start)
+{
+	int m = pidx->nkeys;
+	int nb = pidx->nbuckets;
+	int *bucket_order;
+	unsigned int *slots;
+	int i, j, k, b;
+	int size, maxsize = 0;
+	unsigned int disp;
+	unsigned int maxdisp = (unsigned int) m * (unsigned int) m;
+	int icase = pidx->flags & PBS_IDX_ICASE_CMP;
+
+	bucket_order = malloc(nb * sizeof(int));
+	if (bucket_order == NULL)
+		return -1;
+
+	/* counting sort of the keys by bucket */
+	memset(start, 0, (nb + 1) * sizeof(int));
+	for (i = 0; i < m; i++) {
+		hashes[i] = phash_hash(keys[i], icase, pidx->seed);
+		start[(hashes[i] >> 40) % nb + 1]++;
+	}
+	for (b = 0; b < nb; b++) {
+		start[b + 1] += start[b];
+		size = start[b + 1] - start[b];
+		if (size > maxsize)
+			maxsize = size;
+	}
+	for (i = 0; i < m; i++) {
+		b = (hashes[i] >> 40) % nb;
+		for (j = start[b]; order[j] != -1; j++)
+			;
+		order[j] = i;
+	}
+
+	/* place the largest buckets first, while most slots are free */
+	k = 0;
+	for (size = maxsize; size > 0; size--)
+		for (b = 0; b < nb; b++)
+			if (start[b + 1] - start[b] == size)
+				bucket_order[k++] = b;
+	for (; k < nb; k++)
+		bucket_order[k] = -1;
+
+	slots = malloc((maxsize > 0 ? maxsize : 1) * sizeof(unsigned int));
+	if (slots == NULL) {
+		free(bucket_order);
+		return -1;
+	}
+
+	for (k = 0; k < nb && bucket_order[k] != -1; k++) {
+		b = bucket_order[k];
+		size = start[b + 1] - start[b];
+		for (disp = 0; disp < maxdisp; disp++) {
+			for (j = 0; j < size; j++) {
+				slots[j] = phash_slot(pidx, hashes[order[start[b] + j]], disp);
+				if (pidx->keys[slots[j]] != NULL)
+					break;
+				for (i = 0; i < j && slots[i] != slots[j]; i++)
+					;
+				if (i < j)
+					break;
+			}
+			if (j == size)
+				break;
+		}
+		if (disp == maxdisp) {
+			free(slots);
+			free(bucket_order);
+			return -1;
+		}
+		pidx->disp[b] = disp;
+		for (j = 0; j < size; j++) {
+			pidx->keys[slots[j]] = keys[order[start[b] + j]];
+			pidx->data[slots[j]] = data[order[start[b] + j]];
+		}
+	}
+
+	free(slots);
+	free(bucket_order);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Create a static index over a fixed set of string keys, looked up
+ *	through a minimal perfect hash.  The keys are not copied and must
+ *	outlive the index.  If a key appears more than once, its first
+ *	occurrence is indexed.
+ *
+ * @param[in] - keys  - the keys
+ * @param[in] - data  - data of each key
+ * @param[in] - nkeys - number of keys
+ * @param[in] - flags - PBS_IDX_ICASE_CMP for case-insensitive keys
+ *
+ * @return void *
+ * @retval !NULL - success
+ * @retval NULL  - failure
+ *
+ */
+void *
+pbs_phash_create(char **keys, void **data, int nkeys, int flags)
+{
+	phash_idx *pidx;
+	char **ukeys = NULL;
+	void **udata = NULL;
+	unsigned long long *hashes = NULL;
+	int *order = NULL;
+	int *start = NULL;
+	int m = 0;
+	int i, j;
+	int rc = -1;
+
+	if (keys == NULL || data == NULL || nkeys < 0)
+		return NULL;
+
+	if ((pidx = calloc(1, sizeof(phash_idx))) == NULL)
+		return NULL;
+	pidx->flags = flags;
+
+	/* drop repeated keys, the hash can't separate them */
+	ukeys = malloc((nkeys + 1) * sizeof(char *));
+	udata = malloc((nkeys + 1) * sizeof(void *));
+	if (ukeys == NULL || udata == NULL)
+		goto err;
+	for (i = 0; i < nkeys; i++) {
+		if (keys[i] == NULL)
+			continue;
+		for (j = 0; j < m; j++) {
+			if ((flags & PBS_IDX_ICASE_CMP) ? strcasecmp(ukeys[j], keys[i]) == 0 : strcmp(ukeys[j], keys[i]) == 0)
+				break;
+		}
+		if (j < m)
+			continue;
+		ukeys[m] = keys[i];
+		udata[m] = data[i];
+		m++;
+	}
+
+	pidx->nkeys = m;
+	pidx->nbuckets = m / PHASH_KEYS_PER_BUCKET + 1;
+	pidx->disp = calloc(pidx->nbuckets, sizeof(unsigned int));
+	pidx->keys = calloc(m + 1, sizeof(char *));
+	pidx->data = calloc(m + 1, sizeof(void *));
+	hashes = malloc((m + 1) * sizeof(unsigned long long));
+	order = malloc((m + 1) * sizeof(int));
+	start = malloc((pidx->nbuckets + 1) * sizeof(int));
+	if (pidx->disp == NULL || pidx->keys == NULL || pidx->data == NULL ||
+	    hashes == NULL || order == NULL || start == NULL)
+		goto err;
+
+	if (m == 0)
+		rc = 0;
+	for (pidx->seed = 0; m > 0 && pidx->seed < PHASH_MAX_SEEDS; pidx->seed++) {
+		memset(pidx->keys, 0, m * sizeof(char *));
+		for (i = 0; i < m; i++)
+			order[i] = -1;
+		if ((rc = phash_place(pidx, ukeys, udata, hashes, order, start)) == 0)
+			break;
+	}
+
+err:
+	free(ukeys);
+	free(udata);
+	free(hashes);
+	free(order);
+	free(start);
+	if (rc != 0) {
+		pbs_phash_destroy(pidx);
+		return NULL;
+	}
+	return pidx;
+}
+
+/**
+ * @brief
+ *	destroy a static index
+ *
+ * @param[in] - idx - pointer to static index
+ *
+ * @return void
+ *
+ */
+void
+pbs_phash_destroy(void *idx)
+{
+	phash_idx *pidx = (phash_idx *) idx;
+
+	if (pidx != NULL) {
+		free(pidx->disp);
+		free(pidx->keys);
+		free(pidx->data);
+		free(pidx);
+	}
+}
+
+/**
+ * @brief
+ *	find the data of a key in a static index
+ *
+ * @param[in] - idx - pointer to static index, can be NULL
+ * @param[in] - key - key to find
+ *
+ * @return void *
+ * @retval !NULL - data of the key
+ * @retval NULL  - key is not in index
+ *
+ */
+void *
+pbs_phash_find(void *idx, const char *key)
+{
+	phash_idx *pidx = (phash_idx *) idx;
+	unsigned long long h;
+	unsigned int slot;
+	int icase;
+
+	if (pidx == NULL || key == NULL || pidx->nkeys == 0)
+		return NULL;
+
+	icase = pidx->flags & PBS_IDX_ICASE_CMP;
+	h = phash_hash(key, icase, pidx->seed);
+	slot = phash_slot(pidx, h, pidx->disp[(h >> 40) % pidx->nbuckets]);
+	if (icase ? strcasecmp(pidx->keys[slot], key) != 0 : strcmp(pidx->keys[slot], key) != 0)
+		return NULL;
+	return pidx->data[slot];
+}
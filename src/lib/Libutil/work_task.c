@@ -41,6 +41,12 @@
  * @file	work_task.c
  * @brief
  * work_task.c - contains functions to deal with the server's task list
+ *
+ * Timed tasks are kept in a binary heap ordered by time, tasks of the same
+ * time in the order they were set, so the next one due is found without a
+ * walk of task_list_timed, which only tells which tasks are timed.  Tasks
+ * are also indexed by wt_parm1, so the lookups and deletions by parm1 look
+ * at the tasks of that object only.
  */
 #include <pbs_config.h> /* the master config generated by configure */
 
@@ -53,6 +59,7 @@
 #include "server_limits.h"
 #include "list_link.h"
 #include "work_task.h"
+#include "pbs_idx.h"
 
 /* Global Data Items: */
 
@@ -63,6 +70,194 @@ extern pbs_list_head task_list_event;	   /* list of tasks responding to an event
 extern int svr_delay_entry;
 extern time_t time_now;
 
+#define TIMED_HEAP_INC 1024
+
+static struct work_task **timed_heap = NULL; /* timed tasks, soonest first */
+static int timed_heap_cnt = 0;
+static int timed_heap_max = 0;
+static void *parm1_idx = NULL;		     /* wt_parm1 to list of its tasks */
+static unsigned long task_seq = 0;	     /* for wt_seq */
+
+/* a task taken off its work list other than here is no longer on it */
+#define TASK_LISTED(p) ((p)->wt_linkevent.ll_next != &(p)->wt_linkevent)
+
+/**
+ * @brief
+ *	Tell whether timed task a is due before timed task b
+ */
+static int
+timed_before(struct work_task *a, struct work_task *b)
+{
+	if (a->wt_event != b->wt_event)
+		return (a->wt_event < b->wt_event);
+	return (a->wt_seq < b->wt_seq);
+}
+
+/**
+ * @brief
+ *	Put the task at position i of the heap, and record the position
+ */
+static void
+timed_heap_set(int i, struct work_task *ptask)
+{
+	timed_heap[i] = ptask;
+	ptask->wt_heapidx = i;
+}
+
+/**
+ * @brief
+ *	Move the task at position i of the heap up or down to its place
+ */
+static void
+timed_heap_fix(int i)
+{
+	struct work_task *ptask = timed_heap[i];
+	int child;
+
+	while (i > 0 && timed_before(ptask, timed_heap[(i - 1) / 2])) {
+		timed_heap_set(i, timed_heap[(i - 1) / 2]);
+		i = (i - 1) / 2;
+	}
+	while ((child = 2 * i + 1) < timed_heap_cnt) {
+		if (child + 1 < timed_heap_cnt && timed_before(timed_heap[child + 1], timed_heap[child]))
+			child++;
+		if (!timed_before(timed_heap[child], ptask))
+			break;
+		timed_heap_set(i, timed_heap[child]);
+		i = child;
+	}
+	timed_heap_set(i, ptask);
+}
+
+/**
+ * @brief
+ *	Add a timed task to the heap
+ *
+ * @return int
+ * @retval 0: success
+ * @retval -1: out of memory
+ */
+static int
+timed_heap_add(struct work_task *ptask)
+{
+	if (timed_heap_cnt == timed_heap_max) {
+		struct work_task **tmp;
+
+		tmp = realloc(timed_heap, (timed_heap_max + TIMED_HEAP_INC) * sizeof(struct work_task *));
+		if (tmp == NULL)
+			return -1;
+		timed_heap = tmp;
+		timed_heap_max += TIMED_HEAP_INC;
+	}
+	timed_heap_set(timed_heap_cnt++, ptask);
+	timed_heap_fix(timed_heap_cnt - 1);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Remove a task from the heap, if in it
+ */
+static void
+timed_heap_remove(struct work_task *ptask)
+{
+	int i = ptask->wt_heapidx;
+
+	if (i < 0)
+		return;
+	ptask->wt_heapidx = -1;
+	if (--timed_heap_cnt == i)
+		return;
+	timed_heap_set(i, timed_heap[timed_heap_cnt]);
+	timed_heap_fix(i);
+}
+
+/**
+ * @brief
+ *	Put a task on a work list, and on the heap if the list is
+ *	task_list_timed
+ *
+ * @return int
+ * @retval 0: success
+ * @retval -1: out of memory
+ */
+static int
+task_list_add(pbs_list_head *list, struct work_task *ptask)
+{
+	ptask->wt_list = list;
+	ptask->wt_seq = ++task_seq;
+	if (list == &task_list_timed && timed_heap_add(ptask) != 0)
+		return -1;
+	append_link(list, &ptask->wt_linkevent, ptask);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Add a task to the list of those of its wt_parm1
+ *
+ * @return int
+ * @retval 0: success
+ * @retval -1: failure
+ */
+static int
+parm1_idx_add(struct work_task *ptask)
+{
+	void *key = &ptask->wt_parm1;
+	pbs_list_head *tasks = NULL;
+
+	if (ptask->wt_parm1 == NULL)
+		return 0;
+	if (parm1_idx == NULL && (parm1_idx = pbs_idx_create(0, sizeof(void *))) == NULL)
+		return -1;
+	if (pbs_idx_find(parm1_idx, &key, (void **) &tasks, NULL) != PBS_IDX_RET_OK) {
+		if ((tasks = malloc(sizeof(pbs_list_head))) == NULL)
+			return -1;
+		CLEAR_HEAD((*tasks));
+		if (pbs_idx_insert(parm1_idx, &ptask->wt_parm1, tasks) != PBS_IDX_RET_OK) {
+			free(tasks);
+			return -1;
+		}
+	}
+	append_link(tasks, &ptask->wt_linkparm1, ptask);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Remove a task from the list of those of its wt_parm1
+ */
+static void
+parm1_idx_remove(struct work_task *ptask)
+{
+	void *key = &ptask->wt_parm1;
+	pbs_list_head *tasks = NULL;
+
+	if (ptask->wt_parm1 == NULL || parm1_idx == NULL)
+		return;
+	delete_link(&ptask->wt_linkparm1);
+	if (pbs_idx_find(parm1_idx, &key, (void **) &tasks, NULL) != PBS_IDX_RET_OK)
+		return;
+	if (GET_NEXT((*tasks)) == NULL) {
+		pbs_idx_delete(parm1_idx, &ptask->wt_parm1);
+		free(tasks);
+	}
+}
+
+/**
+ * @brief
+ *	Take a task off its work list, the heap and the parm1 index
+ */
+static void
+task_unlink(struct work_task *ptask)
+{
+	timed_heap_remove(ptask);
+	parm1_idx_remove(ptask);
+	delete_link(&ptask->wt_linkevent);
+	delete_link(&ptask->wt_linkobj);
+	delete_link(&ptask->wt_linkobj2);
+}
+
 /**
  *
  * @brief
@@ -85,7 +280,7 @@ struct work_task *
 set_task(enum work_type type, long event_id, void (*func)(struct work_task *), void *parm)
 {
 	struct work_task *pnew;
-	struct work_task *pold;
+	pbs_list_head *list;
 
 	pnew = (struct work_task *) malloc(sizeof(struct work_task));
 	if (pnew == NULL)
@@ -93,6 +288,7 @@ set_task(enum work_type type, long event_id, void (*func)(struct work_task *), v
 	CLEAR_LINK(pnew->wt_linkevent);
 	CLEAR_LINK(pnew->wt_linkobj);
 	CLEAR_LINK(pnew->wt_linkobj2);
+	CLEAR_LINK(pnew->wt_linkparm1);
 	pnew->wt_event = event_id;
 	pnew->wt_event2 = NULL;
 	pnew->wt_type = type;
@@ -102,25 +298,26 @@ set_task(enum work_type type, long event_id, void (*func)(struct work_task *), v
 	pnew->wt_parm3 = NULL;
 	pnew->wt_aux = 0;
 	pnew->wt_aux2 = 0;
+	pnew->wt_heapidx = -1;
 
 	if (type == WORK_Immed)
-		append_link(&task_list_immed, &pnew->wt_linkevent, pnew);
+		list = &task_list_immed;
 	else if (type == WORK_Interleave)
-		append_link(&task_list_interleave, &pnew->wt_linkevent, pnew);
-	else if (type == WORK_Timed) {
-		pold = (struct work_task *) GET_NEXT(task_list_timed);
-		while (pold) {
-			if (pold->wt_event > pnew->wt_event)
-				break;
-			pold = (struct work_task *) GET_NEXT(pold->wt_linkevent);
-		}
-		if (pold)
-			insert_link(&pold->wt_linkevent, &pnew->wt_linkevent, pnew,
-				    LINK_INSET_BEFORE);
-		else
-			append_link(&task_list_timed, &pnew->wt_linkevent, pnew);
-	} else
-		append_link(&task_list_event, &pnew->wt_linkevent, pnew);
+		list = &task_list_interleave;
+	else if (type == WORK_Timed)
+		list = &task_list_timed;
+	else
+		list = &task_list_event;
+
+	if (parm1_idx_add(pnew) != 0) {
+		free(pnew);
+		return NULL;
+	}
+	if (task_list_add(list, pnew) != 0) {
+		parm1_idx_remove(pnew);
+		free(pnew);
+		return NULL;
+	}
 	return (pnew);
 }
 
@@ -155,10 +352,9 @@ convert_work_task(struct work_task *ptask, enum work_type wtype)
 			list = &task_list_event;
 	}
 
+	timed_heap_remove(ptask);
 	delete_link(&ptask->wt_linkevent);
-	append_link(list, &ptask->wt_linkevent, ptask);
-
-	return 0;
+	return (task_list_add(list, ptask));
 }
 
 /**
@@ -177,9 +373,7 @@ convert_work_task(struct work_task *ptask, enum work_type wtype)
 void
 dispatch_task(struct work_task *ptask)
 {
-	delete_link(&ptask->wt_linkevent);
-	delete_link(&ptask->wt_linkobj);
-	delete_link(&ptask->wt_linkobj2);
+	task_unlink(ptask);
 	if (ptask->wt_func)
 		ptask->wt_func(ptask); /* dispatch process function */
 	(void) free(ptask);
@@ -196,41 +390,96 @@ dispatch_task(struct work_task *ptask)
 void
 delete_task(struct work_task *ptask)
 {
-	delete_link(&ptask->wt_linkobj);
-	delete_link(&ptask->wt_linkobj2);
-	delete_link(&ptask->wt_linkevent);
+	task_unlink(ptask);
 	(void) free(ptask);
 }
 
 /**
  * @brief
- *	Check if some task in the specified task list
- *	has a wt_parm1 matching 'parm1'
- *	and wt_func matching 'func'
+ *	Check whether a task is on one of the given work lists, and comes
+ *	before another task found so far: lists are taken in the given order,
+ *	the timed list by time, the others in the order the tasks were put on.
  *
- * @param[in]	task_list - header of task list to be searched
- * @param[in]	parm1	- parameter being matched.
- * @param[in]	func	- function being matched.
+ * @param[in]	ptask	- task to check
+ * @param[in]	best	- task found so far, NULL if none
+ * @param[in]	lists	- lists to look at, NULL terminated
+ *
+ * @return int
+ * @retval	1 if ptask comes first
+ * @retval	0 otherwise
+ */
+static int
+task_comes_first(struct work_task *ptask, struct work_task *best, pbs_list_head **lists)
+{
+	int i;
+	int ip = -1;
+	int ib = -1;
+
+	if (!TASK_LISTED(ptask))
+		return 0;
+	for (i = 0; lists[i]; i++) {
+		if (ptask->wt_list == lists[i])
+			ip = i;
+		if (best && best->wt_list == lists[i])
+			ib = i;
+	}
+	if (ip == -1)
+		return 0;
+	if (best == NULL || ip < ib)
+		return 1;
+	if (ip > ib)
+		return 0;
+	if (ptask->wt_list == &task_list_timed)
+		return timed_before(ptask, best);
+	return (ptask->wt_seq < best->wt_seq);
+}
+
+/**
+ * @brief
+ *	Find the first task on the given work lists with a wt_parm1
+ *	matching 'parm1' and wt_func matching 'func'
+ *
+ * @param[in]	lists	- lists to look at, in order, NULL terminated
+ * @param[in]	parm1	- parameter being matched. NULL to ignore this field.
+ * @param[in]	func	- function being matched. NULL to ignore this field.
  *
  * @return work task
  * @retval	!NULL if 'parm1' and 'func' was matched
  * @retval	NULL otherwise
  */
 static struct work_task *
-find_worktask_by_parm_func(pbs_list_head task_list, void *parm1, void *func)
+find_worktask_by_parm_func(pbs_list_head **lists, void *parm1, void *func)
 {
 	struct work_task *ptask;
-	struct work_task *ptask_next;
-
-	for (ptask = GET_NEXT(task_list); ptask; ptask = ptask_next) {
-		ptask_next = GET_NEXT(ptask->wt_linkevent);
+	struct work_task *best = NULL;
+	pbs_list_head *tasks = NULL;
+	void *key = &parm1;
+	int i;
 
-		if (parm1 && (ptask->wt_parm1 != parm1))
-			continue;
-		if (func && (ptask->wt_func != func))
-			continue;
+	if (parm1 != NULL) {
+		if (parm1_idx == NULL || pbs_idx_find(parm1_idx, &key, (void **) &tasks, NULL) != PBS_IDX_RET_OK)
+			return NULL;
+		for (ptask = GET_NEXT((*tasks)); ptask; ptask = GET_NEXT(ptask->wt_linkparm1)) {
+			if (func && (ptask->wt_func != func))
+				continue;
+			if (task_comes_first(ptask, best, lists))
+				best = ptask;
+		}
+		return best;
+	}
 
-		return ptask;
+	for (i = 0; lists[i]; i++) {
+		for (ptask = GET_NEXT((*lists[i])); ptask; ptask = GET_NEXT(ptask->wt_linkevent)) {
+			if (func && (ptask->wt_func != func))
+				continue;
+			if (task_comes_first(ptask, best, lists))
+				best = ptask;
+			/* only the timed list is not in order */
+			if (best && lists[i] != &task_list_timed)
+				break;
+		}
+		if (best)
+			return best;
 	}
 
 	return NULL;
@@ -254,27 +503,18 @@ find_worktask_by_parm_func(pbs_list_head task_list, void *parm1, void *func)
 struct work_task *
 find_work_task(enum work_type wtype, void *parm1, void *func)
 {
-	struct work_task *ptask;
-
-	if (wtype == -1 || wtype == WORK_Immed) {
-		ptask = find_worktask_by_parm_func(task_list_immed, parm1, func);
-		if (ptask)
-			return ptask;
-	}
-
-	if (wtype == -1 || wtype == WORK_Timed) {
-		ptask = find_worktask_by_parm_func(task_list_timed, parm1, func);
-		if (ptask)
-			return ptask;
-	}
-
-	if (wtype == -1 || (wtype != WORK_Timed && wtype != WORK_Immed)) {
-		ptask = find_worktask_by_parm_func(task_list_event, parm1, func);
-		if (ptask)
-			return ptask;
-	}
-
-	return NULL;
+	pbs_list_head *lists[4];
+	int n = 0;
+
+	if (wtype == -1 || wtype == WORK_Immed)
+		lists[n++] = &task_list_immed;
+	if (wtype == -1 || wtype == WORK_Timed)
+		lists[n++] = &task_list_timed;
+	if (wtype == -1 || (wtype != WORK_Timed && wtype != WORK_Immed))
+		lists[n++] = &task_list_event;
+	lists[n] = NULL;
+
+	return (find_worktask_by_parm_func(lists, parm1, func));
 }
 
 /**
@@ -296,26 +536,15 @@ void
 delete_task_by_parm1_func(void *parm1, void (*func)(struct work_task *), enum wtask_delete_option option)
 {
 	struct work_task *ptask;
-	struct work_task *ptask_next;
-	pbs_list_head task_lists[] = {task_list_event, task_list_timed, task_list_immed};
-	int i;
+	pbs_list_head *lists[] = {&task_list_event, &task_list_timed, &task_list_immed, NULL};
 
 	if (parm1 == NULL && func == NULL)
 		return;
 
-	for (i = 0; i < 3; i++) {
-		for (ptask = (struct work_task *) GET_NEXT(task_lists[i]); ptask; ptask = ptask_next) {
-			ptask_next = (struct work_task *) GET_NEXT(ptask->wt_linkevent);
-
-			if ((parm1 != NULL) && (ptask->wt_parm1 != parm1))
-				continue;
-			if ((func != NULL) && (ptask->wt_func != func))
-				continue;
-
-			delete_task(ptask);
-			if (option == DELETE_ONE)
-				return;
-		}
+	while ((ptask = find_worktask_by_parm_func(lists, parm1, func)) != NULL) {
+		delete_task(ptask);
+		if (option == DELETE_ONE)
+			return;
 	}
 }
 
@@ -400,7 +629,13 @@ default_next_task(void)
 		tilwhen = 0;
 	}
 
-	while ((ptask = (struct work_task *) GET_NEXT(task_list_timed)) != NULL) {
+	while (timed_heap_cnt > 0) {
+		ptask = timed_heap[0];
+		if (!TASK_LISTED(ptask) || ptask->wt_list != &task_list_timed) {
+			/* taken off task_list_timed by its owner */
+			timed_heap_remove(ptask);
+			continue;
+		}
 		if ((delay = ptask->wt_event - time_now) > 0) {
 			if (tilwhen > delay)
 				tilwhen = delay;
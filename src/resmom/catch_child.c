@@ -901,6 +901,9 @@ send_hellosvr(int stream)
 
 	if ((rc = diswui(stream, pbs_mom_port)) != DIS_SUCCESS)
 		goto err;
+	/* offer binary DIS, an older server ignores this */
+	if (pbs_conf.pbs_dis_binary && (rc = diswui(stream, DIS_BINARY_VERSION)) != DIS_SUCCESS)
+		goto err;
 	if ((rc = dis_flush(stream)) != DIS_SUCCESS)
 		goto err;
 
@@ -140,6 +140,7 @@ extern int exiting_tasks;
 extern vnl_t *vnlp;
 
 extern time_t time_now;
+extern pbs_list_head svr_alljobs;
 
 /*
  ** external functions and data
@@ -1062,6 +1063,503 @@ mom_get_sample(void)
 	return (PBSE_NONE);
 }
 
+/*
+ * Job-scoped sampling
+ *
+ * Rather than scanning all of /proc, mom_get_job_sample() takes the
+ * processes of the job tasks from the cgroup the task session leaders
+ * were put in, and reads their stat files through descriptors kept open
+ * from one sample to the next.  The cost of a sample then follows the
+ * number of job processes, not that of all processes on the host.
+ * At most MAX_PROC_FDS descriptors are kept, the stat files of any other
+ * processes are opened and closed on each sample.
+ */
+#define MAX_PROC_FDS 1024
+
+typedef struct proc_fd {
+	pid_t pid; /* process id */
+	int fd;	   /* open /proc/<pid>/stat, -1 if not open */
+} proc_fd_t;
+
+static proc_fd_t *proc_fds = NULL; /* open stat files, sorted by pid */
+static int nproc_fds = 0;
+
+static char cgroup2_mount[MAXPATHLEN + 1];	/* cgroup v2 mount point */
+static char cgroup1_mount[MAXPATHLEN + 1];	/* cgroup v1 cpuacct mount point */
+static int cgroup_mounts_read = 0;
+
+/**
+ * @brief
+ *	Find where cgroups are mounted, once.
+ *
+ * @return	Void
+ *
+ */
+static void
+get_cgroup_mounts(void)
+{
+	FILE *fp;
+	char line[2 * MAXPATHLEN + 1];
+	char dev[MAXPATHLEN + 1];
+	char dir[MAXPATHLEN + 1];
+	char type[64];
+	char opts[MAXPATHLEN + 1];
+
+	if (cgroup_mounts_read)
+		return;
+	cgroup_mounts_read = 1;
+
+	if ((fp = fopen("/proc/self/mounts", "r")) == NULL)
+		return;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (sscanf(line, "%1024s %1024s %63s %1024s", dev, dir, type, opts) != 4)
+			continue;
+		if (strcmp(type, "cgroup2") == 0 && cgroup2_mount[0] == '\0')
+			pbs_strncpy(cgroup2_mount, dir, sizeof(cgroup2_mount));
+		else if (strcmp(type, "cgroup") == 0 && strstr(opts, "cpuacct") != NULL)
+			pbs_strncpy(cgroup1_mount, dir, sizeof(cgroup1_mount));
+	}
+	fclose(fp);
+}
+
+/**
+ * @brief
+ *	Tell whether a cgroup path has the job id as one of its directories,
+ *	as in the paths made by the cgroups hook.  Job 1.host must not match
+ *	the cgroup of job 11.host.
+ *
+ * @param[in] cg - cgroup path, relative to the mount point
+ * @param[in] jobid - job id
+ *
+ * @return	int
+ * @retval	1	the cgroup is that of the job, or below it
+ * @retval	0	it is not
+ *
+ */
+static int
+cgroup_names_job(const char *cg, const char *jobid)
+{
+	size_t len = strlen(jobid);
+	const char *p = cg;
+
+	while ((p = strchr(p, '/')) != NULL) {
+		p++;
+		if (strncmp(p, jobid, len) == 0 && (p[len] == '/' || p[len] == '\0'))
+			return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ *	Get the path of the cgroup.procs file of the cgroup of a job task.
+ *	Only a cgroup named after the job (as made by the cgroups hook) is
+ *	taken, anything else could hold processes of other jobs.
+ *
+ * @param[in] pjob - job pointer
+ * @param[in] sid - session id of the task
+ * @param[out] path - cgroup.procs path
+ * @param[in] len - size of path
+ *
+ * @return	int
+ * @retval	0	path set
+ * @retval	-1	task is not in a cgroup of its own job
+ *
+ */
+static int
+job_cgroup_procs(job *pjob, pid_t sid, char *path, size_t len)
+{
+	FILE *fp;
+	char fname[MAXPATHLEN + 1];
+	char line[MAXPATHLEN + 1];
+	char *cg = NULL;
+	char *mount = NULL;
+	char *p;
+
+	get_cgroup_mounts();
+
+	snprintf(fname, sizeof(fname), "%s/%d/cgroup", procfs, (int) sid);
+	if ((fp = fopen(fname, "r")) == NULL)
+		return -1;
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if ((p = strchr(line, '\n')) != NULL)
+			*p = '\0';
+		/* lines are "hierarchy:controllers:path" */
+		if (strncmp(line, "0::", 3) == 0 && cgroup2_mount[0] != '\0') {
+			cg = line + 3;
+			mount = cgroup2_mount;
+		} else if (cgroup1_mount[0] != '\0' &&
+			   (p = strchr(line, ':')) != NULL &&
+			   strstr(p, "cpuacct") != NULL &&
+			   (cg = strchr(p + 1, ':')) != NULL) {
+			cg++;
+			mount = cgroup1_mount;
+		} else
+			continue;
+		if (cgroup_names_job(cg, pjob->ji_qs.ji_jobid))
+			break;
+		cg = NULL;
+	}
+	fclose(fp);
+
+	if (cg == NULL)
+		return -1;
+	if (snprintf(path, len, "%s%s/cgroup.procs", mount, cg) >= (int) len)
+		return -1;
+	return 0;
+}
+
+/**
+ * @brief
+ *	Add the processes of a cgroup to a list of pids.
+ *
+ * @param[in] path - cgroup.procs path
+ * @param[in,out] pids - list of pids, grown as needed
+ * @param[in,out] npids - entries in pids
+ * @param[in,out] maxpids - size of pids
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	Error
+ *
+ */
+static int
+read_cgroup_procs(char *path, pid_t **pids, int *npids, int *maxpids)
+{
+	FILE *fp;
+	long pid;
+
+	if ((fp = fopen(path, "r")) == NULL)
+		return -1;
+	while (fscanf(fp, "%ld", &pid) == 1) {
+		if (*npids == *maxpids) {
+			pid_t *hold;
+
+			*maxpids += TBL_INC;
+			hold = realloc(*pids, *maxpids * sizeof(pid_t));
+			assert(hold != NULL);
+			*pids = hold;
+		}
+		(*pids)[(*npids)++] = (pid_t) pid;
+	}
+	fclose(fp);
+	return 0;
+}
+
+static int
+pid_cmp(const void *a, const void *b)
+{
+	pid_t pa = *(const pid_t *) a;
+	pid_t pb = *(const pid_t *) b;
+
+	return (pa < pb) ? -1 : (pa > pb);
+}
+
+/**
+ * @brief
+ *	Keep stat files open for exactly the given processes,
+ *	closing those of processes no longer listed.
+ *
+ * @param[in] pids - sorted, unique pids
+ * @param[in] npids - number of pids
+ *
+ * @return	Void
+ *
+ */
+static void
+update_proc_fds(pid_t *pids, int npids)
+{
+	proc_fd_t *nfds;
+	int i, j;
+
+	nfds = (proc_fd_t *) malloc((npids + 1) * sizeof(proc_fd_t));
+	assert(nfds != NULL);
+
+	/* both lists are sorted by pid, keep the descriptors in common */
+	for (i = 0, j = 0; i < npids; i++) {
+		while (j < nproc_fds && proc_fds[j].pid < pids[i]) {
+			if (proc_fds[j].fd != -1)
+				close(proc_fds[j].fd);
+			j++;
+		}
+		nfds[i].pid = pids[i];
+		if (j < nproc_fds && proc_fds[j].pid == pids[i])
+			nfds[i].fd = proc_fds[j++].fd;
+		else
+			nfds[i].fd = -1;
+	}
+	for (; j < nproc_fds; j++) {
+		if (proc_fds[j].fd != -1)
+			close(proc_fds[j].fd);
+	}
+
+	free(proc_fds);
+	proc_fds = nfds;
+	nproc_fds = npids;
+}
+
+/**
+ * @brief
+ *	Close the stat files kept open by mom_get_job_sample(), keeping
+ *	the list of processes.
+ *
+ * @return	Void
+ *
+ */
+static void
+release_proc_fds(void)
+{
+	int i;
+
+	for (i = 0; i < nproc_fds; i++) {
+		if (proc_fds[i].fd != -1) {
+			close(proc_fds[i].fd);
+			proc_fds[i].fd = -1;
+		}
+	}
+}
+
+/**
+ * @brief
+ *	Close the stat files kept open by mom_get_job_sample().
+ *
+ * @return	Void
+ *
+ */
+static void
+close_proc_fds(void)
+{
+	release_proc_fds();
+	free(proc_fds);
+	proc_fds = NULL;
+	nproc_fds = 0;
+}
+
+/**
+ * @brief
+ *	Parse an open stat file of a process into a proc_info entry, the
+ *	same way mom_get_sample() does.
+ *
+ * @param[in] fd - open /proc/<pid>/stat
+ * @param[out] ps - entry to fill
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	process is gone, root-owned or unreadable
+ *
+ */
+static int
+parse_proc_stat(int fd, proc_stat_t *ps)
+{
+	char buf[2 * MAXPATHLEN + 1];
+	char comm[MAXPATHLEN + 1];
+	unsigned long long starttime;
+	struct stat sb;
+	char *stat_str;
+	ssize_t len;
+
+	/* ownership may change, so is checked on each sample */
+	if (fstat(fd, &sb) == -1 || sb.st_uid == 0)
+		return -1;
+	if ((len = pread(fd, buf, sizeof(buf) - 1, 0)) <= 0)
+		return -1; /* ESRCH once the process has exited */
+	buf[len] = '\0';
+
+	if ((stat_str = choose_procflagsfmt()) == NULL)
+		return -1;
+	if (sscanf(buf, stat_str,
+		   &ps->pid, comm, &ps->state, &ps->ppid, &ps->pgrp,
+		   &ps->session, &ps->flags, &ps->utime, &ps->stime,
+		   &ps->cutime, &ps->cstime, &starttime, &ps->vsize,
+		   &ps->rss) != 14)
+		return -1;
+
+	ps->uid = sb.st_uid;
+	ps->start_time = linux_time + (starttime / hz);
+	snprintf(ps->comm, sizeof(ps->comm), "%.*s",
+		 (int) (sizeof(ps->comm) - 1), comm);
+	ps->utime = JTOS(ps->utime);
+	ps->stime = JTOS(ps->stime);
+	ps->cutime = JTOS(ps->cutime);
+	ps->cstime = JTOS(ps->cstime);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Read the stat of a process into a proc_info entry.
+ *
+ * @param[in,out] pfd - stat file of the process, opened if need be
+ * @param[out] ps - entry to fill
+ * @param[in] keep - keep the stat file open for the next sample
+ *
+ * @return	int
+ * @retval	0	Success
+ * @retval	-1	process is gone, root-owned or unreadable
+ * @retval	-2	out of file descriptors, the process was not read
+ *
+ */
+static int
+read_proc_stat(proc_fd_t *pfd, proc_stat_t *ps, int keep)
+{
+	char fname[MAXPATHLEN + 1];
+	int fd = pfd->fd;
+	int rc;
+
+	if (fd == -1) {
+		snprintf(fname, sizeof(fname), "%s/%d/stat", procfs, (int) pfd->pid);
+		if ((fd = open(fname, O_RDONLY | O_CLOEXEC)) == -1)
+			return ((errno == EMFILE || errno == ENFILE) ? -2 : -1);
+		if (keep)
+			pfd->fd = fd;
+	}
+	rc = parse_proc_stat(fd, ps);
+	if (pfd->fd != fd)
+		close(fd);
+	return rc;
+}
+
+/**
+ * @brief
+ * 	Sample the processes of the jobs only.
+ *	The proc table is filled with the processes in the cgroups of the
+ *	job tasks, which is all that cput_sum(), mem_sum(), resi_sum() and
+ *	kill_session() of a job task look at.  If a task is not in a cgroup
+ *	of its job, or a stat file cannot be opened for lack of descriptors,
+ *	all of /proc is sampled by mom_get_sample().
+ *
+ * @return	int
+ * @retval	PBSE_INTERNAL	Error
+ * @retval	PBSE_NONE	Success
+ *
+ */
+int
+mom_get_job_sample(void)
+{
+	static pid_t *pids = NULL;
+	static int maxpids = 0;
+	static char **cgpaths = NULL;
+	static int maxcgpaths = 0;
+	int npids = 0;
+	int ncgpaths = 0;
+	int ngone = 0;
+	int nopen = 0;
+	int was_open;
+	int rc;
+	int i, j;
+	char path[MAXPATHLEN + 1];
+	job *pjob;
+	task *ptask;
+	extern time_t time_last_sample;
+
+	/* There are no job tasks created in mock run mode, so no need to walk the proc table */
+	if (mock_run)
+		return PBSE_NONE;
+
+	DBPRT(("%s: entered\n", __func__))
+	if (hz == 0)
+		hz = sysconf(_SC_CLK_TCK);
+
+	for (pjob = (job *) GET_NEXT(svr_alljobs);
+	     pjob != NULL;
+	     pjob = (job *) GET_NEXT(pjob->ji_alljobs)) {
+		for (ptask = (task *) GET_NEXT(pjob->ji_tasks);
+		     ptask != NULL;
+		     ptask = (task *) GET_NEXT(ptask->ti_jobtask)) {
+			if (ptask->ti_qs.ti_sid <= 1)
+				continue;
+			if (job_cgroup_procs(pjob, ptask->ti_qs.ti_sid, path, sizeof(path)) != 0) {
+				log_event(PBSEVENT_DEBUG4, PBS_EVENTCLASS_JOB, LOG_DEBUG, pjob->ji_qs.ji_jobid,
+					  "task not in a job cgroup, sampling all processes");
+				for (i = 0; i < ncgpaths; i++)
+					free(cgpaths[i]);
+				return (mom_get_sample());
+			}
+
+			/* tasks of a job usually share its cgroup */
+			for (i = 0; i < ncgpaths; i++) {
+				if (strcmp(cgpaths[i], path) == 0)
+					break;
+			}
+			if (i < ncgpaths)
+				continue;
+			if (ncgpaths == maxcgpaths) {
+				char **hold;
+
+				maxcgpaths += TBL_INC;
+				hold = realloc(cgpaths, maxcgpaths * sizeof(char *));
+				assert(hold != NULL);
+				cgpaths = hold;
+			}
+			cgpaths[ncgpaths] = strdup(path);
+			assert(cgpaths[ncgpaths] != NULL);
+			ncgpaths++;
+			(void) read_cgroup_procs(path, &pids, &npids, &maxpids);
+		}
+	}
+	for (i = 0; i < ncgpaths; i++)
+		free(cgpaths[i]);
+
+	/* a process is listed once even if found through two tasks */
+	qsort(pids, npids, sizeof(pid_t), pid_cmp);
+	for (i = 0, j = 0; i < npids; i++) {
+		if (j == 0 || pids[j - 1] != pids[i])
+			pids[j++] = pids[i];
+	}
+	npids = j;
+	update_proc_fds(pids, npids);
+
+	if (npids >= max_proc) {
+		void *hold;
+
+		max_proc = npids + TBL_INC;
+		hold = realloc((void *) proc_info, max_proc * sizeof(proc_stat_t));
+		assert(hold != NULL);
+		proc_info = (proc_stat_t *) hold;
+	}
+
+	nproc = 0;
+	time_last_sample = time(0);
+	sampletime_floor = time_last_sample;
+	for (i = 0; i < nproc_fds; i++) {
+		if (proc_fds[i].fd != -1)
+			nopen++;
+	}
+	for (i = 0; i < nproc_fds; i++) {
+		was_open = (proc_fds[i].fd != -1);
+		rc = read_proc_stat(&proc_fds[i], &proc_info[nproc], nopen < MAX_PROC_FDS);
+		if (rc == -2) {
+			/* give the kept descriptors back and read the process once */
+			release_proc_fds();
+			nopen = 0;
+			rc = read_proc_stat(&proc_fds[i], &proc_info[nproc], 0);
+			if (rc == -2) {
+				log_event(PBSEVENT_DEBUG4, 0, LOG_DEBUG, __func__,
+					  "out of file descriptors, sampling all processes");
+				return (mom_get_sample());
+			}
+		}
+		if (!was_open && proc_fds[i].fd != -1)
+			nopen++;
+		if (rc != 0) {
+			if (proc_fds[i].fd != -1) {
+				close(proc_fds[i].fd);
+				proc_fds[i].fd = -1;
+				nopen--;
+			}
+			ngone++;
+			continue;
+		}
+		nproc++;
+	}
+	sampletime_ceil = time_last_sample;
+
+	sprintf(log_buffer, "cgroups:  %d, nprocs:  %d, gone:  %d, open:  %d",
+		ncgpaths, nproc, ngone, nopen);
+	log_event(PBSEVENT_DEBUG4, 0, LOG_DEBUG, __func__, log_buffer);
+	return (PBSE_NONE);
+}
+
 /**
  * @brief
  * 	Update the resources used.<attributes> of a job.
@@ -1399,6 +1897,7 @@ mom_close_poll(void)
 		proc_info = NULL;
 		max_proc = 0;
 	}
+	close_proc_fds();
 
 	return (PBSE_NONE);
 }
@@ -8647,7 +8647,7 @@ main(int argc, char *argv[])
 		/* there are jobs so update status	 */
 		/* if we just got a sample, don't bother */
 		if (time_now > time_last_sample) {
-			if (mom_get_sample() != PBSE_NONE)
+			if (mom_get_job_sample() != PBSE_NONE)
 				continue;
 		}
 
@@ -0,0 +1,324 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    bitmap_bench.cpp
+ *
+ * @brief
+ * 		bitmap_bench.cpp - microbenchmark of the node bucket bitmaps.
+ *		Runs what bucket_match() does to the bitmaps of a bucket over a
+ *		large bitmap both a bit at a time (the way it used to be done) and
+ *		with the whole-long pbs_bitmap operations, checks both give the
+ *		same bitmaps, and reports the time each took.
+ *
+ *	usage: pbs_sched_bitmap_bench [-n num_nodes] [-r repetitions] [-d percent_free]
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "pbs_bitmap.h"
+
+#define BENCH_DEFAULT_NODES 100000
+#define BENCH_DEFAULT_REPS 1000
+#define BENCH_DEFAULT_FREE 50
+
+/**
+ * @brief
+ * 		current wall clock time in seconds
+ *
+ * @return	double
+ */
+static double
+bench_time(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/**
+ * @brief
+ * 		the next on bit after start_bit.  This is how pbs_bitmap_next_on_bit()
+ *		used to find it: skip longs which are 0, then test a bit at a time.
+ *
+ * @param[in]	bm	-	the bitmap
+ * @param[in]	start_bit	-	bit to start after
+ *
+ * @return	int
+ * @retval	next on bit
+ * @retval	-1	: no more on bits
+ */
+static int
+bit_next_on_bit(pbs_bitmap *bm, unsigned long start_bit)
+{
+	const unsigned long bits_per_long = 8 * sizeof(unsigned long);
+	unsigned long long_ind;
+	unsigned long i;
+
+	if (start_bit >= bm->num_bits)
+		return -1;
+
+	long_ind = start_bit / bits_per_long;
+	if (bm->bits[long_ind] != 0) {
+		for (i = start_bit % bits_per_long + 1; i < bits_per_long; i++)
+			if (bm->bits[long_ind] & (1UL << i))
+				return long_ind * bits_per_long + i;
+		long_ind++;
+	}
+
+	for (; long_ind < bm->num_longs && bm->bits[long_ind] == 0; long_ind++)
+		;
+	if (long_ind == bm->num_longs)
+		return -1;
+
+	for (i = 0; i < bits_per_long; i++)
+		if (bm->bits[long_ind] & (1UL << i))
+			return long_ind * bits_per_long + i;
+
+	return -1;
+}
+
+/**
+ * @brief
+ * 		L = R one long at a time, with the old bound checks
+ *
+ * @param[in,out]	L	-	bitmap lvalue
+ * @param[in]	R	-	bitmap rvalue
+ *
+ * @return	void
+ */
+static void
+bit_assign(pbs_bitmap *L, pbs_bitmap *R)
+{
+	unsigned long i;
+
+	for (i = 0; i < R->num_longs; i++)
+		L->bits[i] = R->bits[i];
+	for (; i < L->num_longs; i++)
+		L->bits[i] = 0;
+	L->num_bits = R->num_bits;
+}
+
+/**
+ * @brief
+ * 		move the first n on bits of from to to and to2, one bit at a time
+ *
+ * @return	number of bits moved
+ */
+static unsigned long
+bit_move_on_bits(pbs_bitmap *from, pbs_bitmap *to, pbs_bitmap *to2, unsigned long n)
+{
+	unsigned long moved = 0;
+	int k;
+
+	for (k = pbs_bitmap_get_bit(from, 0) ? 0 : bit_next_on_bit(from, 0);
+	     moved < n && k >= 0; k = bit_next_on_bit(from, k)) {
+		pbs_bitmap_bit_off(from, k);
+		pbs_bitmap_bit_on(to, k);
+		pbs_bitmap_bit_on(to2, k);
+		moved++;
+	}
+	return moved;
+}
+
+/**
+ * @brief
+ * 		The entry point of pbs_sched_bitmap_bench
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	1	: the bitmaps differ or error
+ */
+int
+main(int argc, char *argv[])
+{
+	int num_nodes = BENCH_DEFAULT_NODES;
+	int reps = BENCH_DEFAULT_REPS;
+	int pct_free = BENCH_DEFAULT_FREE;
+	unsigned long takes[] = {1, 64, 1000, 0};
+	pbs_bitmap *truth;
+	pbs_bitmap *free_w[2];
+	pbs_bitmap *busy_w[2];
+	pbs_bitmap *node_bits[2];
+	unsigned long ct[2];
+	double start;
+	double bit_time;
+	double word_time;
+	int mismatch = 0;
+	int c;
+	int i;
+	int r;
+	int k;
+
+	while ((c = getopt(argc, argv, "n:r:d:")) != -1) {
+		switch (c) {
+			case 'n':
+				num_nodes = atoi(optarg);
+				break;
+			case 'r':
+				reps = atoi(optarg);
+				break;
+			case 'd':
+				pct_free = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-n num_nodes] [-r repetitions] [-d percent_free]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (num_nodes < 1 || reps < 1)
+		return 1;
+	takes[3] = num_nodes;
+
+	truth = pbs_bitmap_alloc(NULL, num_nodes);
+	srandom(1);
+	for (i = 0; i < num_nodes; i++)
+		if (random() % 100 < pct_free)
+			pbs_bitmap_bit_on(truth, i);
+	for (i = 0; i < 2; i++) {
+		free_w[i] = pbs_bitmap_alloc(NULL, num_nodes);
+		busy_w[i] = pbs_bitmap_alloc(NULL, num_nodes);
+		node_bits[i] = pbs_bitmap_alloc(NULL, num_nodes);
+	}
+
+	printf("nodes: %d\n", num_nodes);
+	printf("repetitions: %d\n", reps);
+
+	/* count the free nodes */
+	start = bench_time();
+	for (r = 0; r < reps; r++)
+		for (ct[0] = 0, k = pbs_bitmap_get_bit(truth, 0) ? 0 : bit_next_on_bit(truth, 0); k >= 0; k = bit_next_on_bit(truth, k))
+			ct[0]++;
+	bit_time = bench_time() - start;
+	start = bench_time();
+	for (r = 0; r < reps; r++)
+		ct[1] = pbs_bitmap_count(truth);
+	word_time = bench_time() - start;
+	printf("free nodes: %lu\n", ct[1]);
+	printf("count bit: %.3fs word: %.3fs\n", bit_time, word_time);
+	if (ct[0] != ct[1])
+		mismatch++;
+
+	/* walk the free nodes */
+	start = bench_time();
+	for (r = 0; r < reps; r++)
+		for (ct[0] = 0, k = pbs_bitmap_first_on_bit(truth); k >= 0; k = bit_next_on_bit(truth, k))
+			ct[0]++;
+	bit_time = bench_time() - start;
+	start = bench_time();
+	for (r = 0; r < reps; r++)
+		for (ct[1] = 0, k = pbs_bitmap_first_on_bit(truth); k >= 0; k = pbs_bitmap_next_on_bit(truth, k))
+			ct[1]++;
+	word_time = bench_time() - start;
+	printf("walk bit: %.3fs word: %.3fs\n", bit_time, word_time);
+	if (ct[0] != ct[1])
+		mismatch++;
+
+	/* set_working_bucket_to_truth() */
+	start = bench_time();
+	for (r = 0; r < reps; r++)
+		bit_assign(free_w[0], truth);
+	bit_time = bench_time() - start;
+	start = bench_time();
+	for (r = 0; r < reps; r++)
+		pbs_bitmap_assign(free_w[1], truth);
+	word_time = bench_time() - start;
+	printf("copy bit: %.3fs word: %.3fs\n", bit_time, word_time);
+	if (!pbs_bitmap_is_equal(free_w[0], free_w[1]))
+		mismatch++;
+
+	/* take nodes from the free pool the way bucket_match() does */
+	for (i = 0; i < static_cast<int>(sizeof(takes) / sizeof(takes[0])); i++) {
+		bit_time = 0;
+		word_time = 0;
+		for (r = 0; r < reps; r++) {
+			pbs_bitmap_assign(free_w[0], truth);
+			pbs_bitmap_clear(busy_w[0]);
+			pbs_bitmap_clear(node_bits[0]);
+			start = bench_time();
+			ct[0] = bit_move_on_bits(free_w[0], busy_w[0], node_bits[0], takes[i]);
+			bit_time += bench_time() - start;
+
+			pbs_bitmap_assign(free_w[1], truth);
+			pbs_bitmap_clear(busy_w[1]);
+			pbs_bitmap_clear(node_bits[1]);
+			start = bench_time();
+			ct[1] = pbs_bitmap_move_on_bits(free_w[1], busy_w[1], node_bits[1], takes[i]);
+			word_time += bench_time() - start;
+		}
+		printf("take %lu bit: %.3fs word: %.3fs\n", takes[i], bit_time, word_time);
+		if (ct[0] != ct[1] || !pbs_bitmap_is_equal(free_w[0], free_w[1]) ||
+		    !pbs_bitmap_is_equal(busy_w[0], busy_w[1]) || !pbs_bitmap_is_equal(node_bits[0], node_bits[1]))
+			mismatch++;
+	}
+
+	/* the whole-bitmap operations against their definition */
+	pbs_bitmap_assign(free_w[0], truth);
+	pbs_bitmap_assign(free_w[1], truth);
+	pbs_bitmap_clear(busy_w[0]);
+	for (i = 0; i < num_nodes; i += 3)
+		pbs_bitmap_bit_on(busy_w[0], i);
+	start = bench_time();
+	for (r = 0; r < reps; r++) {
+		pbs_bitmap_or(free_w[1], busy_w[0]);
+		pbs_bitmap_andnot(free_w[1], busy_w[0]);
+		pbs_bitmap_and(free_w[1], truth);
+	}
+	word_time = bench_time() - start;
+	for (i = 0; i < num_nodes; i++)
+		if (pbs_bitmap_get_bit(free_w[1], i) != (pbs_bitmap_get_bit(truth, i) && !pbs_bitmap_get_bit(busy_w[0], i)))
+			mismatch++;
+	printf("or+andnot+and word: %.3fs\n", word_time);
+	printf("mismatches: %d\n", mismatch);
+
+	pbs_bitmap_free(truth);
+	for (i = 0; i < 2; i++) {
+		pbs_bitmap_free(free_w[i]);
+		pbs_bitmap_free(busy_w[i]);
+		pbs_bitmap_free(node_bits[i]);
+	}
+
+	return mismatch != 0;
+}
@@ -641,26 +641,18 @@ bucket_match(chunk_map **cmap, resource_resv *resresv, schd_error *err)
 	int i;
 	int j;
 	int k;
-	static pbs_bitmap *zeromap = NULL;
 	server_info *sinfo;
 
 	if (cmap == NULL || resresv == NULL || resresv->select == NULL)
 		return 0;
 
-	if (zeromap == NULL) {
-		zeromap = pbs_bitmap_alloc(NULL, 1);
-		if (zeromap == NULL)
-			return 0;
-	}
-
 	sinfo = resresv->server;
 
 	for (i = 0; cmap[i] != NULL; i++) {
 		if (cmap[i]->bkt_cnts != NULL) {
-			for (j = 0; cmap[i]->bkt_cnts[j] != NULL; j++) {
+			for (j = 0; cmap[i]->bkt_cnts[j] != NULL; j++)
 				set_working_bucket_to_truth(cmap[i]->bkt_cnts[j]->bkt);
-				pbs_bitmap_assign(cmap[i]->node_bits, zeromap);
-			}
+			pbs_bitmap_clear(cmap[i]->node_bits);
 		}
 	}
 
@@ -695,23 +687,40 @@ bucket_match(chunk_map **cmap, resource_resv *resresv, schd_error *err)
 				}
 			}
 
-			for (k = pbs_bitmap_first_on_bit(bkt->free_pool->working);
-			     num_chunks_needed > chunks_added && k >= 0;
-			     k = pbs_bitmap_next_on_bit(bkt->free_pool->working, k)) {
-				clear_schd_error(err);
-				if (resresv->aoename != NULL) {
-					if (sinfo->unordered_nodes[k]->current_aoe == NULL ||
-					    strcmp(sinfo->unordered_nodes[k]->current_aoe, resresv->aoename) != 0)
-						if (is_provisionable(sinfo->unordered_nodes[k], resresv, err) == NOT_PROVISIONABLE) {
-							continue;
-						}
+			if (resresv->aoename == NULL && cmap[i]->bkt_cnts[j]->chunk_count > 0) {
+				/* Any free node will do, so take the nodes a long at a time */
+				int chunk_count = cmap[i]->bkt_cnts[j]->chunk_count;
+				int nodes_needed = (num_chunks_needed - chunks_added + chunk_count - 1) / chunk_count;
+
+				if (nodes_needed > 0) {
+					int moved = pbs_bitmap_move_on_bits(bkt->free_pool->working, bkt->busy_pool->working,
+									    cmap[i]->node_bits, nodes_needed);
+					if (moved > 0) {
+						clear_schd_error(err);
+						bkt->free_pool->working_ct -= moved;
+						bkt->busy_pool->working_ct += moved;
+						chunks_added += moved * chunk_count;
+					}
+				}
+			} else {
+				for (k = pbs_bitmap_first_on_bit(bkt->free_pool->working);
+				     num_chunks_needed > chunks_added && k >= 0;
+				     k = pbs_bitmap_next_on_bit(bkt->free_pool->working, k)) {
+					clear_schd_error(err);
+					if (resresv->aoename != NULL) {
+						if (sinfo->unordered_nodes[k]->current_aoe == NULL ||
+						    strcmp(sinfo->unordered_nodes[k]->current_aoe, resresv->aoename) != 0)
+							if (is_provisionable(sinfo->unordered_nodes[k], resresv, err) == NOT_PROVISIONABLE) {
+								continue;
+							}
+					}
+					pbs_bitmap_bit_off(bkt->free_pool->working, k);
+					bkt->free_pool->working_ct--;
+					pbs_bitmap_bit_on(bkt->busy_pool->working, k);
+					bkt->busy_pool->working_ct++;
+					pbs_bitmap_bit_on(cmap[i]->node_bits, k);
+					chunks_added += cmap[i]->bkt_cnts[j]->chunk_count;
 				}
-				pbs_bitmap_bit_off(bkt->free_pool->working, k);
-				bkt->free_pool->working_ct--;
-				pbs_bitmap_bit_on(bkt->busy_pool->working, k);
-				bkt->busy_pool->working_ct++;
-				pbs_bitmap_bit_on(cmap[i]->node_bits, k);
-				chunks_added += cmap[i]->bkt_cnts[j]->chunk_count;
 			}
 
 			if (chunks_added > 0)
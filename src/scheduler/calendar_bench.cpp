@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    calendar_bench.cpp
+ *
+ * @brief
+ * 		calendar_bench.cpp - microbenchmark of the scheduler calendar.
+ *		Builds a calendar of running jobs and calendared top jobs both
+ *		the old way (walking the sorted list to insert) and through the
+ *		calendar's time index, looks events up both ways the way nodes'
+ *		event lists are duplicated, checks the two calendars are in the
+ *		same order, and reports the time each took.
+ *
+ *	usage: pbs_sched_calendar_bench [-n num_running] [-t num_top_jobs] [-l num_lookups]
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include <vector>
+
+#include <log.h>
+#include "data_types.h"
+#include "constant.h"
+#include "resource_resv.h"
+#include "simulate.h"
+
+#define BENCH_DEFAULT_RUNNING 50000
+#define BENCH_DEFAULT_TOP_JOBS 100
+#define BENCH_DEFAULT_LOOKUPS 2000
+
+/**
+ * @brief
+ * 		current wall clock time in seconds
+ *
+ * @return	double
+ */
+static double
+bench_time(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/**
+ * @brief
+ * 		create the run and end events of a job
+ *
+ * @param[in]	resresv	-	the job
+ * @param[in]	running	-	the job is running and only needs an end event
+ * @param[out]	events	-	the created events are appended here
+ *
+ * @return	void
+ */
+static void
+bench_create_events(resource_resv *resresv, bool running, std::vector<timed_event *> &events)
+{
+	if (!running)
+		events.push_back(create_event(TIMED_RUN_EVENT, resresv->start, resresv, NULL, NULL));
+	events.push_back(create_event(TIMED_END_EVENT, resresv->end, resresv, NULL, NULL));
+}
+
+/**
+ * @brief
+ * 		The entry point of pbs_sched_calendar_bench
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	1	: calendars differ or error
+ */
+int
+main(int argc, char *argv[])
+{
+	int num_running = BENCH_DEFAULT_RUNNING;
+	int num_top = BENCH_DEFAULT_TOP_JOBS;
+	int num_lookups = BENCH_DEFAULT_LOOKUPS;
+	std::vector<resource_resv *> jobs;
+	std::vector<timed_event *> list_events;
+	std::vector<timed_event *> index_events;
+	timed_event *list = NULL;
+	timed_event *te;
+	timed_event *te2;
+	event_list *calendar;
+	time_t now = 1600000000;
+	double start;
+	double list_time;
+	double index_time;
+	int mismatch = 0;
+	int step;
+	int c;
+	int i;
+
+	while ((c = getopt(argc, argv, "n:t:l:")) != -1) {
+		switch (c) {
+			case 'n':
+				num_running = atoi(optarg);
+				break;
+			case 't':
+				num_top = atoi(optarg);
+				break;
+			case 'l':
+				num_lookups = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-n num_running] [-t num_top_jobs] [-l num_lookups]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	/* Running jobs end on minute boundaries over the next day, so many of
+	 * them end at the same time.  Top jobs start when running jobs end.
+	 */
+	for (i = 0; i < num_running + num_top; i++) {
+		char name[PBS_MAXSVRJOBID + 1];
+
+		snprintf(name, sizeof(name), "%d.bench", i);
+		auto resresv = new resource_resv(name);
+		resresv->is_job = 1;
+		if (i < num_running) {
+			resresv->start = now - 60 * (i % 97);
+			resresv->end = now + 60 * (1 + (i * 7919L) % 1440);
+		} else {
+			resresv->start = now + 60 * (1 + (i * 104729L) % 1440);
+			resresv->end = resresv->start + 3600 * (1 + i % 24);
+		}
+		jobs.push_back(resresv);
+	}
+
+	for (i = 0; i < num_running + num_top; i++)
+		bench_create_events(jobs[i], i < num_running, list_events);
+	for (i = 0; i < num_running + num_top; i++)
+		bench_create_events(jobs[i], i < num_running, index_events);
+
+	printf("running jobs: %d\n", num_running);
+	printf("top jobs: %d\n", num_top);
+	printf("events: %d\n", static_cast<int>(list_events.size()));
+
+	start = bench_time();
+	for (auto e : list_events)
+		list = add_timed_event(list, e);
+	list_time = bench_time() - start;
+
+	calendar = new_event_list();
+	calendar->current_time = &now;
+	start = bench_time();
+	for (auto e : index_events)
+		add_event(calendar, e);
+	index_time = bench_time() - start;
+
+	printf("build list: %.3fs\n", list_time);
+	printf("build index: %.3fs\n", index_time);
+	if (index_time > 0)
+		printf("build speedup: %.1fx\n", list_time / index_time);
+
+	for (te = list, te2 = calendar->events; te != NULL && te2 != NULL; te = te->next, te2 = te2->next) {
+		if (te->name != te2->name || te->event_type != te2->event_type) {
+			if (mismatch < 10)
+				printf("mismatch: list %s/%d index %s/%d\n", te->name.c_str(),
+				       te->event_type, te2->name.c_str(), te2->event_type);
+			mismatch++;
+		}
+	}
+	if (te != NULL || te2 != NULL)
+		mismatch++;
+
+	/* look events up the way the node event lists are duplicated */
+	step = list_events.size() / (num_lookups > 0 ? num_lookups : 1);
+	if (step == 0)
+		step = 1;
+
+	start = bench_time();
+	for (i = 0; i < static_cast<int>(list_events.size()); i += step) {
+		te = list_events[i];
+		if (find_timed_event(list, te->name, te->event_type, te->event_time) != te)
+			mismatch++;
+	}
+	list_time = bench_time() - start;
+
+	start = bench_time();
+	for (i = 0; i < static_cast<int>(index_events.size()); i += step) {
+		te = index_events[i];
+		if (find_calendar_event(calendar, te->name, te->event_type, te->event_time) != te)
+			mismatch++;
+	}
+	index_time = bench_time() - start;
+
+	printf("lookups: %d\n", static_cast<int>((list_events.size() + step - 1) / step));
+	printf("lookup list: %.3fs\n", list_time);
+	printf("lookup index: %.3fs\n", index_time);
+	if (index_time > 0)
+		printf("lookup speedup: %.1fx\n", list_time / index_time);
+	printf("mismatches: %d\n", mismatch);
+
+	free_timed_event_list(list);
+	free_event_list(calendar);
+	for (auto j : jobs)
+		delete j;
+
+	return mismatch != 0;
+}
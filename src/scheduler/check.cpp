@@ -100,6 +100,7 @@
 #include "resource.h"
 #include "buckets.h"
 #include "pbs_bitmap.h"
+#include "profile.h"
 
 /**
  *
@@ -690,6 +691,7 @@ std::vector<nspec *>
 is_ok_to_run(status *policy, server_info *sinfo,
 	     queue_info *qinfo, resource_resv *resresv, unsigned int flags, schd_error *perr)
 {
+	prof_scope prof("is_ok_to_run");
 	enum sched_error_code rc = SE_NONE; /* Return Code */
 	schd_resource *res = NULL;	    /* resource list to check */
 	int endtime = 0;		    /* end time of job if started now */
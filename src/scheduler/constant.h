@@ -169,7 +169,9 @@ enum thread_task_type {
 	TS_FREE_ND_INFO,
 	TS_DUP_RESRESV,
 	TS_QUERY_JOB_INFO,
-	TS_FREE_RESRESV
+	TS_FREE_RESRESV,
+	TS_NODEPART_FIT,
+	TS_SORT_KEYS
 };
 
 /* return codes for is_ok_to_run_* functions
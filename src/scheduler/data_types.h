@@ -53,6 +53,7 @@
 #ifndef	_DATA_TYPES_H
 #define	_DATA_TYPES_H
 
+#include <map>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
@@ -73,6 +74,7 @@
 class server_info;
 struct job_info;
 struct schd_resource;
+struct resource_lookup;
 struct resource_req;
 struct resource_count;
 struct holiday;
@@ -136,6 +138,10 @@ typedef struct th_data_free_ninfo th_data_free_ninfo;
 typedef struct th_data_dup_resresv th_data_dup_resresv;
 typedef struct th_data_query_jinfo th_data_query_jinfo;
 typedef struct th_data_free_resresv th_data_free_resresv;
+typedef struct th_data_nodepart_fit th_data_nodepart_fit;
+typedef struct nodepart_screen nodepart_screen;
+typedef struct th_data_sort_keys th_data_sort_keys;
+typedef struct sort_keys sort_keys;
 
 using counts_umap = std::unordered_map<std::string, counts *>;
 #ifdef NAS
@@ -172,6 +178,7 @@ struct th_task_info
 	int task_id;							/* task id, should be set by main thread */
 	enum thread_task_type task_type;		/* task type */
 	void *thread_data;					/* data for the worker thread to execute the task */
+	struct ds_queue *done_queue;				/* queue to post the finished task to, NULL for result_queue */
 };
 
 struct th_data_nd_eligible
@@ -243,6 +250,21 @@ struct th_data_free_resresv
 	int eidx;
 };
 
+struct th_data_nodepart_fit
+{
+	nodepart_screen *scr;
+	int sidx;
+	int eidx;
+};
+
+struct th_data_sort_keys
+{
+	sort_keys *sk;
+	int sidx;
+	int midx;	/* start of the second half to merge, -1 to sort the chunk */
+	int eidx;
+};
+
 struct schd_error
 {
 	enum sched_error_code error_code;	/* scheduler error code (see constant.h) */
@@ -362,6 +384,7 @@ struct schedattrs
 	bool preempt_targets_enable:1;
 	bool sched_preempt_enforce_resumption:1;
 	bool throughput_mode:1;
+	bool sched_profile:1;
 	long attr_update_period;
 	char *comment;
 	char *job_sort_formula;
@@ -425,6 +448,8 @@ class server_info
 	time_t server_time;		/* The time the server is at.  Could be in the
 					 * future if we're simulating
 					 */
+	long status_seq;		/* server's job status sequence number, see query_jobs() */
+	unsigned long long universe_fp;	/* fingerprint of the queried universe, see ec_cache.cpp */
 	/* the number of running jobs in each preempt level
 	 * all jobs in preempt_count[NUM_PPRIO] are unknown preempt status's
 	 */
@@ -787,6 +812,9 @@ class resource_resv
 	std::string user;		/* username of the owner of the res resv */
 	std::string group;		/* exec group of owner of res resv */
 	std::string project;		/* exec project of owner of res resv */
+	int user_id;			/* interned id of user (see entity_id()) */
+	int group_id;			/* interned id of group */
+	int project_id;			/* interned id of project */
 	char *nodepart_name;		/* name of node partition to run res resv in */
 
 	long sch_priority;		/* scheduler priority of res resv */
@@ -864,6 +892,14 @@ struct schd_resource
 	resdef *def;			/* resource definition */
 
 	struct schd_resource *next;	/* next resource in list */
+	struct resource_lookup *index;	/* list head only: lookup by resdef id, see index_resource_list() */
+};
+
+/* resources of a list by resdef id, used by find_resource() */
+struct resource_lookup
+{
+	schd_resource *tail;		/* last resource of the list when it was indexed */
+	std::vector<schd_resource *> by_id;	/* resource for each resdef id, NULL if not in list */
 };
 
 struct resource_req
@@ -883,7 +919,8 @@ class resdef
 	const std::string name;	/* name of resource */
 	resource_type type;	/* resource type */
 	unsigned int flags;	/* resource flags (see pbs_ifl.h) */
-	resdef(char *rname, unsigned int rflags, resource_type rtype) : name(rname), type(rtype), flags(rflags) {}
+	int id;			/* dense index of the definition, set by update_resource_defs() */
+	resdef(char *rname, unsigned int rflags, resource_type rtype) : name(rname), type(rtype), flags(rflags), id(-1) {}
 };
 
 class prev_job_info
@@ -939,6 +976,7 @@ class group_info
 {
 	public:
 	std::string name;				/* name of user/group */
+	int id;					/* interned id of name (see entity_id()) */
 	int resgroup;				/* resgroup the group is in */
 	int cresgroup;				/* resgroup of the children of group */
 	int shares;				/* number of shares this group has */
@@ -959,6 +997,9 @@ class group_info
 	group_info *parent;			/* parent node */
 	group_info *sibling;			/* sibling node */
 	group_info *child;			/* child node */
+
+	/* only used on the root of a tree: every node of the tree by id */
+	std::vector<group_info *> ginfo_index;
 	explicit group_info(const std::string& gname);
 	group_info(group_info&);
 	group_info &operator=(const group_info &);
@@ -981,6 +1022,7 @@ struct resresv_set
 	place *place_spec;		/* place spec of set */
 	resource_req *req;		/* ATTR_L (qsub -l) resources of set.  Only contains resources on the resources line */
 	queue_info *qinfo;		/* The queue the resresv is in if the queue has nodes associated */
+	char *key;			/* canonical form of the set, "" if it can't be compared */
 };
 
 struct node_partition
@@ -1232,6 +1274,7 @@ struct event_list
 	timed_event *next_event;	/* the next event to be performed */
 	timed_event *first_run_event;	/* The first run event in the calendar */
 	time_t *current_time;		/* [reference] current time in the calendar */
+	std::map<time_t, timed_event *> time_index;	/* first event of each event time in events */
 };
 
 struct timed_event
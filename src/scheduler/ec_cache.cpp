@@ -0,0 +1,484 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    ec_cache.cpp
+ *
+ * @brief
+ * 		ec_cache.cpp - equivalence class verdicts kept across cycles
+ *
+ *	Within a cycle, once one job of an equivalence class can not run, the
+ *	rest of the class is skipped with the same reason.  Most cycles see the
+ *	same classes fail for the same reasons as the cycle before, and each of
+ *	them pays for a full is_ok_to_run() on its first job again.
+ *
+ *	A verdict depends on the state of the universe when the class was first
+ *	considered.  That state is fingerprinted in two parts.  The universe
+ *	fingerprint covers what was queried from the server (the server, queue,
+ *	node and reservation statuses, except for the job counts), the server's
+ *	dynamic resources, every job which is not queued, the calendar and the
+ *	prime/dedicated time state.  Queued jobs are left out because they do
+ *	not change whether another job can run until they run themselves.  The
+ *	fingerprint is then chained with each change the main loop makes to the
+ *	universe (running a job, preempting for one, adding a top job to the
+ *	calendar).  A verdict is reused only if the class is reached with the
+ *	same chained fingerprint as when it was reached, and only for reasons
+ *	which do not get better with time alone (resource shortages and limits).
+ *
+ * Functions included are:
+ * 	ec_cache_hash_status()
+ * 	ec_cache_begin_cycle()
+ * 	ec_cache_check()
+ * 	ec_cache_store()
+ * 	ec_cache_event()
+ * 	ec_cache_clear()
+ *
+ */
+
+#include <pbs_config.h>
+
+#include <string.h>
+#include <string>
+#include <unordered_map>
+
+#include <pbs_ifl.h>
+#include <log.h>
+
+#include "data_types.h"
+#include "constant.h"
+#include "ec_cache.h"
+#include "misc.h"
+
+/* number of cycles a verdict is kept after it was last stored or used */
+#define EC_CACHE_MAX_IDLE_CYCLES 10
+
+/* the reason an equivalence class could not run */
+struct ec_verdict {
+	unsigned long long fp;	/* fingerprint of the universe the verdict was reached in */
+	schd_error *err;	/* why the class could not run */
+	long last_cycle;	/* last cycle the verdict was stored or used */
+};
+
+/* verdicts by equivalence class key, see create_resresv_set_by_resresv() */
+static std::unordered_map<std::string, ec_verdict> verdicts;
+
+static bool cache_on = false;	   /* verdicts are used this cycle */
+static long cur_cycle = 0;	   /* count of cycles the cache was used in */
+static unsigned long long chain_fp; /* universe fingerprint chained with the changes made to it */
+static unsigned long long job_fp;   /* chain_fp when the current job was checked */
+
+/**
+ * @brief
+ *		fold bytes into a fingerprint (64 bit FNV-1a)
+ *
+ * @param[in]	fp	-	fingerprint so far
+ * @param[in]	data	-	bytes to fold in
+ * @param[in]	len	-	number of bytes
+ *
+ * @return	new fingerprint
+ */
+static unsigned long long
+fp_mix(unsigned long long fp, const void *data, size_t len)
+{
+	const unsigned char *p = static_cast<const unsigned char *>(data);
+
+	for (size_t i = 0; i < len; i++) {
+		fp ^= p[i];
+		fp *= 1099511628211ULL;
+	}
+	return fp;
+}
+
+/**
+ * @brief
+ *		fold a string into a fingerprint.  The terminating NUL is folded in
+ *		so consecutive strings can not run together.
+ */
+static unsigned long long
+fp_mix_str(unsigned long long fp, const char *str)
+{
+	if (str == NULL)
+		str = "";
+	return fp_mix(fp, str, strlen(str) + 1);
+}
+
+/**
+ * @brief
+ *		fold a number into a fingerprint
+ */
+static unsigned long long
+fp_mix_num(unsigned long long fp, long long num)
+{
+	return fp_mix(fp, &num, sizeof(num));
+}
+
+/**
+ * @brief
+ *		fold a resource_req list into a fingerprint
+ */
+static unsigned long long
+fp_mix_req(unsigned long long fp, resource_req *req)
+{
+	for (; req != NULL; req = req->next) {
+		fp = fp_mix_str(fp, req->name);
+		fp = fp_mix(fp, &req->amount, sizeof(req->amount));
+		fp = fp_mix_str(fp, req->res_str);
+	}
+	return fp;
+}
+
+/**
+ * @brief
+ *		fold a node solution into a fingerprint
+ */
+static unsigned long long
+fp_mix_nspecs(unsigned long long fp, std::vector<nspec *> &nspecs)
+{
+	for (auto ns : nspecs) {
+		if (ns->ninfo != NULL)
+			fp = fp_mix_str(fp, ns->ninfo->name.c_str());
+		fp = fp_mix_req(fp, ns->resreq);
+	}
+	return fp;
+}
+
+/**
+ * @brief
+ *		fold a batch_status list into a fingerprint.  The job counts of
+ *		the server and queues change with every job submitted, and are left
+ *		out.
+ *
+ * @param[in]	fp	-	fingerprint so far
+ * @param[in]	bs	-	batch_status list
+ *
+ * @return	new fingerprint
+ */
+unsigned long long
+ec_cache_hash_status(unsigned long long fp, struct batch_status *bs)
+{
+	for (; bs != NULL; bs = bs->next) {
+		fp = fp_mix_str(fp, bs->name);
+		for (struct attrl *attrp = bs->attribs; attrp != NULL; attrp = attrp->next) {
+			if (!strcmp(attrp->name, ATTR_total) || !strcmp(attrp->name, ATTR_count) ||
+			    !strcmp(attrp->name, ATTR_status_seq) || !strcmp(attrp->name, ATTR_license_count))
+				continue;
+			fp = fp_mix_str(fp, attrp->name);
+			fp = fp_mix_str(fp, attrp->resource);
+			fp = fp_mix_str(fp, attrp->value);
+		}
+	}
+	return fp;
+}
+
+/**
+ * @brief
+ *		can a verdict be reused in a later cycle
+ *
+ * @param[in]	code	-	why the class could not run
+ *
+ * @return	bool
+ * @retval	true	: the reason will not go away while the universe stays the same
+ * @retval	false	: the reason can go away with time (e.g., prime time or
+ *			  a reservation boundary), or only concerns one job
+ */
+static bool
+verdict_reusable(enum sched_error_code code)
+{
+	switch (code) {
+		case NOT_ENOUGH_NODES_AVAIL:
+		case NO_NODE_RESOURCES:
+		case INSUFFICIENT_RESOURCE:
+		case INSUFFICIENT_QUEUE_RESOURCE:
+		case INSUFFICIENT_SERVER_RESOURCE:
+		case SET_TOO_SMALL:
+		case CANT_SPAN_PSET:
+		case NO_FREE_NODES:
+		case NO_TOTAL_NODES:
+		case QUEUE_JOB_LIMIT_REACHED:
+		case SERVER_JOB_LIMIT_REACHED:
+		case SERVER_USER_LIMIT_REACHED:
+		case QUEUE_USER_LIMIT_REACHED:
+		case SERVER_GROUP_LIMIT_REACHED:
+		case QUEUE_GROUP_LIMIT_REACHED:
+		case QUEUE_USER_RES_LIMIT_REACHED:
+		case SERVER_USER_RES_LIMIT_REACHED:
+		case QUEUE_GROUP_RES_LIMIT_REACHED:
+		case SERVER_GROUP_RES_LIMIT_REACHED:
+		case QUEUE_BYGROUP_JOB_LIMIT_REACHED:
+		case QUEUE_BYUSER_JOB_LIMIT_REACHED:
+		case SERVER_BYGROUP_JOB_LIMIT_REACHED:
+		case SERVER_BYUSER_JOB_LIMIT_REACHED:
+		case SERVER_BYGROUP_RES_LIMIT_REACHED:
+		case SERVER_BYUSER_RES_LIMIT_REACHED:
+		case QUEUE_BYGROUP_RES_LIMIT_REACHED:
+		case QUEUE_BYUSER_RES_LIMIT_REACHED:
+		case QUEUE_RESOURCE_LIMIT_REACHED:
+		case SERVER_RESOURCE_LIMIT_REACHED:
+		case SERVER_PROJECT_LIMIT_REACHED:
+		case SERVER_PROJECT_RES_LIMIT_REACHED:
+		case SERVER_BYPROJECT_RES_LIMIT_REACHED:
+		case SERVER_BYPROJECT_JOB_LIMIT_REACHED:
+		case QUEUE_PROJECT_LIMIT_REACHED:
+		case QUEUE_PROJECT_RES_LIMIT_REACHED:
+		case QUEUE_BYPROJECT_RES_LIMIT_REACHED:
+		case QUEUE_BYPROJECT_JOB_LIMIT_REACHED:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/**
+ * @brief
+ *		start using the verdict cache for a cycle.  Fingerprint the parts
+ *		of the universe which were not fingerprinted when they were
+ *		queried, and drop verdicts which have not been used for a while.
+ *		The cache is not used for a qrun request.
+ *
+ * @param[in]	sinfo	-	the universe at the start of the main loop
+ *
+ * @return	void
+ */
+void
+ec_cache_begin_cycle(server_info *sinfo)
+{
+	unsigned long long fp;
+	status *policy;
+
+	cache_on = false;
+	if (sinfo == NULL || sinfo->qrun_job != NULL)
+		return;
+
+	cur_cycle++;
+	for (auto it = verdicts.begin(); it != verdicts.end();) {
+		if (cur_cycle - it->second.last_cycle > EC_CACHE_MAX_IDLE_CYCLES) {
+			free_schd_error(it->second.err);
+			it = verdicts.erase(it);
+		} else
+			it++;
+	}
+
+	fp = sinfo->universe_fp;
+
+	policy = sinfo->policy;
+	if (policy != NULL) {
+		fp = fp_mix_num(fp, policy->is_prime);
+		fp = fp_mix_num(fp, policy->is_ded_time);
+		fp = fp_mix_num(fp, policy->prime_status_end);
+	}
+
+	for (auto res = sinfo->res; res != NULL; res = res->next) {
+		fp = fp_mix_str(fp, res->name);
+		fp = fp_mix(fp, &res->avail, sizeof(res->avail));
+		fp = fp_mix(fp, &res->assigned, sizeof(res->assigned));
+		if (res->str_avail != NULL)
+			for (int i = 0; res->str_avail[i] != NULL; i++)
+				fp = fp_mix_str(fp, res->str_avail[i]);
+	}
+
+	for (int i = 0; sinfo->jobs != NULL && sinfo->jobs[i] != NULL; i++) {
+		resource_resv *job = sinfo->jobs[i];
+		job_info *jinfo = job->job;
+
+		if (jinfo == NULL || jinfo->is_queued || jinfo->is_held ||
+		    jinfo->is_waiting || jinfo->is_transit || jinfo->is_expired)
+			continue;
+
+		fp = fp_mix_str(fp, job->name.c_str());
+		if (jinfo->queue != NULL)
+			fp = fp_mix_str(fp, jinfo->queue->name.c_str());
+		fp = fp_mix_str(fp, job->user.c_str());
+		fp = fp_mix_str(fp, job->group.c_str());
+		fp = fp_mix_str(fp, job->project.c_str());
+		fp = fp_mix_num(fp, (jinfo->is_running << 0) | (jinfo->is_exiting << 1) |
+			(jinfo->is_suspended << 2) | (jinfo->is_susp_sched << 3) |
+			(jinfo->is_userbusy << 4) | (jinfo->is_begin << 5) |
+			(jinfo->is_provisioning << 6) | (jinfo->is_prerunning << 7));
+		fp = fp_mix_num(fp, job->start);
+		fp = fp_mix_num(fp, job->end);
+		fp = fp_mix_num(fp, job->duration);
+		fp = fp_mix_req(fp, job->resreq);
+		fp = fp_mix_nspecs(fp, job->nspec_arr);
+		fp = fp_mix_nspecs(fp, jinfo->resreleased);
+	}
+
+	if (sinfo->calendar != NULL) {
+		for (auto te = sinfo->calendar->events; te != NULL; te = te->next) {
+			fp = fp_mix_str(fp, te->name.c_str());
+			fp = fp_mix_num(fp, te->event_type);
+			fp = fp_mix_num(fp, te->event_time);
+			fp = fp_mix_num(fp, te->disabled);
+		}
+	}
+
+	chain_fp = fp;
+	job_fp = fp;
+	cache_on = true;
+}
+
+/**
+ * @brief
+ *		called before a job is checked in the main loop.  If its equivalence
+ *		class was found unable to run in an earlier cycle in the same
+ *		universe, mark the class can not run with the same reason.
+ *		is_ok_to_run() will then return the reason without checking the job.
+ *
+ * @param[in]	sinfo	-	server universe
+ * @param[in]	resresv	-	the job about to be checked
+ *
+ * @return	int
+ * @retval	1	: the class was marked can not run
+ * @retval	0	: no reusable verdict
+ */
+int
+ec_cache_check(server_info *sinfo, resource_resv *resresv)
+{
+	resresv_set *ec;
+
+	job_fp = chain_fp;
+
+	if (!cache_on || sinfo == NULL || resresv == NULL)
+		return 0;
+	if (sinfo->equiv_classes == NULL || resresv->ec_index == UNSPECIFIED)
+		return 0;
+
+	ec = sinfo->equiv_classes[resresv->ec_index];
+	if (ec->can_not_run || ec->key == NULL || ec->key[0] == '\0')
+		return 0;
+
+	auto v = verdicts.find(ec->key);
+	if (v == verdicts.end() || v->second.fp != job_fp)
+		return 0;
+
+	ec->err = dup_schd_error(v->second.err);
+	if (ec->err == NULL)
+		return 0;
+	ec->can_not_run = 1;
+	v->second.last_cycle = cur_cycle;
+
+	log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_DEBUG, resresv->name,
+		  "Equivalence class can not run for the same reason as in a previous cycle");
+	return 1;
+}
+
+/**
+ * @brief
+ *		remember why a job's equivalence class can not run, so a later cycle
+ *		reaching the class in the same universe does not have to check again
+ *
+ * @param[in]	sinfo	-	server universe
+ * @param[in]	resresv	-	the job which could not run
+ * @param[in]	err	-	why it could not run
+ *
+ * @return	void
+ */
+void
+ec_cache_store(server_info *sinfo, resource_resv *resresv, schd_error *err)
+{
+	resresv_set *ec;
+	schd_error *nerr;
+
+	if (!cache_on || sinfo == NULL || resresv == NULL || err == NULL)
+		return;
+	if (sinfo->equiv_classes == NULL || resresv->ec_index == UNSPECIFIED)
+		return;
+	if (!verdict_reusable(err->error_code))
+		return;
+
+	ec = sinfo->equiv_classes[resresv->ec_index];
+	if (ec->key == NULL || ec->key[0] == '\0')
+		return;
+
+	nerr = dup_schd_error(err);
+	if (nerr == NULL)
+		return;
+
+	auto &v = verdicts[ec->key];
+	free_schd_error(v.err);
+	v.err = nerr;
+	v.fp = job_fp;
+	v.last_cycle = cur_cycle;
+}
+
+/**
+ * @brief
+ *		note a change the main loop made to the universe.  Verdicts reached
+ *		after the change are only reused after the same change.
+ *
+ * @param[in]	resresv	-	the job the change was made for
+ * @param[in]	event	-	what was done
+ *
+ * @return	void
+ */
+void
+ec_cache_event(resource_resv *resresv, enum ec_cache_event event)
+{
+	if (!cache_on || resresv == NULL)
+		return;
+
+	chain_fp = fp_mix_num(chain_fp, event);
+	chain_fp = fp_mix_str(chain_fp, resresv->name.c_str());
+	switch (event) {
+		case EC_EVENT_RUN:
+			chain_fp = fp_mix_nspecs(chain_fp, resresv->nspec_arr);
+			break;
+		case EC_EVENT_CALENDAR:
+			chain_fp = fp_mix_num(chain_fp, resresv->start);
+			chain_fp = fp_mix_num(chain_fp, resresv->end);
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * @brief
+ *		forget all verdicts.  Called when the configuration or the resource
+ *		definitions change.
+ *
+ * @return	void
+ */
+void
+ec_cache_clear(void)
+{
+	for (auto &v : verdicts)
+		free_schd_error(v.second.err);
+	verdicts.clear();
+	cache_on = false;
+}
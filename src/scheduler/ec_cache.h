@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+#ifndef _EC_CACHE_H
+#define _EC_CACHE_H
+
+#include <pbs_ifl.h>
+#include "data_types.h"
+
+/* changes to the universe made by the main loop which can change a verdict */
+enum ec_cache_event {
+	EC_EVENT_RUN,
+	EC_EVENT_RUN_FAILURE,
+	EC_EVENT_PREEMPT,
+	EC_EVENT_CALENDAR
+};
+
+/*
+ *	ec_cache_hash_status - fold a batch_status list into a fingerprint
+ */
+unsigned long long ec_cache_hash_status(unsigned long long fp, struct batch_status *bs);
+
+/*
+ *	ec_cache_begin_cycle - start using the verdict cache for a cycle
+ */
+void ec_cache_begin_cycle(server_info *sinfo);
+
+/*
+ *	ec_cache_check - mark a job's equivalence class can not run if a
+ *			 previous cycle found it could not run in the same state
+ */
+int ec_cache_check(server_info *sinfo, resource_resv *resresv);
+
+/*
+ *	ec_cache_store - remember why a job's equivalence class can not run
+ */
+void ec_cache_store(server_info *sinfo, resource_resv *resresv, schd_error *err);
+
+/*
+ *	ec_cache_event - note a change the main loop made to the universe
+ */
+void ec_cache_event(resource_resv *resresv, enum ec_cache_event event);
+
+/*
+ *	ec_cache_clear - forget all verdicts
+ */
+void ec_cache_clear(void);
+
+#endif /* _EC_CACHE_H */
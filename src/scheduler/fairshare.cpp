@@ -75,6 +75,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <pthread.h>
 
 #include <log.h>
 
@@ -96,6 +97,9 @@
 
 extern time_t last_decay;
 
+/* serializes find_alloc_ginfo() growing the tree */
+static pthread_mutex_t fairshare_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /**
  * @brief
  *		add_child - add a group_info to the resource group tree
@@ -115,6 +119,11 @@ add_child(group_info *ginfo, group_info *parent)
 		ginfo->parent = parent;
 		ginfo->resgroup = parent->cresgroup;
 		ginfo->gpath = create_group_path(ginfo);
+
+		auto &index = ginfo->gpath[0]->ginfo_index;
+		if (index.size() <= static_cast<size_t>(ginfo->id))
+			index.resize(ginfo->id + 1, NULL);
+		index[ginfo->id] = ginfo;
 	}
 }
 
@@ -140,8 +149,8 @@ add_unknown(group_info *ginfo, group_info *root)
 
 /**
  * @brief
- *		find_group_info - recursive function to find a group_info in the
- *			  resgroup tree
+ *		find_group_info_subtree - recursive function to find a group_info
+ *			  in a sub-tree of the resgroup tree
  *
  * @param[in]	name	-	name of the ginfo to find
  * @param[in]	root	-	the root of the current sub-tree
@@ -149,20 +158,69 @@ add_unknown(group_info *ginfo, group_info *root)
  * @return	the found group_info or NULL
  *
  */
-group_info *
-find_group_info(const std::string &name, group_info *root)
+static group_info *
+find_group_info_subtree(const std::string &name, group_info *root)
 {
 	group_info *ginfo; /* the found group */
 	if (root == NULL || name == root->name)
 		return root;
 
-	ginfo = find_group_info(name, root->sibling);
+	ginfo = find_group_info_subtree(name, root->sibling);
 	if (ginfo == NULL)
-		ginfo = find_group_info(name, root->child);
+		ginfo = find_group_info_subtree(name, root->child);
 
 	return ginfo;
 }
 
+/**
+ * @brief
+ *		find_group_info_by_id - find a group_info by its interned id in
+ *			  the index of a tree
+ *
+ * @param[in]	id	-	interned id of the name of the ginfo to find
+ * @param[in]	root	-	the root of the tree
+ *
+ * @return	the found group_info or NULL
+ *
+ */
+group_info *
+find_group_info_by_id(int id, group_info *root)
+{
+	if (root == NULL || id < 0)
+		return NULL;
+	if (id == root->id)
+		return root;
+	if (static_cast<size_t>(id) >= root->ginfo_index.size())
+		return NULL;
+
+	return root->ginfo_index[id];
+}
+
+/**
+ * @brief
+ *		find_group_info - find a group_info in the resgroup tree
+ *
+ * @param[in]	name	-	name of the ginfo to find
+ * @param[in]	root	-	the root of the tree or of a sub-tree
+ *
+ * @return	the found group_info or NULL
+ *
+ * @note
+ *		The root of a tree indexes all of its nodes by id, so only
+ *		searches of a sub-tree walk it.
+ */
+group_info *
+find_group_info(const std::string &name, group_info *root)
+{
+	if (root == NULL || name == root->name)
+		return root;
+
+	if (root->parent != NULL)
+		return find_group_info_subtree(name, root);
+
+	return find_group_info_by_id(find_entity_id(name), root);
+}
+
 /**
  * @brief
  *		find_alloc_ginfo - tries to find a ginfo in the fair share tree.  If it
@@ -183,15 +241,16 @@ find_alloc_ginfo(const std::string &name, group_info *root)
 	if (root == NULL)
 		return NULL;
 
+	/* called by the threads querying jobs */
+	pthread_mutex_lock(&fairshare_lock);
 	ginfo = find_group_info(name, root);
 
 	if (ginfo == NULL) {
-		if ((ginfo = new group_info(name)) == NULL)
-			return NULL;
-
+		ginfo = new group_info(name);
 		ginfo->shares = 1;
 		add_unknown(ginfo, root);
 	}
+	pthread_mutex_unlock(&fairshare_lock);
 	return ginfo;
 }
 
@@ -809,6 +868,7 @@ over_fs_usage(group_info *ginfo)
  */
 group_info::group_info(const std::string &gname) : name(gname)
 {
+	id = entity_id(name);
 	resgroup = UNSPECIFIED;
 	cresgroup = UNSPECIFIED;
 	shares = UNSPECIFIED;
@@ -824,6 +884,7 @@ group_info::group_info(const std::string &gname) : name(gname)
 
 group_info::group_info(group_info &oginfo) : name(oginfo.name)
 {
+	id = oginfo.id;
 	resgroup = oginfo.resgroup;
 	cresgroup = oginfo.cresgroup;
 	shares = oginfo.shares;
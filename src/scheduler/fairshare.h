@@ -52,6 +52,11 @@ void add_child(group_info *ginfo, group_info *parent);
  */
 group_info *find_group_info(const std::string &name, group_info *root);
 
+/*
+ *      find_group_info_by_id - find a ginfo by the interned id of its name
+ */
+group_info *find_group_info_by_id(int id, group_info *root);
+
 /*
  *      find_alloc_ginfo - trys to find a ginfo in the fair share tree.  If it
  *                        can not find the ginfo, then allocate a new one and
@@ -74,6 +74,7 @@
 #include "pbs_version.h"
 #include "prev_job_info.h"
 #include "prime.h"
+#include "profile.h"
 #include "queue_info.h"
 #include "range.h"
 #include "resource.h"
@@ -82,6 +83,8 @@
 #include "server_info.h"
 #include "simulate.h"
 #include "sort.h"
+#include "sim_undo.h"
+#include "ec_cache.h"
 #include <errno.h>
 #include <fcntl.h>
 #include <libutil.h>
@@ -143,6 +146,9 @@ schedinit(int nthreads)
 
 	parse_ded_file(DEDTIME_FILE);
 
+	/* verdicts reached under the old configuration can't be trusted */
+	ec_cache_clear();
+
 	if (fstree != NULL)
 		delete fstree;
 	/* preload the static members to the fairshare tree */
@@ -345,6 +351,7 @@ update_cycle_status(status &policy, time_t current_time)
 int
 init_scheduling_cycle(status *policy, int pbs_sd, server_info *sinfo)
 {
+	prof_scope prof("init_scheduling_cycle");
 	group_info *user = NULL; /* the user for the running jobs of the last cycle */
 	static schd_error *err;
 
@@ -514,6 +521,9 @@ schedule(int sd, const sched_cmd *cmd)
 			 */
 			update_resource_defs(sd);
 
+			/* job statuses cached before the restart are not comparable */
+			clear_job_status_cache();
+
 			/* Get config from the qmgr sched object */
 			if (!set_validate_sched_attrs(sd))
 				return 0;
@@ -539,6 +549,9 @@ schedule(int sd, const sched_cmd *cmd)
 
 			update_resource_defs(sd);
 
+			/* job statuses cached before the restart are not comparable */
+			clear_job_status_cache();
+
 			/* Get config from the qmgr sched object */
 			if (!set_validate_sched_attrs(sd))
 				return 0;
@@ -571,7 +584,12 @@ intermediate_schedule(int sd, const sched_cmd *cmd)
 	int cycle_cnt = 0; /* count of cycles run */
 
 	do {
-		ret = scheduling_cycle(sd, cmd);
+		prof_begin_cycle();
+		{
+			prof_scope prof("scheduling_cycle");
+			ret = scheduling_cycle(sd, cmd);
+		}
+		prof_end_cycle();
 
 		/* don't restart cycle if :- */
 
@@ -821,6 +839,7 @@ get_high_prio_cmd(int *is_conn_lost, sched_cmd *high_prior_cmd)
 int
 main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 {
+	prof_scope prof("main_sched_loop");
 	resource_resv *njob;	     /* ptr to the next job to see if it can run */
 	int rc = 0;		     /* return code to the function */
 	int num_topjobs = 0;	     /* number of jobs we've added to the calendar */
@@ -852,6 +871,8 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 		return -1;
 	}
 
+	ec_cache_begin_cycle(sinfo);
+
 	/* main scheduling loop */
 #ifdef NAS
 	/* localmod 030 */
@@ -867,6 +888,7 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 		int should_use_buckets;	       /* Should use node buckets for a job */
 		unsigned int flags = NO_FLAGS; /* flags to is_ok_to_run @see is_ok_to_run() */
 		auto qinfo = njob->job->queue;
+		prof_job_scope job_prof(njob->name.c_str());
 
 #ifdef NAS /* localmod 030 */
 		if (check_for_cycle_interrupt(1)) {
@@ -888,6 +910,8 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 		if (should_use_buckets)
 			flags = USE_BUCKETS;
 
+		ec_cache_check(sinfo, njob);
+
 		if (njob->is_shrink_to_fit) {
 			/* Pass the suitable heuristic for shrinking */
 			ns_arr = is_ok_to_run_STF(policy, sinfo, qinfo, njob, flags, err, shrink_job_algorithm);
@@ -901,6 +925,7 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 			if (rc != SCHD_ERROR) {
 				if (run_update_job(policy, sd, sinfo, qinfo, njob, ns_arr, RURR_ADD_END_EVENT, err)) {
 					rc = SUCCESS;
+					ec_cache_event(njob, EC_EVENT_RUN);
 					if (sinfo->has_soft_limit || qinfo->has_soft_limit)
 						sort_again = MUST_RESORT_JOBS;
 					else
@@ -911,6 +936,8 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 					 */
 					rc = err->error_code;
 					sort_again = SORTED;
+					if (rc == RUN_FAILURE)
+						ec_cache_event(njob, EC_EVENT_RUN_FAILURE);
 				}
 			} else
 				free_nspecs(ns_arr);
@@ -920,6 +947,8 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 				sort_again = MUST_RESORT_JOBS;
 			} else
 				sort_again = SORTED;
+			/* even a failed attempt may have preempted some jobs */
+			ec_cache_event(njob, EC_EVENT_PREEMPT);
 		}
 
 #ifdef NAS /* localmod 034 */
@@ -947,6 +976,7 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 				auto cal_rc = add_job_to_calendar(sd, policy, sinfo, njob, should_use_buckets);
 
 				if (cal_rc > 0) { /* Success! */
+					ec_cache_event(njob, EC_EVENT_CALENDAR);
 #ifdef NAS					  /* localmod 034 */
 					switch (bf_rc) {
 						case 1:
@@ -1030,6 +1060,7 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 				if (rc != RUN_FAILURE && !ec->can_not_run) {
 					ec->can_not_run = 1;
 					ec->err = dup_schd_error(err);
+					ec_cache_store(sinfo, njob, err);
 				}
 			}
 		}
@@ -1113,6 +1144,7 @@ main_sched_loop(status *policy, int sd, server_info *sinfo, schd_error **rerr)
 void
 end_cycle_tasks(server_info *sinfo)
 {
+	prof_scope prof("end_cycle_tasks");
 	/* keep track of update used resources for fairshare */
 	if (sinfo != NULL && sinfo->policy->fair_share)
 		create_prev_job_info(sinfo->running_jobs);
@@ -1141,6 +1173,9 @@ end_cycle_tasks(server_info *sinfo)
 		cmp_aoename = NULL;
 	}
 
+	if (num_threads > 1)
+		log_thread_task_stats();
+
 	log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_REQUEST, LOG_DEBUG,
 		  "", "Leaving Scheduling Cycle");
 }
@@ -1507,6 +1542,7 @@ run_update_job(status *policy, int pbs_sd, server_info *sinfo,
 	       queue_info *qinfo, resource_resv *resresv, std::vector<nspec *> &nspec_arr,
 	       unsigned int flags, schd_error *err)
 {
+	prof_scope prof("run_update_job");
 	bool ret;
 	resource_resv *rr;
 
@@ -1698,6 +1734,24 @@ should_backfill_with_job(status *policy, server_info *sinfo, resource_resv *resr
 	return 0;
 }
 
+/**
+ * @brief
+ * 		end the simulation add_job_to_calendar() ran to find a start time
+ *
+ * @param[in]	sinfo	-	the real universe
+ * @param[in]	nsinfo	-	the universe simulated in
+ *
+ * @return	void
+ */
+static void
+end_calendar_sim(server_info *sinfo, server_info *nsinfo)
+{
+	if (nsinfo == sinfo)
+		sim_undo_rollback();
+	else
+		delete nsinfo;
+}
+
 /**
  * @brief
  * 		Find the start time of the top job and init
@@ -1726,8 +1780,9 @@ int
 add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 		    resource_resv *topjob, int use_buckets)
 {
-	server_info *nsinfo; /* dup'd universe to simulate in */
-	resource_resv *njob; /* the topjob in the dup'd universe */
+	prof_scope prof("add_job_to_calendar");
+	server_info *nsinfo; /* universe to simulate in: a copy of sinfo or sinfo itself */
+	resource_resv *njob; /* the topjob in nsinfo */
 	resource_resv *bjob; /* job pointer which becomes the topjob*/
 	resource_resv *tjob; /* temporary job pointer for job arrays */
 	time_t start_time;   /* calculated start time of topjob */
@@ -1744,14 +1799,25 @@ add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 		if (find_timed_event(nexte, topjob->name, IGNORE_DISABLED_EVENTS, TIMED_NOEVENT, 0) != NULL)
 			return 1;
 	}
-	try {
-		nsinfo = new server_info(*sinfo);
-	} catch (std::exception &e) {
-		return 0;
+	/* only does something in check mode, see pbs_sched_replay -U */
+	sim_undo_check(sinfo, topjob, use_buckets ? SIM_RUN_JOB | USE_BUCKETS : SIM_RUN_JOB);
+
+	/* Simulate in sinfo itself if every change the simulation can make will
+	 * be recorded in the undo log.  Otherwise simulate in a copy.
+	 */
+	if (sim_undo_possible(sinfo, topjob) && sim_undo_begin(sinfo)) {
+		nsinfo = sinfo;
+		sim_undo_save_resresv(topjob);
+	} else {
+		try {
+			nsinfo = new server_info(*sinfo);
+		} catch (std::exception &e) {
+			return 0;
+		}
 	}
 
 	if ((njob = find_resource_resv_by_indrank(nsinfo->jobs, topjob->resresv_ind, topjob->rank)) == NULL) {
-		delete nsinfo;
+		end_calendar_sim(sinfo, nsinfo);
 		return 0;
 	}
 
@@ -1779,7 +1845,7 @@ add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 		if (topjob->job->is_array) {
 			tjob = queue_subjob(topjob, sinfo, topjob->job->queue);
 			if (tjob == NULL) {
-				delete nsinfo;
+				end_calendar_sim(sinfo, nsinfo);
 				return 0;
 			}
 
@@ -1788,7 +1854,7 @@ add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 			if (njob == NULL) {
 				log_event(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_DEBUG, __func__,
 					  "Can't find new subjob in simulated universe");
-				delete nsinfo;
+				end_calendar_sim(sinfo, nsinfo);
 				return 0;
 			}
 			/* The subjob is just for the calendar, not for running */
@@ -1798,6 +1864,9 @@ add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 			bjob = topjob;
 
 		exec = create_execvnode(njob->nspec_arr);
+		/* exec is all we need from the simulation */
+		end_calendar_sim(sinfo, nsinfo);
+
 		if (exec != NULL) {
 			free_nspecs(bjob->nspec_arr);
 			bjob->nspec_arr = parse_execvnode(exec, sinfo, NULL);
@@ -1812,14 +1881,10 @@ add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 					delete bjob->execselect;
 					bjob->execselect = parse_selspec(selectspec);
 				}
-			} else {
-				delete nsinfo;
+			} else
 				return 0;
-			}
-		} else {
-			delete nsinfo;
+		} else
 			return 0;
-		}
 
 		if (bjob->job->est_execvnode != NULL)
 			free(bjob->job->est_execvnode);
@@ -1829,17 +1894,13 @@ add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 		bjob->end = start_time + bjob->duration;
 
 		auto te_start = create_event(TIMED_RUN_EVENT, bjob->start, bjob, NULL, NULL);
-		if (te_start == NULL) {
-			delete nsinfo;
+		if (te_start == NULL)
 			return 0;
-		}
 		add_event(sinfo->calendar, te_start);
 
 		auto te_end = create_event(TIMED_END_EVENT, bjob->end, bjob, NULL, NULL);
-		if (te_end == NULL) {
-			delete nsinfo;
+		if (te_end == NULL)
 			return 0;
-		}
 		add_event(sinfo->calendar, te_end);
 
 		if (update_estimated_attrs(pbs_sd, bjob, bjob->job->est_start_time,
@@ -1886,10 +1947,10 @@ add_job_to_calendar(int pbs_sd, status *policy, server_info *sinfo,
 	} else if (start_time == 0) {
 		log_event(PBSEVENT_SCHED, PBS_EVENTCLASS_JOB, LOG_WARNING, topjob->name,
 			  "Error in calculation of start time of top job");
-		delete nsinfo;
+		end_calendar_sim(sinfo, nsinfo);
 		return 0;
-	}
-	delete nsinfo;
+	} else
+		end_calendar_sim(sinfo, nsinfo);
 
 	return 1;
 }
@@ -2206,6 +2267,7 @@ init_sc_attrs(void)
 	sc_attrs.sched_cycle_length = SCH_CYCLE_LEN_DFLT;
 	sc_attrs.sched_log = NULL;
 	sc_attrs.sched_preempt_enforce_resumption = 0;
+	sc_attrs.sched_profile = 0;
 	sc_attrs.sched_priv = NULL;
 	sc_attrs.server_dyn_res_alarm = 0;
 	sc_attrs.throughput_mode = 1;
@@ -2280,6 +2342,11 @@ parse_sched_obj(int connector, struct batch_status *status)
 				sc_attrs.preempt_targets_enable = 0;
 			else
 				sc_attrs.preempt_targets_enable = 1;
+		} else if (!strcmp(attrp->name, ATTR_sched_profile)) {
+			if (!strcasecmp(attrp->value, ATR_FALSE))
+				sc_attrs.sched_profile = 0;
+			else
+				sc_attrs.sched_profile = 1;
 		} else if (!strcmp(attrp->name, ATTR_job_sort_formula_threshold)) {
 			sc_attrs.job_sort_formula_threshold = res_to_num(attrp->value, NULL);
 		} else if (!strcmp(attrp->name, ATTR_throughput_mode)) {
@@ -2443,8 +2510,7 @@ parse_sched_obj(int connector, struct batch_status *status)
 			clear_comment = 1;
 
 		if (validate_log_dir) {
-			log_close(1);
-			if (log_open(logfile, tmp_log_dir) == -1) {
+			if (log_reopen(logfile, tmp_log_dir) == -1) {
 				/* update the sched comment attribute with the reason for failure */
 				attribs = static_cast<attropl *>(calloc(2, sizeof(struct attropl)));
 				if (attribs == NULL) {
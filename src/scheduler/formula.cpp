@@ -0,0 +1,944 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    formula.cpp
+ *
+ * @brief
+ * 		formula.cpp - native evaluation of the job_sort_formula
+ *
+ *	Evaluating the formula through the embedded python interpreter requires
+ *	building a dictionary of every consumable resource for every job.  To
+ *	avoid this, the formula is compiled once into a small postfix program
+ *	which reads the job's resources directly.  The compiler only accepts the
+ *	subset of python it can reproduce exactly (numbers, names, + - * / // %
+ *	**, unary +/-, parentheses, and a few math functions).  If a formula uses
+ *	anything else, it is evaluated through python like before.
+ *
+ * Functions included are:
+ * 	compile_formula()
+ * 	find_compiled_formula()
+ * 	eval_compiled_formula()
+ * 	clear_formula_cache()
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <pbs_ifl.h>
+#include <pbs_share.h>
+#include <libutil.h>
+#include <log.h>
+#include "formula.h"
+#include "constant.h"
+#include "data_types.h"
+#include "globals.h"
+#include "resource.h"
+#include "resource_resv.h"
+
+/* largest integer a double holds exactly.  Python integers are unbounded */
+#define FORMULA_MAX_EXACT_INT 9007199254740992.0
+
+/* upper bound on the number of formulas we keep compiled */
+#define FORMULA_CACHE_MAX 16
+
+enum formula_token {
+	FTOK_END,
+	FTOK_NUM,
+	FTOK_NAME,
+	FTOK_PLUS,
+	FTOK_MINUS,
+	FTOK_STAR,
+	FTOK_POW,
+	FTOK_SLASH,
+	FTOK_FLOORDIV,
+	FTOK_PERCENT,
+	FTOK_LPAREN,
+	FTOK_RPAREN,
+	FTOK_BAD
+};
+
+/* single argument functions available to the formula */
+enum formula_func {
+	FFUNC_SQRT,
+	FFUNC_LOG,
+	FFUNC_LOG10,
+	FFUNC_EXP,
+	FFUNC_FABS,
+	FFUNC_ABS,
+	FFUNC_CEIL,
+	FFUNC_FLOOR
+};
+
+static const struct {
+	const char *name;
+	enum formula_func func;
+} formula_funcs[] = {
+	{"sqrt", FFUNC_SQRT},
+	{"log", FFUNC_LOG},
+	{"log10", FFUNC_LOG10},
+	{"exp", FFUNC_EXP},
+	{"fabs", FFUNC_FABS},
+	{"abs", FFUNC_ABS},
+	{"ceil", FFUNC_CEIL},
+	{"floor", FFUNC_FLOOR},
+};
+
+/* python keywords can never be a name */
+static const std::unordered_set<std::string> py_keywords = {
+	"False", "None", "True", "and", "as", "assert", "async", "await",
+	"break", "class", "continue", "def", "del", "elif", "else", "except",
+	"finally", "for", "from", "global", "if", "import", "in", "is",
+	"lambda", "nonlocal", "not", "or", "pass", "raise", "return", "try",
+	"while", "with", "yield"};
+
+/*
+ * The python formula is evaluated with __main__ as its locals.  The
+ * scheduler does a 'from math import *' into __main__, so these names take
+ * precedence over resource names.
+ */
+static const std::unordered_set<std::string> py_main_names = {
+	"ex", "globals_dict",
+	"acos", "acosh", "asin", "asinh", "atan", "atan2", "atanh", "cbrt",
+	"ceil", "comb", "copysign", "cos", "cosh", "degrees", "dist", "e",
+	"erf", "erfc", "exp", "exp2", "expm1", "fabs", "factorial", "floor",
+	"fmod", "frexp", "fsum", "gamma", "gcd", "hypot", "inf", "isclose",
+	"isfinite", "isinf", "isnan", "isqrt", "lcm", "ldexp", "lgamma", "log",
+	"log10", "log1p", "log2", "modf", "nan", "nextafter", "perm", "pi",
+	"pow", "prod", "radians", "remainder", "sin", "sinh", "sqrt", "sumprod",
+	"tan", "tanh", "tau", "trunc", "ulp"};
+
+static std::unordered_map<std::string, compiled_formula *> formula_cache;
+
+/* parser state for compile_formula() */
+struct formula_parser {
+	const char *pos;		/* current position in the formula */
+	enum formula_token tok;		/* current token */
+	const char *tok_start;		/* start of the current token */
+	int tok_len;			/* length of the current token */
+	double num;			/* value of a FTOK_NUM */
+	bool num_is_int;		/* FTOK_NUM is an integer literal */
+	int depth;			/* current evaluation stack depth */
+	compiled_formula *cf;		/* formula being compiled */
+};
+
+static int parse_expr(formula_parser *p);
+
+/**
+ * @brief
+ * 		scan a python numeric literal we can reproduce exactly
+ *
+ * @param[in,out]	p	-	parser state
+ *
+ * @return	the token type (FTOK_NUM or FTOK_BAD)
+ */
+static enum formula_token
+scan_number(formula_parser *p)
+{
+	const char *s = p->pos;
+	const char *digits_start = s;
+	int is_int = 1;
+	char buf[128];
+
+	while (isdigit(*s))
+		s++;
+	if (*s == '.') {
+		is_int = 0;
+		s++;
+		while (isdigit(*s))
+			s++;
+	}
+	if (s == digits_start || (s - digits_start == 1 && *digits_start == '.'))
+		return FTOK_BAD;
+	if (*s == 'e' || *s == 'E') {
+		const char *e = s + 1;
+		is_int = 0;
+		if (*e == '+' || *e == '-')
+			e++;
+		if (!isdigit(*e))
+			return FTOK_BAD;
+		while (isdigit(*e))
+			e++;
+		s = e;
+	}
+	/* hex/octal/binary, underscores, complex, or a name glued to a number */
+	if (isalnum(*s) || *s == '_' || *s == '.')
+		return FTOK_BAD;
+
+	/* python3 does not allow leading zeros on a non-zero integer */
+	if (is_int && *digits_start == '0') {
+		const char *z;
+		for (z = digits_start; z < s && *z == '0'; z++)
+			;
+		if (z != s)
+			return FTOK_BAD;
+	}
+
+	if (static_cast<size_t>(s - digits_start) >= sizeof(buf))
+		return FTOK_BAD;
+	memcpy(buf, digits_start, s - digits_start);
+	buf[s - digits_start] = '\0';
+	p->num = strtod(buf, NULL);
+	p->num_is_int = is_int;
+	if (is_int && fabs(p->num) > FORMULA_MAX_EXACT_INT)
+		return FTOK_BAD;
+
+	p->tok_len = s - digits_start;
+	p->pos = s;
+	return FTOK_NUM;
+}
+
+/**
+ * @brief
+ * 		advance the parser to the next token
+ *
+ * @param[in,out]	p	-	parser state
+ *
+ * @return	void
+ */
+static void
+next_token(formula_parser *p)
+{
+	while (*p->pos == ' ' || *p->pos == '\t')
+		p->pos++;
+
+	p->tok_start = p->pos;
+	p->tok_len = 1;
+
+	switch (*p->pos) {
+		case '\0':
+			p->tok = FTOK_END;
+			p->tok_len = 0;
+			return;
+		case '+':
+			p->tok = FTOK_PLUS;
+			break;
+		case '-':
+			p->tok = FTOK_MINUS;
+			break;
+		case '%':
+			p->tok = FTOK_PERCENT;
+			break;
+		case '(':
+			p->tok = FTOK_LPAREN;
+			break;
+		case ')':
+			p->tok = FTOK_RPAREN;
+			break;
+		case '*':
+			if (p->pos[1] == '*') {
+				p->tok = FTOK_POW;
+				p->tok_len = 2;
+			} else
+				p->tok = FTOK_STAR;
+			break;
+		case '/':
+			if (p->pos[1] == '/') {
+				p->tok = FTOK_FLOORDIV;
+				p->tok_len = 2;
+			} else
+				p->tok = FTOK_SLASH;
+			break;
+		default:
+			if (isdigit(*p->pos) || *p->pos == '.') {
+				p->tok = scan_number(p);
+				return;
+			}
+			if (isalpha(*p->pos) || *p->pos == '_') {
+				const char *s = p->pos;
+				while (isalnum(*s) || *s == '_')
+					s++;
+				p->tok = FTOK_NAME;
+				p->tok_len = s - p->pos;
+				p->pos = s;
+				return;
+			}
+			p->tok = FTOK_BAD;
+			return;
+	}
+	p->pos += p->tok_len;
+}
+
+/**
+ * @brief
+ * 		append an operation to the program being compiled and keep track
+ *		of the evaluation stack depth it needs
+ *
+ * @param[in,out]	p	-	parser state
+ * @param[in]	op	-	operation to append
+ *
+ * @return	void
+ */
+static void
+emit(formula_parser *p, const formula_op &op)
+{
+	switch (op.op) {
+		case FOP_CONST:
+		case FOP_RES:
+		case FOP_TERM:
+			p->depth++;
+			break;
+		case FOP_NEG:
+		case FOP_FUNC:
+			break;
+		default:
+			p->depth--;
+	}
+	if (p->depth > p->cf->stack_size)
+		p->cf->stack_size = p->depth;
+	p->cf->code.push_back(op);
+}
+
+/**
+ * @brief
+ * 		map a name in the formula to the operation which pushes its value
+ *
+ * @param[in]	name	-	name used in the formula
+ * @param[out]	op	-	operation to fill in
+ *
+ * @return	int
+ * @retval	1	: name was resolved
+ * @retval	0	: name can't be resolved natively
+ */
+static int
+resolve_name(const std::string &name, formula_op &op)
+{
+	static const struct {
+		const char *name;
+		enum formula_term term;
+	} terms[] = {
+		{FORMULA_ELIGIBLE_TIME, FTERM_ELIGIBLE_TIME},
+		{FORMULA_QUEUE_PRIO, FTERM_QUEUE_PRIO},
+		{FORMULA_JOB_PRIO, FTERM_JOB_PRIO},
+		{FORMULA_FSPERC, FTERM_FSPERC},
+		{FORMULA_FSPERC_DEP, FTERM_FSPERC},
+		{FORMULA_TREE_USAGE, FTERM_TREE_USAGE},
+		{FORMULA_FSFACTOR, FTERM_FSFACTOR},
+		{FORMULA_ACCRUE_TYPE, FTERM_ACCRUE_TYPE},
+	};
+
+	if (name[0] == '_' || py_keywords.count(name) > 0)
+		return 0;
+
+	if (py_main_names.count(name) > 0) {
+		op.op = FOP_CONST;
+		if (name == "pi")
+			op.val = M_PI;
+		else if (name == "e")
+			op.val = M_E;
+		else if (name == "tau")
+			op.val = 2 * M_PI;
+		else
+			return 0;
+		return 1;
+	}
+
+	/* special terms override resources of the same name */
+	for (const auto &t : terms) {
+		if (name == t.name) {
+			op.op = FOP_TERM;
+			op.term = t.term;
+			return 1;
+		}
+	}
+
+	auto def = find_resdef(name);
+	if (def == NULL || consres.find(def) == consres.end())
+		return 0;
+
+	op.op = FOP_RES;
+	op.def = def;
+	return 1;
+}
+
+/**
+ * @brief
+ * 		parse an atom: number, name, function call or parenthesized expression
+ *
+ * @param[in,out]	p	-	parser state
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: can't compile
+ */
+static int
+parse_atom(formula_parser *p)
+{
+	formula_op op = {};
+
+	switch (p->tok) {
+		case FTOK_NUM:
+			op.op = FOP_CONST;
+			op.val = p->num;
+			op.is_int = p->num_is_int;
+			emit(p, op);
+			next_token(p);
+			return 1;
+
+		case FTOK_NAME: {
+			std::string name(p->tok_start, p->tok_len);
+
+			next_token(p);
+			if (p->tok == FTOK_LPAREN) {
+				size_t i;
+
+				for (i = 0; i < sizeof(formula_funcs) / sizeof(formula_funcs[0]); i++)
+					if (name == formula_funcs[i].name)
+						break;
+				if (i == sizeof(formula_funcs) / sizeof(formula_funcs[0]))
+					return 0;
+
+				next_token(p);
+				if (!parse_expr(p) || p->tok != FTOK_RPAREN)
+					return 0;
+				next_token(p);
+				op.op = FOP_FUNC;
+				op.func = formula_funcs[i].func;
+				emit(p, op);
+				return 1;
+			}
+			if (!resolve_name(name, op))
+				return 0;
+			emit(p, op);
+			return 1;
+		}
+
+		case FTOK_LPAREN:
+			next_token(p);
+			if (!parse_expr(p) || p->tok != FTOK_RPAREN)
+				return 0;
+			next_token(p);
+			return 1;
+
+		default:
+			return 0;
+	}
+}
+
+/**
+ * @brief
+ * 		parse a unary expression.  Like python, unary minus binds less
+ *		tightly than a power on its right (-2**2 == -4)
+ *
+ * @param[in,out]	p	-	parser state
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: can't compile
+ */
+static int
+parse_factor(formula_parser *p)
+{
+	formula_op op = {};
+
+	if (p->tok == FTOK_PLUS || p->tok == FTOK_MINUS) {
+		int neg = (p->tok == FTOK_MINUS);
+
+		next_token(p);
+		if (!parse_factor(p))
+			return 0;
+		if (neg) {
+			op.op = FOP_NEG;
+			emit(p, op);
+		}
+		return 1;
+	}
+
+	if (!parse_atom(p))
+		return 0;
+
+	if (p->tok == FTOK_POW) {
+		next_token(p);
+		/* right associative, and the exponent may have a sign */
+		if (!parse_factor(p))
+			return 0;
+		op.op = FOP_POW;
+		emit(p, op);
+	}
+	return 1;
+}
+
+/**
+ * @brief
+ * 		parse a multiplicative expression
+ *
+ * @param[in,out]	p	-	parser state
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: can't compile
+ */
+static int
+parse_term(formula_parser *p)
+{
+	formula_op op = {};
+
+	if (!parse_factor(p))
+		return 0;
+
+	while (1) {
+		switch (p->tok) {
+			case FTOK_STAR:
+				op.op = FOP_MUL;
+				break;
+			case FTOK_SLASH:
+				op.op = FOP_DIV;
+				break;
+			case FTOK_FLOORDIV:
+				op.op = FOP_FLOORDIV;
+				break;
+			case FTOK_PERCENT:
+				op.op = FOP_MOD;
+				break;
+			default:
+				return 1;
+		}
+		next_token(p);
+		if (!parse_factor(p))
+			return 0;
+		emit(p, op);
+	}
+}
+
+/**
+ * @brief
+ * 		parse an additive expression
+ *
+ * @param[in,out]	p	-	parser state
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: can't compile
+ */
+static int
+parse_expr(formula_parser *p)
+{
+	formula_op op = {};
+
+	if (!parse_term(p))
+		return 0;
+
+	while (p->tok == FTOK_PLUS || p->tok == FTOK_MINUS) {
+		op.op = (p->tok == FTOK_PLUS) ? FOP_ADD : FOP_SUB;
+		next_token(p);
+		if (!parse_term(p))
+			return 0;
+		emit(p, op);
+	}
+	return 1;
+}
+
+/**
+ * @brief
+ * 		compile a formula into a postfix program
+ *
+ * @param[in]	formula	-	formula to compile
+ *
+ * @return	compiled_formula *
+ * @retval	compiled formula
+ * @retval	NULL	: the formula needs to be evaluated by python
+ */
+compiled_formula *
+compile_formula(const char *formula)
+{
+	formula_parser p = {};
+
+	if (formula == NULL)
+		return NULL;
+
+	p.cf = new compiled_formula(formula);
+	p.pos = formula;
+	next_token(&p);
+
+	if (!parse_expr(&p) || p.tok != FTOK_END) {
+		delete p.cf;
+		return NULL;
+	}
+
+	return p.cf;
+}
+
+/**
+ * @brief
+ * 		find the compiled form of a formula.  Formulas are compiled the
+ *		first time they are seen and cached until the resource definitions
+ *		change.  Formulas which can't be compiled are remembered as well.
+ *
+ * @param[in]	formula	-	formula to find
+ *
+ * @return	compiled_formula *
+ * @retval	compiled formula
+ * @retval	NULL	: the formula needs to be evaluated by python
+ */
+compiled_formula *
+find_compiled_formula(const char *formula)
+{
+	if (formula == NULL)
+		return NULL;
+
+	auto f = formula_cache.find(formula);
+	if (f != formula_cache.end())
+		return f->second;
+
+	if (formula_cache.size() >= FORMULA_CACHE_MAX)
+		clear_formula_cache();
+
+	auto cf = compile_formula(formula);
+	if (cf != NULL)
+		log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__,
+			   "Formula '%s' compiled, will be evaluated natively", formula);
+	else
+		log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__,
+			   "Formula '%s' will be evaluated by python", formula);
+
+	formula_cache[formula] = cf;
+	return cf;
+}
+
+/**
+ * @brief
+ * 		forget all compiled formulas
+ *
+ * @return	void
+ */
+void
+clear_formula_cache(void)
+{
+	for (auto &f : formula_cache)
+		delete f.second;
+	formula_cache.clear();
+}
+
+/**
+ * @brief
+ * 		python evaluated the values after they were printed into a string.
+ *		Round the same way so the answers match.
+ *
+ * @param[in]	val	-	value to round
+ * @param[in]	digits	-	number of digits after the decimal point
+ *
+ * @return	rounded value
+ */
+static double
+round_as_printed(double val, int digits)
+{
+	char buf[512];
+
+	if (val == trunc(val) || !isfinite(val))
+		return val;
+
+	snprintf(buf, sizeof(buf), "%.*f", digits, val);
+	return strtod(buf, NULL);
+}
+
+/**
+ * @brief
+ * 		read the value of a special term from a job
+ *
+ * @param[in]	resresv	-	job
+ * @param[in]	term	-	term to read
+ * @param[out]	is_int	-	the term is an integer in python
+ *
+ * @return	value of the term
+ */
+static double
+term_value(resource_resv *resresv, enum formula_term term, int *is_int)
+{
+	job_info *job = resresv->job;
+	group_info *gi = job->ginfo;
+
+	*is_int = 0;
+	switch (term) {
+		case FTERM_ELIGIBLE_TIME:
+			*is_int = 1;
+			return job->eligible_time;
+		case FTERM_QUEUE_PRIO:
+			*is_int = 1;
+			return job->queue == NULL ? 0 : job->queue->priority;
+		case FTERM_JOB_PRIO:
+			*is_int = 1;
+			return job->priority;
+		case FTERM_ACCRUE_TYPE:
+			*is_int = 1;
+			return job->accrue_type;
+		case FTERM_FSPERC:
+			return gi == NULL ? 0 : round_as_printed(gi->tree_percentage, 6);
+		case FTERM_TREE_USAGE:
+			return gi == NULL ? 0 : round_as_printed(gi->usage_factor, 6);
+		case FTERM_FSFACTOR:
+			if (gi == NULL || gi->tree_percentage == 0)
+				return 0;
+			return round_as_printed(pow(2, -(gi->usage_factor / gi->tree_percentage)), 6);
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ * 		evaluate a compiled formula for a job.  Arithmetic follows python
+ *		semantics (floor division, sign of modulo, exceptions).
+ *
+ * @param[in]	cf	-	compiled formula
+ * @param[in]	resresv	-	job for special case key words
+ * @param[in]	resreq	-	resources to use when evaluating
+ * @param[out]	ans	-	evaluated answer
+ * @param[out]	err	-	error message on FEVAL_ERROR
+ *
+ * @return	enum formula_eval_ret
+ * @retval	FEVAL_OK	: ans is set
+ * @retval	FEVAL_ERROR	: python would have raised an exception, ans is 0
+ * @retval	FEVAL_FALLBACK	: the result needs to be calculated by python
+ */
+enum formula_eval_ret
+eval_compiled_formula(compiled_formula *cf, resource_resv *resresv, resource_req *resreq, sch_resource_t *ans, const char **err)
+{
+	double stack_buf[32];
+	char int_buf[32];
+	double *stack = stack_buf;
+	char *is_int = int_buf;
+	std::vector<double> stack_vec;
+	std::vector<char> int_vec;
+	int sp = 0;
+
+	if (cf == NULL || resresv == NULL || resresv->job == NULL || ans == NULL || err == NULL)
+		return FEVAL_FALLBACK;
+
+	*ans = 0;
+	*err = NULL;
+
+	if (cf->stack_size > static_cast<int>(sizeof(stack_buf) / sizeof(stack_buf[0]))) {
+		stack_vec.resize(cf->stack_size);
+		int_vec.resize(cf->stack_size);
+		stack = stack_vec.data();
+		is_int = int_vec.data();
+	}
+
+	for (const auto &op : cf->code) {
+		double a, b, r;
+		int ints;
+		int tint;
+
+		switch (op.op) {
+			case FOP_CONST:
+				stack[sp] = op.val;
+				is_int[sp] = op.is_int;
+				sp++;
+				continue;
+
+			case FOP_RES: {
+				auto req = find_resource_req(resreq, op.def);
+				/* python saw the amount printed with float_digits() digits */
+				if (req != NULL) {
+					int digits = float_digits(req->amount, FLOAT_NUM_DIGITS);
+					stack[sp] = round_as_printed(req->amount, digits);
+					is_int[sp] = (digits == 0);
+				} else {
+					stack[sp] = 0;
+					is_int[sp] = 1;
+				}
+				sp++;
+				continue;
+			}
+
+			case FOP_TERM:
+				stack[sp] = term_value(resresv, op.term, &tint);
+				is_int[sp] = tint;
+				sp++;
+				continue;
+
+			case FOP_NEG:
+				if (!is_int[sp - 1] || stack[sp - 1] != 0)
+					stack[sp - 1] = -stack[sp - 1];
+				continue;
+
+			case FOP_FUNC:
+				a = stack[sp - 1];
+				switch (op.func) {
+					case FFUNC_SQRT:
+						if (a < 0) {
+							*err = "math domain error";
+							return FEVAL_ERROR;
+						}
+						r = sqrt(a);
+						is_int[sp - 1] = 0;
+						break;
+					case FFUNC_LOG:
+					case FFUNC_LOG10:
+						if (a <= 0) {
+							*err = "math domain error";
+							return FEVAL_ERROR;
+						}
+						r = (op.func == FFUNC_LOG) ? log(a) : log10(a);
+						is_int[sp - 1] = 0;
+						break;
+					case FFUNC_EXP:
+						r = exp(a);
+						if (isinf(r) && isfinite(a)) {
+							*err = "math range error";
+							return FEVAL_ERROR;
+						}
+						is_int[sp - 1] = 0;
+						break;
+					case FFUNC_FABS:
+						r = fabs(a);
+						is_int[sp - 1] = 0;
+						break;
+					case FFUNC_ABS:
+						r = fabs(a);
+						break;
+					case FFUNC_CEIL:
+					case FFUNC_FLOOR:
+						if (!isfinite(a)) {
+							*err = "cannot convert float to integer";
+							return FEVAL_ERROR;
+						}
+						r = (op.func == FFUNC_CEIL) ? ceil(a) : floor(a);
+						if (fabs(r) > FORMULA_MAX_EXACT_INT)
+							return FEVAL_FALLBACK;
+						is_int[sp - 1] = 1;
+						break;
+					default:
+						return FEVAL_FALLBACK;
+				}
+				stack[sp - 1] = r;
+				continue;
+
+			default:
+				break;
+		}
+
+		/* binary operators */
+		b = stack[--sp];
+		a = stack[sp - 1];
+		ints = is_int[sp - 1] && is_int[sp];
+
+		switch (op.op) {
+			case FOP_ADD:
+				r = a + b;
+				break;
+			case FOP_SUB:
+				r = a - b;
+				break;
+			case FOP_MUL:
+				r = a * b;
+				break;
+			case FOP_DIV:
+				if (b == 0) {
+					*err = "division by zero";
+					return FEVAL_ERROR;
+				}
+				r = a / b;
+				ints = 0;
+				break;
+			case FOP_FLOORDIV:
+			case FOP_MOD: {
+				double mod;
+				double div;
+
+				if (b == 0) {
+					*err = "division by zero";
+					return FEVAL_ERROR;
+				}
+				/* python's float_divmod() */
+				mod = fmod(a, b);
+				div = (a - mod) / b;
+				if (mod != 0) {
+					if ((b < 0) != (mod < 0)) {
+						mod += b;
+						div -= 1.0;
+					}
+				} else
+					mod = copysign(0.0, b);
+				if (div != 0) {
+					double floordiv = floor(div);
+					if (div - floordiv > 0.5)
+						floordiv += 1.0;
+					div = floordiv;
+				} else
+					div = copysign(0.0, a / b);
+				r = (op.op == FOP_MOD) ? mod : div;
+				break;
+			}
+			case FOP_POW:
+				if (b == 0) {
+					r = 1.0;
+					break;
+				}
+				if (a == 0 && b < 0) {
+					*err = "0.0 cannot be raised to a negative power";
+					return FEVAL_ERROR;
+				}
+				/* python returns a complex number */
+				if (a < 0 && isfinite(b) && b != trunc(b))
+					return FEVAL_FALLBACK;
+				r = pow(a, b);
+				if (isinf(r) && isfinite(a) && isfinite(b))
+					return FEVAL_FALLBACK;
+				if (b < 0)
+					ints = 0;
+				break;
+			default:
+				return FEVAL_FALLBACK;
+		}
+
+		/* python integers don't lose precision */
+		if (ints && fabs(r) > FORMULA_MAX_EXACT_INT)
+			return FEVAL_FALLBACK;
+		if (ints && r == 0)
+			r = 0;
+
+		stack[sp - 1] = r;
+		is_int[sp - 1] = ints;
+	}
+
+	if (sp != 1)
+		return FEVAL_FALLBACK;
+
+	*ans = stack[0];
+	return FEVAL_OK;
+}
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+#ifndef _FORMULA_H
+#define _FORMULA_H
+
+#include <string>
+#include <vector>
+
+#include "data_types.h"
+
+/* operations of a compiled formula program */
+enum formula_opcode {
+	FOP_CONST,	/* push a literal */
+	FOP_RES,	/* push the amount of a consumable resource */
+	FOP_TERM,	/* push a special term (e.g., eligible_time) */
+	FOP_NEG,
+	FOP_ADD,
+	FOP_SUB,
+	FOP_MUL,
+	FOP_DIV,
+	FOP_FLOORDIV,
+	FOP_MOD,
+	FOP_POW,
+	FOP_FUNC	/* call a single argument math function */
+};
+
+/* special formula terms which are read from the job rather than its resources */
+enum formula_term {
+	FTERM_ELIGIBLE_TIME,
+	FTERM_QUEUE_PRIO,
+	FTERM_JOB_PRIO,
+	FTERM_FSPERC,
+	FTERM_TREE_USAGE,
+	FTERM_FSFACTOR,
+	FTERM_ACCRUE_TYPE
+};
+
+/* return codes of eval_compiled_formula() */
+enum formula_eval_ret {
+	FEVAL_OK,
+	FEVAL_ERROR,	/* evaluation error (e.g., division by zero), answer is 0 */
+	FEVAL_FALLBACK	/* result can't be reproduced natively, use python */
+};
+
+struct formula_op {
+	enum formula_opcode op;
+	double val;			/* FOP_CONST */
+	bool is_int;			/* FOP_CONST - literal is a python int */
+	resdef *def;			/* FOP_RES */
+	enum formula_term term;		/* FOP_TERM */
+	int func;			/* FOP_FUNC - index into the function table */
+};
+
+/*
+ * A job sort formula compiled into a postfix program.  Only the subset of
+ * python expressions which can be evaluated with identical results are
+ * compiled.  Anything else is left to the embedded python interpreter.
+ */
+class compiled_formula
+{
+	public:
+	std::string formula;		/* source of the formula */
+	std::vector<formula_op> code;	/* postfix program */
+	int stack_size;			/* evaluation stack needed to run code */
+	explicit compiled_formula(const char *src) : formula(src), stack_size(0) {}
+};
+
+/*
+ *	compile_formula - compile a formula into a postfix program
+ *			  returns NULL if the formula can't be compiled
+ */
+compiled_formula *compile_formula(const char *formula);
+
+/*
+ *	find_compiled_formula - find (or compile and cache) a formula
+ *				returns NULL if the formula needs python
+ */
+compiled_formula *find_compiled_formula(const char *formula);
+
+/*
+ *	eval_compiled_formula - evaluate a compiled formula for a job
+ */
+enum formula_eval_ret eval_compiled_formula(compiled_formula *cf, resource_resv *resresv, resource_req *resreq, sch_resource_t *ans, const char **err);
+
+/*
+ *	clear_formula_cache - forget all compiled formulas.  Needs to be called
+ *			      when the resource definitions change
+ */
+void clear_formula_cache(void);
+
+#endif /* _FORMULA_H */
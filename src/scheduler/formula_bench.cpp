@@ -0,0 +1,232 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    formula_bench.cpp
+ *
+ * @brief
+ * 		formula_bench.cpp - microbenchmark of job_sort_formula evaluation.
+ *		Evaluates a formula for a set of synthetic jobs through both the
+ *		native compiled path and the embedded python interpreter, checks
+ *		the answers match, and reports the time each path took.
+ *
+ *	usage: pbs_sched_formula_bench [-n num_jobs] [formula]
+ *
+ */
+#include <pbs_config.h>
+
+#ifdef PYTHON
+#include <pbs_python_private.h>
+#include <Python.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <sys/time.h>
+
+#include <pbs_internal.h>
+#include <log.h>
+#include "data_types.h"
+#include "constant.h"
+#include "globals.h"
+#include "formula.h"
+#include "job_info.h"
+#include "resource.h"
+#include "resource_resv.h"
+
+#define BENCH_DEFAULT_JOBS 100000
+#define BENCH_DEFAULT_FORMULA \
+	"ncpus * 10 + mem / 1048576 + walltime // 3600 * fairshare_factor + " \
+	"queue_priority + eligible_time / 60.0 - job_priority % 7 + accrue_type ** 2"
+
+/**
+ * @brief
+ * 		current wall clock time in seconds
+ *
+ * @return	double
+ */
+static double
+bench_time(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/**
+ * @brief
+ * 		add a resource definition to allres
+ *
+ * @param[in]	name	-	resource name
+ * @param[in]	type	-	server attribute type (ATR_TYPE_*)
+ *
+ * @return	void
+ */
+static void
+bench_add_resdef(const char *name, int type)
+{
+	resdef *def = new resdef(const_cast<char *>(name), ATR_DFLAG_CVTSLT, conv_rsc_type(type));
+	allres[name] = def;
+	if (def->type.is_consumable)
+		consres.insert(def);
+}
+
+/**
+ * @brief
+ * 		The entry point of pbs_sched_formula_bench
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	1	: answers differ or error
+ */
+int
+main(int argc, char *argv[])
+{
+	const char *formula = BENCH_DEFAULT_FORMULA;
+	int num_jobs = BENCH_DEFAULT_JOBS;
+	std::vector<resource_resv *> jobs;
+	std::vector<sch_resource_t> native_ans;
+	double start;
+	double native_time;
+	double python_time;
+	int mismatch = 0;
+	int c;
+	int i;
+
+	while ((c = getopt(argc, argv, "n:")) != -1) {
+		switch (c) {
+			case 'n':
+				num_jobs = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-n num_jobs] [formula]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (optind < argc)
+		formula = argv[optind];
+
+	bench_add_resdef("ncpus", ATR_TYPE_LONG);
+	bench_add_resdef("mem", ATR_TYPE_SIZE);
+	bench_add_resdef("walltime", ATR_TYPE_LONG);
+	bench_add_resdef("ngpus", ATR_TYPE_LONG);
+	bench_add_resdef("scratch", ATR_TYPE_FLOAT);
+
+	auto qinfo = new queue_info("workq");
+	qinfo->priority = 50;
+	auto ginfo = new group_info("bench_user");
+	ginfo->tree_percentage = 0.25;
+	ginfo->usage_factor = 0.1;
+
+	for (i = 0; i < num_jobs; i++) {
+		char name[PBS_MAXSVRJOBID + 1];
+		char val[64];
+
+		snprintf(name, sizeof(name), "%d.bench", i);
+		auto resresv = new resource_resv(name);
+		resresv->is_job = 1;
+		resresv->job = new_job_info();
+		resresv->job->queue = qinfo;
+		resresv->job->ginfo = ginfo;
+		resresv->job->priority = i % 1024;
+		resresv->job->eligible_time = i % 86400;
+		resresv->job->accrue_type = i % 4;
+
+		snprintf(val, sizeof(val), "%d", 1 + i % 128);
+		resresv->resreq = create_resource_req("ncpus", val);
+		snprintf(val, sizeof(val), "%dmb", 1 + i % 4096);
+		resresv->resreq->next = create_resource_req("mem", val);
+		snprintf(val, sizeof(val), "%d", 60 * (1 + i % 1440));
+		resresv->resreq->next->next = create_resource_req("walltime", val);
+		snprintf(val, sizeof(val), "%d.%d", i % 100, i % 7);
+		resresv->resreq->next->next->next = create_resource_req("scratch", val);
+		jobs.push_back(resresv);
+	}
+
+#ifdef PYTHON
+	/* the native path falls back to python for what it can't handle */
+	Py_InitializeEx(0);
+	PyRun_SimpleString("from math import *\n");
+#endif
+
+	printf("formula: %s\n", formula);
+	printf("jobs: %d\n", num_jobs);
+	if (find_compiled_formula(formula) == NULL)
+		printf("formula can not be compiled, native path falls back to python\n");
+
+	native_ans.resize(num_jobs);
+	start = bench_time();
+	for (i = 0; i < num_jobs; i++)
+		native_ans[i] = formula_evaluate(formula, jobs[i], jobs[i]->resreq);
+	native_time = bench_time() - start;
+	printf("native: %.3fs (%.2f us/job)\n", native_time, native_time * 1000000 / num_jobs);
+
+#ifdef PYTHON
+	start = bench_time();
+	for (i = 0; i < num_jobs; i++) {
+		sch_resource_t ans = formula_evaluate_python(formula, jobs[i], jobs[i]->resreq);
+		if (ans != native_ans[i]) {
+			if (mismatch < 10)
+				printf("mismatch: job %s native=%.17g python=%.17g\n",
+				       jobs[i]->name.c_str(), native_ans[i], ans);
+			mismatch++;
+		}
+	}
+	python_time = bench_time() - start;
+	printf("python: %.3fs (%.2f us/job)\n", python_time, python_time * 1000000 / num_jobs);
+	if (native_time > 0)
+		printf("speedup: %.1fx\n", python_time / native_time);
+	printf("mismatches: %d\n", mismatch);
+
+	Py_Finalize();
+#else
+	printf("python: not available\n");
+#endif
+
+	for (auto j : jobs)
+		delete j;
+	delete ginfo;
+	delete qinfo;
+
+	return mismatch != 0;
+}
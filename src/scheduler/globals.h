@@ -86,7 +86,6 @@ extern pthread_mutex_t work_lock;
 extern pthread_cond_t work_cond;
 extern pthread_mutex_t result_lock;
 extern pthread_cond_t result_cond;
-extern ds_queue *work_queue;
 extern ds_queue *result_queue;
 extern pthread_t *threads;
 extern int threads_die;
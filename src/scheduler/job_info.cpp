@@ -44,6 +44,8 @@
  * 		job_info.c - This file contains functions related to job_info structure.
  *
  * Functions included are:
+ * 	begin_job_status_cache()
+ * 	clear_job_status_cache()
  * 	query_jobs()
  * 	query_job()
  * 	new_job_info()
@@ -71,6 +73,7 @@
  * 	is_job_array()
  * 	modify_job_array_for_qrun()
  * 	queue_subjob()
+ * 	formula_evaluate_python()
  * 	formula_evaluate()
  * 	make_eligible()
  * 	make_ineligible()
@@ -99,6 +102,7 @@
 #include <unistd.h>
 #include <sys/types.h>
 #include <math.h>
+#include <algorithm>
 #include <pbs_ifl.h>
 #include <log.h>
 #include <libutil.h>
@@ -125,6 +129,8 @@
 #include "server_info.h"
 #include "attribute.h"
 #include "multi_threading.h"
+#include "formula.h"
+#include "profile.h"
 #include "libpbs.h"
 
 #ifdef NAS
@@ -587,6 +593,190 @@ alloc_tdata_jquery(status *policy, int pbs_sd, struct batch_status *jobs, queue_
 	return tdata;
 }
 
+/*
+ * Job statuses kept across cycles.  query_jobs() asks the server only for
+ * the jobs which changed since the previous cycle and takes the attributes of
+ * the others from the previous cycle's replies.
+ */
+struct job_status_cache {
+	long seq = -1;					/* server status sequence the replies are current for */
+	time_t time = 0;				/* time of the cycle which queried them */
+	std::vector<struct batch_status *> replies;	/* selstat replies, owned by the cache */
+	std::unordered_map<std::string, struct batch_status *> jobs; /* job name to its reply entry */
+};
+
+static job_status_cache prev_jstat; /* replies of the previous cycle */
+static job_status_cache cur_jstat;  /* replies of the current cycle */
+
+/**
+ * @brief
+ * 		free the replies held by a job status cache and invalidate it
+ *
+ * @param[in,out]	jcache	-	cache to clear
+ *
+ * @return void
+ */
+static void
+free_job_status_cache(job_status_cache &jcache)
+{
+	for (auto bs : jcache.replies)
+		pbs_statfree(bs);
+	jcache.replies.clear();
+	jcache.jobs.clear();
+	jcache.seq = -1;
+	jcache.time = 0;
+}
+
+/**
+ * @brief
+ * 		drop all cached job statuses.  The next cycle queries all jobs.
+ *
+ * @return void
+ */
+void
+clear_job_status_cache()
+{
+	free_job_status_cache(prev_jstat);
+	free_job_status_cache(cur_jstat);
+}
+
+/**
+ * @brief
+ * 		start a new cycle of the job status cache.  The replies of the last
+ * 		cycle become the base the delta queries of this cycle are merged with.
+ *
+ * @param[in]	seq	-	the server's status sequence number, -1 if not reported
+ * @param[in]	now	-	time of this cycle
+ *
+ * @return void
+ */
+void
+begin_job_status_cache(long seq, time_t now)
+{
+	free_job_status_cache(prev_jstat);
+
+	/* a sequence number going backwards means the server was restarted */
+	if (seq >= 0 && cur_jstat.seq >= 0 && seq >= cur_jstat.seq)
+		std::swap(prev_jstat, cur_jstat);
+	free_job_status_cache(cur_jstat);
+
+	cur_jstat.seq = seq;
+	cur_jstat.time = now;
+}
+
+/**
+ * @brief
+ * 		fill in the jobs of a delta selstat reply which came back without
+ * 		attributes (unchanged jobs) from the previous cycle's replies.
+ *
+ * @par
+ * 		The server computes eligible_time on the fly, so it is advanced by
+ * 		the time between the cycles for jobs accruing eligible time.
+ *
+ * @param[in,out]	jobs	-	delta selstat reply
+ *
+ * @return int
+ * @retval 1	: all unchanged jobs were found
+ * @retval 0	: a job was not in the cache, a full query is needed
+ */
+static int
+merge_job_status_cache(struct batch_status *jobs)
+{
+	time_t elapsed = cur_jstat.time - prev_jstat.time;
+	int num_unchanged = 0;
+	int num_jobs = 0;
+
+	for (struct batch_status *bs = jobs; bs != NULL; bs = bs->next) {
+		num_jobs++;
+		if (bs->attribs != NULL)
+			continue;
+
+		auto it = prev_jstat.jobs.find(bs->name);
+		if (it == prev_jstat.jobs.end() || it->second->attribs == NULL)
+			return 0;
+
+		bs->attribs = it->second->attribs;
+		it->second->attribs = NULL;
+		num_unchanged++;
+
+		if (elapsed > 0) {
+			struct attrl *elig = NULL;
+			bool accruing = false;
+
+			for (struct attrl *attrp = bs->attribs; attrp != NULL; attrp = attrp->next) {
+				if (!strcmp(attrp->name, ATTR_accrue_type))
+					accruing = (strtol(attrp->value, NULL, 10) == JOB_ELIGIBLE);
+				else if (!strcmp(attrp->name, ATTR_eligible_time))
+					elig = attrp;
+			}
+			if (accruing && elig != NULL) {
+				char *newval = string_dup(std::to_string(static_cast<long>(res_to_num(elig->value, NULL)) + elapsed).c_str());
+				if (newval != NULL) {
+					free(elig->value);
+					elig->value = newval;
+				}
+			}
+		}
+	}
+
+	log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_DEBUG, __func__,
+		   "%d of %d jobs unchanged since status sequence %ld", num_unchanged, num_jobs, prev_jstat.seq);
+
+	return 1;
+}
+
+/**
+ * @brief
+ * 		select-status the jobs matching opl.  When the previous cycle's
+ * 		replies are cached, only the jobs changed since are transferred.
+ *
+ * @param[in]	pbs_sd	-	connection to pbs_server
+ * @param[in]	opl	-	selection criteria
+ * @param[in]	attrib	-	attributes to return
+ * @param[in]	use_cache	-	whether the reply may be merged with/added to the cache
+ *
+ * @return struct batch_status *
+ * @retval reply with all attributes filled in
+ * @retval NULL on error or no jobs (see pbs_errno)
+ */
+static struct batch_status *
+selstat_jobs(int pbs_sd, struct attropl *opl, struct attrl *attrib, bool use_cache)
+{
+	struct batch_status *jobs;
+	char extend[32];
+
+	snprintf(extend, sizeof(extend), "%c", EXTEND_OPT_SCHED_JOBS);
+	if (!use_cache || prev_jstat.seq < 0)
+		return send_selstat(pbs_sd, opl, attrib, extend);
+
+	snprintf(extend, sizeof(extend), "%c%c%ld", EXTEND_OPT_SCHED_JOBS, EXTEND_OPT_DELTA, prev_jstat.seq);
+	jobs = send_selstat(pbs_sd, opl, attrib, extend);
+	if (jobs == NULL || merge_job_status_cache(jobs))
+		return jobs;
+
+	log_event(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG, __func__,
+		  "Job missing from status cache, querying all jobs");
+	pbs_statfree(jobs);
+	extend[1] = '\0';
+	return send_selstat(pbs_sd, opl, attrib, extend);
+}
+
+/**
+ * @brief
+ * 		hand a selstat reply over to the job status cache for the next cycle
+ *
+ * @param[in]	jobs	-	reply to keep
+ *
+ * @return void
+ */
+static void
+add_job_status_cache(struct batch_status *jobs)
+{
+	cur_jstat.replies.push_back(jobs);
+	for (struct batch_status *bs = jobs; bs != NULL; bs = bs->next)
+		cur_jstat.jobs[bs->name] = bs;
+}
+
 /**
  * @brief
  * 		create an array of jobs in a specified queue
@@ -638,10 +828,14 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 	th_task_info *task = NULL;
 	resource_resv ***jinfo_arrs_tasks;
 	int tid;
+	bool use_cache;
 
 	if (policy == NULL || qinfo == NULL || queue_name.empty())
 		return pjobs;
 
+	/* jobs of peer queues come from other servers, which are not cached */
+	use_cache = cur_jstat.seq >= 0 && !qinfo->is_peer_queue;
+
 	opl.value = const_cast<char *>(queue_name.c_str());
 
 	if (qinfo->is_peer_queue)
@@ -698,7 +892,7 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 	}
 
 	/* get jobs from PBS server */
-	if ((jobs = send_selstat(pbs_sd, &opl, attrib, const_cast<char *>("S"))) == NULL) {
+	if ((jobs = selstat_jobs(pbs_sd, &opl, attrib, use_cache)) == NULL) {
 		if (pbs_errno > 0) {
 			const char *errmsg = pbs_geterrmsg(pbs_sd);
 			if (errmsg == NULL)
@@ -758,12 +952,10 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 		free(tdata);
 		resresv_arr[jidx] = NULL;
 	} else {
-		int chunk_size = num_new_jobs / num_threads;
+		int chunk_size = mt_chunk_size(num_new_jobs);
 		int th_err = 0;
 		int num_tasks = 0;
 
-		chunk_size = (chunk_size > MT_CHUNK_SIZE_MIN) ? chunk_size : MT_CHUNK_SIZE_MIN;
-		chunk_size = (chunk_size < MT_CHUNK_SIZE_MAX) ? chunk_size : MT_CHUNK_SIZE_MAX;
 		for (int j = 0; num_new_jobs > 0;
 		     num_tasks++, j += chunk_size, num_new_jobs -= chunk_size) {
 			tdata = alloc_tdata_jquery(policy, pbs_sd, jobs, qinfo, j, j + chunk_size - 1);
@@ -771,21 +963,11 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 				th_err = 1;
 				break;
 			}
-			task = static_cast<th_task_info *>(malloc(sizeof(th_task_info)));
-			if (task == NULL) {
+			if (!queue_task_for_threads(TS_QUERY_JOB_INFO, num_tasks, tdata)) {
 				free(tdata);
-				log_err(errno, __func__, MEM_ERR_MSG);
 				th_err = 1;
 				break;
 			}
-			task->task_id = num_tasks;
-			task->task_type = TS_QUERY_JOB_INFO;
-			task->thread_data = (void *) tdata;
-
-			pthread_mutex_lock(&work_lock);
-			ds_enqueue(work_queue, (void *) task);
-			pthread_cond_signal(&work_cond);
-			pthread_mutex_unlock(&work_lock);
 		}
 		jinfo_arrs_tasks = static_cast<resource_resv ***>(malloc(num_tasks * sizeof(resource_resv **)));
 		if (jinfo_arrs_tasks == NULL) {
@@ -793,21 +975,14 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 			th_err = 1;
 		}
 		/* Get results from worker threads */
-		for (int i = 0; i < num_tasks;) {
-			pthread_mutex_lock(&result_lock);
-			while (ds_queue_is_empty(result_queue))
-				pthread_cond_wait(&result_cond, &result_lock);
-			while (!ds_queue_is_empty(result_queue)) {
-				task = static_cast<th_task_info *>(ds_dequeue(result_queue));
-				tdata = static_cast<th_data_query_jinfo *>(task->thread_data);
-				if (tdata->error)
-					th_err = 1;
-				jinfo_arrs_tasks[task->task_id] = tdata->oarr;
-				free(tdata);
-				free(task);
-				i++;
-			}
-			pthread_mutex_unlock(&result_lock);
+		for (int i = 0; i < num_tasks; i++) {
+			task = wait_for_task_result();
+			tdata = static_cast<th_data_query_jinfo *>(task->thread_data);
+			if (tdata->error)
+				th_err = 1;
+			jinfo_arrs_tasks[task->task_id] = tdata->oarr;
+			free(tdata);
+			free(task);
 		}
 		if (th_err) {
 			pbs_statfree(jobs);
@@ -829,7 +1004,10 @@ query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs,
 		free(jinfo_arrs_tasks);
 	}
 
-	pbs_statfree(jobs);
+	if (use_cache)
+		add_job_status_cache(jobs);
+	else
+		pbs_statfree(jobs);
 
 	return resresv_arr;
 }
@@ -1088,6 +1266,11 @@ query_job(int pbs_sd, struct batch_status *job, server_info *sinfo, queue_info *
 		attrp = attrp->next;
 	}
 
+	/* intern the owner now so limit checks can index by id */
+	resresv->user_id = entity_id(resresv->user);
+	resresv->group_id = entity_id(resresv->group);
+	resresv->project_id = entity_id(resresv->project);
+
 #ifdef NAS /* localmod 040 */
 	/* we modify nodect to be the same value for all jobs in queues that are
 	 * configured to ignore nodect key sorting, for two reasons:
@@ -2023,6 +2206,7 @@ new_resresv_set(void)
 	rset->req = NULL;
 	rset->select_spec = NULL;
 	rset->qinfo = NULL;
+	rset->key = NULL;
 
 	return rset;
 }
@@ -2042,6 +2226,7 @@ free_resresv_set(resresv_set *rset)
 	delete rset->select_spec;
 	free_place(rset->place_spec);
 	free_resource_req_list(rset->req);
+	free(rset->key);
 	free(rset);
 }
 /**
@@ -2114,6 +2299,11 @@ dup_resresv_set(resresv_set *oset, server_info *nsinfo)
 		free_resresv_set(rset);
 		return NULL;
 	}
+	rset->key = string_dup(oset->key);
+	if (oset->key != NULL && rset->key == NULL) {
+		free_resresv_set(rset);
+		return NULL;
+	}
 	if (oset->qinfo != NULL)
 		rset->qinfo = find_queue_info(nsinfo->queues, oset->qinfo->name);
 
@@ -2295,6 +2485,142 @@ create_resresv_sets_resdef(status *policy)
 	return defs;
 }
 
+/**
+ * @brief append a string to a resresv_set key.  The length is written first
+ *	  so no string can be mistaken for the start of the next one.
+ * @param[in,out] key - key to append to
+ * @param[in] str - string to append, NULL is written as '-'
+ */
+static void
+resresv_set_key_str(std::string &key, const char *str)
+{
+	if (str == NULL)
+		key += '-';
+	else {
+		key += std::to_string(strlen(str));
+		key += ':';
+		key += str;
+	}
+}
+
+/**
+ * @brief std::sort() compare function to sort resource_reqs by name
+ */
+static bool
+cmp_resource_req_name(resource_req *r1, resource_req *r2)
+{
+	return strcmp(r1->name, r2->name) < 0;
+}
+
+/**
+ * @brief append the resources of a resource_req list which a resresv_set compares
+ *	  to a resresv_set key.  The resources are sorted by name, because two
+ *	  lists are equal no matter the order of their resources.
+ *	  @see compare_resource_req_list()
+ * @param[in,out] key - key to append to
+ * @param[in] req - resource_req list
+ * @param[in] comparr - resources to compare
+ * @return bool
+ * @retval true - resources appended
+ * @retval false - a resource can't be compared, so the list never equals another
+ */
+static bool
+resresv_set_key_reqs(std::string &key, resource_req *req, std::unordered_set<resdef *> &comparr)
+{
+	std::vector<resource_req *> reqs;
+	char buf[64];
+
+	for (; req != NULL; req = req->next) {
+		if (comparr.find(req->def) != comparr.end())
+			reqs.push_back(req);
+	}
+	std::sort(reqs.begin(), reqs.end(), cmp_resource_req_name);
+
+	key += '[';
+	for (auto r : reqs) {
+		resresv_set_key_str(key, r->name);
+		if (r->type.is_consumable || r->type.is_boolean) {
+			snprintf(buf, sizeof(buf), "=%a", r->amount);
+			key += buf;
+		} else if (r->type.is_string && r->res_str != NULL) {
+			key += '=';
+			resresv_set_key_str(key, r->res_str);
+		} else
+			return false;
+	}
+	key += ']';
+
+	return true;
+}
+
+/**
+ * @brief create the key of the resresv_set a resresv belongs to.  Two resresvs
+ *	  have the same key exactly when find_resresv_set() would put them in
+ *	  the same set.  The key identifies the set across cycles.
+ * @param[in] policy - policy info
+ * @param[in] resresv - the resresv
+ * @return std::string
+ * @retval key of the set
+ * @retval "" if the set can't be compared to other sets
+ */
+static std::string
+resresv_set_key(status *policy, resource_resv *resresv)
+{
+	std::string key;
+	queue_info *qinfo = NULL;
+	selspec *sspec;
+	place *pl;
+	char buf[64];
+
+	if (resresv->is_job && resresv->job != NULL)
+		if (resresv_set_use_queue(resresv->job->queue))
+			qinfo = resresv->job->queue;
+
+	resresv_set_key_str(key, qinfo != NULL ? qinfo->name.c_str() : NULL);
+	resresv_set_key_str(key, resresv_set_use_user(resresv->server, qinfo) ? resresv->user.c_str() : NULL);
+	resresv_set_key_str(key, resresv_set_use_grp(resresv->server, qinfo) ? resresv->group.c_str() : NULL);
+	resresv_set_key_str(key, resresv_set_use_proj(resresv->server, qinfo) ? resresv->project.c_str() : NULL);
+
+	sspec = resresv_set_which_selspec(resresv);
+	if (sspec == NULL || sspec->chunks == NULL)
+		return "";
+	snprintf(buf, sizeof(buf), "%d", sspec->total_chunks);
+	key += buf;
+	for (int i = 0; sspec->chunks[i] != NULL; i++) {
+		snprintf(buf, sizeof(buf), "(%d", sspec->chunks[i]->num_chunks);
+		key += buf;
+		if (sspec->chunks[i]->req == NULL)
+			key += '-';
+		else if (!resresv_set_key_reqs(key, sspec->chunks[i]->req, conf.resdef_to_check))
+			return "";
+		key += ')';
+	}
+
+	pl = resresv->place_spec;
+	if (pl == NULL)
+		return "";
+	snprintf(buf, sizeof(buf), "%d%d%d%d%d%d%d", pl->free, pl->pack, pl->scatter,
+		 pl->vscatter, pl->excl, pl->exclhost, pl->share);
+	key += buf;
+	resresv_set_key_str(key, pl->group);
+
+	/* A set keeps only the resources of its first resresv which are compared.
+	 * If there are none, it only matches resresvs without any resources.
+	 */
+	if (resresv->resreq == NULL)
+		key += '-';
+	else {
+		std::string reqkey;
+		if (!resresv_set_key_reqs(reqkey, resresv->resreq, policy->equiv_class_resdef))
+			return "";
+		if (reqkey == "[]")
+			return "";
+		key += reqkey;
+	}
+
+	return key;
+}
+
 /**
  * @brief create a resresv_set based on a resource_resv
  *
@@ -2342,6 +2668,12 @@ create_resresv_set_by_resresv(status *policy, server_info *sinfo, resource_resv
 	/* rset->req may be NULL if the intersection of resresv->resreq and policy->equiv_class_resdef is the NULL set */
 	rset->req = dup_selective_resource_req_list(resresv->resreq, policy->equiv_class_resdef);
 
+	rset->key = string_dup(resresv_set_key(policy, resresv).c_str());
+	if (rset->key == NULL) {
+		free_resresv_set(rset);
+		return NULL;
+	}
+
 	return rset;
 }
 
@@ -2456,6 +2788,7 @@ create_resresv_sets(status *policy, server_info *sinfo)
 	resresv_set **rsets;
 	resresv_set **tmp_rset_arr;
 	resresv_set *cur_rset;
+	std::unordered_map<std::string, int> set_index; /* index of each set by key */
 
 	if (policy == NULL || sinfo == NULL)
 		return NULL;
@@ -2472,7 +2805,14 @@ create_resresv_sets(status *policy, server_info *sinfo)
 	rsets[0] = NULL;
 
 	for (i = 0; resresvs[i] != NULL; i++) {
-		auto cur_ind = find_resresv_set_by_resresv(policy, rsets, resresvs[i]);
+		auto key = resresv_set_key(policy, resresvs[i]);
+		int cur_ind = -1;
+
+		if (!key.empty()) {
+			auto k = set_index.find(key);
+			if (k != set_index.end())
+				cur_ind = k->second;
+		}
 
 		/* Didn't find the set, create it.*/
 		if (cur_ind == -1) {
@@ -2484,6 +2824,8 @@ create_resresv_sets(status *policy, server_info *sinfo)
 			cur_ind = j;
 			rsets[j++] = cur_rset;
 			rsets[j] = NULL;
+			if (!key.empty())
+				set_index[key] = cur_ind;
 		}
 		resresvs[i]->ec_index = cur_ind;
 	}
@@ -2574,8 +2916,8 @@ dup_job_info(job_info *ojinfo, queue_info *nqinfo, server_info *nsinfo)
 	njinfo->resreq_rel = dup_resource_req_list(ojinfo->resreq_rel);
 
 	if (nqinfo->server->fstree != NULL) {
-		njinfo->ginfo = find_group_info(ojinfo->ginfo->name,
-						nqinfo->server->fstree->root);
+		njinfo->ginfo = find_group_info_by_id(ojinfo->ginfo->id,
+						      nqinfo->server->fstree->root);
 	} else
 		njinfo->ginfo = NULL;
 
@@ -2750,6 +3092,7 @@ schd_get_preempt_order(resource_resv *resresv)
 int
 find_and_preempt_jobs(status *policy, int pbs_sd, resource_resv *hjob, server_info *sinfo, schd_error *err)
 {
+	prof_scope prof("find_and_preempt_jobs");
 
 	int i = 0;
 	int *jobs = NULL;
@@ -3956,7 +4299,7 @@ queue_subjob(resource_resv *array, server_info *sinfo,
 /**
  * @brief
  * 		evaluate a math formula for jobs based on their resources
- *		NOTE: currently done through embedded python interpreter
+ *		through the embedded python interpreter
  *
  * @param[in]	formula	-	formula to evaluate
  * @param[in]	resresv	-	job for special case key words
@@ -3968,7 +4311,7 @@ queue_subjob(resource_resv *array, server_info *sinfo,
 
 #ifdef PYTHON
 sch_resource_t
-formula_evaluate(const char *formula, resource_resv *resresv, resource_req *resreq)
+formula_evaluate_python(const char *formula, resource_resv *resresv, resource_req *resreq)
 {
 	char buf[1024];
 	char *globals;
@@ -3981,10 +4324,6 @@ formula_evaluate(const char *formula, resource_resv *resresv, resource_req *resr
 	PyObject *dict;
 	PyObject *obj;
 
-	if (formula == NULL || resresv == NULL ||
-	    resresv->job == NULL)
-		return 0;
-
 	formula_buf_len = sizeof(buf) + strlen(formula) + 1;
 
 	formula_buf = static_cast<char *>(malloc(formula_buf_len));
@@ -4063,6 +4402,8 @@ formula_evaluate(const char *formula, resource_resv *resresv, resource_req *resr
 		ans = PyFloat_AsDouble(obj);
 		Py_XDECREF(obj);
 	}
+	/* don't leave a KeyError or conversion error pending for the next call */
+	PyErr_Clear();
 
 	obj = PyMapping_GetItemString(dict, "_PBS_PYTHON_EXCEPTIONSTR_");
 	if (obj != NULL) {
@@ -4079,13 +4420,53 @@ formula_evaluate(const char *formula, resource_resv *resresv, resource_req *resr
 
 	return ans;
 }
-#else
+#endif
+
+
+/**
+ * @brief
+ * 		evaluate a math formula for jobs based on their resources
+ *		NOTE: formulas are compiled and evaluated natively when possible.
+ *		      Anything else is done through the embedded python interpreter
+ *
+ * @param[in]	formula	-	formula to evaluate
+ * @param[in]	resresv	-	job for special case key words
+ * @param[in]	resreq	-	resources to use when evaluating
+ *
+ * @return	evaluated formula answer or 0 on exception
+ *
+ */
 sch_resource_t
-formula_evaluate(char *formula, resource_resv *resresv, resource_req *resreq)
+formula_evaluate(const char *formula, resource_resv *resresv, resource_req *resreq)
 {
+	compiled_formula *cf;
+	sch_resource_t ans = 0;
+	const char *err = NULL;
+
+	if (formula == NULL || resresv == NULL ||
+	    resresv->job == NULL)
+		return 0;
+
+	cf = find_compiled_formula(formula);
+	if (cf != NULL) {
+		switch (eval_compiled_formula(cf, resresv, resreq, &ans, &err)) {
+			case FEVAL_OK:
+				return ans;
+			case FEVAL_ERROR:
+				log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_JOB, LOG_DEBUG, resresv->name,
+					   "Formula evaluation for job had an error.  Zero value will be used: %s", err);
+				return 0;
+			case FEVAL_FALLBACK:
+				break;
+		}
+	}
+
+#ifdef PYTHON
+	return formula_evaluate_python(formula, resresv, resreq);
+#else
 	return 0;
-}
 #endif
+}
 
 /**
  * @brief
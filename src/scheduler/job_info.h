@@ -53,6 +53,12 @@ resource_resv *query_job(int pbs_sd, struct batch_status *job, server_info *sinf
  */
 void query_jobs_chunk(th_data_query_jinfo *data);
 
+/* start a new cycle of the cross-cycle job status cache used by query_jobs() */
+void begin_job_status_cache(long seq, time_t now);
+
+/* drop the cached job statuses, the next cycle queries all jobs */
+void clear_job_status_cache();
+
 /* create an array of jobs for a particular queue */
 resource_resv **query_jobs(status *policy, int pbs_sd, queue_info *qinfo, resource_resv **pjobs, const std::string &queue_name);
 
@@ -244,11 +250,19 @@ queue_subjob(resource_resv *array, server_info *sinfo,
 	     queue_info *qinfo);
 /*
  *	formula_evaluate - evaluate a math formula for jobs based on their resources
- *		NOTE: currently done through embedded python interpreter
+ *		NOTE: compiled natively when possible, otherwise done through
+ *		      the embedded python interpreter
  */
 
 sch_resource_t formula_evaluate(const char *formula, resource_resv *resresv, resource_req *resreq);
 
+#ifdef PYTHON
+/*
+ *	formula_evaluate_python - evaluate a formula through the embedded python interpreter
+ */
+sch_resource_t formula_evaluate_python(const char *formula, resource_resv *resresv, resource_req *resreq);
+#endif
+
 /*
  *
  *      update_accruetype - Updates accrue_type of job on server.
@@ -89,11 +89,11 @@
  * 	lim_setoldlimits()
  * 	lim_dup_ctx()
  * 	is_hardlimit()
- * 	lim_gengroupreskey()
- * 	lim_genprojectreskey()
- * 	lim_genuserreskey()
  * 	lim_callback()
  * 	lim_get()
+ * 	lim_cache_get()
+ * 	lim_cache_set_check()
+ * 	lim_cache_check_results()
  * 	schderr_args_q()
  * 	schderr_args_q_res()
  * 	schderr_args_server()
@@ -128,40 +128,56 @@
 #include "resource.h"
 #include "globals.h"
 
+/* counts the limit functions check against.  Either a private copy of the
+ * counts which can be updated while walking the calendar, or a view of the
+ * live counts of a server or queue which copies nothing.
+ */
 class limcounts {
+      private:
+	counts_umap own_user;
+	counts_umap own_group;
+	counts_umap own_project;
+	counts_umap own_all;
+
       public:
-	counts_umap user;
-	counts_umap group;
-	counts_umap project;
-	counts_umap all;
+	counts_umap &user;
+	counts_umap &group;
+	counts_umap &project;
+	counts_umap &all;
 	limcounts() = delete;
 	limcounts(const counts_umap &ruser,
 		  const counts_umap &rgroup,
 		  const counts_umap &rproject,
 		  const counts_umap &rall);
+	limcounts(counts_umap *ruser,
+		  counts_umap *rgroup,
+		  counts_umap *rproject,
+		  counts_umap *rall);
 	limcounts(const limcounts &);
-	limcounts &operator=(const limcounts &);
+	limcounts &operator=(const limcounts &) = delete;
 	~limcounts();
 };
 
+class lim_cache;
+
 static int
 check_max_group_res(resource_resv *, counts_umap &,
-		    resdef **, void *);
+		    resdef **, lim_cache *);
 static int
 check_max_project_res(resource_resv *, counts_umap &,
-		      resdef **, void *);
+		      resdef **, lim_cache *);
 static int
 check_max_user_res(resource_resv *, counts_umap &,
-		   resdef **, void *);
+		   resdef **, lim_cache *);
 static int
 check_max_group_res_soft(resource_resv *,
-			 counts_umap &, void *, int);
+			 counts_umap &, lim_cache *, int);
 static int
 check_max_project_res_soft(resource_resv *,
-			   counts_umap &, void *, int);
+			   counts_umap &, lim_cache *, int);
 static int
 check_max_user_res_soft(resource_resv **, resource_resv *,
-			counts_umap &, void *, int);
+			counts_umap &, lim_cache *, int);
 static int
 check_server_max_user_run(server_info *, queue_info *,
 			  resource_resv *, limcounts *, limcounts *, schd_error *);
@@ -369,9 +385,6 @@ static int
 lim_callback(void *, enum lim_keytypes, char *, char *,
 	     char *, char *);
 static void *lim_dup_ctx(void *);
-static char *lim_gengroupreskey(const char *);
-static char *lim_genprojectreskey(const char *);
-static char *lim_genuserreskey(const char *);
 static void schderr_args_q(const std::string &, const char *, schd_error *);
 static void schderr_args_q(const std::string &, const std::string &, schd_error *);
 static void schderr_args_q_res(const std::string &, const char *, char *, schd_error *);
@@ -380,10 +393,48 @@ static void schderr_args_server(const char *, schd_error *);
 static void schderr_args_server(const std::string &, schd_error *);
 static void schderr_args_server_res(std::string &, const char *, schd_error *);
 static sch_resource_t lim_get(const char *, void *);
+static sch_resource_t lim_cache_get(lim_cache *, enum lim_keytypes, int, const char *, resdef *);
+static int genparam_id(void);
+static int allparam_id(void);
 static int lim_setoldlimits(const struct attrl *, void *);
 static int lim_setreslimits(const struct attrl *, void *);
 static int lim_setrunlimits(const struct attrl *, void *);
 
+/* check mode, see lim_cache_set_check() */
+static bool lim_check;
+static int lim_checked;
+static int lim_mismatches;
+
+/**
+ * @class	lim_cache
+ * @brief
+ * 		limit values of one limit context indexed by entity type, interned
+ * 		entity id (see entity_id()) and limit slot.  Slot 0 of an entity is
+ * 		its run limit, slot 1 + resdef::id its limit on that resource.
+ * 		Values are read from the context the first time they are asked for,
+ * 		so each limit check is a couple of vector lookups instead of building
+ * 		a key string and parsing the limit's value.
+ *
+ * @param[in]	ctx	-	limit context the values are read from
+ * @param[in]	vals	-	per entity type, per entity id, per slot value or
+ * 				UNSPECIFIED_RES if not read yet
+ */
+class lim_cache {
+      public:
+	void *ctx;
+	std::vector<std::vector<sch_resource_t>> vals[LIM_OVERALL + 1];
+	explicit lim_cache(void *c) : ctx(c) {}
+	lim_cache(const lim_cache &oc, void *c) : lim_cache(oc)
+	{
+		ctx = c;
+	}
+	void clear()
+	{
+		for (auto &v : vals)
+			v.clear();
+	}
+};
+
 /**
  * @struct	limit_info
  * @brief
@@ -391,15 +442,21 @@ static int lim_setrunlimits(const struct attrl *, void *);
  *
  * @param[in]	li_ctxh	-	limit context for storing (hard) resource and run limits
  * @param[in]	li_ctxs	-	limit context for storing (soft) resource and run limits
+ * @param[in]	li_cacheh	-	cached values of li_ctxh
+ * @param[in]	li_caches	-	cached values of li_ctxs
  */
 struct limit_info {
 	void *li_ctxh;
 	void *li_ctxs;
+	lim_cache *li_cacheh;
+	lim_cache *li_caches;
 };
 #define LI2RESCTX(li) (((struct limit_info *) li)->li_ctxh)
 #define LI2RESCTXSOFT(li) (((struct limit_info *) li)->li_ctxs)
 #define LI2RUNCTX(li) (((struct limit_info *) li)->li_ctxh)
 #define LI2RUNCTXSOFT(li) (((struct limit_info *) li)->li_ctxs)
+#define LI2CACHE(li) (((struct limit_info *) li)->li_cacheh)
+#define LI2CACHESOFT(li) (((struct limit_info *) li)->li_caches)
 
 /**
  * @var	resource *limres
@@ -455,6 +512,9 @@ lim_alloc_liminfo(void)
 		} else
 			LI2RESCTXSOFT(lip) = ctx;
 
+		LI2CACHE(lip) = new lim_cache(LI2RESCTX(lip));
+		LI2CACHESOFT(lip) = new lim_cache(LI2RESCTXSOFT(lip));
+
 		assert(LI2RUNCTX(lip) != NULL);
 		assert(LI2RUNCTXSOFT(lip) != NULL);
 
@@ -497,6 +557,10 @@ lim_dup_liminfo(void *p)
 		} else
 			LI2RESCTXSOFT(newlip) = ctx;
 
+		/* the limits are the same, so keep what has been looked up so far */
+		LI2CACHE(newlip) = new lim_cache(*LI2CACHE(oldlip), LI2RESCTX(newlip));
+		LI2CACHESOFT(newlip) = new lim_cache(*LI2CACHESOFT(oldlip), LI2RESCTXSOFT(newlip));
+
 		/*
 		 *	We currently store both resource and run limits in a
 		 *	single member of the limit_info structure.  That might
@@ -542,6 +606,8 @@ lim_free_liminfo(void *p)
 		(void) entlim_free_ctx(LI2RUNCTXSOFT(lip), free);
 		LI2RUNCTXSOFT(lip) = NULL;
 	}
+	delete LI2CACHE(lip);
+	delete LI2CACHESOFT(lip);
 	free(lip);
 }
 /**
@@ -642,6 +708,9 @@ lim_setlimits(const struct attrl *a, enum limtype lt, void *p)
 {
 	struct limit_info *lip = static_cast<limit_info *>(p);
 
+	LI2CACHE(lip)->clear();
+	LI2CACHESOFT(lip)->clear();
+
 	switch (lt) {
 		case LIM_RES:
 			if (is_hardlimit(a))
@@ -723,45 +792,45 @@ has_softlimits(void *p)
  * @brief
  *		limitcount class constructor.
  */
-// Parametrized Constructor
+// Parametrized Constructor: private copy of the counts
 limcounts::limcounts(const counts_umap &ruser,
 		     const counts_umap &rgroup,
 		     const counts_umap &rproject,
-		     const counts_umap &rall)
+		     const counts_umap &rall) : own_user(dup_counts_umap(ruser)),
+						own_group(dup_counts_umap(rgroup)),
+						own_project(dup_counts_umap(rproject)),
+						own_all(dup_counts_umap(rall)),
+						user(own_user), group(own_group),
+						project(own_project), all(own_all)
 {
-	user = dup_counts_umap(ruser);
-	group = dup_counts_umap(rgroup);
-	project = dup_counts_umap(rproject);
-	all = dup_counts_umap(rall);
 }
 
-// Copy Constructor
-limcounts::limcounts(const limcounts &rlimit)
+// View Constructor: the counts are used in place and must outlive the view
+limcounts::limcounts(counts_umap *ruser,
+		     counts_umap *rgroup,
+		     counts_umap *rproject,
+		     counts_umap *rall) : user(*ruser), group(*rgroup),
+					  project(*rproject), all(*rall)
 {
-	user = dup_counts_umap(rlimit.user);
-	group = dup_counts_umap(rlimit.group);
-	project = dup_counts_umap(rlimit.project);
-	all = dup_counts_umap(rlimit.all);
 }
 
-// Assignment operator
-limcounts &
-limcounts::operator=(const limcounts &rlimit)
+// Copy Constructor
+limcounts::limcounts(const limcounts &rlimit) : own_user(dup_counts_umap(rlimit.user)),
+						own_group(dup_counts_umap(rlimit.group)),
+						own_project(dup_counts_umap(rlimit.project)),
+						own_all(dup_counts_umap(rlimit.all)),
+						user(own_user), group(own_group),
+						project(own_project), all(own_all)
 {
-	user = dup_counts_umap(rlimit.user);
-	group = dup_counts_umap(rlimit.group);
-	project = dup_counts_umap(rlimit.project);
-	all = dup_counts_umap(rlimit.all);
-	return *this;
 }
 
-// destructor
+// destructor: a view owns nothing, so only a copy frees anything
 limcounts::~limcounts()
 {
-	free_counts_list(user);
-	free_counts_list(group);
-	free_counts_list(project);
-	free_counts_list(all);
+	free_counts_list(own_user);
+	free_counts_list(own_group);
+	free_counts_list(own_project);
+	free_counts_list(own_all);
 }
 
 /**
@@ -962,30 +1031,30 @@ check_limits(server_info *si, queue_info *qi, resource_resv *rr, schd_error *err
 		if (svr_counts_max != NULL) {
 			server_lim = svr_counts_max;
 		} else {
-			server_lim = new limcounts(si->user_counts,
-						   si->group_counts,
-						   si->project_counts,
-						   si->alljobcounts);
+			server_lim = new limcounts(&si->user_counts,
+						   &si->group_counts,
+						   &si->project_counts,
+						   &si->alljobcounts);
 		}
 		if (que_counts_max != NULL) {
 			queue_lim = que_counts_max;
 		} else {
-			queue_lim = new limcounts(qi->user_counts,
-						  qi->group_counts,
-						  qi->project_counts,
-						  qi->alljobcounts);
+			queue_lim = new limcounts(&qi->user_counts,
+						  &qi->group_counts,
+						  &qi->project_counts,
+						  &qi->alljobcounts);
 		}
 	} else if ((flags & CHECK_CUMULATIVE_LIMIT)) {
 		if (!si->has_hard_limit && !qi->has_hard_limit)
 			return SE_NONE;
-		server_lim = new limcounts(si->total_user_counts,
-					   si->total_group_counts,
-					   si->total_project_counts,
-					   si->total_alljobcounts);
-		queue_lim = new limcounts(qi->total_user_counts,
-					  qi->total_group_counts,
-					  qi->total_project_counts,
-					  qi->total_alljobcounts);
+		server_lim = new limcounts(&si->total_user_counts,
+					   &si->total_group_counts,
+					   &si->total_project_counts,
+					   &si->total_alljobcounts);
+		queue_lim = new limcounts(&qi->total_user_counts,
+					  &qi->total_group_counts,
+					  &qi->total_project_counts,
+					  &qi->total_alljobcounts);
 	}
 	for (i = 0; i < sizeof(limfuncs) / sizeof(limfuncs[0]); i++) {
 		rc = static_cast<enum sched_error_code>((limfuncs[i])(si, qi, rr, server_lim, queue_lim, err));
@@ -1142,7 +1211,6 @@ static int
 check_server_max_user_run(server_info *si, queue_info *qi, resource_resv *rr,
 			  limcounts *sc, limcounts *qc, schd_error *err)
 {
-	char *key;
 	std::string user;
 	int used;
 	int max_user_run, max_genuser_run;
@@ -1157,15 +1225,9 @@ check_server_max_user_run(server_info *si, queue_info *qi, resource_resv *rr,
 
 	auto &cts = sc->user;
 
-	if ((key = entlim_mk_runkey(LIM_USER, user.c_str())) == NULL)
-		return (SCHD_ERROR);
-	max_user_run = (int) lim_get(key, LI2RUNCTX(si->liminfo));
-	free(key);
+	max_user_run = (int) lim_cache_get(LI2CACHE(si->liminfo), LIM_USER, rr->user_id, user.c_str(), NULL);
 
-	if ((key = entlim_mk_runkey(LIM_USER, genparam)) == NULL)
-		return (SCHD_ERROR);
-	max_genuser_run = (int) lim_get(key, LI2RUNCTX(si->liminfo));
-	free(key);
+	max_genuser_run = (int) lim_cache_get(LI2CACHE(si->liminfo), LIM_USER, genparam_id(), genparam, NULL);
 
 	if ((max_user_run == SCHD_INFINITY) &&
 	    (max_genuser_run == SCHD_INFINITY))
@@ -1212,7 +1274,6 @@ static int
 check_server_max_group_run(server_info *si, queue_info *qi, resource_resv *rr,
 			   limcounts *sc, limcounts *qc, schd_error *err)
 {
-	char *key;
 	std::string group;
 	int used;
 	int max_group_run, max_gengroup_run;
@@ -1227,15 +1288,9 @@ check_server_max_group_run(server_info *si, queue_info *qi, resource_resv *rr,
 
 	auto &cts = sc->group;
 
-	if ((key = entlim_mk_runkey(LIM_GROUP, group.c_str())) == NULL)
-		return (SCHD_ERROR);
-	max_group_run = (int) lim_get(key, LI2RUNCTX(si->liminfo));
-	free(key);
+	max_group_run = (int) lim_cache_get(LI2CACHE(si->liminfo), LIM_GROUP, rr->group_id, group.c_str(), NULL);
 
-	if ((key = entlim_mk_runkey(LIM_GROUP, genparam)) == NULL)
-		return (SCHD_ERROR);
-	max_gengroup_run = (int) lim_get(key, LI2RUNCTX(si->liminfo));
-	free(key);
+	max_gengroup_run = (int) lim_cache_get(LI2CACHE(si->liminfo), LIM_GROUP, genparam_id(), genparam, NULL);
 
 	if ((max_group_run == SCHD_INFINITY) &&
 	    (max_gengroup_run == SCHD_INFINITY))
@@ -1295,7 +1350,7 @@ check_server_max_user_res(server_info *si, queue_info *qi, resource_resv *rr,
 	auto &cts = sc->user;
 
 	ret = check_max_user_res(rr, cts, &rdef,
-				 LI2RESCTX(si->liminfo));
+				 LI2CACHE(si->liminfo));
 	if (ret != 0)
 		log_eventf(PBSEVENT_DEBUG4, PBS_EVENTCLASS_JOB, LOG_DEBUG, rr->name,
 			   "check_max_user_res returned %d", ret);
@@ -1350,7 +1405,7 @@ check_server_max_group_res(server_info *si, queue_info *qi, resource_resv *rr,
 	auto &cts = sc->group;
 
 	ret = check_max_group_res(rr, cts,
-				  &rdef, LI2RESCTX(si->liminfo));
+				  &rdef, LI2CACHE(si->liminfo));
 	if (ret != 0)
 		log_eventf(PBSEVENT_DEBUG4, PBS_EVENTCLASS_JOB, LOG_DEBUG, rr->name,
 			   "check_max_group_res returned %d", ret);
@@ -1392,7 +1447,6 @@ static int
 check_queue_max_user_run(server_info *si, queue_info *qi, resource_resv *rr,
 			 limcounts *sc, limcounts *qc, schd_error *err)
 {
-	char *key;
 	std::string user;
 	int used;
 	int max_user_run, max_genuser_run;
@@ -1407,15 +1461,9 @@ check_queue_max_user_run(server_info *si, queue_info *qi, resource_resv *rr,
 
 	auto &cts = qc->user;
 
-	if ((key = entlim_mk_runkey(LIM_USER, user.c_str())) == NULL)
-		return (SCHD_ERROR);
-	max_user_run = (int) lim_get(key, LI2RUNCTX(qi->liminfo));
-	free(key);
+	max_user_run = (int) lim_cache_get(LI2CACHE(qi->liminfo), LIM_USER, rr->user_id, user.c_str(), NULL);
 
-	if ((key = entlim_mk_runkey(LIM_USER, genparam)) == NULL)
-		return (SCHD_ERROR);
-	max_genuser_run = (int) lim_get(key, LI2RUNCTX(qi->liminfo));
-	free(key);
+	max_genuser_run = (int) lim_cache_get(LI2CACHE(qi->liminfo), LIM_USER, genparam_id(), genparam, NULL);
 
 	if ((max_user_run == SCHD_INFINITY) &&
 	    (max_genuser_run == SCHD_INFINITY))
@@ -1462,7 +1510,6 @@ static int
 check_queue_max_group_run(server_info *si, queue_info *qi, resource_resv *rr,
 			  limcounts *sc, limcounts *qc, schd_error *err)
 {
-	char *key;
 	std::string group;
 	int used;
 	int max_group_run, max_gengroup_run;
@@ -1477,15 +1524,9 @@ check_queue_max_group_run(server_info *si, queue_info *qi, resource_resv *rr,
 
 	auto &cts = qc->group;
 
-	if ((key = entlim_mk_runkey(LIM_GROUP, group.c_str())) == NULL)
-		return (SCHD_ERROR);
-	max_group_run = (int) lim_get(key, LI2RUNCTX(qi->liminfo));
-	free(key);
+	max_group_run = (int) lim_cache_get(LI2CACHE(qi->liminfo), LIM_GROUP, rr->group_id, group.c_str(), NULL);
 
-	if ((key = entlim_mk_runkey(LIM_GROUP, genparam)) == NULL)
-		return (SCHD_ERROR);
-	max_gengroup_run = (int) lim_get(key, LI2RUNCTX(qi->liminfo));
-	free(key);
+	max_gengroup_run = (int) lim_cache_get(LI2CACHE(qi->liminfo), LIM_GROUP, genparam_id(), genparam, NULL);
 
 	if ((max_group_run == SCHD_INFINITY) &&
 	    (max_gengroup_run == SCHD_INFINITY))
@@ -1544,7 +1585,7 @@ check_queue_max_user_res(server_info *si, queue_info *qi, resource_resv *rr,
 
 	auto &cts = qc->user;
 
-	ret = check_max_user_res(rr, cts, &rdef, LI2RESCTX(qi->liminfo));
+	ret = check_max_user_res(rr, cts, &rdef, LI2CACHE(qi->liminfo));
 	if (ret != 0)
 		log_eventf(PBSEVENT_DEBUG4, PBS_EVENTCLASS_JOB, LOG_DEBUG, rr->name,
 			   "check_max_user_res returned %d", ret);
@@ -1600,7 +1641,7 @@ check_queue_max_group_res(server_info *si, queue_info *qi, resource_resv *rr,
 
 	auto &cts = qc->group;
 
-	ret = check_max_group_res(rr, cts, &rdef, LI2RESCTX(qi->liminfo));
+	ret = check_max_group_res(rr, cts, &rdef, LI2CACHE(qi->liminfo));
 	if (ret != 0)
 		log_eventf(PBSEVENT_DEBUG4, PBS_EVENTCLASS_JOB, LOG_DEBUG, rr->name,
 			   "check_max_group_res returned %d", ret);
@@ -1645,7 +1686,6 @@ static int
 check_queue_max_res(server_info *si, queue_info *qi, resource_resv *rr,
 		    limcounts *sc, limcounts *qc, schd_error *err)
 {
-	char *reskey;
 	sch_resource_t max_res;
 	sch_resource_t used;
 	schd_resource *res;
@@ -1669,11 +1709,7 @@ check_queue_max_res(server_info *si, queue_info *qi, resource_resv *rr,
 		if ((req = find_resource_req(rr->resreq, res->def)) == NULL)
 			continue;
 
-		if ((reskey = entlim_mk_reskey(LIM_OVERALL, allparam,
-					       res->name)) == NULL)
-			return (SCHD_ERROR);
-		max_res = lim_get(reskey, LI2RESCTX(qi->liminfo));
-		free(reskey);
+		max_res = lim_cache_get(LI2CACHE(qi->liminfo), LIM_OVERALL, allparam_id(), allparam, res->def);
 
 		if (max_res == SCHD_INFINITY)
 			continue;
@@ -1718,7 +1754,6 @@ static int
 check_server_max_res(server_info *si, queue_info *qi, resource_resv *rr,
 		     limcounts *sc, limcounts *qc, schd_error *err)
 {
-	char *reskey;
 	sch_resource_t max_res;
 	sch_resource_t used;
 	schd_resource *res;
@@ -1743,11 +1778,7 @@ check_server_max_res(server_info *si, queue_info *qi, resource_resv *rr,
 		if ((req = find_resource_req(rr->resreq, res->def)) == NULL)
 			continue;
 
-		if ((reskey = entlim_mk_reskey(LIM_OVERALL, allparam,
-					       res->name)) == NULL)
-			return (SCHD_ERROR);
-		max_res = lim_get(reskey, LI2RESCTX(si->liminfo));
-		free(reskey);
+		max_res = lim_cache_get(LI2CACHE(si->liminfo), LIM_OVERALL, allparam_id(), allparam, res->def);
 
 		if (max_res == SCHD_INFINITY)
 			continue;
@@ -1792,7 +1823,6 @@ check_server_max_run(server_info *si, queue_info *qi, resource_resv *rr,
 		     limcounts *sc, limcounts *qc, schd_error *err)
 {
 	int max_running;
-	char *key;
 	int running;
 
 	if (si == NULL)
@@ -1803,10 +1833,7 @@ check_server_max_run(server_info *si, queue_info *qi, resource_resv *rr,
 
 	auto &cts = sc->all;
 
-	if ((key = entlim_mk_runkey(LIM_OVERALL, allparam)) == NULL)
-		return (SCHD_ERROR);
-	max_running = (int) lim_get(key, LI2RUNCTX(si->liminfo));
-	free(key);
+	max_running = (int) lim_cache_get(LI2CACHE(si->liminfo), LIM_OVERALL, allparam_id(), allparam, NULL);
 
 	running = find_counts_elm(cts, PBS_ALL_ENTITY, NULL, NULL, NULL);
 
@@ -1843,7 +1870,6 @@ check_queue_max_run(server_info *si, queue_info *qi, resource_resv *rr,
 		    limcounts *sc, limcounts *qc, schd_error *err)
 {
 	int max_running;
-	char *key;
 	int running;
 
 	if (qi == NULL)
@@ -1854,11 +1880,7 @@ check_queue_max_run(server_info *si, queue_info *qi, resource_resv *rr,
 
 	auto &cts = qc->all;
 
-	if ((key = entlim_mk_runkey(LIM_OVERALL, allparam)) == NULL)
-		return (SCHD_ERROR);
-
-	max_running = (int) lim_get(key, LI2RUNCTX(qi->liminfo));
-	free(key);
+	max_running = (int) lim_cache_get(LI2CACHE(qi->liminfo), LIM_OVERALL, allparam_id(), allparam, NULL);
 
 	running = find_counts_elm(cts, PBS_ALL_ENTITY, NULL, NULL, NULL);
 
@@ -1891,7 +1913,6 @@ static int
 check_queue_max_run_soft(server_info *si, queue_info *qi, resource_resv *rr)
 {
 	int max_running;
-	char *key;
 	counts *cnt = NULL;
 	int used = 0;
 
@@ -1901,10 +1922,7 @@ check_queue_max_run_soft(server_info *si, queue_info *qi, resource_resv *rr)
 	if (!qi->has_all_limit)
 		return (0);
 
-	if ((key = entlim_mk_runkey(LIM_OVERALL, allparam)) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_running = (int) lim_get(key, LI2RUNCTXSOFT(qi->liminfo));
-	free(key);
+	max_running = (int) lim_cache_get(LI2CACHESOFT(qi->liminfo), LIM_OVERALL, allparam_id(), allparam, NULL);
 
 	/* at this point, we know a limit is set for PBS_ALL*/
 	used = find_counts_elm(qi->alljobcounts, PBS_ALL_ENTITY, NULL, &cnt, NULL);
@@ -1938,7 +1956,6 @@ check_queue_max_run_soft(server_info *si, queue_info *qi, resource_resv *rr)
 static int
 check_queue_max_user_run_soft(server_info *si, queue_info *qi, resource_resv *rr)
 {
-	char *key;
 	std::string user;
 	int used;
 	int max_user_run_soft, max_genuser_run_soft;
@@ -1952,15 +1969,9 @@ check_queue_max_user_run_soft(server_info *si, queue_info *qi, resource_resv *rr
 
 	user = rr->user;
 
-	if ((key = entlim_mk_runkey(LIM_USER, user.c_str())) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_user_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(qi->liminfo));
-	free(key);
+	max_user_run_soft = (int) lim_cache_get(LI2CACHESOFT(qi->liminfo), LIM_USER, rr->user_id, user.c_str(), NULL);
 
-	if ((key = entlim_mk_runkey(LIM_USER, genparam)) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_genuser_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(qi->liminfo));
-	free(key);
+	max_genuser_run_soft = (int) lim_cache_get(LI2CACHESOFT(qi->liminfo), LIM_USER, genparam_id(), genparam, NULL);
 
 	if ((max_user_run_soft == SCHD_INFINITY) &&
 	    (max_genuser_run_soft == SCHD_INFINITY))
@@ -2014,7 +2025,6 @@ static int
 check_queue_max_group_run_soft(server_info *si, queue_info *qi,
 			       resource_resv *rr)
 {
-	char *key;
 	std::string group;
 	int used;
 	int max_group_run_soft, max_gengroup_run_soft;
@@ -2028,15 +2038,9 @@ check_queue_max_group_run_soft(server_info *si, queue_info *qi,
 
 	group = rr->group;
 
-	if ((key = entlim_mk_runkey(LIM_GROUP, group.c_str())) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_group_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(qi->liminfo));
-	free(key);
+	max_group_run_soft = (int) lim_cache_get(LI2CACHESOFT(qi->liminfo), LIM_GROUP, rr->group_id, group.c_str(), NULL);
 
-	if ((key = entlim_mk_runkey(LIM_GROUP, genparam)) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_gengroup_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(qi->liminfo));
-	free(key);
+	max_gengroup_run_soft = (int) lim_cache_get(LI2CACHESOFT(qi->liminfo), LIM_GROUP, genparam_id(), genparam, NULL);
 
 	if ((max_group_run_soft == SCHD_INFINITY) &&
 	    (max_gengroup_run_soft == SCHD_INFINITY))
@@ -2094,7 +2098,7 @@ check_queue_max_user_res_soft(server_info *si, queue_info *qi, resource_resv *rr
 		return (0);
 
 	return (check_max_user_res_soft(qi->running_jobs, rr, qi->user_counts,
-					LI2RESCTXSOFT(qi->liminfo), PREEMPT_TO_BIT(PREEMPT_OVER_QUEUE_LIMIT)));
+					LI2CACHESOFT(qi->liminfo), PREEMPT_TO_BIT(PREEMPT_OVER_QUEUE_LIMIT)));
 }
 
 /**
@@ -2124,7 +2128,7 @@ check_queue_max_group_res_soft(server_info *si, queue_info *qi,
 		return (0);
 
 	return (check_max_group_res_soft(rr, qi->group_counts,
-					 LI2RESCTXSOFT(qi->liminfo), PREEMPT_TO_BIT(PREEMPT_OVER_QUEUE_LIMIT)));
+					 LI2CACHESOFT(qi->liminfo), PREEMPT_TO_BIT(PREEMPT_OVER_QUEUE_LIMIT)));
 }
 
 /**
@@ -2147,7 +2151,6 @@ static int
 check_server_max_run_soft(server_info *si, queue_info *qi, resource_resv *rr)
 {
 	int max_running;
-	char *key;
 	counts *cnt = NULL;
 	int used = 0;
 
@@ -2157,10 +2160,7 @@ check_server_max_run_soft(server_info *si, queue_info *qi, resource_resv *rr)
 	if (!si->has_all_limit)
 		return (0);
 
-	if ((key = entlim_mk_runkey(LIM_OVERALL, allparam)) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_running = (int) lim_get(key, LI2RUNCTXSOFT(si->liminfo));
-	free(key);
+	max_running = (int) lim_cache_get(LI2CACHESOFT(si->liminfo), LIM_OVERALL, allparam_id(), allparam, NULL);
 
 	/* at this point, we know a limit is set for PBS_ALL*/
 	used = find_counts_elm(si->alljobcounts, PBS_ALL_ENTITY, NULL, &cnt, NULL);
@@ -2195,7 +2195,6 @@ static int
 check_server_max_user_run_soft(server_info *si, queue_info *qi,
 			       resource_resv *rr)
 {
-	char *key;
 	std::string user;
 	int used;
 	int max_user_run_soft, max_genuser_run_soft;
@@ -2209,15 +2208,9 @@ check_server_max_user_run_soft(server_info *si, queue_info *qi,
 
 	user = rr->user;
 
-	if ((key = entlim_mk_runkey(LIM_USER, user.c_str())) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_user_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(si->liminfo));
-	free(key);
+	max_user_run_soft = (int) lim_cache_get(LI2CACHESOFT(si->liminfo), LIM_USER, rr->user_id, user.c_str(), NULL);
 
-	if ((key = entlim_mk_runkey(LIM_USER, genparam)) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_genuser_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(si->liminfo));
-	free(key);
+	max_genuser_run_soft = (int) lim_cache_get(LI2CACHESOFT(si->liminfo), LIM_USER, genparam_id(), genparam, NULL);
 
 	if ((max_user_run_soft == SCHD_INFINITY) &&
 	    (max_genuser_run_soft == SCHD_INFINITY))
@@ -2270,7 +2263,6 @@ static int
 check_server_max_group_run_soft(server_info *si, queue_info *qi,
 				resource_resv *rr)
 {
-	char *key;
 	std::string group;
 	int used;
 	int max_group_run_soft, max_gengroup_run_soft;
@@ -2284,15 +2276,9 @@ check_server_max_group_run_soft(server_info *si, queue_info *qi,
 
 	group = rr->group;
 
-	if ((key = entlim_mk_runkey(LIM_GROUP, group.c_str())) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_group_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(si->liminfo));
-	free(key);
+	max_group_run_soft = (int) lim_cache_get(LI2CACHESOFT(si->liminfo), LIM_GROUP, rr->group_id, group.c_str(), NULL);
 
-	if ((key = entlim_mk_runkey(LIM_GROUP, genparam)) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_gengroup_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(si->liminfo));
-	free(key);
+	max_gengroup_run_soft = (int) lim_cache_get(LI2CACHESOFT(si->liminfo), LIM_GROUP, genparam_id(), genparam, NULL);
 
 	if ((max_group_run_soft == SCHD_INFINITY) &&
 	    (max_gengroup_run_soft == SCHD_INFINITY))
@@ -2353,7 +2339,7 @@ check_server_max_user_res_soft(server_info *si, queue_info *qi,
 		return (0);
 
 	return (check_max_user_res_soft(si->running_jobs, rr, si->user_counts,
-					LI2RESCTXSOFT(si->liminfo), PREEMPT_TO_BIT(PREEMPT_OVER_SERVER_LIMIT)));
+					LI2CACHESOFT(si->liminfo), PREEMPT_TO_BIT(PREEMPT_OVER_SERVER_LIMIT)));
 }
 
 /**
@@ -2383,7 +2369,7 @@ check_server_max_group_res_soft(server_info *si, queue_info *qi,
 		return (0);
 
 	return (check_max_group_res_soft(rr, si->group_counts,
-					 LI2RESCTXSOFT(si->liminfo), PREEMPT_TO_BIT(PREEMPT_OVER_SERVER_LIMIT)));
+					 LI2CACHESOFT(si->liminfo), PREEMPT_TO_BIT(PREEMPT_OVER_SERVER_LIMIT)));
 }
 
 /**
@@ -2404,7 +2390,6 @@ check_server_max_group_res_soft(server_info *si, queue_info *qi,
 static int
 check_server_max_res_soft(server_info *si, queue_info *qi, resource_resv *rr)
 {
-	char *reskey;
 	sch_resource_t max_res_soft;
 	sch_resource_t used;
 	schd_resource *res;
@@ -2423,11 +2408,7 @@ check_server_max_res_soft(server_info *si, queue_info *qi, resource_resv *rr)
 		if (find_resource_req(rr->resreq, res->def) == NULL)
 			continue;
 
-		if ((reskey = entlim_mk_reskey(LIM_OVERALL, allparam,
-					       res->name)) == NULL)
-			return (PREEMPT_TO_BIT(PREEMPT_ERR));
-		max_res_soft = lim_get(reskey, LI2RESCTXSOFT(si->liminfo));
-		free(reskey);
+		max_res_soft = lim_cache_get(LI2CACHESOFT(si->liminfo), LIM_OVERALL, allparam_id(), allparam, res->def);
 
 		if (max_res_soft == SCHD_INFINITY)
 			continue;
@@ -2473,7 +2454,6 @@ check_server_max_res_soft(server_info *si, queue_info *qi, resource_resv *rr)
 static int
 check_queue_max_res_soft(server_info *si, queue_info *qi, resource_resv *rr)
 {
-	char *reskey;
 	sch_resource_t max_res_soft;
 	sch_resource_t used;
 	schd_resource *res;
@@ -2492,11 +2472,7 @@ check_queue_max_res_soft(server_info *si, queue_info *qi, resource_resv *rr)
 		if (find_resource_req(rr->resreq, res->def) == NULL)
 			continue;
 
-		if ((reskey = entlim_mk_reskey(LIM_OVERALL, allparam,
-					       res->name)) == NULL)
-			return (PREEMPT_TO_BIT(PREEMPT_ERR));
-		max_res_soft = lim_get(reskey, LI2RESCTXSOFT(qi->liminfo));
-		free(reskey);
+		max_res_soft = lim_cache_get(LI2CACHESOFT(qi->liminfo), LIM_OVERALL, allparam_id(), allparam, res->def);
 
 		if (max_res_soft == SCHD_INFINITY)
 			continue;
@@ -2542,10 +2518,8 @@ check_queue_max_res_soft(server_info *si, queue_info *qi, resource_resv *rr)
  */
 static int
 check_max_group_res(resource_resv *rr, counts_umap &cts_list,
-		    resdef **rdef, void *limitctx)
+		    resdef **rdef, lim_cache *limitctx)
 {
-	char *groupreskey;
-	char *gengroupreskey;
 	std::string group;
 	schd_resource *res;
 	sch_resource_t max_group_res;
@@ -2565,17 +2539,10 @@ check_max_group_res(resource_resv *rr, counts_umap &cts_list,
 			continue;
 
 		/* individual group limit check */
-		if ((groupreskey = entlim_mk_reskey(LIM_GROUP, group.c_str(),
-						    res->name)) == NULL)
-			return (-1);
-		max_group_res = lim_get(groupreskey, limitctx);
-		free(groupreskey);
+		max_group_res = lim_cache_get(limitctx, LIM_GROUP, rr->group_id, group.c_str(), res->def);
 
 		/* generic group limit check */
-		if ((gengroupreskey = lim_gengroupreskey(res->name)) == NULL)
-			return (-1);
-		max_gengroup_res = lim_get(gengroupreskey, limitctx);
-		free(gengroupreskey);
+		max_gengroup_res = lim_cache_get(limitctx, LIM_GROUP, genparam_id(), genparam, res->def);
 
 		if ((max_group_res == SCHD_INFINITY) &&
 		    (max_gengroup_res == SCHD_INFINITY))
@@ -2620,10 +2587,8 @@ check_max_group_res(resource_resv *rr, counts_umap &cts_list,
  * @retval	-1	: on error
  */
 static int
-check_max_group_res_soft(resource_resv *rr, counts_umap &cts_list, void *limitctx, int preempt_bit)
+check_max_group_res_soft(resource_resv *rr, counts_umap &cts_list, lim_cache *limitctx, int preempt_bit)
 {
-	char *groupreskey;
-	char *gengroupreskey;
 	std::string group;
 	schd_resource *res;
 	sch_resource_t max_group_res_soft;
@@ -2645,17 +2610,10 @@ check_max_group_res_soft(resource_resv *rr, counts_umap &cts_list, void *limitct
 			continue;
 
 		/* individual group limit check */
-		if ((groupreskey = entlim_mk_reskey(LIM_GROUP, group.c_str(),
-						    res->name)) == NULL)
-			return (-1);
-		max_group_res_soft = lim_get(groupreskey, limitctx);
-		free(groupreskey);
+		max_group_res_soft = lim_cache_get(limitctx, LIM_GROUP, rr->group_id, group.c_str(), res->def);
 
 		/* generic group limit check */
-		if ((gengroupreskey = lim_gengroupreskey(res->name)) == NULL)
-			return (-1);
-		max_gengroup_res_soft = lim_get(gengroupreskey, limitctx);
-		free(gengroupreskey);
+		max_gengroup_res_soft = lim_cache_get(limitctx, LIM_GROUP, genparam_id(), genparam, res->def);
 
 		if ((max_group_res_soft == SCHD_INFINITY) &&
 		    (max_gengroup_res_soft == SCHD_INFINITY))
@@ -2710,10 +2668,8 @@ check_max_group_res_soft(resource_resv *rr, counts_umap &cts_list, void *limitct
  */
 static int
 check_max_user_res(resource_resv *rr, counts_umap &cts_list, resdef **rdef,
-		   void *limitctx)
+		   lim_cache *limitctx)
 {
-	char *userreskey;
-	char *genuserreskey;
 	std::string user;
 	schd_resource *res;
 	sch_resource_t max_user_res;
@@ -2734,17 +2690,10 @@ check_max_user_res(resource_resv *rr, counts_umap &cts_list, resdef **rdef,
 			continue;
 
 		/* individual user limit check */
-		if ((userreskey = entlim_mk_reskey(LIM_USER, user.c_str(),
-						   res->name)) == NULL)
-			return (-1);
-		max_user_res = lim_get(userreskey, limitctx);
-		free(userreskey);
+		max_user_res = lim_cache_get(limitctx, LIM_USER, rr->user_id, user.c_str(), res->def);
 
 		/* generic user limit check */
-		if ((genuserreskey = lim_genuserreskey(res->name)) == NULL)
-			return (-1);
-		max_genuser_res = lim_get(genuserreskey, limitctx);
-		free(genuserreskey);
+		max_genuser_res = lim_cache_get(limitctx, LIM_USER, genparam_id(), genparam, res->def);
 
 		if ((max_user_res == SCHD_INFINITY) &&
 		    (max_genuser_res == SCHD_INFINITY))
@@ -2791,10 +2740,8 @@ check_max_user_res(resource_resv *rr, counts_umap &cts_list, resdef **rdef,
  */
 static int
 check_max_user_res_soft(resource_resv **rr_arr, resource_resv *rr,
-			counts_umap &cts_list, void *limitctx, int preempt_bit)
+			counts_umap &cts_list, lim_cache *limitctx, int preempt_bit)
 {
-	char *userreskey;
-	char *genuserreskey;
 	std::string user;
 	schd_resource *res;
 	sch_resource_t max_user_res_soft;
@@ -2816,17 +2763,10 @@ check_max_user_res_soft(resource_resv **rr_arr, resource_resv *rr,
 			continue;
 
 		/* individual user limit check */
-		if ((userreskey = entlim_mk_reskey(LIM_USER, user.c_str(),
-						   res->name)) == NULL)
-			return (-1);
-		max_user_res_soft = lim_get(userreskey, limitctx);
-		free(userreskey);
+		max_user_res_soft = lim_cache_get(limitctx, LIM_USER, rr->user_id, user.c_str(), res->def);
 
 		/* generic user limit check */
-		if ((genuserreskey = lim_genuserreskey(res->name)) == NULL)
-			return (-1);
-		max_genuser_res_soft = lim_get(genuserreskey, limitctx);
-		free(genuserreskey);
+		max_genuser_res_soft = lim_cache_get(limitctx, LIM_USER, genparam_id(), genparam, res->def);
 
 		if ((max_user_res_soft == SCHD_INFINITY) &&
 		    (max_genuser_res_soft == SCHD_INFINITY))
@@ -3128,54 +3068,6 @@ is_hardlimit(const struct attrl *a)
 		return (0);
 }
 
-/**
- * @brief
- *		lim_gengroupreskey	special-purpose shortcut function to construct a
- *				generic group resource key
- *
- * @param[in]	res	-	the resource
- *
- * @return	a resource limit key if successful
- * @retval	NULL	: if not
- */
-static char *
-lim_gengroupreskey(const char *res)
-{
-	return (entlim_mk_reskey(LIM_GROUP, genparam, res));
-}
-
-/**
- * @brief
- *		lim_genprojectreskey	special-purpose shortcut function to construct a
- *				generic project resource key
- *
- * @param[in]	res	-	the resource
- *
- * @return	a resource limit key if successful
- * @retval	NULL	: if not
- */
-static char *
-lim_genprojectreskey(const char *res)
-{
-	return (entlim_mk_reskey(LIM_PROJECT, genparam, res));
-}
-
-/**
- * @brief
- *		lim_genuserreskey	special-purpose shortcut function to construct a
- *				generic user resource key
- *
- * @param[in]	res	-	the resource
- *
- * @return	a resource limit key on success
- * @retval	NULL	: on failure
- */
-static char *
-lim_genuserreskey(const char *res)
-{
-	return (entlim_mk_reskey(LIM_USER, genparam, res));
-}
-
 /**
  * @brief
  *		lim_callback install a new key of the given type and value
@@ -3260,6 +3152,134 @@ lim_get(const char *param, void *ctx)
 	}
 }
 
+/**
+ * @brief
+ *		lim_cache_get	fetch a limit value by entity id
+ *
+ * @param[in]	lc	-	the cached limit storage context
+ * @param[in]	kt	-	entity type of the limit
+ * @param[in]	id	-	interned id of entity, or < 0 to intern it here
+ * @param[in]	entity	-	name of the entity
+ * @param[in]	def	-	resource of the limit, or NULL for a run limit
+ *
+ * @return	sch_resource_t
+ * @retval	the value of the limit
+ * @retval	SCHD_INFINITY if no such limit exists in the named context
+ *
+ * @par MT-Safe:	no
+ * @par
+ *		The cache is filled in here without a lock.  That is safe only
+ *		because limits are checked on the main thread (tid 0): the worker
+ *		threads copy limit_infos with their caches but never check limits.
+ *		A limit checked from a worker thread would need the cache filled
+ *		under a lock, or filled up front.
+ */
+static sch_resource_t
+lim_cache_get(lim_cache *lc, enum lim_keytypes kt, int id, const char *entity, resdef *def)
+{
+	char *key;
+	sch_resource_t v;
+	sch_resource_t *cached = NULL;
+
+	/* resources without an index can't be cached, read them directly */
+	if (def == NULL || def->id >= 0) {
+		size_t slot = (def == NULL) ? 0 : def->id + 1;
+
+		if (id < 0)
+			id = entity_id(entity);
+
+		auto &ents = lc->vals[kt];
+		if (ents.size() <= static_cast<size_t>(id))
+			ents.resize(id + 1);
+		auto &slots = ents[id];
+		if (slots.size() <= slot)
+			slots.resize(slot + 1, UNSPECIFIED_RES);
+		cached = &slots[slot];
+		if (*cached != UNSPECIFIED_RES && !lim_check)
+			return *cached;
+	}
+
+	if (def != NULL)
+		key = entlim_mk_reskey(kt, entity, def->name.c_str());
+	else
+		key = entlim_mk_runkey(kt, entity);
+	if (key == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return (SCHD_INFINITY);
+	}
+	v = lim_get(key, lc->ctx);
+
+	if (cached != NULL && *cached != UNSPECIFIED_RES) {
+		/* check mode: the cached value must be what the context holds now */
+		lim_checked++;
+		if (*cached != v) {
+			lim_mismatches++;
+			log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_SCHED, LOG_WARNING, __func__,
+				   "Limit cache check: %s is cached as %.0f, limit is %.0f", key, *cached, v);
+		}
+		v = *cached;
+	}
+	free(key);
+
+	if (cached != NULL)
+		*cached = v;
+	return (v);
+}
+
+/**
+ * @brief
+ *		set or clear check mode.  In check mode lim_cache_get() reads
+ *		every limit it has cached again from its limit context and
+ *		compares the two.  The cached value is still the one used.
+ *
+ * @param[in]	check	-	true to check cached limit values
+ *
+ * @return	void
+ */
+void
+lim_cache_set_check(bool check)
+{
+	lim_check = check;
+	lim_checked = 0;
+	lim_mismatches = 0;
+}
+
+/**
+ * @brief	the number of cached limit values lim_cache_get() compared and
+ *		how many of them differed from their limit context
+ *
+ * @param[out]	checked	-	cached values compared
+ * @param[out]	mismatches	-	cached values which differed
+ *
+ * @return	void
+ */
+void
+lim_cache_check_results(int *checked, int *mismatches)
+{
+	*checked = lim_checked;
+	*mismatches = lim_mismatches;
+}
+
+/**
+ * @brief	interned id of the generic entity of generic limits
+ */
+static int
+genparam_id(void)
+{
+	static const int id = entity_id(genparam);
+	return id;
+}
+
+/**
+ * @brief	interned id of the entity of overall limits
+ */
+static int
+allparam_id(void)
+{
+	static const int id = entity_id(allparam);
+	return id;
+}
+
 /**
  * @brief
  *		schderr_args_q	log a queue-related run limit exceeded message
@@ -3367,10 +3387,8 @@ schderr_args_server_res(std::string &entity, const char *res, schd_error *err)
  */
 static int
 check_max_project_res(resource_resv *rr, counts_umap &cts_list,
-		      resdef **rdef, void *limitctx)
+		      resdef **rdef, lim_cache *limitctx)
 {
-	char *projectreskey;
-	char *genprojectreskey;
 	schd_resource *res;
 	std::string project;
 	sch_resource_t max_project_res;
@@ -3389,17 +3407,10 @@ check_max_project_res(resource_resv *rr, counts_umap &cts_list,
 			continue;
 
 		/* individual project limit check */
-		if ((projectreskey = entlim_mk_reskey(LIM_PROJECT,
-						      project.c_str(), res->name)) == NULL)
-			return (-1);
-		max_project_res = lim_get(projectreskey, limitctx);
-		free(projectreskey);
+		max_project_res = lim_cache_get(limitctx, LIM_PROJECT, rr->project_id, project.c_str(), res->def);
 
 		/* generic project limit check */
-		if ((genprojectreskey = lim_genprojectreskey(res->name)) == NULL)
-			return (-1);
-		max_genproject_res = lim_get(genprojectreskey, limitctx);
-		free(genprojectreskey);
+		max_genproject_res = lim_cache_get(limitctx, LIM_PROJECT, genparam_id(), genparam, res->def);
 
 		if ((max_project_res == SCHD_INFINITY) &&
 		    (max_genproject_res == SCHD_INFINITY))
@@ -3444,10 +3455,8 @@ check_max_project_res(resource_resv *rr, counts_umap &cts_list,
  * @retval	-1	: on error
  */
 static int
-check_max_project_res_soft(resource_resv *rr, counts_umap &cts_list, void *limitctx, int preempt_bit)
+check_max_project_res_soft(resource_resv *rr, counts_umap &cts_list, lim_cache *limitctx, int preempt_bit)
 {
-	char *projectreskey;
-	char *genprojectreskey;
 	std::string project;
 	schd_resource *res;
 	sch_resource_t max_project_res_soft;
@@ -3468,17 +3477,10 @@ check_max_project_res_soft(resource_resv *rr, counts_umap &cts_list, void *limit
 			continue;
 
 		/* individual project limit check */
-		if ((projectreskey = entlim_mk_reskey(LIM_PROJECT, project.c_str(),
-						      res->name)) == NULL)
-			return (-1);
-		max_project_res_soft = lim_get(projectreskey, limitctx);
-		free(projectreskey);
+		max_project_res_soft = lim_cache_get(limitctx, LIM_PROJECT, rr->project_id, project.c_str(), res->def);
 
 		/* generic project limit check */
-		if ((genprojectreskey = lim_genprojectreskey(res->name)) == NULL)
-			return (-1);
-		max_genproject_res_soft = lim_get(genprojectreskey, limitctx);
-		free(genprojectreskey);
+		max_genproject_res_soft = lim_cache_get(limitctx, LIM_PROJECT, genparam_id(), genparam, res->def);
 
 		if ((max_project_res_soft == SCHD_INFINITY) &&
 		    (max_genproject_res_soft == SCHD_INFINITY))
@@ -3553,7 +3555,7 @@ check_server_max_project_res(server_info *si, queue_info *qi, resource_resv *rr,
 	auto &cts = sc->project;
 
 	ret = check_max_project_res(rr, cts,
-				    &rdef, LI2RESCTX(si->liminfo));
+				    &rdef, LI2CACHE(si->liminfo));
 	if (ret != 0) {
 		log_eventf(PBSEVENT_DEBUG4, PBS_EVENTCLASS_JOB, LOG_DEBUG, rr->name,
 			   "check_max_project_res returned %d", ret);
@@ -3594,7 +3596,6 @@ static int
 check_server_max_project_run_soft(server_info *si, queue_info *qi,
 				  resource_resv *rr)
 {
-	char *key;
 	std::string project;
 	int used;
 	int max_project_run_soft, max_genproject_run_soft;
@@ -3610,15 +3611,9 @@ check_server_max_project_run_soft(server_info *si, queue_info *qi,
 		return (0);
 
 	project = rr->project;
-	if ((key = entlim_mk_runkey(LIM_PROJECT, project.c_str())) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_project_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(si->liminfo));
-	free(key);
+	max_project_run_soft = (int) lim_cache_get(LI2CACHESOFT(si->liminfo), LIM_PROJECT, rr->project_id, project.c_str(), NULL);
 
-	if ((key = entlim_mk_runkey(LIM_PROJECT, genparam)) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_genproject_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(si->liminfo));
-	free(key);
+	max_genproject_run_soft = (int) lim_cache_get(LI2CACHESOFT(si->liminfo), LIM_PROJECT, genparam_id(), genparam, NULL);
 
 	if ((max_project_run_soft == SCHD_INFINITY) &&
 	    (max_genproject_run_soft == SCHD_INFINITY))
@@ -3678,7 +3673,7 @@ check_server_max_project_res_soft(server_info *si, queue_info *qi,
 		return (0);
 
 	return (check_max_project_res_soft(rr, si->project_counts,
-					   LI2RESCTXSOFT(si->liminfo), PREEMPT_TO_BIT(PREEMPT_OVER_SERVER_LIMIT)));
+					   LI2CACHESOFT(si->liminfo), PREEMPT_TO_BIT(PREEMPT_OVER_SERVER_LIMIT)));
 }
 
 /**
@@ -3718,7 +3713,7 @@ check_queue_max_project_res(server_info *si, queue_info *qi, resource_resv *rr,
 
 	auto &cts = qc->project;
 
-	ret = check_max_project_res(rr, cts, &rdef, LI2RESCTX(qi->liminfo));
+	ret = check_max_project_res(rr, cts, &rdef, LI2CACHE(qi->liminfo));
 	if (ret != 0)
 		log_eventf(PBSEVENT_DEBUG4, PBS_EVENTCLASS_JOB, LOG_DEBUG, rr->name,
 			   "check_max_project_res returned %d", ret);
@@ -3759,7 +3754,6 @@ static int
 check_queue_max_project_run_soft(server_info *si, queue_info *qi,
 				 resource_resv *rr)
 {
-	char *key;
 	std::string project;
 	int used;
 	int max_project_run_soft, max_genproject_run_soft;
@@ -3775,15 +3769,9 @@ check_queue_max_project_run_soft(server_info *si, queue_info *qi,
 		return (0);
 
 	project = rr->project;
-	if ((key = entlim_mk_runkey(LIM_PROJECT, project.c_str())) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_project_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(qi->liminfo));
-	free(key);
+	max_project_run_soft = (int) lim_cache_get(LI2CACHESOFT(qi->liminfo), LIM_PROJECT, rr->project_id, project.c_str(), NULL);
 
-	if ((key = entlim_mk_runkey(LIM_PROJECT, genparam)) == NULL)
-		return (PREEMPT_TO_BIT(PREEMPT_ERR));
-	max_genproject_run_soft = (int) lim_get(key, LI2RUNCTXSOFT(qi->liminfo));
-	free(key);
+	max_genproject_run_soft = (int) lim_cache_get(LI2CACHESOFT(qi->liminfo), LIM_PROJECT, genparam_id(), genparam, NULL);
 
 	if ((max_project_run_soft == SCHD_INFINITY) &&
 	    (max_genproject_run_soft == SCHD_INFINITY))
@@ -3843,7 +3831,7 @@ check_queue_max_project_res_soft(server_info *si, queue_info *qi,
 		return (0);
 
 	return (check_max_project_res_soft(rr, qi->project_counts,
-					   LI2RESCTXSOFT(qi->liminfo), PREEMPT_TO_BIT(PREEMPT_OVER_QUEUE_LIMIT)));
+					   LI2CACHESOFT(qi->liminfo), PREEMPT_TO_BIT(PREEMPT_OVER_QUEUE_LIMIT)));
 }
 
 /**
@@ -3869,7 +3857,6 @@ static int
 check_server_max_project_run(server_info *si, queue_info *qi, resource_resv *rr,
 			     limcounts *sc, limcounts *qc, schd_error *err)
 {
-	char *key;
 	std::string project;
 	int used;
 	int max_project_run, max_genproject_run;
@@ -3886,15 +3873,9 @@ check_server_max_project_run(server_info *si, queue_info *qi, resource_resv *rr,
 		return (0);
 
 	project = rr->project;
-	if ((key = entlim_mk_runkey(LIM_PROJECT, project.c_str())) == NULL)
-		return (SCHD_ERROR);
-	max_project_run = (int) lim_get(key, LI2RUNCTX(si->liminfo));
-	free(key);
+	max_project_run = (int) lim_cache_get(LI2CACHE(si->liminfo), LIM_PROJECT, rr->project_id, project.c_str(), NULL);
 
-	if ((key = entlim_mk_runkey(LIM_PROJECT, genparam)) == NULL)
-		return (SCHD_ERROR);
-	max_genproject_run = (int) lim_get(key, LI2RUNCTX(si->liminfo));
-	free(key);
+	max_genproject_run = (int) lim_cache_get(LI2CACHE(si->liminfo), LIM_PROJECT, genparam_id(), genparam, NULL);
 
 	if ((max_project_run == SCHD_INFINITY) &&
 	    (max_genproject_run == SCHD_INFINITY))
@@ -3943,7 +3924,6 @@ static int
 check_queue_max_project_run(server_info *si, queue_info *qi, resource_resv *rr,
 			    limcounts *sc, limcounts *qc, schd_error *err)
 {
-	char *key;
 	std::string project;
 	int used;
 	int max_project_run, max_genproject_run;
@@ -3960,15 +3940,9 @@ check_queue_max_project_run(server_info *si, queue_info *qi, resource_resv *rr,
 	if (!qi->has_proj_limit)
 		return (0);
 
-	if ((key = entlim_mk_runkey(LIM_PROJECT, project.c_str())) == NULL)
-		return (SCHD_ERROR);
-	max_project_run = (int) lim_get(key, LI2RUNCTX(qi->liminfo));
-	free(key);
+	max_project_run = (int) lim_cache_get(LI2CACHE(qi->liminfo), LIM_PROJECT, rr->project_id, project.c_str(), NULL);
 
-	if ((key = entlim_mk_runkey(LIM_PROJECT, genparam)) == NULL)
-		return (SCHD_ERROR);
-	max_genproject_run = (int) lim_get(key, LI2RUNCTX(qi->liminfo));
-	free(key);
+	max_genproject_run = (int) lim_cache_get(LI2CACHE(qi->liminfo), LIM_PROJECT, genparam_id(), genparam, NULL);
 
 	if ((max_project_run == SCHD_INFINITY) &&
 	    (max_genproject_run == SCHD_INFINITY))
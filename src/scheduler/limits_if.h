@@ -238,4 +238,21 @@ void update_soft_limits(server_info *, queue_info *, resource_resv *);
  * @return	int
  */
 int find_preempt_bits(counts *, std::string &, resource_resv *);
+
+/**	@fn void lim_cache_set_check(bool check)
+ *	@brief	in check mode, compare every cached limit value used against
+ *		the value in its limit context
+ *
+ *	@param check	true to check cached limit values
+ *
+ *	@return void
+ */
+void lim_cache_set_check(bool);
+
+/**	@fn void lim_cache_check_results(int *checked, int *mismatches)
+ *	@brief	cached limit values compared and how many of them differed
+ *
+ *	@return void
+ */
+void lim_cache_check_results(int *, int *);
 #endif /* _LIMITS_IF_H */
@@ -56,6 +56,7 @@
 #include <libutil.h>
 #include <log.h>
 #include <math.h>
+#include <pthread.h>
 #include <pbs_error.h>
 #include <pbs_ifl.h>
 #include <pbs_internal.h>
@@ -1588,3 +1589,63 @@ break_comma_list(const std::string &strlist)
 		ret.push_back(str);
 	return ret;
 }
+
+/* interned entity names, see entity_id() */
+static std::unordered_map<std::string, int> entity_ids;
+static pthread_mutex_t entity_ids_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief	intern a user, group, project or fairshare entity name to a
+ *		small dense integer.  Ids are handed out in order starting at 0
+ *		and stay the same for the life of the scheduler, so they can be
+ *		used as array indices across cycles.
+ *
+ * @param[in]	name - entity name
+ *
+ * @return	int
+ * @retval	id of name
+ *
+ * @par MT-safe: Yes
+ */
+int
+entity_id(const std::string &name)
+{
+	int id;
+
+	pthread_mutex_lock(&entity_ids_lock);
+	auto it = entity_ids.find(name);
+	if (it != entity_ids.end())
+		id = it->second;
+	else {
+		id = entity_ids.size();
+		entity_ids[name] = id;
+	}
+	pthread_mutex_unlock(&entity_ids_lock);
+
+	return id;
+}
+
+/**
+ * @brief	look up the id of an entity name without interning it
+ *
+ * @param[in]	name - entity name
+ *
+ * @return	int
+ * @retval	id of name
+ * @retval	-1 if name has never been interned
+ *
+ * @par MT-safe: Yes
+ */
+int
+find_entity_id(const std::string &name)
+{
+	int id = -1;
+
+	pthread_mutex_lock(&entity_ids_lock);
+	auto it = entity_ids.find(name);
+	if (it != entity_ids.end())
+		id = it->second;
+	pthread_mutex_unlock(&entity_ids_lock);
+
+	return id;
+}
@@ -276,4 +276,14 @@ void log_event(int eventtype, int objclass, int sev, const std::string &objname,
  * overloaded break_comma_list function
  */
 std::vector<std::string> break_comma_list(const std::string &strlist);
+
+/*
+ * intern a user/group/project/fairshare entity name to a dense integer id
+ */
+int entity_id(const std::string &name);
+
+/*
+ * look up the id of an entity name, -1 if it was never interned
+ */
+int find_entity_id(const std::string &name);
 #endif /* _MISC_H */
@@ -45,6 +45,10 @@
 #include <pthread.h>
 #include <errno.h>
 #include <signal.h>
+#include <time.h>
+
+#include <atomic>
+#include <deque>
 
 #include "log.h"
 #include "pbs_idx.h"
@@ -57,8 +61,45 @@
 #include "queue.h"
 #include "fifo.h"
 #include "resource_resv.h"
+#include "node_partition.h"
+#include "profile.h"
+#include "sort.h"
 #include "multi_threading.h"
 
+/*
+ * Each worker thread has its own deque of tasks.  The main thread deals
+ * tasks out round robin.  A worker takes the oldest task of its own deque
+ * and when that is empty, steals the oldest task of another's deque.
+ * Tasks are thus started roughly in the order they were queued, so a
+ * caller consuming results in order gets the first ones first.  Each
+ * deque has its own lock, so workers only contend when stealing.
+ */
+struct task_deque {
+	pthread_mutex_t lock;
+	std::deque<th_task_info *> tasks;
+};
+
+static task_deque *task_deques = NULL;
+static int next_deque = 0;		     /* deque the next task is dealt to */
+static std::atomic<int> tasks_pending(0); /* tasks queued and not yet taken */
+
+/* per task type counters, see log_thread_task_stats() */
+#define NUM_TASK_TYPES (TS_SORT_KEYS + 1)
+static std::atomic<long> task_count[NUM_TASK_TYPES];
+static std::atomic<long> task_stolen[NUM_TASK_TYPES];
+static std::atomic<long long> task_usecs[NUM_TASK_TYPES];
+
+static const char *task_names[NUM_TASK_TYPES] = {
+	"check_node_eligibility_chunk",
+	"dup_node_info_chunk",
+	"query_node_info_chunk",
+	"free_node_info_chunk",
+	"dup_resource_resv_array_chunk",
+	"query_jobs_chunk",
+	"free_resource_resv_array_chunk",
+	"nodepart_fit_chunk",
+	"sort_keys_chunk"};
+
 /**
  * @brief	create the thread id key & set it for the main thread
  *
@@ -82,6 +123,27 @@ create_id_key(void)
 	pthread_setspecific(th_id_key, (void *) mainid);
 }
 
+/**
+ * @brief	free the per worker task deques
+ *
+ * @param	void
+ *
+ * @return	void
+ */
+static void
+free_task_deques(void)
+{
+	if (task_deques == NULL)
+		return;
+
+	for (int i = 0; i < num_threads; i++)
+		pthread_mutex_destroy(&task_deques[i].lock);
+	delete[] task_deques;
+	task_deques = NULL;
+	tasks_pending = 0;
+	next_deque = 0;
+}
+
 /**
  * @brief	convenience function to kill worker threads
  *
@@ -112,11 +174,10 @@ kill_threads(void)
 	pthread_cond_destroy(&result_cond);
 	pthread_mutex_destroy(&general_lock);
 	free(threads);
-	free_ds_queue(work_queue);
+	free_task_deques();
 	free_ds_queue(result_queue);
 	threads = NULL;
 	num_threads = 0;
-	work_queue = NULL;
 	result_queue = NULL;
 }
 
@@ -184,17 +245,14 @@ init_multi_threading(int nthreads)
 		return 0;
 	}
 
-	/* Create task and result queues */
-	work_queue = new_ds_queue();
-	if (work_queue == NULL) {
-		free(threads);
-		return 0;
-	}
+	/* Create the task deques and result queue */
+	task_deques = new task_deque[num_threads];
+	for (i = 0; i < num_threads; i++)
+		pthread_mutex_init(&task_deques[i].lock, NULL);
 	result_queue = new_ds_queue();
 	if (result_queue == NULL) {
 		free(threads);
-		free_ds_queue(work_queue);
-		work_queue = NULL;
+		free_task_deques();
 		return 0;
 	}
 
@@ -205,9 +263,8 @@ init_multi_threading(int nthreads)
 		thid = static_cast<int *>(malloc(sizeof(int)));
 		if (thid == NULL) {
 			free(threads);
-			free_ds_queue(work_queue);
+			free_task_deques();
 			free_ds_queue(result_queue);
-			work_queue = NULL;
 			result_queue = NULL;
 			log_err(errno, __func__, MEM_ERR_MSG);
 			return 0;
@@ -219,6 +276,39 @@ init_multi_threading(int nthreads)
 	return 1;
 }
 
+/**
+ * @brief	take the next task for a worker thread: the oldest task of its
+ *		own deque, or else the oldest task of another thread's deque
+ *
+ * @param[in]	idx - index of the worker's deque
+ * @param[out]	stolen - set to whether the task came from another deque
+ *
+ * @return	th_task_info *
+ * @retval	the task
+ * @retval	NULL if there is no queued task
+ */
+static th_task_info *
+take_task(int idx, bool *stolen)
+{
+	th_task_info *task = NULL;
+
+	for (int i = 0; i < num_threads && task == NULL; i++) {
+		task_deque *dq = &task_deques[(idx + i) % num_threads];
+
+		pthread_mutex_lock(&dq->lock);
+		if (!dq->tasks.empty()) {
+			task = dq->tasks.front();
+			dq->tasks.pop_front();
+		}
+		pthread_mutex_unlock(&dq->lock);
+		*stolen = (i != 0);
+	}
+	if (task != NULL)
+		tasks_pending--;
+
+	return task;
+}
+
 /**
  * @brief	Main pthread routine for worker threads
  *
@@ -232,7 +322,9 @@ worker(void *tid)
 	th_task_info *work = NULL;
 	sigset_t set;
 	int ntid;
-	char buf[1024];
+	bool stolen;
+	struct timespec start;
+	struct timespec end;
 
 	pthread_setspecific(th_id_key, tid);
 	ntid = *(int *) tid;
@@ -248,63 +340,72 @@ worker(void *tid)
 	}
 
 	while (!threads_die) {
-		/* Get the next work task from work queue */
-		pthread_mutex_lock(&work_lock);
-		while (ds_queue_is_empty(work_queue) && !threads_die) {
-			pthread_cond_wait(&work_cond, &work_lock);
+		/* Get the next work task, stealing it if need be */
+		work = take_task(ntid - 1, &stolen);
+		if (work == NULL) {
+			pthread_mutex_lock(&work_lock);
+			while (tasks_pending <= 0 && !threads_die)
+				pthread_cond_wait(&work_cond, &work_lock);
+			pthread_mutex_unlock(&work_lock);
+			continue;
 		}
-		work = static_cast<th_task_info *>(ds_dequeue(work_queue));
-		pthread_mutex_unlock(&work_lock);
-
-		/* find out what task we need to do */
-		if (work != NULL) {
-			switch (work->task_type) {
-				case TS_IS_ND_ELIGIBLE:
-					snprintf(buf, sizeof(buf), "Thread %d calling check_node_eligibility_chunk()", ntid);
-					log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
-					check_node_eligibility_chunk(static_cast<th_data_nd_eligible *>(work->thread_data));
-					break;
-				case TS_DUP_ND_INFO:
-					snprintf(buf, sizeof(buf), "Thread %d calling dup_node_info_chunk()", ntid);
-					log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
-					dup_node_info_chunk(static_cast<th_data_dup_nd_info *>(work->thread_data));
-					break;
-				case TS_QUERY_ND_INFO:
-					snprintf(buf, sizeof(buf), "Thread %d calling query_node_info_chunk()", ntid);
-					log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
-					query_node_info_chunk(static_cast<th_data_query_ninfo *>(work->thread_data));
-					break;
-				case TS_FREE_ND_INFO:
-					snprintf(buf, sizeof(buf), "Thread %d calling free_node_info_chunk()", ntid);
-					log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
-					free_node_info_chunk(static_cast<th_data_free_ninfo *>(work->thread_data));
-					break;
-				case TS_DUP_RESRESV:
-					snprintf(buf, sizeof(buf), "Thread %d calling dup_resource_resv_array_chunk()", ntid);
-					log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
-					dup_resource_resv_array_chunk(static_cast<th_data_dup_resresv *>(work->thread_data));
-					break;
-				case TS_QUERY_JOB_INFO:
-					snprintf(buf, sizeof(buf), "Thread %d calling query_jobs_chunk()", ntid);
-					log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
-					query_jobs_chunk(static_cast<th_data_query_jinfo *>(work->thread_data));
-					break;
-				case TS_FREE_RESRESV:
-					snprintf(buf, sizeof(buf), "Thread %d calling free_resource_resv_array_chunk()", ntid);
-					log_event(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__, buf);
-					free_resource_resv_array_chunk(static_cast<th_data_free_resresv *>(work->thread_data));
-					break;
-				default:
-					log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_SCHED, LOG_ERR, __func__,
-						  "Invalid task type passed to worker thread");
+
+		if (work->task_type < 0 || work->task_type >= NUM_TASK_TYPES) {
+			log_event(PBSEVENT_ERROR, PBS_EVENTCLASS_SCHED, LOG_ERR, __func__,
+				  "Invalid task type passed to worker thread");
+		} else {
+			log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__,
+				   "Thread %d calling %s()%s", ntid, task_names[work->task_type], stolen ? " (stolen)" : "");
+			clock_gettime(CLOCK_MONOTONIC, &start);
+
+			{
+				prof_scope prof(task_names[work->task_type]);
+
+				/* find out what task we need to do */
+				switch (work->task_type) {
+					case TS_IS_ND_ELIGIBLE:
+						check_node_eligibility_chunk(static_cast<th_data_nd_eligible *>(work->thread_data));
+						break;
+					case TS_DUP_ND_INFO:
+						dup_node_info_chunk(static_cast<th_data_dup_nd_info *>(work->thread_data));
+						break;
+					case TS_QUERY_ND_INFO:
+						query_node_info_chunk(static_cast<th_data_query_ninfo *>(work->thread_data));
+						break;
+					case TS_FREE_ND_INFO:
+						free_node_info_chunk(static_cast<th_data_free_ninfo *>(work->thread_data));
+						break;
+					case TS_DUP_RESRESV:
+						dup_resource_resv_array_chunk(static_cast<th_data_dup_resresv *>(work->thread_data));
+						break;
+					case TS_QUERY_JOB_INFO:
+						query_jobs_chunk(static_cast<th_data_query_jinfo *>(work->thread_data));
+						break;
+					case TS_FREE_RESRESV:
+						free_resource_resv_array_chunk(static_cast<th_data_free_resresv *>(work->thread_data));
+						break;
+					case TS_NODEPART_FIT:
+						nodepart_fit_chunk(static_cast<th_data_nodepart_fit *>(work->thread_data));
+						break;
+					case TS_SORT_KEYS:
+						sort_keys_chunk(static_cast<th_data_sort_keys *>(work->thread_data));
+						break;
+				}
 			}
 
-			/* Post results */
-			pthread_mutex_lock(&result_lock);
-			ds_enqueue(result_queue, (void *) work);
-			pthread_cond_signal(&result_cond);
-			pthread_mutex_unlock(&result_lock);
+			clock_gettime(CLOCK_MONOTONIC, &end);
+			task_count[work->task_type]++;
+			if (stolen)
+				task_stolen[work->task_type]++;
+			task_usecs[work->task_type] += (end.tv_sec - start.tv_sec) * 1000000LL +
+						       (end.tv_nsec - start.tv_nsec) / 1000;
 		}
+
+		/* Post results */
+		pthread_mutex_lock(&result_lock);
+		ds_enqueue(work->done_queue != NULL ? work->done_queue : result_queue, (void *) work);
+		pthread_cond_signal(&result_cond);
+		pthread_mutex_unlock(&result_lock);
 	}
 
 	pthread_exit(NULL);
@@ -320,8 +421,141 @@ worker(void *tid)
 void
 queue_work_for_threads(th_task_info *task)
 {
+	task_deque *dq;
+
+	/* count it first so no worker goes to sleep while it is being queued */
+	tasks_pending++;
+
+	dq = &task_deques[next_deque];
+	next_deque = (next_deque + 1) % num_threads;
+	pthread_mutex_lock(&dq->lock);
+	dq->tasks.push_back(task);
+	pthread_mutex_unlock(&dq->lock);
+
 	pthread_mutex_lock(&work_lock);
-	ds_enqueue(work_queue, (void *) task);
 	pthread_cond_signal(&work_cond);
 	pthread_mutex_unlock(&work_lock);
 }
+
+/**
+ * @brief	allocate a task and queue it up for the worker threads
+ *
+ * @param[in]	done_queue - queue to post the finished task to.  Tasks
+ *			     which are pending while the caller queues and
+ *			     waits for other tasks need a queue of their own.
+ * @param[in]	task_type - type of the task
+ * @param[in]	task_id - id of the task, for the caller to order results by
+ * @param[in]	thread_data - data of the task, freed by the caller once done
+ *
+ * @return int
+ * @retval 1 the task was queued
+ * @retval 0 malloc error
+ */
+int
+queue_task_for_threads_to(ds_queue *done_queue, enum thread_task_type task_type, int task_id, void *thread_data)
+{
+	th_task_info *task;
+
+	task = static_cast<th_task_info *>(malloc(sizeof(th_task_info)));
+	if (task == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return 0;
+	}
+	task->task_id = task_id;
+	task->task_type = task_type;
+	task->thread_data = thread_data;
+	task->done_queue = done_queue;
+
+	queue_work_for_threads(task);
+
+	return 1;
+}
+
+/**
+ * @brief	allocate a task and queue it up for the worker threads, to be
+ *		picked up with wait_for_task_result()
+ *
+ * @see queue_task_for_threads_to() for parameters and return values
+ */
+int
+queue_task_for_threads(enum thread_task_type task_type, int task_id, void *thread_data)
+{
+	return queue_task_for_threads_to(result_queue, task_type, task_id, thread_data);
+}
+
+/**
+ * @brief	wait for a worker thread to finish a task posted to a queue
+ *
+ * @param[in]	done_queue - the queue the task was queued for
+ *
+ * @return th_task_info *
+ * @retval the finished task, for the caller to free
+ */
+th_task_info *
+wait_for_task_result_on(ds_queue *done_queue)
+{
+	th_task_info *task;
+
+	pthread_mutex_lock(&result_lock);
+	while (ds_queue_is_empty(done_queue))
+		pthread_cond_wait(&result_cond, &result_lock);
+	task = static_cast<th_task_info *>(ds_dequeue(done_queue));
+	pthread_mutex_unlock(&result_lock);
+
+	return task;
+}
+
+/**
+ * @brief	wait for a worker thread to finish a task queued with
+ *		queue_task_for_threads()
+ *
+ * @return th_task_info *
+ * @retval the finished task, for the caller to free
+ */
+th_task_info *
+wait_for_task_result(void)
+{
+	return wait_for_task_result_on(result_queue);
+}
+
+/**
+ * @brief	size of the chunks to split work on num_items items into.
+ *		Aim for a few chunks per thread, so threads which finish early
+ *		have work left to steal.
+ *
+ * @param[in]	num_items - number of items to split
+ *
+ * @return int
+ */
+int
+mt_chunk_size(int num_items)
+{
+	int chunk_size = num_items / (num_threads * MT_TASKS_PER_THREAD);
+
+	chunk_size = (chunk_size > MT_CHUNK_SIZE_MIN) ? chunk_size : MT_CHUNK_SIZE_MIN;
+	chunk_size = (chunk_size < MT_CHUNK_SIZE_MAX) ? chunk_size : MT_CHUNK_SIZE_MAX;
+
+	return chunk_size;
+}
+
+/**
+ * @brief	log how many tasks of each type the worker threads ran, how
+ *		many were stolen and how long they took, then reset the counters
+ *
+ * @return void
+ */
+void
+log_thread_task_stats(void)
+{
+	for (int i = 0; i < NUM_TASK_TYPES; i++) {
+		long count = task_count[i].exchange(0);
+		long stolen = task_stolen[i].exchange(0);
+		long long usecs = task_usecs[i].exchange(0);
+
+		if (count == 0)
+			continue;
+		log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__,
+			   "%s: %ld tasks, %ld stolen, %lld.%06lld seconds",
+			   task_names[i], count, stolen, usecs / 1000000, usecs % 1000000);
+	}
+}
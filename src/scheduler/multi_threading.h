@@ -41,13 +41,30 @@
 #define SRC_SCHEDULER_MULTI_THREADING_H_
 
 #include "data_types.h"
+#include "queue.h"
 
 #define MT_CHUNK_SIZE_MIN 1024
 #define MT_CHUNK_SIZE_MAX 8192
+#define MT_TASKS_PER_THREAD 4 /* chunks per thread to aim for, see mt_chunk_size() */
+#define MT_NODEPART_CHUNK_SIZE 16 /* placement sets screened per task */
 
 int init_multi_threading(int nthreads);
 void kill_threads(void);
 void *worker(void *);
 void queue_work_for_threads(th_task_info *task);
 
+/* allocate a task and queue it up for the worker threads */
+int queue_task_for_threads(enum thread_task_type task_type, int task_id, void *thread_data);
+int queue_task_for_threads_to(ds_queue *done_queue, enum thread_task_type task_type, int task_id, void *thread_data);
+
+/* wait for a worker thread to finish a task */
+th_task_info *wait_for_task_result(void);
+th_task_info *wait_for_task_result_on(ds_queue *done_queue);
+
+/* size of the chunks to split work on num_items items into */
+int mt_chunk_size(int num_items);
+
+/* log and reset the per task type counters of the worker threads */
+void log_thread_task_stats(void);
+
 #endif /* SRC_SCHEDULER_MULTI_THREADING_H_ */
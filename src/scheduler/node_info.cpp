@@ -144,6 +144,7 @@
 #include "pbs_bitmap.h"
 #include "pbs_license.h"
 #include "multi_threading.h"
+#include "ec_cache.h"
 #ifdef NAS
 #include "site_code.h"
 #endif
@@ -302,6 +303,7 @@ query_nodes(int pbs_sd, server_info *sinfo)
 		log_eventf(PBSEVENT_SCHED, PBS_EVENTCLASS_NODE, LOG_INFO, "", "Error getting nodes: %s", err);
 		return NULL;
 	}
+	sinfo->universe_fp = ec_cache_hash_status(sinfo->universe_fp, nodes);
 
 	cur_node = nodes;
 	while (cur_node != NULL) {
@@ -326,7 +328,7 @@ query_nodes(int pbs_sd, server_info *sinfo)
 
 		ninfo_arr[nidx] = NULL;
 	} else {
-		int chunk_size = num_nodes / num_threads;
+		int chunk_size = mt_chunk_size(num_nodes);
 		int th_err = 0;
 		int j;
 		int num_tasks;
@@ -336,7 +338,6 @@ query_nodes(int pbs_sd, server_info *sinfo)
 			return NULL;
 		}
 		ninfo_arr[0] = NULL;
-		chunk_size = (chunk_size > MT_CHUNK_SIZE_MIN) ? chunk_size : MT_CHUNK_SIZE_MIN;
 		for (j = 0, num_tasks = 0; num_nodes > 0;
 		     j += chunk_size, num_tasks++, num_nodes -= chunk_size) {
 			tdata = alloc_tdata_nd_query(nodes, sinfo, j, j + chunk_size - 1);
@@ -344,18 +345,11 @@ query_nodes(int pbs_sd, server_info *sinfo)
 				th_err = 1;
 				break;
 			}
-			task = static_cast<th_task_info *>(malloc(sizeof(th_task_info)));
-			if (task == NULL) {
+			if (!queue_task_for_threads(TS_QUERY_ND_INFO, num_tasks, tdata)) {
 				free(tdata);
-				log_err(errno, __func__, MEM_ERR_MSG);
 				th_err = 1;
 				break;
 			}
-			task->task_id = num_tasks;
-			task->task_type = TS_QUERY_ND_INFO;
-			task->thread_data = (void *) tdata;
-
-			queue_work_for_threads(task);
 		}
 		ninfo_arrs_tasks = static_cast<node_info ***>(malloc(num_tasks * sizeof(node_info **)));
 		if (ninfo_arrs_tasks == NULL) {
@@ -363,21 +357,14 @@ query_nodes(int pbs_sd, server_info *sinfo)
 			th_err = 1;
 		}
 		/* Get results from worker threads */
-		for (int i = 0; i < num_tasks;) {
-			pthread_mutex_lock(&result_lock);
-			while (ds_queue_is_empty(result_queue))
-				pthread_cond_wait(&result_cond, &result_lock);
-			while (!ds_queue_is_empty(result_queue)) {
-				task = static_cast<th_task_info *>(ds_dequeue(result_queue));
-				tdata = static_cast<th_data_query_ninfo *>(task->thread_data);
-				if (tdata->error)
-					th_err = 1;
-				ninfo_arrs_tasks[task->task_id] = tdata->oarr;
-				free(tdata);
-				free(task);
-				i++;
-			}
-			pthread_mutex_unlock(&result_lock);
+		for (int i = 0; i < num_tasks; i++) {
+			task = wait_for_task_result();
+			tdata = static_cast<th_data_query_ninfo *>(task->thread_data);
+			if (tdata->error)
+				th_err = 1;
+			ninfo_arrs_tasks[task->task_id] = tdata->oarr;
+			free(tdata);
+			free(task);
 		}
 		if (th_err) {
 			pbs_statfree(nodes);
@@ -761,39 +748,25 @@ free_nodes(node_info **ninfo_arr)
 		free(ninfo_arr);
 		return;
 	}
-	chunk_size = num_nodes / num_threads;
-	chunk_size = (chunk_size > MT_CHUNK_SIZE_MIN) ? chunk_size : MT_CHUNK_SIZE_MIN;
+	chunk_size = mt_chunk_size(num_nodes);
 	for (i = 0, num_tasks = 0; num_nodes > 0;
 	     num_tasks++, i += chunk_size, num_nodes -= chunk_size) {
 		tdata = alloc_tdata_free_nodes(ninfo_arr, i, i + chunk_size - 1);
 		if (tdata == NULL)
 			break;
 
-		task = static_cast<th_task_info *>(malloc(sizeof(th_task_info)));
-		if (task == NULL) {
+		if (!queue_task_for_threads(TS_FREE_ND_INFO, 0, tdata)) {
 			free(tdata);
-			log_err(errno, __func__, MEM_ERR_MSG);
 			break;
 		}
-		task->task_type = TS_FREE_ND_INFO;
-		task->thread_data = (void *) tdata;
-
-		queue_work_for_threads(task);
 	}
 
 	/* Get results from worker threads */
-	for (i = 0; i < num_tasks;) {
-		pthread_mutex_lock(&result_lock);
-		while (ds_queue_is_empty(result_queue))
-			pthread_cond_wait(&result_cond, &result_lock);
-		while (!ds_queue_is_empty(result_queue)) {
-			task = static_cast<th_task_info *>(ds_dequeue(result_queue));
-			tdata = static_cast<th_data_free_ninfo *>(task->thread_data);
-			free(tdata);
-			free(task);
-			i++;
-		}
-		pthread_mutex_unlock(&result_lock);
+	for (i = 0; i < num_tasks; i++) {
+		task = wait_for_task_result();
+		tdata = static_cast<th_data_free_ninfo *>(task->thread_data);
+		free(tdata);
+		free(task);
 	}
 	free(ninfo_arr);
 }
@@ -1232,8 +1205,7 @@ dup_nodes(node_info **onodes, server_info *nsinfo, unsigned int flags)
 	} else { /* We are multithreading */
 		int j;
 		int num_tasks;
-		int chunk_size = num_nodes / num_threads;
-		chunk_size = (chunk_size > MT_CHUNK_SIZE_MIN) ? chunk_size : MT_CHUNK_SIZE_MIN;
+		int chunk_size = mt_chunk_size(num_nodes);
 		for (j = 0, num_tasks = 0; thread_node_ct_left > 0;
 		     num_tasks++, j += chunk_size, thread_node_ct_left -= chunk_size) {
 			tdata = alloc_tdata_dup_nodes(flags, nsinfo, onodes, nnodes, j, j + chunk_size - 1);
@@ -1241,34 +1213,21 @@ dup_nodes(node_info **onodes, server_info *nsinfo, unsigned int flags)
 				th_err = 1;
 				break;
 			}
-			task = static_cast<th_task_info *>(malloc(sizeof(th_task_info)));
-			if (task == NULL) {
+			if (!queue_task_for_threads(TS_DUP_ND_INFO, 0, tdata)) {
 				free(tdata);
 				th_err = 1;
-				log_err(errno, __func__, MEM_ERR_MSG);
 				break;
 			}
-			task->task_type = TS_DUP_ND_INFO;
-			task->thread_data = (void *) tdata;
-
-			queue_work_for_threads(task);
 		}
 
 		/* Get results from worker threads */
-		for (int i = 0; i < num_tasks;) {
-			pthread_mutex_lock(&result_lock);
-			while (ds_queue_is_empty(result_queue))
-				pthread_cond_wait(&result_cond, &result_lock);
-			while (!ds_queue_is_empty(result_queue)) {
-				task = static_cast<th_task_info *>(ds_dequeue(result_queue));
-				tdata = static_cast<th_data_dup_nd_info *>(task->thread_data);
-				if (tdata->error)
-					th_err = 1;
-				free(tdata);
-				free(task);
-				i++;
-			}
-			pthread_mutex_unlock(&result_lock);
+		for (int i = 0; i < num_tasks; i++) {
+			task = wait_for_task_result();
+			tdata = static_cast<th_data_dup_nd_info *>(task->thread_data);
+			if (tdata->error)
+				th_err = 1;
+			free(tdata);
+			free(task);
 		}
 	}
 
@@ -2061,6 +2020,7 @@ eval_selspec(status *policy, selspec *spec, place *placespec,
 	char reason[MAX_LOG_SIZE] = {0};
 	int i = 0;
 	static struct schd_error *failerr = NULL;
+	nodepart_screen *screen;
 
 	if (spec == NULL || ninfo_arr == NULL || resresv == NULL || placespec == NULL)
 		return false;
@@ -2118,11 +2078,15 @@ eval_selspec(status *policy, selspec *spec, place *placespec,
 		return rc;
 	}
 
-	/* Otherwise we're node grouping... */
+	/* Otherwise we're node grouping...
+	 * The meta data checks of the placement sets are done ahead on the
+	 * worker threads, while the placement sets are evaluated in order here.
+	 */
+	screen = start_nodepart_screen(policy, nodepart, resresv, flags);
 
 	for (i = 0; nodepart[i] != NULL && rc == 0; i++) {
 		clear_schd_error(err);
-		if (resresv_can_fit_nodepart(policy, nodepart[i], resresv, flags, err)) {
+		if (screened_can_fit_nodepart(screen, policy, nodepart, i, resresv, flags, err)) {
 			log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_JOB, LOG_DEBUG, resresv->name,
 				   "Evaluating placement set: %s", nodepart[i]->name);
 			if (nodepart[i]->ok_break)
@@ -2161,11 +2125,12 @@ eval_selspec(status *policy, selspec *spec, place *placespec,
 		}
 
 		if (!can_fit && !rc &&
-		    resresv_can_fit_nodepart(policy, nodepart[i], resresv, flags | COMPARE_TOTAL, err)) {
+		    screened_can_fit_nodepart(screen, policy, nodepart, i, resresv, flags | COMPARE_TOTAL, err)) {
 			can_fit = 1;
 		}
 		pass_flags = NO_FLAGS;
 	}
+	free_nodepart_screen(screen);
 
 	if (!can_fit) {
 		if (flags & SPAN_PSETS) {
@@ -2662,7 +2627,7 @@ eval_complex_selspec(status *policy, selspec *spec, node_info **ninfo_arr, place
 				 */
 				if (conf.provision_policy != AVOID_PROVISION &&
 				    !cstat.node_sort->empty() && conf.node_sort_unused)
-					qsort(nodes, tot_nodes, sizeof(node_info *), multi_node_sort);
+					sort_moved_nodes(nodes, tot_nodes, ns_chunk);
 			}
 			chunks_needed--;
 			nsa.insert(nsa.end(), ns_chunk.begin(), ns_chunk.end());
@@ -5230,43 +5195,28 @@ check_node_array_eligibility(node_info **ninfo_arr, resource_resv *resresv, plac
 	} else { /* We are multithreading */
 		int j;
 		int num_tasks;
-		int chunk_size = num_nodes / num_threads;
-		chunk_size = (chunk_size > MT_CHUNK_SIZE_MIN) ? chunk_size : MT_CHUNK_SIZE_MIN;
+		int chunk_size = mt_chunk_size(num_nodes);
 		for (j = 0, num_tasks = 0; num_nodes > 0;
 		     num_tasks++, j += chunk_size, num_nodes -= chunk_size) {
 			tdata = alloc_tdata_nd_eligible(pl, resresv, ninfo_arr, j, j + chunk_size - 1);
 			if (tdata == NULL)
 				break;
 
-			task = static_cast<th_task_info *>(malloc(sizeof(th_task_info)));
-			if (task == NULL) {
+			if (!queue_task_for_threads(TS_IS_ND_ELIGIBLE, 0, tdata)) {
 				free(tdata);
-				log_err(errno, __func__, MEM_ERR_MSG);
 				break;
 			}
-			task->task_type = TS_IS_ND_ELIGIBLE;
-			task->thread_data = (void *) tdata;
-
-			queue_work_for_threads(task);
 		}
 
 		/* Get results from worker threads */
-		for (int i = 0; i < num_tasks;) {
-			pthread_mutex_lock(&result_lock);
-			while (ds_queue_is_empty(result_queue))
-				pthread_cond_wait(&result_cond, &result_lock);
-			while (!ds_queue_is_empty(result_queue)) {
-				task = static_cast<th_task_info *>(ds_dequeue(result_queue));
-				tdata = static_cast<th_data_nd_eligible *>(task->thread_data);
-				if (err->status_code == SCHD_UNKWN && tdata->err->status_code != SCHD_UNKWN)
-					copy_schd_error(err, tdata->err);
-
-				free_schd_error(tdata->err);
-				free(tdata);
-				free(task);
-				i++;
-			}
-			pthread_mutex_unlock(&result_lock);
+		for (int i = 0; i < num_tasks; i++) {
+			task = wait_for_task_result();
+			tdata = static_cast<th_data_nd_eligible *>(task->thread_data);
+			if (err->status_code == SCHD_UNKWN && tdata->err->status_code != SCHD_UNKWN)
+				copy_schd_error(err, tdata->err);
+			free_schd_error(tdata->err);
+			free(tdata);
+			free(task);
 		}
 	}
 }
@@ -88,8 +88,66 @@
 #include "globals.h"
 #include "sort.h"
 #include "buckets.h"
+#include "multi_threading.h"
+#include "sim_undo.h"
+#include <pthread.h>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
 #include <vector>
 
+/* bits of nodepart_screen::fit */
+#define NP_FIT_FREE 1  /* the job fits into the free resources of the placement set */
+#define NP_FIT_TOTAL 2 /* the job fits into the total resources of the placement set */
+
+/*
+ * The meta data checks of resresv_can_fit_nodepart() for all placement sets
+ * a job is evaluated against, computed ahead by the worker threads.
+ */
+struct nodepart_screen
+{
+	status *policy;
+	resource_resv *resresv;
+	node_partition **nodepart;
+	unsigned int flags;
+	int num_parts;
+	int num_tasks;
+	int tasks_done;
+	char *fit;		 /* NP_FIT_* bits per placement set */
+	schd_error **errs;	 /* why a placement set's free resources are too small */
+	bool *chunk_done;	 /* worker is done with the chunk of placement sets */
+	ds_queue *done_queue;	 /* where the worker threads post finished chunks */
+	std::atomic<int> cancel; /* placement sets from this index on are not needed */
+};
+
+/*
+ * Which nodes are in which node partition.  Nodes are grouped the same way
+ * cycle after cycle, so the grouping of an array of nodes by a list of
+ * resources is kept across cycles.  It is looked up by the resources and
+ * the names of the nodes, and only patched for the nodes whose grouping
+ * resource values changed.  Nodes are known by their index in the array,
+ * since the node_info structures are queried anew each cycle.
+ */
+struct np_group {
+	std::string name;	  /* res_name=res_val */
+	std::string res_val;	  /* value of the resource */
+	size_t res_i;		  /* index of the resource in the resource names */
+	std::vector<int> members; /* indices of the nodes in the partition, ascending */
+};
+
+struct np_grouping {
+	std::vector<std::string> node_keys; /* grouping resource values of each node, see np_node_key() */
+	std::vector<np_group> groups;	    /* in the order the partitions are created */
+	unsigned long last_use;		    /* to evict the least recently used grouping */
+};
+
+#define NP_GROUPING_MAX 64	  /* groupings kept across cycles */
+#define NP_GROUPING_PATCH_DIV 8 /* patch a grouping if less than 1/8th of its nodes changed */
+
+static std::unordered_map<std::string, np_grouping> np_groupings;
+static unsigned long np_grouping_uses = 0;
+
 /**
  * @brief
  *		new_node_partition - allocate and initialize a node_partition
@@ -349,18 +407,317 @@ find_node_partition_by_rank(node_partition **np_arr, int rank)
 	return np_arr[i];
 }
 
+/**
+ * @brief
+ * 		the values of a node's node grouping resources, as one string.  The
+ *		values of a resource are separated by '\x1f' and each resource ends
+ *		in '\x1e'.  Stale nodes are in no node partition.
+ *
+ * @param[in]	ninfo	-	the node
+ * @param[in]	defs	-	definitions of the node grouping resources
+ * @param[in]	flags	-	NP_CREATE_REST - nodes without a resource have the value ""
+ *
+ * @return	std::string
+ */
+static std::string
+np_node_key(node_info *ninfo, const std::vector<resdef *> &defs, unsigned int flags)
+{
+	std::string key;
+
+	if (ninfo->is_stale)
+		return "\x1d";
+
+	for (auto def : defs) {
+		schd_resource *res = find_resource(ninfo->res, def);
+
+		if (res != NULL) {
+			/* Incase of indirect resource, point it to the right place */
+			if (res->indirect_res != NULL)
+				res = res->indirect_res;
+			for (int i = 0; res->str_avail != NULL && res->str_avail[i] != NULL; i++) {
+				if (i > 0)
+					key += '\x1f';
+				key += res->str_avail[i];
+			}
+		} else if (flags & NP_CREATE_REST)
+			key += "\"\"";
+		key += '\x1e';
+	}
+	return key;
+}
+
+/**
+ * @brief
+ * 		the values of one node grouping resource from a np_node_key() string
+ *
+ * @param[in]	key	-	the node's key
+ * @param[in]	res_i	-	index of the resource
+ * @param[out]	values	-	the values
+ *
+ * @return	void
+ */
+static void
+np_key_values(const std::string &key, size_t res_i, std::vector<std::string> &values)
+{
+	size_t start = 0;
+	size_t end;
+
+	values.clear();
+	for (size_t i = 0; i < res_i; i++) {
+		start = key.find('\x1e', start);
+		if (start == std::string::npos)
+			return;
+		start++;
+	}
+	end = key.find('\x1e', start);
+	if (end == std::string::npos || end == start)
+		return;
+
+	while (start <= end) {
+		size_t sep = key.find('\x1f', start);
+
+		if (sep == std::string::npos || sep > end)
+			sep = end;
+		values.push_back(key.substr(start, sep - start));
+		start = sep + 1;
+	}
+}
+
+/**
+ * @brief
+ * 		add a node to the node partition of a resource value, creating
+ *		the partition if it is new
+ *
+ * @param[in,out]	npg	-	the grouping
+ * @param[in,out]	index	-	position of each partition in npg->groups by name
+ * @param[in]	resnames	-	node grouping resource names
+ * @param[in]	res_i	-	index of the resource
+ * @param[in]	value	-	the value of the resource
+ * @param[in]	node_i	-	index of the node
+ *
+ * @return	void
+ */
+static void
+np_group_add(np_grouping *npg, std::unordered_map<std::string, size_t> &index,
+	     const std::vector<std::string> &resnames, size_t res_i, const std::string &value, int node_i)
+{
+	std::string name = resnames[res_i] + "=" + value;
+	auto it = index.find(name);
+	np_group *grp;
+
+	if (it == index.end()) {
+		index[name] = npg->groups.size();
+		npg->groups.emplace_back();
+		grp = &npg->groups.back();
+		grp->name = name;
+		grp->res_val = value;
+		grp->res_i = res_i;
+	} else
+		grp = &npg->groups[it->second];
+
+	/* a node with the same value twice is only in the partition once */
+	auto pos = std::lower_bound(grp->members.begin(), grp->members.end(), node_i);
+	if (pos == grp->members.end() || *pos != node_i)
+		grp->members.insert(pos, node_i);
+}
+
+/**
+ * @brief
+ * 		group nodes into node partitions from scratch
+ *
+ * @param[in,out]	npg	-	the grouping, with node_keys set
+ * @param[in]	resnames	-	node grouping resource names
+ *
+ * @return	void
+ */
+static void
+np_grouping_build(np_grouping *npg, const std::vector<std::string> &resnames)
+{
+	std::unordered_map<std::string, size_t> index;
+	std::vector<std::string> values;
+
+	npg->groups.clear();
+	for (size_t res_i = 0; res_i < resnames.size(); res_i++) {
+		for (size_t node_i = 0; node_i < npg->node_keys.size(); node_i++) {
+			np_key_values(npg->node_keys[node_i], res_i, values);
+			for (const auto &value : values)
+				np_group_add(npg, index, resnames, res_i, value, node_i);
+		}
+	}
+}
+
+/* std::remove_if() predicate for node partitions which lost their last node */
+static bool
+np_group_is_empty(const np_group &grp)
+{
+	return grp.members.empty();
+}
+
+/* orders node partitions the way np_grouping_build() creates them */
+struct cmp_np_group_creation {
+	const np_grouping *npg;
+
+	size_t
+	value_pos(const np_group &grp) const
+	{
+		std::vector<std::string> values;
+
+		np_key_values(npg->node_keys[grp.members[0]], grp.res_i, values);
+		return std::find(values.begin(), values.end(), grp.res_val) - values.begin();
+	}
+
+	bool
+	operator()(const np_group &g1, const np_group &g2) const
+	{
+		if (g1.res_i != g2.res_i)
+			return g1.res_i < g2.res_i;
+		if (g1.members[0] != g2.members[0])
+			return g1.members[0] < g2.members[0];
+		return value_pos(g1) < value_pos(g2);
+	}
+};
+
+/**
+ * @brief
+ * 		move the nodes whose grouping resource values changed to their
+ *		new node partitions.  The partitions end up in the same order
+ *		as if they were grouped from scratch.
+ *
+ * @param[in,out]	npg	-	the grouping, with the old node_keys
+ * @param[in]	resnames	-	node grouping resource names
+ * @param[in]	new_keys	-	the new keys of the nodes
+ * @param[in]	changed	-	indices of the nodes whose keys changed
+ *
+ * @return	void
+ */
+static void
+np_grouping_patch(np_grouping *npg, const std::vector<std::string> &resnames,
+		  const std::vector<std::string> &new_keys, const std::vector<int> &changed)
+{
+	std::unordered_map<std::string, size_t> index;
+	std::vector<std::string> values;
+	cmp_np_group_creation cmp;
+
+	for (size_t i = 0; i < npg->groups.size(); i++)
+		index[npg->groups[i].name] = i;
+
+	for (auto node_i : changed) {
+		for (size_t res_i = 0; res_i < resnames.size(); res_i++) {
+			np_key_values(npg->node_keys[node_i], res_i, values);
+			for (const auto &value : values) {
+				auto it = index.find(resnames[res_i] + "=" + value);
+				if (it != index.end()) {
+					auto &members = npg->groups[it->second].members;
+					auto pos = std::lower_bound(members.begin(), members.end(), node_i);
+					if (pos != members.end() && *pos == node_i)
+						members.erase(pos);
+				}
+			}
+		}
+		npg->node_keys[node_i] = new_keys[node_i];
+		for (size_t res_i = 0; res_i < resnames.size(); res_i++) {
+			np_key_values(npg->node_keys[node_i], res_i, values);
+			for (const auto &value : values)
+				np_group_add(npg, index, resnames, res_i, value, node_i);
+		}
+	}
+
+	npg->groups.erase(std::remove_if(npg->groups.begin(), npg->groups.end(), np_group_is_empty),
+			  npg->groups.end());
+	cmp.npg = npg;
+	std::sort(npg->groups.begin(), npg->groups.end(), cmp);
+}
+
+/**
+ * @brief
+ * 		find how an array of nodes is grouped into node partitions.  The
+ *		grouping from an earlier call with the same resources and nodes is
+ *		reused if the nodes' grouping resource values are the same.  If a
+ *		few changed, only those nodes are moved between partitions.
+ *
+ * @param[in]	nodes	-	the nodes
+ * @param[in]	num_nodes	-	number of nodes
+ * @param[in]	resnames	-	node grouping resource names
+ * @param[in]	flags	-	NP_CREATE_REST - group nodes without a resource as ""
+ * @param[out]	local	-	grouping to fill in if it can't be kept
+ *
+ * @return	np_grouping *
+ * @retval	the grouping
+ * @retval	NULL	: on error
+ *
+ * @par MT-safe: only kept across calls on the main thread
+ */
+static np_grouping *
+find_alloc_np_grouping(node_info **nodes, int num_nodes, const std::vector<std::string> &resnames,
+		       unsigned int flags, np_grouping *local)
+{
+	std::vector<resdef *> defs;
+	std::vector<std::string> keys(num_nodes);
+	std::vector<int> changed;
+	std::string cache_key;
+	size_t names_hash = num_nodes;
+	np_grouping *npg;
+	int tid;
+
+	for (const auto &name : resnames) {
+		auto def = find_resdef(name);
+		/* nodes without the resource can't be put in a "" partition */
+		if (def == NULL && (flags & NP_CREATE_REST))
+			return NULL;
+		defs.push_back(def);
+		cache_key += name;
+		cache_key += '\x1e';
+	}
+	for (int i = 0; i < num_nodes; i++) {
+		keys[i] = np_node_key(nodes[i], defs, flags);
+		names_hash = names_hash * 31 + std::hash<std::string>()(nodes[i]->name);
+	}
+
+	tid = *((int *) pthread_getspecific(th_id_key));
+	if (tid != 0) {
+		local->node_keys.swap(keys);
+		np_grouping_build(local, resnames);
+		return local;
+	}
+
+	cache_key += std::to_string(flags & NP_CREATE_REST) + ":" + std::to_string(names_hash);
+	auto it = np_groupings.find(cache_key);
+	if (it != np_groupings.end() && static_cast<int>(it->second.node_keys.size()) == num_nodes) {
+		npg = &it->second;
+		for (int i = 0; i < num_nodes; i++) {
+			if (npg->node_keys[i] != keys[i])
+				changed.push_back(i);
+		}
+		if (changed.size() * NP_GROUPING_PATCH_DIV < static_cast<size_t>(num_nodes))
+			np_grouping_patch(npg, resnames, keys, changed);
+		else {
+			npg->node_keys.swap(keys);
+			np_grouping_build(npg, resnames);
+		}
+	} else {
+		if (it == np_groupings.end() && np_groupings.size() >= NP_GROUPING_MAX) {
+			auto lru = np_groupings.begin();
+			for (auto i = np_groupings.begin(); i != np_groupings.end(); i++) {
+				if (i->second.last_use < lru->second.last_use)
+					lru = i;
+			}
+			np_groupings.erase(lru);
+		}
+		npg = &np_groupings[cache_key];
+		npg->node_keys.swap(keys);
+		np_grouping_build(npg, resnames);
+	}
+	npg->last_use = ++np_grouping_uses;
+
+	return npg;
+}
+
 /**
  * @brief
  * 		break apart nodes into partitions
- *		A possible side-effect of this function when multiple identical
- *		resources are defined on an attribute, is that the node
- *		partitions accounting for this node may count this node in the
- *		total count of "free_nodes" for that partition (if the node was
- *		free in the first place). Due to this, incorrect accounting,
- *		the metadata of the node partition may cause eval_selspec to
- *		descend into the node matching code instead of bailing out right
- *		away due to the fact that the node partition has insufficient
- *		resources.
+ *		Which nodes go in which partition is kept across cycles (see
+ *		find_alloc_np_grouping()), so only the partitions themselves,
+ *		their buckets and resource totals are made from the nodes here.
  *
  * @param[in]	policy	-	policy info
  * @param[in]	nodes	-	the nodes which to create partitions from
@@ -379,20 +736,10 @@ node_partition **
 create_node_partitions(status *policy, node_info **nodes, const std::vector<std::string> &resnames, unsigned int flags, int *num_parts)
 {
 	node_partition **np_arr;
-	node_partition *np;
-	node_partition **tmp_arr;
-	int np_arr_size = 0;
-	static schd_resource *res;
-
+	np_grouping local;
+	np_grouping *npg;
 	int num_nodes;
-
-	schd_resource *tmpres;
-
-	int val_i;  /* index of placement set resource value */
-	int node_i; /* index into nodes array */
-	int np_i;   /* index into node partition array we are creating */
-
-	static schd_resource *unset_res = NULL;
+	int np_i; /* index into node partition array we are creating */
 
 	std::vector<queue_info *> queues;
 
@@ -404,158 +751,72 @@ create_node_partitions(status *policy, node_info **nodes, const std::vector<std:
 
 	num_nodes = count_array(nodes);
 
-	if ((np_arr = static_cast<node_partition **>(malloc((num_nodes + 1) * sizeof(node_partition *)))) == NULL) {
+	npg = find_alloc_np_grouping(nodes, num_nodes, resnames, flags, &local);
+	if (npg == NULL)
+		return NULL;
+
+	if ((np_arr = static_cast<node_partition **>(malloc((npg->groups.size() + 1) * sizeof(node_partition *)))) == NULL) {
 		log_err(errno, __func__, MEM_ERR_MSG);
 		return NULL;
 	}
-
-	np_arr_size = num_nodes;
-
-	np_i = 0;
 	np_arr[0] = NULL;
 
-	if (flags & NP_CREATE_REST && unset_res == NULL)
-		unset_res = new_resource();
-
-	for (auto &res_i : resnames) {
-		auto def = find_resdef(res_i);
-		for (node_i = 0; nodes[node_i] != NULL; node_i++) {
-			if (nodes[node_i]->is_stale)
-				continue;
-
-			res = find_resource(nodes[node_i]->res, def);
-
-			if (res == NULL && (flags & NP_CREATE_REST)) {
-				unset_res->name = res_i.c_str();
-				if (set_resource(unset_res, "\"\"", RF_AVAIL) == 0) {
-					free_node_partition_array(np_arr);
-					return NULL;
-				}
-				res = unset_res;
-			}
-			if (res != NULL) {
-				/* Incase of indirect resource, point it to the right place */
-				if (res->indirect_res != NULL)
-					res = res->indirect_res;
-				for (val_i = 0; res->str_avail[val_i] != NULL; val_i++) {
-					std::string str = res_i + "=" + res->str_avail[val_i];
-					/* If we find the partition, we've already created it - add the node
-					 * to the existing partition.  If we don't find it, we create it.
-					 */
-					np = find_node_partition(np_arr, str);
-					if (np == NULL) {
-						if (np_i >= np_arr_size) {
-							tmp_arr = static_cast<node_partition **>(realloc(np_arr,
-													 (np_arr_size * 2 + 1) * sizeof(node_partition *)));
-							if (tmp_arr == NULL) {
-								log_err(errno, __func__, MEM_ERR_MSG);
-								free_node_partition_array(np_arr);
-								return NULL;
-							}
-							np_arr = tmp_arr;
-							np_arr_size *= 2;
-						}
-
-						np_arr[np_i] = new_node_partition();
-						if (np_arr[np_i] != NULL) {
-							np_arr[np_i]->name = string_dup(str.c_str());
-							np_arr[np_i]->def = def;
-							np_arr[np_i]->res_val = string_dup(res->str_avail[val_i]);
-							np_arr[np_i]->tot_nodes = 1;
-							if (nodes[node_i]->is_free)
-								np_arr[np_i]->free_nodes = 1;
-							np_arr[np_i]->rank = get_sched_rank();
-
-							if (np_arr[np_i]->res_val == NULL) {
-								np_arr[np_i + 1] = NULL;
-								free_node_partition_array(np_arr);
-								return NULL;
-							}
-
-							np_i++;
-							np_arr[np_i] = NULL;
-						} else {
-							free_node_partition_array(np_arr);
-							return NULL;
-						}
-					} else {
-						np->tot_nodes++;
-						if (nodes[node_i]->is_free)
-							np->free_nodes++;
-					}
-				}
-			}
-			/* else we ignore nodes without the node partition resource set
-			 * unless the NP_CREATE_REST flag is set
-			 */
-		}
-	}
-
-	/* now that we have a list of node partitions and number of nodes in each
-	 * lets allocate a node array and fill it
+	/* now that we know which nodes are in which node partition,
+	 * lets create the node partitions and fill them
 	 */
-
-	for (np_i = 0; np_arr[np_i] != NULL; np_i++) {
-		int i = 0;
-		np_arr[np_i]->ok_break = 1;
+	np_i = 0;
+	for (const auto &grp : npg->groups) {
+		node_partition *np;
 		schd_resource *hostres = NULL;
+		int i = 0;
 
-		np_arr[np_i]->ninfo_arr =
-			static_cast<node_info **>(malloc((np_arr[np_i]->tot_nodes + 1) * sizeof(node_info *)));
-
-		if (np_arr[np_i]->ninfo_arr == NULL) {
+		np = new_node_partition();
+		if (np == NULL) {
+			free_node_partition_array(np_arr);
+			return NULL;
+		}
+		np_arr[np_i++] = np;
+		np_arr[np_i] = NULL;
+
+		np->name = string_dup(grp.name.c_str());
+		np->def = find_resdef(resnames[grp.res_i]);
+		np->res_val = string_dup(grp.res_val.c_str());
+		np->rank = get_sched_rank();
+		np->ok_break = 1;
+		np->ninfo_arr = static_cast<node_info **>(malloc((grp.members.size() + 1) * sizeof(node_info *)));
+		if (np->name == NULL || np->res_val == NULL || np->ninfo_arr == NULL) {
 			free_node_partition_array(np_arr);
 			return NULL;
 		}
 
-		np_arr[np_i]->ninfo_arr[0] = NULL;
-
-		for (node_i = 0; nodes[node_i] != NULL && i < np_arr[np_i]->tot_nodes; node_i++) {
-			if (nodes[node_i]->is_stale)
-				continue;
+		for (auto node_i : grp.members) {
+			node_info *ninfo = nodes[node_i];
 
-			res = find_resource(nodes[node_i]->res, np_arr[np_i]->def);
-			if (res == NULL && (flags & NP_CREATE_REST)) {
-				set_resource(unset_res, "\"\"", RF_AVAIL);
-				res = unset_res;
+			if (np->ok_break) {
+				schd_resource *tmpres = find_resource(ninfo->res, allres["host"]);
+				if (tmpres != NULL) {
+					if (hostres == NULL)
+						hostres = tmpres;
+					else if (!compare_res_to_str(hostres, tmpres->str_avail[0], CMP_CASELESS))
+						np->ok_break = 0;
+				}
 			}
-			if (res != NULL) {
-				/* Incase of indirect resource, point it to the right place */
-				if (res->indirect_res != NULL)
-					res = res->indirect_res;
-				if (compare_res_to_str(res, np_arr[np_i]->res_val, CMP_CASE)) {
-					if (np_arr[np_i]->ok_break) {
-						tmpres = find_resource(nodes[node_i]->res, allres["host"]);
-						if (tmpres != NULL) {
-							if (hostres == NULL)
-								hostres = tmpres;
-							else {
-								if (!compare_res_to_str(hostres, tmpres->str_avail[0], CMP_CASELESS))
-									np_arr[np_i]->ok_break = 0;
-							}
-						}
-					}
-					if (!(NP_NO_ADD_NP_ARR & flags)) {
-						tmp_arr = static_cast<node_partition **>(add_ptr_to_array(nodes[node_i]->np_arr, np_arr[np_i]));
-						if (tmp_arr == NULL) {
-							free_node_partition_array(np_arr);
-							return NULL;
-						}
-						nodes[node_i]->np_arr = tmp_arr;
-					}
-
-					np_arr[np_i]->ninfo_arr[i] = nodes[node_i];
-					i++;
-					np_arr[np_i]->ninfo_arr[i] = NULL;
+			if (!(NP_NO_ADD_NP_ARR & flags)) {
+				node_partition **tmp_arr;
+
+				tmp_arr = static_cast<node_partition **>(add_ptr_to_array(ninfo->np_arr, np));
+				if (tmp_arr == NULL) {
+					free_node_partition_array(np_arr);
+					return NULL;
 				}
+				ninfo->np_arr = tmp_arr;
 			}
+			np->ninfo_arr[i++] = ninfo;
 		}
-		/* if multiple resource values are present, tot_nodes may be incorrect.
-		 * recalculating tot_nodes for each node partition.
-		 */
-		np_arr[np_i]->tot_nodes = count_array(np_arr[np_i]->ninfo_arr);
-		np_arr[np_i]->bkts = create_node_buckets(policy, np_arr[np_i]->ninfo_arr, queues, NO_PRINT_BUCKETS);
-		node_partition_update(policy, np_arr[np_i]);
+		np->ninfo_arr[i] = NULL;
+		np->tot_nodes = i;
+		np->bkts = create_node_buckets(policy, np->ninfo_arr, queues, NO_PRINT_BUCKETS);
+		node_partition_update(policy, np);
 	}
 
 	*num_parts = np_i;
@@ -722,8 +983,7 @@ node_partition_update(status *policy, node_partition *np)
 
 	if (!policy->node_sort->empty() && conf.node_sort_unused) {
 		/* Resort the nodes in the partition so that selection works correctly. */
-		qsort(np->ninfo_arr, np->tot_nodes, sizeof(node_info *),
-		      multi_node_sort);
+		sort_node_array(np->ninfo_arr, np->tot_nodes);
 	}
 
 	return rc;
@@ -1019,6 +1279,214 @@ resresv_can_fit_nodepart(status *policy, node_partition *np, resource_resv *resr
 	return 1;
 }
 
+/**
+ * @brief	pthread routine to do the meta data checks of a chunk of
+ *		placement sets for a nodepart_screen
+ *
+ * @param[in,out]	data - th_data_nodepart_fit object
+ *
+ * @return void
+ */
+void
+nodepart_fit_chunk(th_data_nodepart_fit *data)
+{
+	nodepart_screen *scr;
+	schd_error *err;
+
+	if (data == NULL)
+		return;
+
+	scr = data->scr;
+	err = new_schd_error();
+	if (err == NULL)
+		return;
+
+	for (int i = data->sidx; i <= data->eidx && i < scr->num_parts; i++) {
+		if (i >= scr->cancel)
+			break;
+
+		if (resresv_can_fit_nodepart(scr->policy, scr->nodepart[i], scr->resresv, scr->flags, err))
+			scr->fit[i] |= NP_FIT_FREE;
+		else {
+			scr->errs[i] = err;
+			err = new_schd_error();
+			if (err == NULL)
+				return;
+		}
+		if (resresv_can_fit_nodepart(scr->policy, scr->nodepart[i], scr->resresv, scr->flags | COMPARE_TOTAL, err))
+			scr->fit[i] |= NP_FIT_TOTAL;
+		clear_schd_error(err);
+	}
+	free_schd_error(err);
+}
+
+/**
+ * @brief	mark a worker thread's chunk of a nodepart_screen as done
+ *
+ * @param[in,out]	scr - the screen
+ * @param[in]	task - the finished task
+ *
+ * @return void
+ */
+static void
+finish_nodepart_screen_task(nodepart_screen *scr, th_task_info *task)
+{
+	scr->chunk_done[task->task_id] = true;
+	scr->tasks_done++;
+	free(task->thread_data);
+	free(task);
+}
+
+/**
+ * @brief	start the meta data checks of resresv_can_fit_nodepart() on
+ *		an array of placement sets on the worker threads.  The
+ *		results are picked up in order with screened_can_fit_nodepart().
+ *
+ * @param[in]	policy	-	policy info
+ * @param[in]	nodepart	-	the placement sets
+ * @param[in]	resresv	-	job/resv to see if it can fit
+ * @param[in]	flags	-	check_flags passed to resresv_can_fit_nodepart()
+ *
+ * @return	nodepart_screen *
+ * @retval	the screen, to be freed with free_nodepart_screen()
+ * @retval	NULL	: too few placement sets to be worth it, no worker
+ *			  threads, or error.  Check the placement sets serially.
+ */
+nodepart_screen *
+start_nodepart_screen(status *policy, node_partition **nodepart, resource_resv *resresv, unsigned int flags)
+{
+	nodepart_screen *scr;
+	int num_parts;
+	int tid;
+
+	if (policy == NULL || nodepart == NULL || resresv == NULL)
+		return NULL;
+
+	tid = *((int *) pthread_getspecific(th_id_key));
+	if (tid != 0 || num_threads <= 1)
+		return NULL;
+
+	num_parts = count_array(nodepart);
+	if (num_parts <= MT_NODEPART_CHUNK_SIZE)
+		return NULL;
+
+	scr = new nodepart_screen;
+	scr->policy = policy;
+	scr->resresv = resresv;
+	scr->nodepart = nodepart;
+	scr->flags = flags;
+	scr->num_parts = num_parts;
+	scr->num_tasks = (num_parts + MT_NODEPART_CHUNK_SIZE - 1) / MT_NODEPART_CHUNK_SIZE;
+	scr->tasks_done = 0;
+	scr->cancel = num_parts;
+	scr->fit = static_cast<char *>(calloc(num_parts, sizeof(char)));
+	scr->errs = static_cast<schd_error **>(calloc(num_parts, sizeof(schd_error *)));
+	scr->chunk_done = static_cast<bool *>(calloc(scr->num_tasks, sizeof(bool)));
+	scr->done_queue = new_ds_queue();
+	if (scr->fit == NULL || scr->errs == NULL || scr->chunk_done == NULL || scr->done_queue == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		free(scr->fit);
+		free(scr->errs);
+		free(scr->chunk_done);
+		free_ds_queue(scr->done_queue);
+		delete scr;
+		return NULL;
+	}
+
+	for (int i = 0; i < scr->num_tasks; i++) {
+		th_data_nodepart_fit *tdata;
+
+		tdata = static_cast<th_data_nodepart_fit *>(malloc(sizeof(th_data_nodepart_fit)));
+		if (tdata == NULL) {
+			log_err(errno, __func__, MEM_ERR_MSG);
+			scr->num_tasks = i;
+			break;
+		}
+		tdata->scr = scr;
+		tdata->sidx = i * MT_NODEPART_CHUNK_SIZE;
+		tdata->eidx = tdata->sidx + MT_NODEPART_CHUNK_SIZE - 1;
+		if (!queue_task_for_threads_to(scr->done_queue, TS_NODEPART_FIT, i, tdata)) {
+			free(tdata);
+			scr->num_tasks = i;
+			break;
+		}
+	}
+
+	return scr;
+}
+
+/**
+ * @brief	screened version of resresv_can_fit_nodepart().  Uses the
+ *		results of a nodepart_screen if there is one, waiting for the
+ *		worker thread checking the placement set if need be.
+ *
+ * @param[in]	scr	-	screen started on nodepart, or NULL
+ * @param[in]	nodepart	-	the placement sets
+ * @param[in]	idx	-	index of the placement set to check
+ * @param[in]	flags	-	the flags the screen was started with,
+ *				optionally with COMPARE_TOTAL added
+ * @param[out]	err	-	why the job/resv can't fit. If the total
+ *				resources are too small, this is only set for
+ *				the last placement set, which is where callers
+ *				walking the array in order look at it.
+ *
+ * @see resresv_can_fit_nodepart() for other parameters and return values
+ */
+int
+screened_can_fit_nodepart(nodepart_screen *scr, status *policy, node_partition **nodepart, int idx,
+			  resource_resv *resresv, unsigned int flags, schd_error *err)
+{
+	int chunk;
+
+	if (scr == NULL || idx >= scr->num_tasks * MT_NODEPART_CHUNK_SIZE)
+		return resresv_can_fit_nodepart(policy, nodepart[idx], resresv, flags, err);
+
+	chunk = idx / MT_NODEPART_CHUNK_SIZE;
+	while (!scr->chunk_done[chunk])
+		finish_nodepart_screen_task(scr, wait_for_task_result_on(scr->done_queue));
+
+	if (flags & COMPARE_TOTAL) {
+		if (scr->fit[idx] & NP_FIT_TOTAL)
+			return 1;
+		if (idx == scr->num_parts - 1)
+			return resresv_can_fit_nodepart(policy, nodepart[idx], resresv, flags, err);
+		return 0;
+	}
+
+	if (scr->fit[idx] & NP_FIT_FREE)
+		return 1;
+	if (scr->errs[idx] != NULL)
+		move_schd_error(err, scr->errs[idx]);
+	return 0;
+}
+
+/**
+ * @brief	stop and free a nodepart_screen.  Placement sets not yet
+ *		checked are skipped by the worker threads.
+ *
+ * @param[in]	scr - the screen to free
+ *
+ * @return void
+ */
+void
+free_nodepart_screen(nodepart_screen *scr)
+{
+	if (scr == NULL)
+		return;
+
+	scr->cancel = 0;
+	while (scr->tasks_done < scr->num_tasks)
+		finish_nodepart_screen_task(scr, wait_for_task_result_on(scr->done_queue));
+
+	for (int i = 0; i < scr->num_parts; i++)
+		free_schd_error(scr->errs[i]);
+	free(scr->errs);
+	free(scr->fit);
+	free(scr->chunk_done);
+	free_ds_queue(scr->done_queue);
+	delete scr;
+}
+
 /**
  * @brief
  * 		create_specific_nodepart - create a node partition with specific
@@ -1199,19 +1667,24 @@ sort_all_nodepart(status *policy, server_info *sinfo)
 	if (policy == NULL || sinfo == NULL)
 		return;
 
-	if (sinfo->node_group_enable && !sinfo->node_group_key.empty())
+	if (sinfo->node_group_enable && !sinfo->node_group_key.empty()) {
+		sim_undo_save_order(reinterpret_cast<void **>(sinfo->nodepart), sinfo->num_parts);
 		qsort(sinfo->nodepart, sinfo->num_parts,
 		      sizeof(node_partition *), cmp_placement_sets);
+	}
 
 	for (auto qinfo : sinfo->queues) {
 
-		if (sinfo->node_group_enable && !qinfo->node_group_key.empty())
+		if (sinfo->node_group_enable && !qinfo->node_group_key.empty()) {
+			sim_undo_save_order(reinterpret_cast<void **>(qinfo->nodepart), qinfo->num_parts);
 			qsort(qinfo->nodepart, qinfo->num_parts,
 			      sizeof(node_partition *), cmp_placement_sets);
+		}
 	}
 	if (!policy->node_sort->empty() && conf.node_sort_unused && sinfo->hostsets != NULL) {
 		/* Resort the nodes in host sets to correctly reflect unused resources */
-		qsort(sinfo->hostsets, sinfo->num_hostsets, sizeof(node_partition *), multi_nodepart_sort);
+		sim_undo_save_order(reinterpret_cast<void **>(sinfo->hostsets), sinfo->num_hostsets);
+		sort_nodepart_array(sinfo->hostsets, sinfo->num_hostsets);
 	}
 }
 
@@ -1241,6 +1714,16 @@ update_all_nodepart(status *policy, server_info *sinfo, unsigned int flags)
 	if (sinfo->allpart == NULL)
 		return;
 
+	if (sim_undo_active()) {
+		sim_undo_save_nodepart_array(sinfo->nodepart);
+		sim_undo_save_nodepart_array(sinfo->hostsets);
+		sim_undo_save_nodepart(sinfo->allpart);
+		for (auto qinfo : sinfo->queues) {
+			sim_undo_save_nodepart_array(qinfo->nodepart);
+			sim_undo_save_nodepart(qinfo->allpart);
+		}
+	}
+
 	if (sinfo->node_group_enable && !sinfo->node_group_key.empty())
 		node_partition_update_array(policy, sinfo->nodepart);
 
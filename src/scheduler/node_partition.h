@@ -198,6 +198,28 @@ find_alloc_np_cache(status *policy, std::vector<np_cache *> &pnpc_arr,
  */
 int resresv_can_fit_nodepart(status *policy, node_partition *np, resource_resv *resresv, unsigned int flags, schd_error *err);
 
+/*
+ * pthread routine to do the meta data checks of a chunk of placement sets
+ */
+void nodepart_fit_chunk(th_data_nodepart_fit *data);
+
+/*
+ * start checking an array of placement sets with resresv_can_fit_nodepart()
+ * on the worker threads
+ */
+nodepart_screen *start_nodepart_screen(status *policy, node_partition **nodepart, resource_resv *resresv, unsigned int flags);
+
+/*
+ * resresv_can_fit_nodepart() using the results of a nodepart_screen
+ */
+int screened_can_fit_nodepart(nodepart_screen *scr, status *policy, node_partition **nodepart, int idx,
+			      resource_resv *resresv, unsigned int flags, schd_error *err);
+
+/*
+ * stop and free a nodepart_screen
+ */
+void free_nodepart_screen(nodepart_screen *scr);
+
 /*
  *	create_specific_nodepart - create a node partition with specific
  *				   nodes, rather than from a placement
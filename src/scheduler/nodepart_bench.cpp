@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    nodepart_bench.cpp
+ *
+ * @brief
+ * 		nodepart_bench.cpp - microbenchmark of node partition creation.
+ *		Creates node partitions from scratch, again with the grouping of
+ *		the nodes kept from the first time, and again after the grouping
+ *		resource values of a few nodes changed.  Checks the partitions
+ *		are the same as those created from scratch from an identical
+ *		set of nodes, and reports the time each took.
+ *
+ *	usage: pbs_sched_nodepart_bench [-n num_nodes] [-c num_changed] [-r num_runs]
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include <string>
+#include <vector>
+
+#include <pbs_internal.h>
+#include <log.h>
+#include "data_types.h"
+#include "constant.h"
+#include "globals.h"
+#include "multi_threading.h"
+#include "node_info.h"
+#include "node_partition.h"
+#include "resource.h"
+#include "server_info.h"
+
+#define BENCH_DEFAULT_NODES 30000
+#define BENCH_DEFAULT_CHANGED 16
+#define BENCH_DEFAULT_RUNS 10
+#define BENCH_NODES_PER_SWITCH 16
+#define BENCH_NODES_PER_RACK 256
+
+/**
+ * @brief
+ * 		current wall clock time in seconds
+ *
+ * @return	double
+ */
+static double
+bench_time(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/**
+ * @brief
+ * 		add a resource definition to allres
+ *
+ * @param[in]	name	-	resource name
+ * @param[in]	type	-	server attribute type (ATR_TYPE_*)
+ *
+ * @return	resdef *
+ */
+static resdef *
+bench_add_resdef(const char *name, int type)
+{
+	resdef *def = new resdef(const_cast<char *>(name), ATR_DFLAG_CVTSLT, conv_rsc_type(type));
+	allres[name] = def;
+	if (def->type.is_consumable)
+		consres.insert(def);
+	return def;
+}
+
+/**
+ * @brief
+ * 		create the nodes, in groups of switches and racks
+ *
+ * @param[in]	prefix	-	prefix of the node names
+ * @param[in]	num_nodes	-	number of nodes
+ *
+ * @return	node_info **
+ */
+static node_info **
+bench_create_nodes(const char *prefix, int num_nodes)
+{
+	node_info **nodes;
+
+	nodes = static_cast<node_info **>(calloc(num_nodes + 1, sizeof(node_info *)));
+	if (nodes == NULL)
+		return NULL;
+
+	for (int i = 0; i < num_nodes; i++) {
+		char name[PBS_MAXHOSTNAME + 1];
+		char val[64];
+		schd_resource *res;
+
+		snprintf(name, sizeof(name), "%s%d", prefix, i);
+		auto ninfo = new node_info(name);
+		ninfo->rank = i + 1;
+		ninfo->is_free = (i % 3) != 0;
+		snprintf(val, sizeof(val), "%shost%d", prefix, i / 2);
+		ninfo->res = res = create_resource("host", val, RF_AVAIL);
+		snprintf(val, sizeof(val), "sw%d,all", i / BENCH_NODES_PER_SWITCH);
+		res = res->next = create_resource("switch", val, RF_AVAIL);
+		if (i % 100 != 0) { /* some nodes are in no rack */
+			snprintf(val, sizeof(val), "rack%d", i / BENCH_NODES_PER_RACK);
+			res = res->next = create_resource("rack", val, RF_AVAIL);
+		}
+		res = res->next = create_resource("ncpus", "64", RF_AVAIL);
+		res->assigned = i % 64;
+		nodes[i] = ninfo;
+	}
+	return nodes;
+}
+
+/**
+ * @brief
+ * 		count the differences between two arrays of node partitions
+ *
+ * @return	int
+ */
+static int
+bench_mismatches(node_partition **np1, int num1, node_partition **np2, int num2)
+{
+	int mismatch = 0;
+
+	if (num1 != num2)
+		return 1;
+
+	for (int i = 0; i < num1; i++) {
+		if (strcmp(np1[i]->name, np2[i]->name) != 0 || np1[i]->tot_nodes != np2[i]->tot_nodes ||
+		    np1[i]->free_nodes != np2[i]->free_nodes || np1[i]->ok_break != np2[i]->ok_break) {
+			mismatch++;
+			continue;
+		}
+		for (int j = 0; j < np1[i]->tot_nodes; j++) {
+			if (np1[i]->ninfo_arr[j]->rank != np2[i]->ninfo_arr[j]->rank) {
+				mismatch++;
+				break;
+			}
+		}
+	}
+	return mismatch;
+}
+
+/**
+ * @brief
+ * 		The entry point of pbs_sched_nodepart_bench
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	1	: partitions differ or error
+ */
+int
+main(int argc, char *argv[])
+{
+	int num_nodes = BENCH_DEFAULT_NODES;
+	int num_changed = BENCH_DEFAULT_CHANGED;
+	int num_runs = BENCH_DEFAULT_RUNS;
+	const std::vector<std::string> resnames{"switch", "rack"};
+	unsigned int flags = NP_CREATE_REST | NP_NO_ADD_NP_ARR;
+	std::vector<sort_info> node_sort;
+	node_info **nodes;
+	node_partition **np;
+	int num_parts = 0;
+	double start;
+	double scratch_time = 0;
+	double kept_time = 0;
+	double patch_time = 0;
+	double ref_time = 0;
+	int mismatch = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:c:r:")) != -1) {
+		switch (c) {
+			case 'n':
+				num_nodes = atoi(optarg);
+				break;
+			case 'c':
+				num_changed = atoi(optarg);
+				break;
+			case 'r':
+				num_runs = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-n num_nodes] [-c num_changed] [-r num_runs]\n", argv[0]);
+				return 1;
+		}
+	}
+
+	init_multi_threading(1);
+	bench_add_resdef("host", ATR_TYPE_STR);
+	bench_add_resdef("switch", ATR_TYPE_ARST);
+	bench_add_resdef("rack", ATR_TYPE_STR);
+	auto ncpus = bench_add_resdef("ncpus", ATR_TYPE_LONG);
+
+	auto policy = new status();
+	policy->resdef_to_check.insert(ncpus);
+	policy->node_sort = &node_sort;
+	cstat.node_sort = &node_sort;
+
+	nodes = bench_create_nodes("node", num_nodes);
+	if (nodes == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	printf("nodes: %d\n", num_nodes);
+	printf("changed nodes per run: %d\n", num_changed);
+
+	for (int r = 0; r < num_runs; r++) {
+		node_info **ref_nodes;
+		node_partition **ref_np;
+		int ref_num_parts = 0;
+		char prefix[32];
+
+		/* move some nodes to another switch */
+		for (int i = 0; i < num_changed && num_nodes > 0; i++) {
+			int node_i = (r * 7919L + i * 104729L) % num_nodes;
+			char val[64];
+
+			snprintf(val, sizeof(val), "sw%d,all", (node_i / BENCH_NODES_PER_SWITCH + r + 1) % (num_nodes / BENCH_NODES_PER_SWITCH + 1));
+			set_resource(find_resource(nodes[node_i]->res, allres["switch"]), val, RF_AVAIL);
+		}
+
+		start = bench_time();
+		np = create_node_partitions(policy, nodes, resnames, flags, &num_parts);
+		if (r == 0)
+			scratch_time = bench_time() - start;
+		else
+			patch_time += bench_time() - start;
+		free_node_partition_array(np);
+
+		start = bench_time();
+		np = create_node_partitions(policy, nodes, resnames, flags, &num_parts);
+		kept_time += bench_time() - start;
+
+		/* identical nodes under other names are grouped from scratch */
+		snprintf(prefix, sizeof(prefix), "ref%d_", r);
+		ref_nodes = bench_create_nodes(prefix, num_nodes);
+		for (int i = 0; i < num_nodes; i++) {
+			schd_resource *res = find_resource(nodes[i]->res, allres["switch"]);
+			set_resource(find_resource(ref_nodes[i]->res, allres["switch"]), res->orig_str_avail, RF_AVAIL);
+		}
+		start = bench_time();
+		ref_np = create_node_partitions(policy, ref_nodes, resnames, flags, &ref_num_parts);
+		ref_time += bench_time() - start;
+
+		mismatch += bench_mismatches(np, num_parts, ref_np, ref_num_parts);
+		free_node_partition_array(np);
+		free_node_partition_array(ref_np);
+		free_nodes(ref_nodes);
+	}
+
+	printf("node partitions: %d\n", num_parts);
+	printf("create from scratch: %.3fs\n", scratch_time);
+	printf("create with kept grouping: %.3fs\n", kept_time / num_runs);
+	if (num_runs > 1)
+		printf("create after changes: %.3fs\n", patch_time / (num_runs - 1));
+	printf("reference from scratch: %.3fs\n", ref_time / num_runs);
+	printf("mismatches: %d\n", mismatch);
+
+	return mismatch != 0;
+}
@@ -39,10 +39,61 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "pbs_bitmap.h"
 
 #define BYTES_TO_BITS(x) ((x) *8)
+#define BITS_PER_LONG BYTES_TO_BITS(sizeof(unsigned long))
+
+/*
+ * The whole-bitmap operations are simple loops over the longs which the
+ * compiler vectorizes.  Where the compiler can, it builds an AVX2 copy of
+ * them next to the plain one and picks between the two at run time.
+ */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define BITMAP_BULK_OP __attribute__((target_clones("arch=haswell", "default")))
+#else
+#define BITMAP_BULK_OP
+#endif
+
+/**
+ * @brief index of the lowest on bit of a long
+ * @param word - the long, must not be 0
+ * @return int
+ */
+static inline int
+lowest_on_bit(unsigned long word)
+{
+#ifdef __GNUC__
+	return __builtin_ctzl(word);
+#else
+	int i;
+
+	for (i = 0; !(word & (1UL << i)); i++)
+		;
+	return i;
+#endif
+}
+
+/**
+ * @brief number of on bits in a long
+ * @param word - the long
+ * @return int
+ */
+static inline int
+count_on_bits(unsigned long word)
+{
+#ifdef __GNUC__
+	return __builtin_popcountl(word);
+#else
+	int i;
+
+	for (i = 0; word != 0; i++)
+		word &= word - 1;
+	return i;
+#endif
+}
 
 /**
  * @brief allocate space for a pbs_bitmap (and possibly the bitmap itself)
@@ -71,12 +122,13 @@ pbs_bitmap_alloc(pbs_bitmap *pbm, unsigned long num_bits)
 
 	/* shrinking bitmap, clear previously used bits */
 	if (num_bits < bm->num_bits) {
-		long i;
-		i = num_bits / BYTES_TO_BITS(sizeof(unsigned long)) + 1;
-		for (; static_cast<unsigned long>(i) < bm->num_longs; i++)
-			bm->bits[i] = 0;
-		for (i = pbs_bitmap_next_on_bit(bm, num_bits); i != -1; i = pbs_bitmap_next_on_bit(bm, i))
-			pbs_bitmap_bit_off(bm, i);
+		unsigned long i;
+		i = num_bits / BITS_PER_LONG;
+		if (num_bits % BITS_PER_LONG > 0) {
+			bm->bits[i] &= (1UL << (num_bits % BITS_PER_LONG)) - 1;
+			i++;
+		}
+		memset(bm->bits + i, 0, (bm->num_longs - i) * sizeof(unsigned long));
 	}
 
 	/* If we have enough unused bits available, we don't need to allocate */
@@ -212,45 +264,27 @@ int
 pbs_bitmap_next_on_bit(pbs_bitmap *pbm, unsigned long start_bit)
 {
 	unsigned long long_ind;
-	long bit;
-	size_t i;
+	unsigned long word;
 
 	if (pbm == NULL)
 		return -1;
 
+	start_bit++;
 	if (start_bit >= pbm->num_bits)
 		return -1;
 
-	long_ind = start_bit / BYTES_TO_BITS(sizeof(unsigned long));
-	bit = start_bit % BYTES_TO_BITS(sizeof(unsigned long));
+	long_ind = start_bit / BITS_PER_LONG;
 
 	/* special case - look at first long that contains start_bit */
-	if (pbm->bits[long_ind] != 0) {
-		for (i = bit + 1; i < BYTES_TO_BITS(sizeof(unsigned long)); i++) {
-			if (pbm->bits[long_ind] & (1UL << i)) {
-				return (long_ind * BYTES_TO_BITS(sizeof(unsigned long)) + i);
-			}
-		}
+	word = pbm->bits[long_ind] & (~0UL << (start_bit % BITS_PER_LONG));
 
-		/* didn't find an on bit after start_bit_index in the long that contained start_bit */
-		if (long_ind < pbm->num_longs) {
-			long_ind++;
-		}
+	while (word == 0) {
+		if (++long_ind >= pbm->num_longs)
+			return -1;
+		word = pbm->bits[long_ind];
 	}
 
-	for (; long_ind < pbm->num_longs && pbm->bits[long_ind] == 0; long_ind++)
-		;
-
-	if (long_ind == pbm->num_longs)
-		return -1;
-
-	for (i = 0; i < BYTES_TO_BITS(sizeof(unsigned long)); i++) {
-		if (pbm->bits[long_ind] & (1UL << i)) {
-			return (long_ind * BYTES_TO_BITS(sizeof(unsigned long)) + i);
-		}
-	}
-
-	return -1;
+	return long_ind * BITS_PER_LONG + lowest_on_bit(word);
 }
 
 /**
@@ -280,8 +314,6 @@ pbs_bitmap_first_on_bit(pbs_bitmap *bm)
 int
 pbs_bitmap_assign(pbs_bitmap *L, pbs_bitmap *R)
 {
-	unsigned long i;
-
 	if (L == NULL || R == NULL)
 		return 0;
 
@@ -295,11 +327,9 @@ pbs_bitmap_assign(pbs_bitmap *L, pbs_bitmap *R)
 		if (pbs_bitmap_alloc(L, BYTES_TO_BITS(R->num_longs * sizeof(unsigned long))) == NULL)
 			return 0;
 
-	for (i = 0; i < R->num_longs; i++)
-		L->bits[i] = R->bits[i];
+	memcpy(L->bits, R->bits, R->num_longs * sizeof(unsigned long));
 	if (R->num_longs < L->num_longs)
-		for (; i < L->num_longs; i++)
-			L->bits[i] = 0;
+		memset(L->bits + R->num_longs, 0, (L->num_longs - R->num_longs) * sizeof(unsigned long));
 
 	L->num_bits = R->num_bits;
 	return 1;
@@ -330,3 +360,189 @@ pbs_bitmap_is_equal(pbs_bitmap *L, pbs_bitmap *R)
 
 	return 1;
 }
+
+/**
+ * @brief turn all the bits of a bitmap off
+ * @param bm - the bitmap
+ * @return nothing
+ */
+void
+pbs_bitmap_clear(pbs_bitmap *bm)
+{
+	if (bm == NULL || bm->bits == NULL)
+		return;
+
+	memset(bm->bits, 0, bm->num_longs * sizeof(unsigned long));
+}
+
+/**
+ * @brief count the on bits of a bitmap
+ * @param bm - the bitmap
+ * @return unsigned long
+ * @retval number of on bits
+ */
+BITMAP_BULK_OP
+unsigned long
+pbs_bitmap_count(pbs_bitmap *bm)
+{
+	unsigned long i;
+	unsigned long ct = 0;
+
+	if (bm == NULL)
+		return 0;
+
+	for (i = 0; i < bm->num_longs; i++)
+		ct += count_on_bits(bm->bits[i]);
+
+	return ct;
+}
+
+/**
+ * @brief pbs_bitmap version of L |= R
+ * @param L - bitmap lvalue
+ * @param R - bitmap rvalue
+ * @return int
+ * @retval 1 success
+ * @retval 0 failure
+ */
+BITMAP_BULK_OP
+int
+pbs_bitmap_or(pbs_bitmap *L, pbs_bitmap *R)
+{
+	unsigned long i;
+	unsigned long *lbits;
+	unsigned long *rbits;
+
+	if (L == NULL || R == NULL)
+		return 0;
+
+	if (R->num_bits > L->num_bits)
+		if (pbs_bitmap_alloc(L, R->num_bits) == NULL)
+			return 0;
+
+	lbits = L->bits;
+	rbits = R->bits;
+	for (i = 0; i < R->num_longs && i < L->num_longs; i++)
+		lbits[i] |= rbits[i];
+
+	return 1;
+}
+
+/**
+ * @brief pbs_bitmap version of L &= R
+ * @param L - bitmap lvalue
+ * @param R - bitmap rvalue
+ * @return int
+ * @retval 1 success
+ * @retval 0 failure
+ */
+BITMAP_BULK_OP
+int
+pbs_bitmap_and(pbs_bitmap *L, pbs_bitmap *R)
+{
+	unsigned long i;
+	unsigned long *lbits;
+	unsigned long *rbits;
+
+	if (L == NULL || R == NULL)
+		return 0;
+
+	lbits = L->bits;
+	rbits = R->bits;
+	for (i = 0; i < R->num_longs && i < L->num_longs; i++)
+		lbits[i] &= rbits[i];
+	for (; i < L->num_longs; i++)
+		lbits[i] = 0;
+
+	return 1;
+}
+
+/**
+ * @brief pbs_bitmap version of L &= ~R
+ * @param L - bitmap lvalue
+ * @param R - bitmap rvalue
+ * @return int
+ * @retval 1 success
+ * @retval 0 failure
+ */
+BITMAP_BULK_OP
+int
+pbs_bitmap_andnot(pbs_bitmap *L, pbs_bitmap *R)
+{
+	unsigned long i;
+	unsigned long *lbits;
+	unsigned long *rbits;
+
+	if (L == NULL || R == NULL)
+		return 0;
+
+	lbits = L->bits;
+	rbits = R->bits;
+	for (i = 0; i < R->num_longs && i < L->num_longs; i++)
+		lbits[i] &= ~rbits[i];
+
+	return 1;
+}
+
+/**
+ * @brief move the first on bits of a bitmap to one or two other bitmaps.
+ *	  The bits are turned off in from and on in to and to2.  Whole longs
+ *	  are moved at a time until fewer bits are left to move than a long has.
+ * @param from - bitmap to move bits from
+ * @param to - bitmap to move bits to
+ * @param to2 - second bitmap to move bits to, or NULL
+ * @param max_bits - the most bits to move
+ * @return unsigned long
+ * @retval number of bits moved
+ */
+unsigned long
+pbs_bitmap_move_on_bits(pbs_bitmap *from, pbs_bitmap *to, pbs_bitmap *to2, unsigned long max_bits)
+{
+	unsigned long i;
+	unsigned long num_longs;
+	unsigned long moved = 0;
+
+	if (from == NULL || to == NULL || max_bits == 0)
+		return 0;
+
+	if (from->num_bits > to->num_bits)
+		if (pbs_bitmap_alloc(to, from->num_bits) == NULL)
+			return 0;
+	if (to2 != NULL && from->num_bits > to2->num_bits)
+		if (pbs_bitmap_alloc(to2, from->num_bits) == NULL)
+			return 0;
+
+	num_longs = from->num_longs;
+	if (to->num_longs < num_longs)
+		num_longs = to->num_longs;
+	if (to2 != NULL && to2->num_longs < num_longs)
+		num_longs = to2->num_longs;
+
+	for (i = 0; i < num_longs && moved < max_bits; i++) {
+		unsigned long word = from->bits[i];
+		unsigned long ct;
+
+		if (word == 0)
+			continue;
+
+		ct = count_on_bits(word);
+		if (ct > max_bits - moved) {
+			unsigned long left = max_bits - moved;
+			unsigned long rest = word;
+
+			/* keep the lowest left bits of the long */
+			for (ct = 0; ct < left; ct++)
+				rest &= rest - 1;
+			word &= ~rest;
+			ct = left;
+		}
+
+		from->bits[i] &= ~word;
+		to->bits[i] |= word;
+		if (to2 != NULL)
+			to2->bits[i] |= word;
+		moved += ct;
+	}
+
+	return moved;
+}
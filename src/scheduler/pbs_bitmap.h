@@ -75,4 +75,22 @@ int pbs_bitmap_assign(pbs_bitmap *L, pbs_bitmap *R);
 /* pbs_bitmap's version of L == R */
 int pbs_bitmap_is_equal(pbs_bitmap *L, pbs_bitmap *R);
 
+/* Turn all bits off */
+void pbs_bitmap_clear(pbs_bitmap *bm);
+
+/* Count the on bits */
+unsigned long pbs_bitmap_count(pbs_bitmap *bm);
+
+/* pbs_bitmap's version of L |= R */
+int pbs_bitmap_or(pbs_bitmap *L, pbs_bitmap *R);
+
+/* pbs_bitmap's version of L &= R */
+int pbs_bitmap_and(pbs_bitmap *L, pbs_bitmap *R);
+
+/* pbs_bitmap's version of L &= ~R */
+int pbs_bitmap_andnot(pbs_bitmap *L, pbs_bitmap *R);
+
+/* Move the first on bits of a bitmap to one or two other bitmaps */
+unsigned long pbs_bitmap_move_on_bits(pbs_bitmap *from, pbs_bitmap *to, pbs_bitmap *to2, unsigned long max_bits);
+
 #endif /* _PBS_BITMASK_H */
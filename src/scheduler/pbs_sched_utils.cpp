@@ -258,6 +258,8 @@ die(int sig)
 
 	unload_auths();
 
+	/* the log writer may be waiting for the log mutex the interrupted thread holds */
+	log_async_signal_stop();
 	log_close(1);
 	exit(1);
 }
@@ -377,8 +379,7 @@ restart(int sig)
 	const sched_cmd cmd = {SCH_CONFIGURE, NULL};
 
 	if (sig) {
-		log_close(1);
-		log_open(logfile, path_log);
+		log_reopen(logfile, path_log);
 		sprintf(log_buffer, "restart on signal %d", sig);
 	} else {
 		sprintf(log_buffer, "restart command");
@@ -1082,6 +1083,10 @@ sched_main(int argc, char *argv[], schedule_func sched_ptr)
 	}
 #endif /* _POSIX_MEMLOCK */
 
+	/* hand the writing of the scheduler log to a writer thread */
+	if (pbs_conf.pbs_log_async && log_async_start() != 0)
+		log_err(-1, __func__, "could not start log writer thread, logging synchronously");
+
 	(void) sprintf(log_buffer, msg_startup1, PBS_VERSION, 0);
 	log_event(PBSEVENT_SYSTEM | PBSEVENT_ADMIN | PBSEVENT_FORCE,
 		  LOG_NOTICE, PBS_EVENTCLASS_SERVER, msg_daemonname, log_buffer);
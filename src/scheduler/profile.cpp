@@ -0,0 +1,445 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    profile.cpp
+ *
+ * @brief
+ * 		profile.cpp - per phase timings of the scheduling cycle
+ *
+ *	When the sched_profile attribute of the scheduler is set, phases of
+ *	the cycle are timed with prof_scope objects.  Each thread accumulates
+ *	the wall and CPU time of every stack of phases it went through in its
+ *	own table, so timing takes no locks.  At the end of the cycle, the main
+ *	thread collects the tables of all threads (the worker threads are idle
+ *	then), and writes
+ *	  - a JSON record of the cycle to PROF_JSON_FILE, one line per cycle,
+ *	    with the time of each stack of phases and of the slowest jobs
+ *	  - the self time of each stack of phases of the cycle to
+ *	    PROF_FOLDED_FILE in the collapsed stack format of flamegraph.pl
+ *	and logs the time of the top level phases.
+ *
+ * Functions included are:
+ * 	prof_scope::prof_scope()
+ * 	prof_scope::~prof_scope()
+ * 	prof_job_scope::prof_job_scope()
+ * 	prof_job_scope::~prof_job_scope()
+ * 	prof_begin_cycle()
+ * 	prof_end_cycle()
+ *
+ */
+
+#include <pbs_config.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <log.h>
+
+#include "constant.h"
+#include "globals.h"
+#include "profile.h"
+
+/* accumulated time of a stack of phases */
+struct prof_stat {
+	long count;
+	long long wall_ns; /* total wall time, including the nested phases */
+	long long cpu_ns;
+	long long self_wall_ns; /* wall time outside of the nested phases */
+	long long self_cpu_ns;
+};
+
+/* a phase a thread is in */
+struct prof_frame {
+	std::string path; /* names of the phases from the outermost one, ';' separated */
+	long long child_wall_ns;
+	long long child_cpu_ns;
+};
+
+/* time of one job considered in the main loop */
+struct prof_job {
+	std::string jobid;
+	long long wall_ns;
+	long long cpu_ns;
+};
+
+/* the profile of one thread */
+struct prof_thread {
+	int tid;
+	std::vector<prof_frame> stack;
+	std::map<std::string, prof_stat> stats;
+};
+
+static std::atomic<bool> prof_on(false);
+static time_t prof_cycle_start;
+static struct timespec prof_wall_start;
+static std::vector<prof_job> prof_jobs; /* main thread only */
+static std::vector<prof_thread *> prof_threads;
+static pthread_mutex_t prof_threads_lock = PTHREAD_MUTEX_INITIALIZER;
+static thread_local prof_thread *prof_td = NULL;
+
+/**
+ * @brief
+ * 		nanoseconds between two times
+ */
+static long long
+prof_ns(const struct timespec &start, const struct timespec &end)
+{
+	return (end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec);
+}
+
+/**
+ * @brief
+ * 		the profile of the calling thread, created on first use
+ *
+ * @return	prof_thread *
+ */
+static prof_thread *
+prof_get_thread(void)
+{
+	if (prof_td == NULL) {
+		void *tid = pthread_getspecific(th_id_key);
+
+		prof_td = new prof_thread;
+		prof_td->tid = (tid != NULL) ? *static_cast<int *>(tid) : 0;
+		pthread_mutex_lock(&prof_threads_lock);
+		prof_threads.push_back(prof_td);
+		pthread_mutex_unlock(&prof_threads_lock);
+	}
+	return prof_td;
+}
+
+/**
+ * @brief
+ * 		start timing a phase
+ *
+ * @param[in]	name	-	name of the phase, a string constant
+ */
+prof_scope::prof_scope(const char *name)
+{
+	prof_thread *td;
+	prof_frame frame;
+
+	active = prof_on.load(std::memory_order_relaxed);
+	if (!active)
+		return;
+
+	td = prof_get_thread();
+	if (td->stack.empty()) {
+		/* phases on worker threads are shown under the threads */
+		frame.path = (td->tid == 0) ? name : std::string("worker_threads;") + name;
+	} else
+		frame.path = td->stack.back().path + ";" + name;
+	frame.child_wall_ns = 0;
+	frame.child_cpu_ns = 0;
+	td->stack.push_back(frame);
+
+	clock_gettime(CLOCK_MONOTONIC, &wall_start);
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_start);
+}
+
+/**
+ * @brief
+ * 		stop timing a phase and add its time to its stack of phases
+ */
+prof_scope::~prof_scope()
+{
+	struct timespec wall_end;
+	struct timespec cpu_end;
+	long long wall_ns;
+	long long cpu_ns;
+	prof_thread *td;
+
+	if (!active)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &wall_end);
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_end);
+	wall_ns = prof_ns(wall_start, wall_end);
+	cpu_ns = prof_ns(cpu_start, cpu_end);
+
+	td = prof_get_thread();
+	if (td->stack.empty())
+		return; /* profiling was reset while in the phase */
+
+	auto &frame = td->stack.back();
+	auto &st = td->stats[frame.path];
+	st.count++;
+	st.wall_ns += wall_ns;
+	st.cpu_ns += cpu_ns;
+	st.self_wall_ns += wall_ns - frame.child_wall_ns;
+	st.self_cpu_ns += cpu_ns - frame.child_cpu_ns;
+	td->stack.pop_back();
+
+	if (!td->stack.empty()) {
+		td->stack.back().child_wall_ns += wall_ns;
+		td->stack.back().child_cpu_ns += cpu_ns;
+	}
+}
+
+/**
+ * @brief
+ * 		start timing the consideration of a job
+ *
+ * @param[in]	jid	-	the job's id, must outlive the object
+ */
+prof_job_scope::prof_job_scope(const char *jid)
+{
+	active = prof_on.load(std::memory_order_relaxed);
+	if (!active)
+		return;
+
+	jobid = jid;
+	clock_gettime(CLOCK_MONOTONIC, &wall_start);
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_start);
+}
+
+/**
+ * @brief
+ * 		stop timing the consideration of a job
+ */
+prof_job_scope::~prof_job_scope()
+{
+	struct timespec wall_end;
+	struct timespec cpu_end;
+	prof_job pj;
+
+	if (!active)
+		return;
+
+	clock_gettime(CLOCK_MONOTONIC, &wall_end);
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu_end);
+	pj.jobid = jobid;
+	pj.wall_ns = prof_ns(wall_start, wall_end);
+	pj.cpu_ns = prof_ns(cpu_start, cpu_end);
+	prof_jobs.push_back(pj);
+}
+
+/**
+ * @brief
+ * 		start profiling a cycle if the sched_profile attribute is set.
+ *		Anything left from a previous cycle is thrown away.
+ *
+ * @return	void
+ */
+void
+prof_begin_cycle(void)
+{
+	pthread_mutex_lock(&prof_threads_lock);
+	for (auto td : prof_threads) {
+		td->stack.clear();
+		td->stats.clear();
+	}
+	pthread_mutex_unlock(&prof_threads_lock);
+	prof_jobs.clear();
+
+	prof_on = sc_attrs.sched_profile;
+	if (prof_on) {
+		time(&prof_cycle_start);
+		clock_gettime(CLOCK_MONOTONIC, &prof_wall_start);
+	}
+}
+
+/**
+ * @brief
+ * 		write a string as a JSON string
+ *
+ * @param[in]	fp	-	file to write to
+ * @param[in]	str	-	the string
+ *
+ * @return	void
+ */
+static void
+prof_json_string(FILE *fp, const std::string &str)
+{
+	fputc('"', fp);
+	for (auto c : str) {
+		if (c == '"' || c == '\\')
+			fprintf(fp, "\\%c", c);
+		else if (static_cast<unsigned char>(c) < 0x20)
+			fprintf(fp, "\\u%04x", c);
+		else
+			fputc(c, fp);
+	}
+	fputc('"', fp);
+}
+
+/* std::sort() compare function for jobs, slowest first */
+static bool
+cmp_prof_job_slowest(const prof_job &j1, const prof_job &j2)
+{
+	return j1.wall_ns > j2.wall_ns;
+}
+
+/**
+ * @brief
+ * 		append the JSON record of a cycle to PROF_JSON_FILE
+ *
+ * @param[in]	stats	-	time of each stack of phases, of all threads
+ * @param[in]	wall_ns	-	wall time of the cycle
+ *
+ * @return	void
+ */
+static void
+prof_write_json(const std::map<std::string, prof_stat> &stats, long long wall_ns)
+{
+	struct stat sb;
+	FILE *fp;
+	bool first = true;
+	size_t num_top;
+
+	if (stat(PROF_JSON_FILE, &sb) == 0 && sb.st_size > PROF_JSON_MAX_SIZE)
+		rename(PROF_JSON_FILE, PROF_JSON_FILE ".1");
+
+	if ((fp = fopen(PROF_JSON_FILE, "a")) == NULL) {
+		log_err(errno, __func__, "Can not open " PROF_JSON_FILE);
+		return;
+	}
+
+	fprintf(fp, "{\"cycle_start\":%ld,\"wall_ms\":%.3f,\"phases\":[", static_cast<long>(prof_cycle_start), wall_ns / 1e6);
+	for (const auto &st : stats) {
+		fprintf(fp, "%s{\"stack\":", first ? "" : ",");
+		prof_json_string(fp, st.first);
+		fprintf(fp, ",\"count\":%ld,\"wall_ms\":%.3f,\"cpu_ms\":%.3f,\"self_wall_ms\":%.3f,\"self_cpu_ms\":%.3f}",
+			st.second.count, st.second.wall_ns / 1e6, st.second.cpu_ns / 1e6,
+			st.second.self_wall_ns / 1e6, st.second.self_cpu_ns / 1e6);
+		first = false;
+	}
+
+	num_top = std::min(prof_jobs.size(), static_cast<size_t>(PROF_TOP_JOBS));
+	std::partial_sort(prof_jobs.begin(), prof_jobs.begin() + num_top, prof_jobs.end(), cmp_prof_job_slowest);
+	fprintf(fp, "],\"jobs_considered\":%zu,\"slowest_jobs\":[", prof_jobs.size());
+	for (size_t i = 0; i < num_top; i++) {
+		fprintf(fp, "%s{\"jobid\":", i == 0 ? "" : ",");
+		prof_json_string(fp, prof_jobs[i].jobid);
+		fprintf(fp, ",\"wall_ms\":%.3f,\"cpu_ms\":%.3f}", prof_jobs[i].wall_ns / 1e6, prof_jobs[i].cpu_ns / 1e6);
+	}
+	fprintf(fp, "]}\n");
+	fclose(fp);
+}
+
+/**
+ * @brief
+ * 		write the collapsed stacks of a cycle to PROF_FOLDED_FILE, with the
+ *		self wall time of each stack of phases in microseconds
+ *
+ * @param[in]	stats	-	time of each stack of phases, of all threads
+ *
+ * @return	void
+ */
+static void
+prof_write_folded(const std::map<std::string, prof_stat> &stats)
+{
+	FILE *fp;
+
+	if ((fp = fopen(PROF_FOLDED_FILE, "w")) == NULL) {
+		log_err(errno, __func__, "Can not open " PROF_FOLDED_FILE);
+		return;
+	}
+	for (const auto &st : stats) {
+		long long usecs = st.second.self_wall_ns / 1000;
+
+		if (usecs > 0)
+			fprintf(fp, "%s %lld\n", st.first.c_str(), usecs);
+	}
+	fclose(fp);
+}
+
+/**
+ * @brief
+ * 		collect the profile of the cycle from all threads, write it out
+ *		and log the time of the outermost phases and their children
+ *
+ * @return	void
+ */
+void
+prof_end_cycle(void)
+{
+	std::map<std::string, prof_stat> stats;
+	struct timespec wall_end;
+	long long wall_ns;
+
+	if (!prof_on)
+		return;
+	prof_on = false;
+
+	clock_gettime(CLOCK_MONOTONIC, &wall_end);
+	wall_ns = prof_ns(prof_wall_start, wall_end);
+
+	pthread_mutex_lock(&prof_threads_lock);
+	for (auto td : prof_threads) {
+		for (const auto &st : td->stats) {
+			auto &sum = stats[st.first];
+			sum.count += st.second.count;
+			sum.wall_ns += st.second.wall_ns;
+			sum.cpu_ns += st.second.cpu_ns;
+			sum.self_wall_ns += st.second.self_wall_ns;
+			sum.self_cpu_ns += st.second.self_cpu_ns;
+		}
+		td->stats.clear();
+		td->stack.clear();
+	}
+	pthread_mutex_unlock(&prof_threads_lock);
+
+	prof_write_json(stats, wall_ns);
+	prof_write_folded(stats);
+
+	for (const auto &st : stats) {
+		/* the outermost phases and the ones directly within them */
+		if (std::count(st.first.begin(), st.first.end(), ';') > 1)
+			continue;
+		log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__,
+			   "%s: %ld calls, %.3f seconds wall, %.3f seconds cpu",
+			   st.first.c_str(), st.second.count, st.second.wall_ns / 1e9, st.second.cpu_ns / 1e9);
+	}
+	log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_SCHED, LOG_DEBUG, __func__,
+		   "Cycle took %.3f seconds, %zu jobs considered, profile written to %s and %s",
+		   wall_ns / 1e9, prof_jobs.size(), PROF_JSON_FILE, PROF_FOLDED_FILE);
+	prof_jobs.clear();
+}
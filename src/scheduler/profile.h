@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+#ifndef _PROFILE_H
+#define _PROFILE_H
+
+#include <time.h>
+
+/* files the cycle profiles are written to, in the sched_priv directory */
+#define PROF_JSON_FILE "sched_profile.json"	    /* one JSON record per cycle */
+#define PROF_FOLDED_FILE "sched_profile.folded" /* collapsed stacks of the last cycle */
+#define PROF_JSON_MAX_SIZE (16 * 1024 * 1024)   /* rotate the JSON file to .1 beyond this */
+#define PROF_TOP_JOBS 20			    /* slowest jobs listed per cycle */
+
+/*
+ * prof_scope - time a phase of the cycle from construction to destruction.
+ *		Phases nest, and the time of each stack of phases is
+ *		accumulated per thread.  Does nothing if profiling is off.
+ */
+class prof_scope
+{
+	public:
+	explicit prof_scope(const char *name);
+	~prof_scope();
+	prof_scope(const prof_scope &) = delete;
+	prof_scope &operator=(const prof_scope &) = delete;
+
+	private:
+	bool active;
+	struct timespec wall_start;
+	struct timespec cpu_start;
+};
+
+/*
+ * prof_job_scope - time the consideration of one job in the main loop
+ */
+class prof_job_scope
+{
+	public:
+	explicit prof_job_scope(const char *jobid);
+	~prof_job_scope();
+	prof_job_scope(const prof_job_scope &) = delete;
+	prof_job_scope &operator=(const prof_job_scope &) = delete;
+
+	private:
+	bool active;
+	const char *jobid;
+	struct timespec wall_start;
+	struct timespec cpu_start;
+};
+
+/*
+ *	prof_begin_cycle - start profiling a cycle if sched_profile is set
+ */
+void prof_begin_cycle(void);
+
+/*
+ *	prof_end_cycle - collect the profile of the cycle from all threads,
+ *			 write it out and log a summary
+ */
+void prof_end_cycle(void);
+
+#endif /* _PROFILE_H */
@@ -84,6 +84,8 @@
 #include "limits_if.h"
 #include "pbs_internal.h"
 #include "fifo.h"
+#include "sim_undo.h"
+#include "ec_cache.h"
 
 /**
  * @brief
@@ -146,6 +148,7 @@ query_queues(status *policy, int pbs_sd, server_info *sinfo)
 		free_schd_error(sch_err);
 		return qinfo_arr;
 	}
+	sinfo->universe_fp = ec_cache_hash_status(sinfo->universe_fp, queues);
 
 	for (cur_queue = queues; cur_queue != NULL && !err; cur_queue = cur_queue->next) {
 		queue_info *qinfo;
@@ -550,9 +553,10 @@ update_queue_on_run(queue_info *qinfo, resource_resv *resresv, char *job_state)
 		qinfo->sc.queued--;
 	}
 
-	if (!cstat.node_sort->empty() && conf.node_sort_unused && qinfo->nodes != NULL)
-		qsort(qinfo->nodes, qinfo->num_nodes, sizeof(node_info *),
-		      multi_node_sort);
+	if (!cstat.node_sort->empty() && conf.node_sort_unused && qinfo->nodes != NULL) {
+		sim_undo_save_order(reinterpret_cast<void **>(qinfo->nodes), qinfo->num_nodes);
+		sort_moved_nodes(qinfo->nodes, qinfo->num_nodes, resresv->nspec_arr);
+	}
 
 	if ((job_state != NULL) && (*job_state == 'S') && (resresv->job->resreq_rel != NULL))
 		req = resresv->job->resreq_rel;
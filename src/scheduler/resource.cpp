@@ -81,6 +81,8 @@
 #include "sort.h"
 #include "parse.h"
 #include "fifo.h"
+#include "formula.h"
+#include "ec_cache.h"
 
 /**
  * @brief
@@ -377,6 +379,10 @@ update_resource_defs(int pbs_sd)
 
 	allres = tmpres;
 
+	int id = 0;
+	for (auto &def : allres)
+		def.second->id = id++;
+
 	consres.clear();
 	for (const auto &def : allres) {
 		if (def.second->type.is_consumable)
@@ -389,6 +395,12 @@ update_resource_defs(int pbs_sd)
 			boolres.insert(def.second);
 	}
 
+	/* compiled formulas point to the old resource definitions */
+	clear_formula_cache();
+
+	/* so do the reasons equivalence classes could not run */
+	ec_cache_clear();
+
 	conf.resdef_to_check.clear();
 	if (!conf.res_to_check.empty()) {
 		conf.resdef_to_check = resstr_to_resdef(conf.res_to_check);
@@ -143,6 +143,10 @@ resource_resv::resource_resv(const std::string &rname) : name(rname)
 
 	ec_index = UNSPECIFIED;
 
+	user_id = UNSPECIFIED;
+	group_id = UNSPECIFIED;
+	project_id = UNSPECIFIED;
+
 	start = UNSPECIFIED;
 	end = UNSPECIFIED;
 	duration = UNSPECIFIED;
@@ -260,35 +264,25 @@ free_resource_resv_array(resource_resv **resresv_arr)
 		return;
 	}
 
-	chunk_size = num_jobs / num_threads;
-	chunk_size = (chunk_size > MT_CHUNK_SIZE_MIN) ? chunk_size : MT_CHUNK_SIZE_MIN;
-	chunk_size = (chunk_size < MT_CHUNK_SIZE_MAX) ? chunk_size : MT_CHUNK_SIZE_MAX;
+	chunk_size = mt_chunk_size(num_jobs);
 	for (i = 0, num_tasks = 0; num_jobs > 0;
 	     num_tasks++, i += chunk_size, num_jobs -= chunk_size) {
 		tdata = alloc_tdata_free_rr_arr(resresv_arr, i, i + chunk_size - 1);
 		if (tdata == NULL)
 			break;
 
-		task = static_cast<th_task_info *>(malloc(sizeof(th_task_info)));
-		task->task_type = TS_FREE_RESRESV;
-		task->thread_data = (void *) tdata;
-
-		queue_work_for_threads(task);
+		if (!queue_task_for_threads(TS_FREE_RESRESV, 0, tdata)) {
+			free(tdata);
+			break;
+		}
 	}
 
 	/* Get results from worker threads */
-	for (i = 0; i < num_tasks;) {
-		pthread_mutex_lock(&result_lock);
-		while (ds_queue_is_empty(result_queue))
-			pthread_cond_wait(&result_cond, &result_lock);
-		while (!ds_queue_is_empty(result_queue)) {
-			task = static_cast<th_task_info *>(ds_dequeue(result_queue));
-			tdata = static_cast<th_data_free_resresv *>(task->thread_data);
-			free(tdata);
-			free(task);
-			i++;
-		}
-		pthread_mutex_unlock(&result_lock);
+	for (i = 0; i < num_tasks; i++) {
+		task = wait_for_task_result();
+		tdata = static_cast<th_data_free_resresv *>(task->thread_data);
+		free(tdata);
+		free(task);
 	}
 
 	free(resresv_arr);
@@ -450,9 +444,7 @@ dup_resource_resv_array(resource_resv **oresresv_arr,
 		}
 	} else { /* We are multithreading */
 		int num_tasks = 0;
-		int chunk_size = num_resresv / num_threads;
-		chunk_size = (chunk_size > MT_CHUNK_SIZE_MIN) ? chunk_size : MT_CHUNK_SIZE_MIN;
-		chunk_size = (chunk_size < MT_CHUNK_SIZE_MAX) ? chunk_size : MT_CHUNK_SIZE_MAX;
+		int chunk_size = mt_chunk_size(num_resresv);
 		for (int j = 0; thread_job_ct_left > 0;
 		     num_tasks++, j += chunk_size, thread_job_ct_left -= chunk_size) {
 			tdata = alloc_tdata_dup_nodes(oresresv_arr, nresresv_arr, nsinfo, nqinfo, j, j + chunk_size - 1);
@@ -460,28 +452,21 @@ dup_resource_resv_array(resource_resv **oresresv_arr,
 				th_err = 1;
 				break;
 			}
-			task = static_cast<th_task_info *>(malloc(sizeof(th_task_info)));
-			task->task_type = TS_DUP_RESRESV;
-			task->thread_data = (void *) tdata;
-
-			queue_work_for_threads(task);
+			if (!queue_task_for_threads(TS_DUP_RESRESV, 0, tdata)) {
+				free(tdata);
+				th_err = 1;
+				break;
+			}
 		}
 
 		/* Get results from worker threads */
-		for (int i = 0; i < num_tasks;) {
-			pthread_mutex_lock(&result_lock);
-			while (ds_queue_is_empty(result_queue))
-				pthread_cond_wait(&result_cond, &result_lock);
-			while (!ds_queue_is_empty(result_queue)) {
-				task = static_cast<th_task_info *>(ds_dequeue(result_queue));
-				tdata = static_cast<th_data_dup_resresv *>(task->thread_data);
-				if (tdata->error)
-					th_err = 1;
-				free(tdata);
-				free(task);
-				i++;
-			}
-			pthread_mutex_unlock(&result_lock);
+		for (int i = 0; i < num_tasks; i++) {
+			task = wait_for_task_result();
+			tdata = static_cast<th_data_dup_resresv *>(task->thread_data);
+			if (tdata->error)
+				th_err = 1;
+			free(tdata);
+			free(task);
 		}
 	}
 
@@ -539,6 +524,9 @@ dup_resource_resv(resource_resv *oresresv, server_info *nsinfo, queue_info *nqin
 	nresresv->user = oresresv->user;
 	nresresv->group = oresresv->group;
 	nresresv->project = oresresv->project;
+	nresresv->user_id = oresresv->user_id;
+	nresresv->group_id = oresresv->group_id;
+	nresresv->project_id = oresresv->project_id;
 
 	nresresv->nodepart_name = string_dup(oresresv->nodepart_name);
 	if (oresresv->select != NULL)
@@ -614,6 +614,10 @@ query_resv(struct batch_status *resv, server_info *sinfo)
 		attrp = attrp->next;
 	}
 
+	advresv->user_id = entity_id(advresv->user);
+	advresv->group_id = entity_id(advresv->group);
+	advresv->project_id = entity_id(advresv->project);
+
 	/* If we have a select_orig, this means we're doing an ralter and reducing the size of our reservation
 	 * We need to map the orig chunks to chunks from the smaller select to make sure we keep them.
 	 * To do this, we set the seq_num of the select chunk to the same seq_num of the select_orig chunk
@@ -2045,8 +2049,7 @@ modify_jobs_nodes_for_resv(resource_resv *resresv, time_t server_time)
 		free(jobs_in_reservations);
 
 		/* Sort the nodes to ensure correct job placement. */
-		qsort(resresv->resv->resv_nodes,
-		      count_array(resresv->resv->resv_nodes),
-		      sizeof(node_info *), multi_node_sort);
+		sort_node_array(resresv->resv->resv_nodes,
+				count_array(resresv->resv->resv_nodes));
 	}
 }
\ No newline at end of file
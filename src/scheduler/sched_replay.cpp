@@ -0,0 +1,1033 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    sched_replay.cpp
+ *
+ * @brief
+ * 		sched_replay.cpp - run the scheduler against a captured snapshot
+ *		of a server instead of a live server.
+ *
+ *	With -C, the status of the server, scheduler objects, resources,
+ *	queues, vnodes, reservations and jobs of a live server is written to a
+ *	snapshot file.  Otherwise the snapshot is loaded and scheduling cycles
+ *	are run against it: the IFL calls the scheduler makes are pointed at
+ *	stubs which answer the status requests from the snapshot and record
+ *	the run, preempt and other requests the scheduler sends instead of
+ *	sending them.  Every cycle starts from the same snapshot, and the clock
+ *	is set back to the time the snapshot was captured, so the cycles can be
+ *	compared with each other and between builds.
+ *
+ *	usage: pbs_sched_replay -C [-s server] snapshot
+ *	       pbs_sched_replay [-d sched_priv] [-L logfile] [-n num_cycles] [-t num_threads]
+ *				[-o decisions_file] [-p preempt_method] [-P] [-r] [-U] [-l]
+ *				[-a cycle:attribute[.resource]=value] snapshot
+ *
+ *	-U checks the undo log used to estimate the start times of top jobs:
+ *	each estimate is also made in a copy of the universe and compared, see
+ *	sim_undo_check().
+ *
+ *	-l checks the limit cache: every cached limit value used is also read
+ *	from its limit context and compared, see lim_cache_set_check().
+ *
+ *	-a sets a server attribute of the snapshot from the given cycle on, e.g.
+ *	to change a limit between cycles.  It may be given more than once.
+ *
+ * Functions included are:
+ * 	time()
+ * 	replay_write_escaped()
+ * 	capture_snapshot()
+ * 	replay_unescape()
+ * 	load_snapshot()
+ * 	replay_match()
+ * 	replay_stat()
+ * 	replay_statserver()
+ * 	replay_statsched()
+ * 	replay_statrsc()
+ * 	replay_statque()
+ * 	replay_statvnode()
+ * 	replay_statresv()
+ * 	replay_selstat()
+ * 	replay_runjob()
+ * 	replay_alterjob()
+ * 	replay_preempt_jobs()
+ * 	replay_sigjob()
+ * 	replay_confirmresv()
+ * 	replay_movejob()
+ * 	replay_manager()
+ * 	replay_connect()
+ * 	replay_disconnect()
+ * 	replay_geterrmsg()
+ * 	install_replay_stubs()
+ * 	main()
+ *
+ */
+#include <pbs_config.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include <string>
+#include <vector>
+
+#include <libpbs.h>
+#include <libsec.h>
+#include <log.h>
+#include <pbs_ecl.h>
+#include <pbs_ifl.h>
+#include <pbs_internal.h>
+#include <sched_cmds.h>
+#include "data_types.h"
+#include "constant.h"
+#include "config.h"
+#include "fifo.h"
+#include "globals.h"
+#include "limits_if.h"
+#include "multi_threading.h"
+#include "sim_undo.h"
+
+#define SNAPSHOT_MAGIC "#PBS_SCHED_SNAPSHOT 1"
+#define REPLAY_DEFAULT_CYCLES 3
+#define REPLAY_FAKE_SD 1000 /* connection handle handed to the scheduler */
+
+/* object types of a snapshot, in the order they are captured */
+enum replay_obj_type {
+	RP_SERVER,
+	RP_SCHED,
+	RP_RESOURCE,
+	RP_QUEUE,
+	RP_NODE,
+	RP_RESV,
+	RP_JOB,
+	RP_NUM_TYPES
+};
+
+static const char *replay_obj_names[RP_NUM_TYPES] = {
+	"server",
+	"sched",
+	"resource",
+	"queue",
+	"node",
+	"resv",
+	"job"};
+
+struct replay_attr {
+	std::string name;
+	std::string resource;
+	std::string value;
+};
+
+struct replay_obj {
+	std::string name;
+	std::vector<replay_attr> attrs;
+};
+
+static std::vector<replay_obj> snapshot[RP_NUM_TYPES];
+static time_t snapshot_time;
+
+/* added to the real time by time() to set the clock back to snapshot_time */
+static time_t replay_time_offset = 0;
+
+/* requests the scheduler sent in the current cycle */
+static std::vector<std::string> decisions;
+static int num_alters;
+
+/* a server attribute set from a cycle on, see -a */
+struct replay_change {
+	int cycle;
+	replay_attr attr;
+};
+
+/* how the stub server says a job was preempted, see pbs_preempt_jobs() */
+static char preempt_method = 'S';
+
+/**
+ * @brief
+ * 		the time of day, set back to the time the snapshot was captured
+ *		while replaying.  Takes the place of the C library's time() for
+ *		the scheduler linked into this program.
+ *
+ * @param[out]	tloc	-	if not NULL, set to the time too
+ *
+ * @return	time_t
+ */
+extern "C" time_t
+time(time_t *tloc) __THROW
+{
+	struct timeval tv;
+	time_t now;
+
+	gettimeofday(&tv, NULL);
+	now = tv.tv_sec + replay_time_offset;
+	if (tloc != NULL)
+		*tloc = now;
+	return now;
+}
+
+/**
+ * @brief
+ * 		current wall clock time in seconds
+ *
+ * @return	double
+ */
+static double
+bench_time(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/**
+ * @brief
+ * 		write a string to a snapshot with the backslashes, tabs and
+ *		newlines in it escaped
+ *
+ * @param[in]	fp	-	snapshot file
+ * @param[in]	str	-	string to write, NULL is written as ""
+ *
+ * @return	void
+ */
+static void
+replay_write_escaped(FILE *fp, const char *str)
+{
+	if (str == NULL)
+		return;
+
+	for (; *str != '\0'; str++) {
+		switch (*str) {
+			case '\\':
+				fputs("\\\\", fp);
+				break;
+			case '\t':
+				fputs("\\t", fp);
+				break;
+			case '\n':
+				fputs("\\n", fp);
+				break;
+			default:
+				fputc(*str, fp);
+		}
+	}
+}
+
+/**
+ * @brief
+ * 		capture the status of a live server to a snapshot file
+ *
+ * @param[in]	server	-	server to connect to, NULL for the default one
+ * @param[in]	file	-	snapshot file to write
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	1	: failure
+ */
+static int
+capture_snapshot(const char *server, const char *file)
+{
+	struct batch_status *bs[RP_NUM_TYPES];
+	char extend[] = {EXTEND_OPT_SCHED_JOBS, '\0'};
+	FILE *fp;
+	int sd;
+	int i;
+
+	if (CS_client_init() != CS_SUCCESS) {
+		fprintf(stderr, "unable to initialize security library\n");
+		return 1;
+	}
+	if ((sd = pbs_connect(const_cast<char *>(server))) < 0) {
+		fprintf(stderr, "can not connect to server %s (%d)\n", server ? server : pbs_default(), pbs_errno);
+		return 1;
+	}
+
+	/* the same requests the scheduler makes, but for all attributes */
+	bs[RP_SERVER] = pbs_statserver(sd, NULL, NULL);
+	bs[RP_SCHED] = pbs_statsched(sd, NULL, NULL);
+	bs[RP_RESOURCE] = pbs_statrsc(sd, NULL, NULL, const_cast<char *>("p"));
+	bs[RP_QUEUE] = pbs_statque(sd, NULL, NULL, NULL);
+	bs[RP_NODE] = pbs_statvnode(sd, NULL, NULL, NULL);
+	bs[RP_RESV] = pbs_statresv(sd, NULL, NULL, NULL);
+	bs[RP_JOB] = pbs_selstat(sd, NULL, NULL, extend);
+
+	if (bs[RP_SERVER] == NULL || bs[RP_SCHED] == NULL) {
+		const char *errmsg = pbs_geterrmsg(sd);
+
+		fprintf(stderr, "can not get the status of the server: %s (%d)\n", errmsg ? errmsg : "", pbs_errno);
+		pbs_disconnect(sd);
+		return 1;
+	}
+	pbs_disconnect(sd);
+
+	if ((fp = fopen(file, "w")) == NULL) {
+		perror(file);
+		return 1;
+	}
+	fprintf(fp, "%s\ntime %ld\n", SNAPSHOT_MAGIC, static_cast<long>(time(NULL)));
+	for (i = 0; i < RP_NUM_TYPES; i++) {
+		for (struct batch_status *cur = bs[i]; cur != NULL; cur = cur->next) {
+			fprintf(fp, "%s ", replay_obj_names[i]);
+			replay_write_escaped(fp, cur->name);
+			fputc('\n', fp);
+			for (struct attrl *attr = cur->attribs; attr != NULL; attr = attr->next) {
+				fputc('\t', fp);
+				replay_write_escaped(fp, attr->name);
+				fputc('\t', fp);
+				replay_write_escaped(fp, attr->resource);
+				fputc('\t', fp);
+				replay_write_escaped(fp, attr->value);
+				fputc('\n', fp);
+			}
+		}
+		pbs_statfree(bs[i]);
+	}
+	if (fclose(fp) != 0) {
+		perror(file);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ * 		undo replay_write_escaped()
+ *
+ * @param[in]	start	-	start of the escaped string
+ * @param[in]	end	-	end of the escaped string
+ *
+ * @return	std::string
+ */
+static std::string
+replay_unescape(const char *start, const char *end)
+{
+	std::string str;
+
+	str.reserve(end - start);
+	for (const char *p = start; p < end; p++) {
+		if (*p == '\\' && p + 1 < end) {
+			p++;
+			if (*p == 't')
+				str += '\t';
+			else if (*p == 'n')
+				str += '\n';
+			else
+				str += *p;
+		} else
+			str += *p;
+	}
+	return str;
+}
+
+/**
+ * @brief
+ * 		load a snapshot written by capture_snapshot()
+ *
+ * @param[in]	file	-	snapshot file
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	1	: failure
+ */
+static int
+load_snapshot(const char *file)
+{
+	FILE *fp;
+	char *line = NULL;
+	size_t linesz = 0;
+	ssize_t len;
+	int lineno = 0;
+	replay_obj *cur = NULL;
+	int rc = 0;
+
+	if ((fp = fopen(file, "r")) == NULL) {
+		perror(file);
+		return 1;
+	}
+
+	while ((len = getline(&line, &linesz, fp)) != -1) {
+		lineno++;
+		if (len > 0 && line[len - 1] == '\n')
+			line[--len] = '\0';
+
+		if (lineno == 1) {
+			if (strcmp(line, SNAPSHOT_MAGIC) != 0) {
+				fprintf(stderr, "%s: not a scheduler snapshot\n", file);
+				rc = 1;
+				break;
+			}
+		} else if (line[0] == '\t') {
+			char *name = line + 1;
+			char *res;
+			char *val;
+
+			if (cur == NULL || (res = strchr(name, '\t')) == NULL || (val = strchr(res + 1, '\t')) == NULL) {
+				fprintf(stderr, "%s:%d: bad attribute line\n", file, lineno);
+				rc = 1;
+				break;
+			}
+			cur->attrs.push_back(replay_attr{replay_unescape(name, res),
+							 replay_unescape(res + 1, val),
+							 replay_unescape(val + 1, line + len)});
+		} else if (strncmp(line, "time ", 5) == 0) {
+			snapshot_time = strtol(line + 5, NULL, 10);
+		} else if (line[0] != '\0' && line[0] != '#') {
+			char *sp = strchr(line, ' ');
+			int i;
+
+			if (sp != NULL) {
+				*sp = '\0';
+				for (i = 0; i < RP_NUM_TYPES; i++)
+					if (strcmp(line, replay_obj_names[i]) == 0)
+						break;
+			}
+			if (sp == NULL || i == RP_NUM_TYPES) {
+				fprintf(stderr, "%s:%d: bad object line\n", file, lineno);
+				rc = 1;
+				break;
+			}
+			snapshot[i].push_back(replay_obj{replay_unescape(sp + 1, line + len), {}});
+			cur = &snapshot[i].back();
+		}
+	}
+	free(line);
+	fclose(fp);
+
+	if (rc == 0 && snapshot[RP_SERVER].empty()) {
+		fprintf(stderr, "%s: no server in snapshot\n", file);
+		rc = 1;
+	}
+	return rc;
+}
+
+/**
+ * @brief
+ * 		does an object match the select criteria of a pbs_selstat().
+ *		Only equality and inequality are checked, which is all the
+ *		scheduler asks for.
+ *
+ * @param[in]	obj	-	object to check
+ * @param[in]	crit	-	select criteria
+ *
+ * @return	bool
+ */
+static bool
+replay_match(const replay_obj &obj, struct attropl *crit)
+{
+	for (; crit != NULL; crit = crit->next) {
+		const replay_attr *found = NULL;
+		const char *name = crit->name;
+
+		if (crit->op != EQ && crit->op != NE)
+			continue;
+		/* selecting on the destination is selecting on the job's queue */
+		if (strcmp(name, ATTR_q) == 0)
+			name = ATTR_queue;
+		for (const auto &attr : obj.attrs) {
+			if (attr.name == name && (crit->resource == NULL || attr.resource == crit->resource)) {
+				found = &attr;
+				break;
+			}
+		}
+		bool eq = found != NULL && crit->value != NULL && found->value == crit->value;
+		if ((crit->op == EQ) != eq)
+			return false;
+	}
+	return true;
+}
+
+/**
+ * @brief
+ * 		build a status reply from the snapshot, the way the server would
+ *
+ * @param[in]	type	-	type of the objects to return
+ * @param[in]	id	-	name of the one object to return, NULL or "" for all
+ * @param[in]	attrib	-	attributes to return, NULL for all
+ * @param[in]	crit	-	select criteria, NULL for none
+ *
+ * @return	struct batch_status *, to be freed with pbs_statfree()
+ */
+static struct batch_status *
+replay_stat(int type, const char *id, struct attrl *attrib, struct attropl *crit)
+{
+	struct batch_status *head = NULL;
+	struct batch_status **tail = &head;
+
+	pbs_errno = PBSE_NONE;
+	for (const auto &obj : snapshot[type]) {
+		struct attrl **atail;
+		struct batch_status *bs;
+
+		if (id != NULL && id[0] != '\0' && obj.name != id)
+			continue;
+		if (!replay_match(obj, crit))
+			continue;
+
+		bs = static_cast<struct batch_status *>(calloc(1, sizeof(struct batch_status)));
+		if (bs == NULL) {
+			pbs_errno = PBSE_SYSTEM;
+			pbs_statfree(head);
+			return NULL;
+		}
+		bs->name = strdup(obj.name.c_str());
+		atail = &bs->attribs;
+		for (const auto &attr : obj.attrs) {
+			struct attrl *a;
+
+			if (attrib != NULL) {
+				struct attrl *want;
+
+				for (want = attrib; want != NULL; want = want->next)
+					if (attr.name == want->name)
+						break;
+				if (want == NULL)
+					continue;
+			}
+			if ((a = static_cast<struct attrl *>(calloc(1, sizeof(struct attrl)))) == NULL) {
+				pbs_errno = PBSE_SYSTEM;
+				pbs_statfree(bs);
+				pbs_statfree(head);
+				return NULL;
+			}
+			a->name = strdup(attr.name.c_str());
+			a->resource = attr.resource.empty() ? NULL : strdup(attr.resource.c_str());
+			a->value = strdup(attr.value.c_str());
+			a->op = SET;
+			*atail = a;
+			atail = &a->next;
+		}
+		*tail = bs;
+		tail = &bs->next;
+	}
+	return head;
+}
+
+/* the stat stubs below stand in for the IFL status calls of the same name */
+static struct batch_status *
+replay_statserver(int c, struct attrl *attrib, const char *extend)
+{
+	return replay_stat(RP_SERVER, NULL, attrib, NULL);
+}
+
+static struct batch_status *
+replay_statsched(int c, struct attrl *attrib, const char *extend)
+{
+	return replay_stat(RP_SCHED, NULL, attrib, NULL);
+}
+
+static struct batch_status *
+replay_statrsc(int c, const char *id, struct attrl *attrib, const char *extend)
+{
+	return replay_stat(RP_RESOURCE, id, attrib, NULL);
+}
+
+static struct batch_status *
+replay_statque(int c, const char *id, struct attrl *attrib, const char *extend)
+{
+	return replay_stat(RP_QUEUE, id, attrib, NULL);
+}
+
+static struct batch_status *
+replay_statvnode(int c, const char *id, struct attrl *attrib, const char *extend)
+{
+	return replay_stat(RP_NODE, id, attrib, NULL);
+}
+
+static struct batch_status *
+replay_statresv(int c, const char *id, struct attrl *attrib, const char *extend)
+{
+	return replay_stat(RP_RESV, id, attrib, NULL);
+}
+
+/* the delta option in extend is ignored: every job is returned as changed */
+static struct batch_status *
+replay_selstat(int c, struct attropl *crit, struct attrl *attrib, const char *extend)
+{
+	return replay_stat(RP_JOB, NULL, attrib, crit);
+}
+
+/**
+ * @brief
+ * 		record a run request, stands in for pbs_runjob(), pbs_asyrunjob()
+ *		and pbs_asyrunjob_ack()
+ *
+ * @return	int
+ * @retval	0	: the job always runs
+ */
+static int
+replay_runjob(int c, const char *jobid, const char *location, const char *extend)
+{
+	decisions.push_back(std::string("run ") + jobid + " " + (location ? location : ""));
+	pbs_errno = PBSE_NONE;
+	return 0;
+}
+
+/**
+ * @brief
+ * 		count an attribute update, stands in for pbs_alterjob() and
+ *		pbs_asyalterjob().  They are not decisions, and comments with times
+ *		in them differ from cycle to cycle, so they are only counted.
+ *
+ * @return	int
+ * @retval	0	: success
+ */
+static int
+replay_alterjob(int c, const char *jobid, struct attrl *attrib, const char *extend)
+{
+	num_alters++;
+	pbs_errno = PBSE_NONE;
+	return 0;
+}
+
+/**
+ * @brief
+ * 		record a preemption request, stands in for pbs_preempt_jobs().
+ *		Every job is preempted by preempt_method.
+ *
+ * @param[in]	c	-	connection handle
+ * @param[in]	preempt_jobs_list	-	NULL terminated list of jobs to preempt
+ *
+ * @return	preempt_job_info *, to be freed with free()
+ */
+static preempt_job_info *
+replay_preempt_jobs(int c, char **preempt_jobs_list)
+{
+	preempt_job_info *reply;
+	int count;
+	int i;
+
+	for (count = 0; preempt_jobs_list[count] != NULL; count++)
+		;
+	if ((reply = static_cast<preempt_job_info *>(calloc(count + 1, sizeof(preempt_job_info)))) == NULL) {
+		pbs_errno = PBSE_SYSTEM;
+		return NULL;
+	}
+	for (i = 0; i < count; i++) {
+		decisions.push_back(std::string("preempt ") + preempt_jobs_list[i] + " " + preempt_method);
+		pbs_strncpy(reply[i].job_id, preempt_jobs_list[i], sizeof(reply[i].job_id));
+		reply[i].order[0] = preempt_method;
+	}
+	pbs_errno = PBSE_NONE;
+	return reply;
+}
+
+/* the remaining requests the scheduler can make are recorded as decisions */
+static int
+replay_sigjob(int c, const char *jobid, const char *signal, const char *extend)
+{
+	decisions.push_back(std::string("signal ") + jobid + " " + signal);
+	pbs_errno = PBSE_NONE;
+	return 0;
+}
+
+static int
+replay_confirmresv(int c, const char *rid, const char *location, unsigned long start, const char *extend)
+{
+	decisions.push_back(std::string("confirm ") + rid + " " + (location ? location : "") + " " + std::to_string(start));
+	pbs_errno = PBSE_NONE;
+	return 0;
+}
+
+static int
+replay_movejob(int c, const char *jobid, const char *destin, const char *extend)
+{
+	decisions.push_back(std::string("move ") + jobid + " " + (destin ? destin : ""));
+	pbs_errno = PBSE_NONE;
+	return 0;
+}
+
+static int
+replay_manager(int c, int command, int objtype, const char *objname, struct attropl *attrib, const char *extend)
+{
+	pbs_errno = PBSE_NONE;
+	return 0;
+}
+
+/* there are no other servers to talk to */
+static int
+replay_connect(const char *server)
+{
+	pbs_errno = PBSE_NOSERVER;
+	return -1;
+}
+
+static int
+replay_disconnect(int c)
+{
+	return 0;
+}
+
+static char *
+replay_geterrmsg(int c)
+{
+	return NULL;
+}
+
+/**
+ * @brief
+ * 		point the IFL calls the scheduler makes at the replay stubs
+ *
+ * @return	void
+ */
+static void
+install_replay_stubs(void)
+{
+	pfn_pbs_statserver = replay_statserver;
+	pfn_pbs_statsched = replay_statsched;
+	pfn_pbs_statrsc = replay_statrsc;
+	pfn_pbs_statque = replay_statque;
+	pfn_pbs_statvnode = replay_statvnode;
+	pfn_pbs_statresv = replay_statresv;
+	pfn_pbs_selstat = replay_selstat;
+	pfn_pbs_runjob = replay_runjob;
+	pfn_pbs_asyrunjob = replay_runjob;
+	pfn_pbs_asyrunjob_ack = replay_runjob;
+	pfn_pbs_alterjob = replay_alterjob;
+	pfn_pbs_asyalterjob = replay_alterjob;
+	pfn_pbs_preempt_jobs = replay_preempt_jobs;
+	pfn_pbs_sigjob = replay_sigjob;
+	pfn_pbs_confirmresv = replay_confirmresv;
+	pfn_pbs_movejob = replay_movejob;
+	pfn_pbs_manager = replay_manager;
+	pfn_pbs_connect = replay_connect;
+	pfn_pbs_disconnect = replay_disconnect;
+	pfn_pbs_geterrmsg = replay_geterrmsg;
+}
+
+/**
+ * @brief
+ * 		set an attribute of an object of the snapshot, adding it if the
+ * 		object does not have it
+ *
+ * @param[in,out]	obj	-	the object
+ * @param[in]	nattr	-	attribute name, resource and value
+ *
+ * @return	void
+ */
+static void
+replay_set_obj_attr(replay_obj &obj, const replay_attr &nattr)
+{
+	for (auto &attr : obj.attrs) {
+		if (attr.name == nattr.name && attr.resource == nattr.resource) {
+			attr.value = nattr.value;
+			return;
+		}
+	}
+	obj.attrs.push_back(nattr);
+}
+
+/**
+ * @brief
+ * 		set an attribute of the default scheduler object of the snapshot
+ *
+ * @param[in]	name	-	attribute name
+ * @param[in]	value	-	attribute value
+ *
+ * @return	void
+ */
+static void
+replay_set_sched_attr(const char *name, const char *value)
+{
+	for (auto &obj : snapshot[RP_SCHED]) {
+		if (obj.name == PBS_DFLT_SCHED_NAME)
+			replay_set_obj_attr(obj, replay_attr{name, "", value});
+	}
+}
+
+/**
+ * @brief
+ * 		parse the argument of -a: cycle:attribute[.resource]=value
+ *
+ * @param[in]	arg	-	the argument
+ * @param[out]	chg	-	the parsed change
+ *
+ * @return	int
+ * @retval	0	: parsed
+ * @retval	-1	: malformed
+ */
+static int
+replay_parse_change(const char *arg, replay_change &chg)
+{
+	char *end;
+	const char *name;
+	const char *eq;
+	const char *dot;
+
+	chg.cycle = strtol(arg, &end, 10);
+	if (end == arg || *end != ':' || chg.cycle < 1)
+		return -1;
+	name = end + 1;
+	if ((eq = strchr(name, '=')) == NULL || eq == name)
+		return -1;
+	dot = static_cast<const char *>(memchr(name, '.', eq - name));
+	if (dot != NULL) {
+		chg.attr.name.assign(name, dot - name);
+		chg.attr.resource.assign(dot + 1, eq - dot - 1);
+	} else {
+		chg.attr.name.assign(name, eq - name);
+		chg.attr.resource.clear();
+	}
+	chg.attr.value = eq + 1;
+	return 0;
+}
+
+static void
+usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s -C [-s server] snapshot\n", prog);
+	fprintf(stderr, "       %s [-d sched_priv] [-L logfile] [-n num_cycles] [-t num_threads]\n"
+			"\t\t[-o decisions_file] [-p preempt_method] [-P] [-r] [-U] [-l]\n"
+			"\t\t[-a cycle:attribute[.resource]=value] snapshot\n",
+		prog);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *server = NULL;
+	const char *privdir = NULL;
+	const char *decfile = NULL;
+	char *logpath = NULL;
+	int capture = 0;
+	int num_cycles = REPLAY_DEFAULT_CYCLES;
+	int nthreads = -1;
+	int profile = 0;
+	int real_time = 0;
+	int undo_check = 0;
+	int limit_check = 0;
+	std::vector<replay_change> changes;
+	replay_change chg;
+	int num_differ = 0;
+	std::vector<std::string> first;
+	double total = 0;
+	double min_time = 0;
+	double max_time = 0;
+	FILE *decfp = NULL;
+	int pipefds[2];
+	int c;
+	int i;
+
+	while ((c = getopt(argc, argv, "Cs:d:L:n:t:o:p:PrUla:")) != -1) {
+		switch (c) {
+			case 'C':
+				capture = 1;
+				break;
+			case 's':
+				server = optarg;
+				break;
+			case 'd':
+				privdir = optarg;
+				break;
+			case 'L':
+				logpath = optarg;
+				break;
+			case 'n':
+				num_cycles = atoi(optarg);
+				break;
+			case 't':
+				nthreads = atoi(optarg);
+				break;
+			case 'o':
+				decfile = optarg;
+				break;
+			case 'p':
+				preempt_method = optarg[0];
+				break;
+			case 'P':
+				profile = 1;
+				break;
+			case 'r':
+				real_time = 1;
+				break;
+			case 'U':
+				undo_check = 1;
+				break;
+			case 'l':
+				limit_check = 1;
+				break;
+			case 'a':
+				if (replay_parse_change(optarg, chg) != 0) {
+					usage(argv[0]);
+					return 1;
+				}
+				changes.push_back(chg);
+				break;
+			default:
+				usage(argv[0]);
+				return 1;
+		}
+	}
+	if (optind != argc - 1 || num_cycles < 1 || strchr("SCQD", preempt_method) == NULL) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (pbs_loadconf(0) == 0 && capture) {
+		fprintf(stderr, "can not load the PBS configuration\n");
+		return 1;
+	}
+	if (pbs_client_thread_init_thread_context() != 0) {
+		fprintf(stderr, "unable to initialize thread context\n");
+		return 1;
+	}
+
+	if (capture)
+		return capture_snapshot(server, argv[optind]);
+
+	if (load_snapshot(argv[optind]) != 0)
+		return 1;
+	if (profile)
+		replay_set_sched_attr(ATTR_sched_profile, ATR_TRUE);
+
+	if (decfile != NULL && (decfp = fopen(decfile, "w")) == NULL) {
+		perror(decfile);
+		return 1;
+	}
+	/* like pbs_sched -L, the log file must be an absolute path */
+	if (logpath != NULL && log_open(logpath, const_cast<char *>(".")) == -1) {
+		fprintf(stderr, "%s: log file could not be opened\n", logpath);
+		return 1;
+	}
+	if (privdir != NULL && chdir(privdir) == -1) {
+		perror(privdir);
+		return 1;
+	}
+
+	/* the scheduler checks for commands from the server during the cycle */
+	if (pipe(pipefds) == -1) {
+		perror("pipe");
+		return 1;
+	}
+	clust_secondary_sock = pipefds[0];
+
+	if (!real_time && snapshot_time > 0)
+		replay_time_offset = snapshot_time - time(NULL);
+
+	set_no_attribute_verification();
+	install_replay_stubs();
+	sc_name = PBS_DFLT_SCHED_NAME;
+	dflt_sched = 1;
+
+	if (schedinit(nthreads) != 0) {
+		fprintf(stderr, "can not initialize the scheduler\n");
+		return 1;
+	}
+	/* jobs of peer queues live on other servers, which are not in the snapshot */
+	conf.peer_queues.clear();
+	sim_undo_set_check(undo_check);
+	lim_cache_set_check(limit_check);
+
+	printf("snapshot: %zu queues, %zu vnodes, %zu reservations, %zu jobs\n",
+	       snapshot[RP_QUEUE].size(), snapshot[RP_NODE].size(),
+	       snapshot[RP_RESV].size(), snapshot[RP_JOB].size());
+
+	for (i = 0; i < num_cycles; i++) {
+		sched_cmd cmd = {i == 0 ? SCH_SCHEDULE_FIRST : SCH_SCHEDULE_NEW, NULL};
+		int num_run = 0;
+		int num_preempt = 0;
+		double start;
+		double elapsed;
+
+		decisions.clear();
+		num_alters = 0;
+
+		for (const auto &change : changes) {
+			if (change.cycle == i + 1)
+				replay_set_obj_attr(snapshot[RP_SERVER].front(), change.attr);
+		}
+
+		start = bench_time();
+		schedule(REPLAY_FAKE_SD, &cmd);
+		elapsed = bench_time() - start;
+
+		for (const auto &dec : decisions) {
+			if (dec.compare(0, 4, "run ") == 0)
+				num_run++;
+			else if (dec.compare(0, 8, "preempt ") == 0)
+				num_preempt++;
+		}
+		printf("cycle %d: %.3fs, %d run, %d preempted, %zu other requests, %d attribute updates\n",
+		       i + 1, elapsed, num_run, num_preempt, decisions.size() - num_run - num_preempt, num_alters);
+
+		if (decfp != NULL) {
+			fprintf(decfp, "cycle %d\n", i + 1);
+			for (const auto &dec : decisions)
+				fprintf(decfp, "%s\n", dec.c_str());
+		}
+
+		if (i == 0)
+			first = decisions;
+		else if (decisions != first)
+			num_differ++;
+
+		total += elapsed;
+		if (i == 0 || elapsed < min_time)
+			min_time = elapsed;
+		if (i == 0 || elapsed > max_time)
+			max_time = elapsed;
+	}
+
+	printf("%d cycles: min %.3fs avg %.3fs max %.3fs\n", num_cycles, min_time, total / num_cycles, max_time);
+	if (num_cycles > 1)
+		printf("cycles deciding differently from the first: %d\n", num_differ);
+	if (undo_check) {
+		int checked;
+		int mismatches;
+
+		sim_undo_check_results(&checked, &mismatches);
+		printf("undo log checks: %d, differing from a copy: %d\n", checked, mismatches);
+	}
+	if (limit_check) {
+		int checked;
+		int mismatches;
+
+		lim_cache_check_results(&checked, &mismatches);
+		printf("limit cache checks: %d, differing from the limit: %d\n", checked, mismatches);
+	}
+
+	if (decfp != NULL)
+		fclose(decfp);
+	if (num_threads > 1)
+		kill_threads();
+	return 0;
+}
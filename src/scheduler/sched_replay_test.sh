@@ -0,0 +1,144 @@
+#!/bin/sh
+#
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+# Replay sched_replay_sample.snap against the default sched_config with
+# strict_ordering turned on, with one and with several worker threads, and
+# check that every cycle decides to run the same jobs on the same vnodes.
+# With -U, every top job start time estimate made with the undo log is also
+# made in a copy of the universe, the way it was done before the undo log,
+# and the two must agree.  The sample has top jobs which get a start time and
+# one which does not.
+#
+# Then replay it again with the overall ncpus limit changed before each cycle.
+# With -l, every limit value taken from the limit cache is also read from its
+# limit context, and the two must agree.  Each cycle must decide what its own
+# limit allows, not what the limit of an earlier cycle allowed.
+
+srcdir=${srcdir:-`dirname $0`}
+replay=./pbs_sched_replay
+snap=$srcdir/sched_replay_sample.snap
+
+tmpdir=`mktemp -d ${TMPDIR:-/tmp}/sched_replay_test.XXXXXX` || exit 1
+trap 'rm -rf $tmpdir' 0
+
+mkdir $tmpdir/sched_priv
+sed 's/^strict_ordering:.*/strict_ordering: true	ALL/' $srcdir/pbs_sched_config > $tmpdir/sched_priv/sched_config
+cp $srcdir/pbs_holidays $tmpdir/sched_priv/holidays
+cp $srcdir/pbs_dedicated $tmpdir/sched_priv/dedicated_time
+cp $srcdir/pbs_resource_group $tmpdir/sched_priv/resource_group
+
+cat > $tmpdir/expected <<EOT
+run 4.host1 (n4:ncpus=4)
+run 7.host1 (n3:ncpus=2)
+EOT
+
+status=0
+for threads in 1 4; do
+	out=$tmpdir/decisions.$threads
+	if ! $replay -U -d $tmpdir/sched_priv -L $tmpdir/log.$threads -t $threads -n 3 \
+		-o $out $snap > $tmpdir/stats.$threads 2>&1; then
+		echo "pbs_sched_replay -t $threads failed:"
+		cat $tmpdir/stats.$threads
+		status=1
+		continue
+	fi
+	if ! grep -q '^cycles deciding differently from the first: 0$' $tmpdir/stats.$threads; then
+		echo "pbs_sched_replay -t $threads: cycles did not decide the same:"
+		cat $tmpdir/stats.$threads
+		status=1
+	fi
+	if ! grep -q '^undo log checks: [1-9][0-9]*, differing from a copy: 0$' $tmpdir/stats.$threads; then
+		echo "pbs_sched_replay -t $threads: undo log and copy simulations differ:"
+		cat $tmpdir/stats.$threads
+		grep 'Undo log check' $tmpdir/log.$threads
+		status=1
+	fi
+	for cycle in 1 2 3; do
+		sed -n "/^cycle $cycle\$/,/^cycle /{/^run /p}" $out > $tmpdir/got
+		if ! cmp -s $tmpdir/expected $tmpdir/got; then
+			echo "pbs_sched_replay -t $threads: unexpected decisions in cycle $cycle:"
+			diff $tmpdir/expected $tmpdir/got
+			status=1
+		fi
+	done
+done
+
+# 10 of the 16 ncpus are in use.  14 leaves room for job 4, 12 only for job 7,
+# and 20 for both.
+limits="2:14 3:12 4:20"
+cat > $tmpdir/expected.limits <<EOT
+cycle 1
+run 4.host1 (n4:ncpus=4)
+run 7.host1 (n3:ncpus=2)
+cycle 2
+run 4.host1 (n4:ncpus=4)
+cycle 3
+run 7.host1 (n3:ncpus=2)
+cycle 4
+run 4.host1 (n4:ncpus=4)
+run 7.host1 (n3:ncpus=2)
+EOT
+
+changes=
+for l in $limits; do
+	changes="$changes -a ${l%%:*}:max_run_res.ncpus=[o:PBS_ALL=${l#*:}]"
+done
+for threads in 1 4; do
+	out=$tmpdir/decisions.limits.$threads
+	if ! $replay -l $changes -d $tmpdir/sched_priv -L $tmpdir/log.limits.$threads -t $threads -n 4 \
+		-o $out $snap > $tmpdir/stats.limits.$threads 2>&1; then
+		echo "pbs_sched_replay -l -t $threads failed:"
+		cat $tmpdir/stats.limits.$threads
+		status=1
+		continue
+	fi
+	if ! grep -q '^limit cache checks: [1-9][0-9]*, differing from the limit: 0$' $tmpdir/stats.limits.$threads; then
+		echo "pbs_sched_replay -l -t $threads: cached limits differ from the limits:"
+		cat $tmpdir/stats.limits.$threads
+		grep 'Limit cache check' $tmpdir/log.limits.$threads
+		status=1
+	fi
+	sed -n '/^cycle /p;/^run /p' $out > $tmpdir/got
+	if ! cmp -s $tmpdir/expected.limits $tmpdir/got; then
+		echo "pbs_sched_replay -l -t $threads: unexpected decisions with changing limits:"
+		diff $tmpdir/expected.limits $tmpdir/got
+		status=1
+	fi
+done
+exit $status
@@ -51,6 +51,7 @@
  * 	find_alloc_resource_by_str()
  * 	find_resource_by_str()
  * 	find_resource()
+ * 	index_resource_list()
  * 	free_server_info()
  * 	free_resource_list()
  * 	free_resource()
@@ -130,6 +131,7 @@
 #include "resource_resv.h"
 #include "state_count.h"
 #include "node_partition.h"
+#include "profile.h"
 #include "resource.h"
 #include "assert.h"
 #include "limits_if.h"
@@ -141,6 +143,8 @@
 #include "fifo.h"
 #include "buckets.h"
 #include "parse.h"
+#include "sim_undo.h"
+#include "ec_cache.h"
 #include "hook.h"
 #include "libpbs.h"
 #include "libutil.h"
@@ -174,9 +178,11 @@ extern char **environ;
 server_info *
 query_server(status *pol, int pbs_sd)
 {
+	prof_scope prof("query_server");
 	struct batch_status *server;   /* info about the server */
 	struct batch_status *bs_resvs; /* batch status of the reservations */
 	server_info *sinfo;	       /* scheduler internal form of server info */
+	unsigned long long server_fp;  /* fingerprint of the server status */
 	int num_express_queues = 0;    /* number of express queues */
 	status *policy;
 	int job_arrays_associated = FALSE;
@@ -199,6 +205,11 @@ query_server(status *pol, int pbs_sd)
 		return NULL;
 	}
 
+	/* fingerprinted before it is converted: parsing the limits overwrites
+	 * their values in place
+	 */
+	server_fp = ec_cache_hash_status(0, server);
+
 	/* convert batch_status structure into server_info structure */
 	if ((sinfo = query_server_info(pol, server)) == NULL) {
 		pbs_statfree(server);
@@ -208,6 +219,9 @@ query_server(status *pol, int pbs_sd)
 	/* We dup'd the policy structure for the cycle */
 	policy = sinfo->policy;
 
+	begin_job_status_cache(sinfo->status_seq, sinfo->server_time);
+	sinfo->universe_fp = server_fp;
+
 	if (query_server_dyn_res(sinfo) == -1) {
 		pbs_statfree(server);
 		sinfo->fstree = NULL;
@@ -230,6 +244,7 @@ query_server(status *pol, int pbs_sd)
 	 * after all other data is queried
 	 */
 	bs_resvs = stat_resvs(pbs_sd);
+	sinfo->universe_fp = ec_cache_hash_status(sinfo->universe_fp, bs_resvs);
 
 	/* get the nodes, if any - NOTE: will set sinfo -> num_nodes */
 	if ((sinfo->nodes = query_nodes(pbs_sd, sinfo)) == NULL) {
@@ -242,8 +257,7 @@ query_server(status *pol, int pbs_sd)
 
 	/* sort the nodes before we filter them down to more useful lists */
 	if (!policy->node_sort->empty())
-		qsort(sinfo->nodes, sinfo->num_nodes, sizeof(node_info *),
-		      multi_node_sort);
+		sort_node_array(sinfo->nodes, sinfo->num_nodes);
 
 	/* get the queues */
 	sinfo->queues = query_queues(policy, pbs_sd, sinfo);
@@ -586,6 +600,10 @@ query_server_info(status *pol, struct batch_status *server)
 				sinfo->has_runjob_hook = 1;
 			else
 				sinfo->has_runjob_hook = 0;
+		} else if (!strcmp(attrp->name, ATTR_status_seq)) {
+			count = strtol(attrp->value, &endp, 10);
+			if (*endp == '\0')
+				sinfo->status_seq = count;
 		}
 		attrp = attrp->next;
 	}
@@ -813,8 +831,20 @@ find_alloc_resource(schd_resource *resplist, resdef *def)
 		resp->type = def->type;
 		resp->name = def->name.c_str();
 
-		if (prev != NULL)
+		if (prev != NULL) {
+			resource_lookup *ind = resplist->index;
+
 			prev->next = resp;
+			/* keep an up to date index current */
+			if (ind != NULL && ind->tail == prev) {
+				ind->tail = resp;
+				if (def->id >= 0) {
+					if (static_cast<size_t>(def->id) >= ind->by_id.size())
+						ind->by_id.resize(def->id + 1, NULL);
+					ind->by_id[def->id] = resp;
+				}
+			}
+		}
 	}
 
 	return resp;
@@ -911,10 +941,20 @@ schd_resource *
 find_resource(schd_resource *reslist, resdef *def)
 {
 	schd_resource *resp;
+	resource_lookup *ind;
 
 	if (reslist == NULL || def == NULL)
 		return NULL;
 
+	/* An index is only good as long as nothing was appended to the list */
+	ind = reslist->index;
+	if (ind != NULL && ind->tail->next == NULL && def->id >= 0) {
+		/* the index is only as long as the highest id in the list */
+		if (static_cast<size_t>(def->id) < ind->by_id.size())
+			return ind->by_id[def->id];
+		return NULL;
+	}
+
 	resp = reslist;
 
 	while (resp != NULL && resp->def != def)
@@ -923,6 +963,50 @@ find_resource(schd_resource *reslist, resdef *def)
 	return resp;
 }
 
+/**
+ * @brief
+ * 		index a resource list by resdef id so find_resource() does not
+ *		have to walk it.  The index hangs off the head of the list.
+ *
+ * @par
+ *		Resources appended to the list afterwards make find_resource()
+ *		fall back to walking the list until it is indexed again.  The
+ *		index only reaches the highest resdef id in the list, not every
+ *		resource defined, since each node has one.
+ *
+ * @param[in,out]	reslist	-	resource list to index
+ *
+ * @return	void
+ *
+ * @par MT-Safe:	yes, for different lists: only reslist is touched, and the
+ *			dup_nodes worker threads each index their own node's list
+ */
+void
+index_resource_list(schd_resource *reslist)
+{
+	resource_lookup *ind;
+	schd_resource *resp;
+	int max_id = -1;
+
+	if (reslist == NULL)
+		return;
+
+	for (resp = reslist; resp != NULL; resp = resp->next)
+		if (resp->def != NULL && resp->def->id > max_id)
+			max_id = resp->def->id;
+
+	if (reslist->index == NULL)
+		reslist->index = new resource_lookup();
+	ind = reslist->index;
+	ind->by_id.assign(max_id + 1, NULL);
+
+	for (resp = reslist; resp != NULL; resp = resp->next) {
+		if (resp->def != NULL && resp->def->id >= 0 && ind->by_id[resp->def->id] == NULL)
+			ind->by_id[resp->def->id] = resp;
+		ind->tail = resp;
+	}
+}
+
 /**
  * @brief	free the svr_to_psets map
  * 		Note: this won't be needed once we convert node_partition to a class
@@ -1087,6 +1171,8 @@ free_resource(schd_resource *resp)
 	if (resp->str_assigned != NULL)
 		free(resp->str_assigned);
 
+	delete resp->index;
+
 	free(resp);
 }
 
@@ -1141,6 +1227,8 @@ server_info::init_server_info()
 	num_resvs = 0;
 	num_hostsets = 0;
 	server_time = 0;
+	status_seq = -1;
+	universe_fp = 0;
 	job_sort_formula = NULL;
 	init_state_count(&sc);
 	memset(preempt_count, 0, (NUM_PPRIO + 1) * sizeof(int));
@@ -1194,6 +1282,7 @@ new_resource()
 	resp->indirect_res = NULL;
 	resp->str_avail = NULL;
 	resp->str_assigned = NULL;
+	resp->index = NULL;
 	resp->assigned = RES_DEFAULT_ASSN;
 	resp->avail = RES_DEFAULT_AVAIL;
 
@@ -1585,16 +1674,16 @@ update_server_on_run(status *policy, server_info *sinfo,
 
 				resv_nodes = resresv->job->resv->resv->resv_nodes;
 				num_resv_nodes = count_array(resv_nodes);
-				qsort(resv_nodes, num_resv_nodes, sizeof(node_info *),
-				      multi_node_sort);
+				sim_undo_save_order(reinterpret_cast<void **>(resv_nodes), num_resv_nodes);
+				sort_moved_nodes(resv_nodes, num_resv_nodes, resresv->nspec_arr);
 			} else {
-				qsort(sinfo->nodes, sinfo->num_nodes, sizeof(node_info *),
-				      multi_node_sort);
+				sim_undo_save_order(reinterpret_cast<void **>(sinfo->nodes), sinfo->num_nodes);
+				sort_moved_nodes(sinfo->nodes, sinfo->num_nodes, resresv->nspec_arr);
 
 				if (sinfo->nodes != sinfo->unassoc_nodes) {
 					auto num_unassoc = count_array(sinfo->unassoc_nodes);
-					qsort(sinfo->unassoc_nodes, num_unassoc, sizeof(node_info *),
-					      multi_node_sort);
+					sim_undo_save_order(reinterpret_cast<void **>(sinfo->unassoc_nodes), num_unassoc);
+					sort_moved_nodes(sinfo->unassoc_nodes, num_unassoc, resresv->nspec_arr);
 				}
 			}
 		}
@@ -2028,6 +2117,8 @@ server_info::server_info(const server_info &osinfo)
 	name = osinfo.name;
 	liminfo = lim_dup_liminfo(osinfo.liminfo);
 	server_time = osinfo.server_time;
+	status_seq = osinfo.status_seq;
+	universe_fp = osinfo.universe_fp;
 	res = dup_resource_list(osinfo.res);
 	alljobcounts = dup_counts_umap(osinfo.alljobcounts);
 	group_counts = dup_counts_umap(osinfo.group_counts);
@@ -2164,7 +2255,7 @@ server_info::server_info(const server_info &osinfo)
 		nodes[i]->np_arr =
 			copy_node_partition_ptr_array(osinfo.nodes[i]->np_arr, nodepart);
 		if (calendar != NULL)
-			nodes[i]->node_events = dup_te_lists(osinfo.nodes[i]->node_events, calendar->next_event);
+			nodes[i]->node_events = dup_te_lists(osinfo.nodes[i]->node_events, calendar);
 	}
 	buckets = dup_node_bucket_array(osinfo.buckets, this);
 	/* Now that all job information has been created, time to associate
@@ -2221,6 +2312,9 @@ dup_resource_list(schd_resource *res)
 		prev = nres;
 	}
 
+	if (res != NULL && res->index != NULL)
+		index_resource_list(head);
+
 	return head;
 }
 /**
@@ -2325,6 +2419,9 @@ dup_ind_resource_list(schd_resource *res)
 		prev = nres;
 	}
 
+	if (res != NULL && res->index != NULL)
+		index_resource_list(head);
+
 	return head;
 }
 
@@ -2694,6 +2791,15 @@ update_universe_on_end(status *policy, resource_resv *resresv, const char *job_s
 
 	sinfo = resresv->server;
 
+	if (sim_undo_active()) {
+		sim_undo_save_resresv(resresv);
+		if (resresv->is_job)
+			sim_undo_save_queue(resresv->job->queue);
+		if (resresv->ninfo_arr != NULL)
+			for (int i = 0; resresv->ninfo_arr[i] != NULL; i++)
+				sim_undo_save_node(resresv->ninfo_arr[i]);
+	}
+
 	if (resresv->is_job) {
 		qinfo = resresv->job->queue;
 		if (resresv->job != NULL && resresv->execselect != NULL) {
@@ -2710,11 +2816,13 @@ update_universe_on_end(status *policy, resource_resv *resresv, const char *job_s
 				 * This will happen on the next call to node_partition_update()
 				 */
 				if (sinfo->allpart != NULL) {
+					sim_undo_save_nodepart(sinfo->allpart);
 					free_resource_list(sinfo->allpart->res);
 					sinfo->allpart->res = NULL;
 				}
 				for (auto queue : sinfo->queues) {
 					if (queue->allpart != NULL) {
+						sim_undo_save_nodepart(queue->allpart);
 						free_resource_list(queue->allpart->res);
 						queue->allpart->res = NULL;
 					}
@@ -2782,6 +2890,13 @@ update_universe_on_run_helper(status *policy, int pbs_sd, resource_resv *rr, uns
 	if (rr->is_job && rr->job != NULL && rr->job->parent_job != NULL)
 		array = rr->job->parent_job;
 
+	if (sim_undo_active()) {
+		sim_undo_save_resresv(rr);
+		sim_undo_save_queue(qinfo);
+		for (auto n : rr->nspec_arr)
+			sim_undo_save_node(n->ninfo);
+	}
+
 	/* any resresv marked can_not_run will be ignored by the scheduler
 	 * so just incase we run by this resresv again, we want to ignore it
 	 * since it is already running
@@ -2893,6 +3008,8 @@ update_universe_on_run_helper(status *policy, int pbs_sd, resource_resv *rr, uns
 bool
 update_universe_on_run(status *policy, int pbs_sd, resource_resv *rr, std::vector<nspec *> &orig_ns, unsigned int flags)
 {
+	sim_undo_save_resresv(rr);
+
 	if (!rr->nspec_arr.empty())
 		free_nspecs(rr->nspec_arr);
 
@@ -3125,6 +3242,8 @@ resolve_indirect_resources(node_info **nodes)
 			}
 			cur_res = cur_res->next;
 		}
+		/* node resources are looked up in the innermost node search loops */
+		index_resource_list(nodes[i]->res);
 	}
 
 	if (error)
@@ -0,0 +1,1250 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    sim_undo.cpp
+ *
+ * @brief
+ * 		sim_undo.cpp - undo log for simulating in the real universe
+ *
+ *	Finding the start time of a top job used to mean simulating the future
+ *	in a full copy of the server_info.  When the simulation only runs and
+ *	ends jobs, every change it makes goes through a small number of
+ *	functions.  Those functions record the state of each object the first
+ *	time they touch it, and sim_undo_rollback() puts it all back.  The
+ *	cost of a simulation is then proportional to what it touches rather than
+ *	to the size of the universe.
+ *
+ * Functions included are:
+ * 	sim_undo_possible()
+ * 	sim_undo_begin()
+ * 	sim_undo_rollback()
+ * 	sim_undo_active()
+ * 	sim_undo_save_resresv()
+ * 	sim_undo_save_node()
+ * 	sim_undo_save_queue()
+ * 	sim_undo_save_nodepart()
+ * 	sim_undo_save_nodepart_array()
+ * 	sim_undo_save_bucket()
+ * 	sim_undo_save_order()
+ * 	sim_undo_save_event()
+ * 	sim_undo_add_event()
+ * 	sim_undo_set_check()
+ * 	sim_undo_check()
+ * 	sim_undo_check_results()
+ *
+ */
+
+#include <pbs_config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <log.h>
+
+#include "data_types.h"
+#include "constant.h"
+#include "sim_undo.h"
+#include "server_info.h"
+#include "node_info.h"
+#include "node_partition.h"
+#include "resource_resv.h"
+#include "simulate.h"
+#include "misc.h"
+#include "pbs_bitmap.h"
+#include "globals.h"
+
+/* saved state of a job or reservation */
+struct undo_resresv {
+	resource_resv *rr;
+	bool can_not_run;
+	bool can_not_fit;
+	time_t start;
+	time_t end;
+	std::vector<nspec *> nspec_arr;
+	node_info **ninfo_arr;
+	selspec *execselect;
+	char *nodepart_name;
+	timed_event *run_event;
+	timed_event *end_event;
+	/* job specific */
+	bool is_queued, is_running, is_held, is_waiting, is_transit, is_exiting;
+	bool is_suspended, is_susp_sched, is_userbusy, is_begin, is_expired;
+	bool is_provisioning;
+	time_t stime;
+	time_t est_start_time;
+	int accrue_type;
+	unsigned int preempt_status;
+	unsigned int preempt;
+	long parent_running_subjobs;
+};
+
+/* saved state of a node */
+struct undo_node {
+	node_info *ninfo;
+	bool is_down, is_free, is_offline, is_unknown, is_exclusive;
+	bool is_job_exclusive, is_resv_exclusive, is_sharing, is_busy;
+	bool is_job_busy, is_stale, is_maintenance, is_provisioning, is_sleeping;
+	int num_jobs;
+	int num_run_resv;
+	int num_susp_jobs;
+	resource_resv **job_arr;
+	resource_resv **run_resvs_arr;
+	char *current_aoe;
+	char *current_eoe;
+	bool has_counts;
+	counts_umap group_counts;
+	counts_umap user_counts;
+	std::vector<timed_event *> node_events;
+};
+
+/* saved state of a queue */
+struct undo_queue {
+	queue_info *qinfo;
+	bool is_started;
+	bool is_ok_to_run;
+	state_count sc;
+	resource_resv **running_jobs;
+	counts_umap counts[8];
+};
+
+/* saved metadata of a node partition */
+struct undo_nodepart {
+	node_partition *np;
+	int free_nodes;
+	schd_resource *res;
+};
+
+/* saved pools of a node bucket */
+struct undo_bucket {
+	node_bucket *bkt;
+	pbs_bitmap *truth[3];
+	int truth_ct[3];
+};
+
+/* saved order of an array of pointers */
+struct undo_order {
+	void **arr;
+	std::vector<void *> elems;
+};
+
+/* the undo log itself */
+static struct {
+	bool active;
+	server_info *sinfo;
+	std::unordered_set<const void *> saved;
+
+	/* server state, saved in sim_undo_begin() */
+	status policy;
+	state_count sc;
+	time_t server_time;
+	bool pset_metadata_stale;
+	int num_preempted;
+	int preempt_count[NUM_PPRIO + 1];
+	resource_resv **running_jobs;
+	resource_resv **exiting_jobs;
+	counts_umap counts[8];
+
+	/* calendar state, saved in sim_undo_begin() */
+	timed_event *next_event;
+	timed_event *first_run_event;
+	int eol;
+
+	std::vector<undo_resresv> resresvs;
+	std::vector<undo_node> nodes;
+	std::vector<undo_queue> queues;
+	std::vector<undo_nodepart> nodeparts;
+	std::vector<undo_bucket> buckets;
+	std::vector<undo_order> orders;
+	std::vector<std::pair<timed_event *, int>> disabled;
+	std::vector<timed_event *> added_events;
+	std::vector<std::pair<schd_resource *, sch_resource_t>> assigned;
+} ulog;
+
+/* check mode, see sim_undo_check() */
+static bool undo_check;
+static int undo_checked;
+static int undo_mismatches;
+
+/**
+ * @brief	mark an object as saved
+ *
+ * @param[in]	obj	-	the object
+ *
+ * @return	bool
+ * @retval	true	: the object needs to be saved
+ * @retval	false	: nothing is being recorded or the object is already saved
+ */
+static bool
+undo_first_touch(const void *obj)
+{
+	if (!ulog.active || obj == NULL)
+		return false;
+
+	return ulog.saved.insert(obj).second;
+}
+
+/**
+ * @brief	save the assigned amounts of a resource list
+ *
+ * @param[in]	res	-	the resource list
+ *
+ * @return	void
+ */
+static void
+undo_save_assigned(schd_resource *res)
+{
+	for (; res != NULL; res = res->next) {
+		ulog.assigned.emplace_back(res, res->assigned);
+		if (res->indirect_res != NULL)
+			ulog.assigned.emplace_back(res->indirect_res, res->indirect_res->assigned);
+	}
+}
+
+/**
+ * @brief	copy a NULL terminated array of resource_resv pointers
+ *
+ * @param[in]	arr	-	the array
+ *
+ * @return	the copy (NULL if arr is NULL)
+ */
+static resource_resv **
+undo_copy_resresv_array(resource_resv **arr)
+{
+	resource_resv **narr;
+	int len;
+
+	if (arr == NULL)
+		return NULL;
+
+	len = count_array(arr);
+	narr = static_cast<resource_resv **>(malloc((len + 1) * sizeof(resource_resv *)));
+	if (narr == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return NULL;
+	}
+	memcpy(narr, arr, (len + 1) * sizeof(resource_resv *));
+
+	return narr;
+}
+
+/**
+ * @brief	save the 8 counts maps of a server or queue
+ *
+ * @param[out]	dst	-	where to save the maps
+ * @param[in]	grp, proj, user, all, tgrp, tproj, tuser, tall - the maps
+ *
+ * @return	void
+ */
+static void
+undo_save_counts(counts_umap *dst, counts_umap &grp, counts_umap &proj, counts_umap &user,
+		 counts_umap &all, counts_umap &tgrp, counts_umap &tproj, counts_umap &tuser, counts_umap &tall)
+{
+	dst[0] = dup_counts_umap(grp);
+	dst[1] = dup_counts_umap(proj);
+	dst[2] = dup_counts_umap(user);
+	dst[3] = dup_counts_umap(all);
+	dst[4] = dup_counts_umap(tgrp);
+	dst[5] = dup_counts_umap(tproj);
+	dst[6] = dup_counts_umap(tuser);
+	dst[7] = dup_counts_umap(tall);
+}
+
+/**
+ * @brief	put back one counts map saved by undo_save_counts()
+ *
+ * @param[out]	cur	-	the live map
+ * @param[in]	saved	-	the saved map
+ *
+ * @return	void
+ */
+static void
+undo_restore_counts(counts_umap &cur, counts_umap &saved)
+{
+	free_counts_list(cur);
+	cur = std::move(saved);
+	saved.clear();
+}
+
+/**
+ * @brief
+ * 		can the start time of resresv be found by simulating in sinfo itself
+ *		(with an undo log) rather than in a copy of sinfo
+ *
+ * @par
+ *		The undo log covers running and ending plain jobs on nodes, queues
+ *		and the server, and prime/dedicated time policy changes.  Anything
+ *		else the simulation may need to do (fairshare usage, soft limits
+ *		and preemption priorities, job arrays, runone dependencies,
+ *		provisioning, reservations) falls back to a copy.
+ *
+ * @param[in]	sinfo	-	the universe
+ * @param[in]	resresv	-	the job to find a start time for
+ *
+ * @return	bool
+ */
+bool
+sim_undo_possible(server_info *sinfo, resource_resv *resresv)
+{
+	timed_event *te;
+
+	if (sinfo == NULL || resresv == NULL || sinfo->calendar == NULL || ulog.active)
+		return false;
+
+	if (!resresv->is_job || resresv->job == NULL)
+		return false;
+
+	if (resresv->job->is_array || resresv->job->is_subjob || resresv->job->is_suspended ||
+	    resresv->job->is_preempted || resresv->job->dependent_jobs != NULL ||
+	    !resresv->nspec_arr.empty())
+		return false;
+
+	if (sinfo->policy->fair_share || conf.prime_fs || conf.non_prime_fs)
+		return false;
+
+	if (sinfo->provision_enable || sinfo->power_provisioning || sinfo->has_soft_limit)
+		return false;
+
+	for (auto qinfo : sinfo->queues)
+		if (qinfo->has_soft_limit)
+			return false;
+
+	for (te = sinfo->calendar->next_event; te != NULL; te = te->next) {
+		resource_resv *rr;
+
+		switch (te->event_type) {
+			case TIMED_POLICY_EVENT:
+			case TIMED_DED_START_EVENT:
+			case TIMED_DED_END_EVENT:
+				break;
+			case TIMED_END_EVENT:
+				rr = static_cast<resource_resv *>(te->event_ptr);
+				if (!rr->is_job || rr->job == NULL || rr->job->is_array)
+					return false;
+				break;
+			case TIMED_RUN_EVENT:
+				rr = static_cast<resource_resv *>(te->event_ptr);
+				if (!rr->is_job || rr->job == NULL || rr->job->is_array ||
+				    rr->job->is_subjob || rr->job->is_suspended ||
+				    rr->job->is_preempted || rr->job->dependent_jobs != NULL ||
+				    rr->nspec_arr.empty())
+					return false;
+				break;
+			default:
+				return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief
+ * 		start recording the changes made to sinfo.  The server, policy and
+ *		calendar are saved right away, everything else the first time it
+ *		is touched.
+ *
+ * @param[in]	sinfo	-	the universe about to be simulated in
+ *
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: failure (already recording or out of memory)
+ */
+int
+sim_undo_begin(server_info *sinfo)
+{
+	if (sinfo == NULL || sinfo->calendar == NULL || ulog.active)
+		return 0;
+
+	ulog.active = true;
+	ulog.sinfo = sinfo;
+
+	ulog.policy = *sinfo->policy;
+	ulog.sc = sinfo->sc;
+	ulog.server_time = sinfo->server_time;
+	ulog.pset_metadata_stale = sinfo->pset_metadata_stale;
+	ulog.num_preempted = sinfo->num_preempted;
+	memcpy(ulog.preempt_count, sinfo->preempt_count, sizeof(ulog.preempt_count));
+	ulog.running_jobs = undo_copy_resresv_array(sinfo->running_jobs);
+	ulog.exiting_jobs = undo_copy_resresv_array(sinfo->exiting_jobs);
+	if ((sinfo->running_jobs != NULL && ulog.running_jobs == NULL) ||
+	    (sinfo->exiting_jobs != NULL && ulog.exiting_jobs == NULL)) {
+		free(ulog.running_jobs);
+		free(ulog.exiting_jobs);
+		ulog.running_jobs = NULL;
+		ulog.exiting_jobs = NULL;
+		ulog.active = false;
+		ulog.sinfo = NULL;
+		return 0;
+	}
+	undo_save_counts(ulog.counts, sinfo->group_counts, sinfo->project_counts,
+			 sinfo->user_counts, sinfo->alljobcounts, sinfo->total_group_counts,
+			 sinfo->total_project_counts, sinfo->total_user_counts, sinfo->total_alljobcounts);
+	undo_save_assigned(sinfo->res);
+
+	ulog.next_event = sinfo->calendar->next_event;
+	ulog.first_run_event = sinfo->calendar->first_run_event;
+	ulog.eol = sinfo->calendar->eol;
+
+	return 1;
+}
+
+/**
+ * @brief	are changes to the universe being recorded
+ *
+ * @return	bool
+ */
+bool
+sim_undo_active(void)
+{
+	return ulog.active;
+}
+
+/**
+ * @brief	save a job before it is run or ended in a simulation
+ *
+ * @param[in]	resresv	-	the job
+ *
+ * @return	void
+ */
+void
+sim_undo_save_resresv(resource_resv *resresv)
+{
+	undo_resresv u;
+
+	if (!undo_first_touch(resresv))
+		return;
+
+	u.rr = resresv;
+	u.can_not_run = resresv->can_not_run;
+	u.can_not_fit = resresv->can_not_fit;
+	u.start = resresv->start;
+	u.end = resresv->end;
+	u.nspec_arr = resresv->nspec_arr;
+	u.ninfo_arr = resresv->ninfo_arr;
+	u.execselect = resresv->execselect;
+	u.nodepart_name = string_dup(resresv->nodepart_name);
+	u.run_event = resresv->run_event;
+	u.end_event = resresv->end_event;
+	u.parent_running_subjobs = 0;
+	if (resresv->job != NULL) {
+		job_info *job = resresv->job;
+
+		u.is_queued = job->is_queued;
+		u.is_running = job->is_running;
+		u.is_held = job->is_held;
+		u.is_waiting = job->is_waiting;
+		u.is_transit = job->is_transit;
+		u.is_exiting = job->is_exiting;
+		u.is_suspended = job->is_suspended;
+		u.is_susp_sched = job->is_susp_sched;
+		u.is_userbusy = job->is_userbusy;
+		u.is_begin = job->is_begin;
+		u.is_expired = job->is_expired;
+		u.is_provisioning = job->is_provisioning;
+		u.stime = job->stime;
+		u.est_start_time = job->est_start_time;
+		u.accrue_type = job->accrue_type;
+		u.preempt_status = job->preempt_status;
+		u.preempt = job->preempt;
+		if (job->parent_job != NULL)
+			u.parent_running_subjobs = job->parent_job->job->running_subjobs;
+	}
+	ulog.resresvs.push_back(std::move(u));
+}
+
+/**
+ * @brief	save a node before a job is run on it or ends on it
+ *
+ * @param[in]	ninfo	-	the node
+ *
+ * @return	void
+ */
+void
+sim_undo_save_node(node_info *ninfo)
+{
+	undo_node u;
+	te_list *tel;
+
+	if (!undo_first_touch(ninfo))
+		return;
+
+	u.ninfo = ninfo;
+	u.is_down = ninfo->is_down;
+	u.is_free = ninfo->is_free;
+	u.is_offline = ninfo->is_offline;
+	u.is_unknown = ninfo->is_unknown;
+	u.is_exclusive = ninfo->is_exclusive;
+	u.is_job_exclusive = ninfo->is_job_exclusive;
+	u.is_resv_exclusive = ninfo->is_resv_exclusive;
+	u.is_sharing = ninfo->is_sharing;
+	u.is_busy = ninfo->is_busy;
+	u.is_job_busy = ninfo->is_job_busy;
+	u.is_stale = ninfo->is_stale;
+	u.is_maintenance = ninfo->is_maintenance;
+	u.is_provisioning = ninfo->is_provisioning;
+	u.is_sleeping = ninfo->is_sleeping;
+	u.num_jobs = ninfo->num_jobs;
+	u.num_run_resv = ninfo->num_run_resv;
+	u.num_susp_jobs = ninfo->num_susp_jobs;
+	u.job_arr = undo_copy_resresv_array(ninfo->job_arr);
+	u.run_resvs_arr = undo_copy_resresv_array(ninfo->run_resvs_arr);
+	u.current_aoe = string_dup(ninfo->current_aoe);
+	u.current_eoe = string_dup(ninfo->current_eoe);
+	u.has_counts = ninfo->has_hard_limit;
+	if (u.has_counts) {
+		u.group_counts = dup_counts_umap(ninfo->group_counts);
+		u.user_counts = dup_counts_umap(ninfo->user_counts);
+	}
+	for (tel = ninfo->node_events; tel != NULL; tel = tel->next)
+		u.node_events.push_back(tel->event);
+	undo_save_assigned(ninfo->res);
+	ulog.nodes.push_back(std::move(u));
+
+	if (ninfo->svr_node != NULL)
+		sim_undo_save_node(ninfo->svr_node);
+
+	if (ninfo->node_ind != -1 && ninfo->bucket_ind != -1 && ninfo->server->buckets != NULL)
+		sim_undo_save_bucket(ninfo->server->buckets[ninfo->bucket_ind]);
+
+	if (ninfo->np_arr != NULL)
+		for (int i = 0; ninfo->np_arr[i] != NULL; i++)
+			sim_undo_save_nodepart(ninfo->np_arr[i]);
+}
+
+/**
+ * @brief	save a queue before a job in it is run or ended
+ *
+ * @param[in]	qinfo	-	the queue
+ *
+ * @return	void
+ */
+void
+sim_undo_save_queue(queue_info *qinfo)
+{
+	undo_queue u;
+
+	if (!undo_first_touch(qinfo))
+		return;
+
+	u.qinfo = qinfo;
+	u.is_started = qinfo->is_started;
+	u.is_ok_to_run = qinfo->is_ok_to_run;
+	u.sc = qinfo->sc;
+	u.running_jobs = undo_copy_resresv_array(qinfo->running_jobs);
+	undo_save_counts(u.counts, qinfo->group_counts, qinfo->project_counts,
+			 qinfo->user_counts, qinfo->alljobcounts, qinfo->total_group_counts,
+			 qinfo->total_project_counts, qinfo->total_user_counts, qinfo->total_alljobcounts);
+	undo_save_assigned(qinfo->qres);
+	ulog.queues.push_back(std::move(u));
+}
+
+/**
+ * @brief	save the metadata, node order and buckets of a node partition
+ *
+ * @param[in]	np	-	the node partition
+ *
+ * @return	void
+ */
+void
+sim_undo_save_nodepart(node_partition *np)
+{
+	undo_nodepart u;
+
+	if (!undo_first_touch(np))
+		return;
+
+	u.np = np;
+	u.free_nodes = np->free_nodes;
+	u.res = dup_resource_list(np->res);
+	ulog.nodeparts.push_back(u);
+
+	if (np->ninfo_arr != NULL)
+		sim_undo_save_order(reinterpret_cast<void **>(np->ninfo_arr), np->tot_nodes);
+	if (np->bkts != NULL)
+		for (int i = 0; np->bkts[i] != NULL; i++)
+			sim_undo_save_bucket(np->bkts[i]);
+}
+
+/**
+ * @brief	save an array of node partitions and the order it is in
+ *
+ * @param[in]	nodepart	-	the NULL terminated array
+ *
+ * @return	void
+ */
+void
+sim_undo_save_nodepart_array(node_partition **nodepart)
+{
+	int i;
+
+	if (!ulog.active || nodepart == NULL)
+		return;
+
+	for (i = 0; nodepart[i] != NULL; i++)
+		sim_undo_save_nodepart(nodepart[i]);
+	sim_undo_save_order(reinterpret_cast<void **>(nodepart), i);
+}
+
+/**
+ * @brief	save the free, busy and busy later pools of a node bucket
+ *
+ * @param[in]	bkt	-	the bucket
+ *
+ * @return	void
+ */
+void
+sim_undo_save_bucket(node_bucket *bkt)
+{
+	undo_bucket u;
+	bucket_bitpool *pools[3];
+
+	if (!undo_first_touch(bkt))
+		return;
+
+	pools[0] = bkt->free_pool;
+	pools[1] = bkt->busy_later_pool;
+	pools[2] = bkt->busy_pool;
+
+	u.bkt = bkt;
+	for (int i = 0; i < 3; i++) {
+		u.truth[i] = pbs_bitmap_alloc(NULL, pools[i]->truth->num_bits > 0 ? pools[i]->truth->num_bits : 1);
+		if (u.truth[i] != NULL)
+			pbs_bitmap_assign(u.truth[i], pools[i]->truth);
+		u.truth_ct[i] = pools[i]->truth_ct;
+	}
+	ulog.buckets.push_back(u);
+}
+
+/**
+ * @brief	save the order of an array which is about to be sorted
+ *
+ * @param[in]	arr	-	the array
+ * @param[in]	len	-	the number of elements to save
+ *
+ * @return	void
+ */
+void
+sim_undo_save_order(void **arr, int len)
+{
+	undo_order u;
+
+	if (!undo_first_touch(arr))
+		return;
+
+	u.arr = arr;
+	u.elems.assign(arr, arr + len);
+	ulog.orders.push_back(std::move(u));
+}
+
+/**
+ * @brief	save the disabled bit of a timed event
+ *
+ * @param[in]	te	-	the event
+ *
+ * @return	void
+ */
+void
+sim_undo_save_event(timed_event *te)
+{
+	if (!undo_first_touch(te))
+		return;
+
+	ulog.disabled.emplace_back(te, te->disabled ? 1 : 0);
+}
+
+/**
+ * @brief	note an event added to the calendar being simulated in
+ *
+ * @param[in]	calendar	-	the calendar the event was added to
+ * @param[in]	te	-	the event
+ *
+ * @return	void
+ */
+void
+sim_undo_add_event(event_list *calendar, timed_event *te)
+{
+	if (!ulog.active || calendar != ulog.sinfo->calendar)
+		return;
+
+	ulog.added_events.push_back(te);
+	ulog.saved.insert(te);
+}
+
+/**
+ * @brief
+ * 		undo every change recorded since sim_undo_begin() and stop recording
+ *
+ * @return	void
+ */
+void
+sim_undo_rollback(void)
+{
+	server_info *sinfo = ulog.sinfo;
+
+	if (!ulog.active)
+		return;
+
+	/* stop recording first: the functions used below must not add to the log */
+	ulog.active = false;
+
+	for (auto it = ulog.added_events.rbegin(); it != ulog.added_events.rend(); ++it)
+		delete_event(sinfo, *it);
+	for (auto &d : ulog.disabled)
+		d.first->disabled = d.second;
+
+	for (auto &u : ulog.resresvs) {
+		resource_resv *rr = u.rr;
+
+		rr->can_not_run = u.can_not_run;
+		rr->can_not_fit = u.can_not_fit;
+		rr->start = u.start;
+		rr->end = u.end;
+		if (rr->nspec_arr != u.nspec_arr) {
+			free_nspecs(rr->nspec_arr);
+			rr->nspec_arr = u.nspec_arr;
+		}
+		if (rr->ninfo_arr != u.ninfo_arr) {
+			free(rr->ninfo_arr);
+			rr->ninfo_arr = u.ninfo_arr;
+		}
+		if (rr->execselect != u.execselect) {
+			delete rr->execselect;
+			rr->execselect = u.execselect;
+		}
+		free(rr->nodepart_name);
+		rr->nodepart_name = u.nodepart_name;
+		rr->run_event = u.run_event;
+		rr->end_event = u.end_event;
+		if (rr->job != NULL) {
+			job_info *job = rr->job;
+
+			job->is_queued = u.is_queued;
+			job->is_running = u.is_running;
+			job->is_held = u.is_held;
+			job->is_waiting = u.is_waiting;
+			job->is_transit = u.is_transit;
+			job->is_exiting = u.is_exiting;
+			job->is_suspended = u.is_suspended;
+			job->is_susp_sched = u.is_susp_sched;
+			job->is_userbusy = u.is_userbusy;
+			job->is_begin = u.is_begin;
+			job->is_expired = u.is_expired;
+			job->is_provisioning = u.is_provisioning;
+			job->stime = u.stime;
+			job->est_start_time = u.est_start_time;
+			job->accrue_type = u.accrue_type;
+			job->preempt_status = u.preempt_status;
+			job->preempt = u.preempt;
+			if (job->parent_job != NULL)
+				job->parent_job->job->running_subjobs = u.parent_running_subjobs;
+		}
+	}
+
+	for (auto &u : ulog.nodes) {
+		node_info *ninfo = u.ninfo;
+		te_list **tail;
+
+		ninfo->is_down = u.is_down;
+		ninfo->is_free = u.is_free;
+		ninfo->is_offline = u.is_offline;
+		ninfo->is_unknown = u.is_unknown;
+		ninfo->is_exclusive = u.is_exclusive;
+		ninfo->is_job_exclusive = u.is_job_exclusive;
+		ninfo->is_resv_exclusive = u.is_resv_exclusive;
+		ninfo->is_sharing = u.is_sharing;
+		ninfo->is_busy = u.is_busy;
+		ninfo->is_job_busy = u.is_job_busy;
+		ninfo->is_stale = u.is_stale;
+		ninfo->is_maintenance = u.is_maintenance;
+		ninfo->is_provisioning = u.is_provisioning;
+		ninfo->is_sleeping = u.is_sleeping;
+		ninfo->num_jobs = u.num_jobs;
+		ninfo->num_run_resv = u.num_run_resv;
+		ninfo->num_susp_jobs = u.num_susp_jobs;
+		free(ninfo->job_arr);
+		ninfo->job_arr = u.job_arr;
+		free(ninfo->run_resvs_arr);
+		ninfo->run_resvs_arr = u.run_resvs_arr;
+		free(ninfo->current_aoe);
+		ninfo->current_aoe = u.current_aoe;
+		free(ninfo->current_eoe);
+		ninfo->current_eoe = u.current_eoe;
+		if (u.has_counts) {
+			undo_restore_counts(ninfo->group_counts, u.group_counts);
+			undo_restore_counts(ninfo->user_counts, u.user_counts);
+		}
+		free_te_list(ninfo->node_events);
+		ninfo->node_events = NULL;
+		tail = &ninfo->node_events;
+		for (auto te : u.node_events) {
+			te_list *tel = new_te_list();
+			if (tel == NULL)
+				break;
+			tel->event = te;
+			*tail = tel;
+			tail = &tel->next;
+		}
+	}
+
+	for (auto &u : ulog.queues) {
+		queue_info *qinfo = u.qinfo;
+
+		qinfo->is_started = u.is_started;
+		qinfo->is_ok_to_run = u.is_ok_to_run;
+		qinfo->sc = u.sc;
+		free(qinfo->running_jobs);
+		qinfo->running_jobs = u.running_jobs;
+		undo_restore_counts(qinfo->group_counts, u.counts[0]);
+		undo_restore_counts(qinfo->project_counts, u.counts[1]);
+		undo_restore_counts(qinfo->user_counts, u.counts[2]);
+		undo_restore_counts(qinfo->alljobcounts, u.counts[3]);
+		undo_restore_counts(qinfo->total_group_counts, u.counts[4]);
+		undo_restore_counts(qinfo->total_project_counts, u.counts[5]);
+		undo_restore_counts(qinfo->total_user_counts, u.counts[6]);
+		undo_restore_counts(qinfo->total_alljobcounts, u.counts[7]);
+	}
+
+	for (auto &u : ulog.nodeparts) {
+		free_resource_list(u.np->res);
+		u.np->res = u.res;
+		u.np->free_nodes = u.free_nodes;
+	}
+
+	for (auto &u : ulog.buckets) {
+		bucket_bitpool *pools[3] = {u.bkt->free_pool, u.bkt->busy_later_pool, u.bkt->busy_pool};
+
+		for (int i = 0; i < 3; i++) {
+			if (u.truth[i] != NULL) {
+				pbs_bitmap_assign(pools[i]->truth, u.truth[i]);
+				pbs_bitmap_free(u.truth[i]);
+			}
+			pools[i]->truth_ct = u.truth_ct[i];
+		}
+	}
+
+	for (auto &u : ulog.orders)
+		memcpy(u.arr, u.elems.data(), u.elems.size() * sizeof(void *));
+
+	/* resources may have been saved more than once, the first save is the original */
+	for (auto it = ulog.assigned.rbegin(); it != ulog.assigned.rend(); ++it)
+		it->first->assigned = it->second;
+
+	*sinfo->policy = ulog.policy;
+	sinfo->sc = ulog.sc;
+	sinfo->server_time = ulog.server_time;
+	sinfo->pset_metadata_stale = ulog.pset_metadata_stale;
+	sinfo->num_preempted = ulog.num_preempted;
+	memcpy(sinfo->preempt_count, ulog.preempt_count, sizeof(ulog.preempt_count));
+	free(sinfo->running_jobs);
+	sinfo->running_jobs = ulog.running_jobs;
+	free(sinfo->exiting_jobs);
+	sinfo->exiting_jobs = ulog.exiting_jobs;
+	undo_restore_counts(sinfo->group_counts, ulog.counts[0]);
+	undo_restore_counts(sinfo->project_counts, ulog.counts[1]);
+	undo_restore_counts(sinfo->user_counts, ulog.counts[2]);
+	undo_restore_counts(sinfo->alljobcounts, ulog.counts[3]);
+	undo_restore_counts(sinfo->total_group_counts, ulog.counts[4]);
+	undo_restore_counts(sinfo->total_project_counts, ulog.counts[5]);
+	undo_restore_counts(sinfo->total_user_counts, ulog.counts[6]);
+	undo_restore_counts(sinfo->total_alljobcounts, ulog.counts[7]);
+
+	sinfo->calendar->next_event = ulog.next_event;
+	sinfo->calendar->first_run_event = ulog.first_run_event;
+	sinfo->calendar->eol = ulog.eol;
+
+	/* node partitions cached during the simulation describe the simulated nodes */
+	free_np_cache_array(sinfo->npc_arr);
+
+	ulog.sinfo = NULL;
+	ulog.saved.clear();
+	ulog.resresvs.clear();
+	ulog.nodes.clear();
+	ulog.queues.clear();
+	ulog.nodeparts.clear();
+	ulog.buckets.clear();
+	ulog.orders.clear();
+	ulog.disabled.clear();
+	ulog.added_events.clear();
+	ulog.assigned.clear();
+}
+
+/**
+ * @brief	set or clear check mode, see sim_undo_check()
+ *
+ * @param[in]	check	-	true to check simulations done with the undo log
+ *
+ * @return	void
+ */
+void
+sim_undo_set_check(bool check)
+{
+	undo_check = check;
+	undo_checked = 0;
+	undo_mismatches = 0;
+}
+
+/**
+ * @brief	the number of simulations sim_undo_check() compared and how
+ *		many of them differed
+ *
+ * @param[out]	checked	-	simulations compared
+ * @param[out]	mismatches	-	simulations which differed
+ *
+ * @return	void
+ */
+void
+sim_undo_check_results(int *checked, int *mismatches)
+{
+	*checked = undo_checked;
+	*mismatches = undo_mismatches;
+}
+
+/**
+ * @brief	describe the assigned amounts of a resource list
+ *
+ * @param[out]	s	-	description to append to
+ * @param[in]	res	-	the resource list
+ *
+ * @return	void
+ */
+static void
+undo_state_res(std::string &s, schd_resource *res)
+{
+	for (; res != NULL; res = res->next)
+		s += std::string(" ") + res->name + "=" + std::to_string(res->assigned);
+}
+
+/**
+ * @brief	describe a counts map in name order
+ *
+ * @param[out]	s	-	description to append to
+ * @param[in]	cts	-	the counts map
+ *
+ * @return	void
+ */
+static void
+undo_state_counts(std::string &s, const counts_umap &cts)
+{
+	std::map<std::string, std::string> sorted;
+
+	for (const auto &c : cts) {
+		std::string v = std::to_string(c.second->running);
+
+		for (resource_count *rc = c.second->rescts; rc != NULL; rc = rc->next)
+			v += std::string(",") + rc->name + "=" + std::to_string(rc->amount);
+		sorted[c.first] = v;
+	}
+	for (const auto &c : sorted)
+		s += " " + c.first + ":" + c.second;
+}
+
+/**
+ * @brief	describe a NULL terminated array of resource_resv by name
+ *
+ * @param[out]	s	-	description to append to
+ * @param[in]	arr	-	the array
+ * @param[in]	sorted	-	describe the names in name order
+ *
+ * @return	void
+ */
+static void
+undo_state_resresvs(std::string &s, resource_resv **arr, bool sorted)
+{
+	std::vector<std::string> names;
+
+	for (int i = 0; arr != NULL && arr[i] != NULL; i++)
+		names.push_back(arr[i]->name);
+	if (sorted)
+		std::sort(names.begin(), names.end());
+	for (const auto &name : names)
+		s += " " + name;
+}
+
+/**
+ * @brief	describe a node partition
+ *
+ * @param[out]	s	-	description to append to
+ * @param[in]	np	-	the node partition
+ *
+ * @return	void
+ */
+static void
+undo_state_nodepart(std::string &s, node_partition *np)
+{
+	if (np == NULL)
+		return;
+	s += std::string("nodepart ") + np->name;
+	/* without res the metadata is recreated before it is used again */
+	if (np->res != NULL) {
+		s += " free=" + std::to_string(np->free_nodes);
+		undo_state_res(s, np->res);
+	}
+	s += "\n";
+}
+
+/**
+ * @brief	describe the part of a universe a simulation changes, one
+ *		object per line, without pointers so a universe and its copy
+ *		describe the same.  The copy constructor rebuilds the running
+ *		and exiting job arrays in job order, so they are described in name
+ *		order.  The node partition metadata is not described while it is
+ *		stale: it is updated before it is used again.
+ *
+ * @param[in]	sinfo	-	the universe
+ *
+ * @return	the description
+ */
+static std::string
+undo_state(server_info *sinfo)
+{
+	std::string s;
+	const state_count &sc = sinfo->sc;
+	int i;
+
+	s += "server time=" + std::to_string(sinfo->server_time) +
+	     " prime=" + std::to_string(sinfo->policy->is_prime) +
+	     " ded=" + std::to_string(sinfo->policy->is_ded_time) +
+	     " sc=" + std::to_string(sc.running) + "/" + std::to_string(sc.queued) + "/" +
+	     std::to_string(sc.exiting) + "/" + std::to_string(sc.expired) + "/" + std::to_string(sc.total) +
+	     " preempted=" + std::to_string(sinfo->num_preempted) +
+	     " pset_stale=" + std::to_string(sinfo->pset_metadata_stale);
+	undo_state_res(s, sinfo->res);
+	s += "\nrunning";
+	undo_state_resresvs(s, sinfo->running_jobs, true);
+	s += "\nexiting";
+	undo_state_resresvs(s, sinfo->exiting_jobs, true);
+	s += "\ncounts";
+	undo_state_counts(s, sinfo->user_counts);
+	undo_state_counts(s, sinfo->group_counts);
+	undo_state_counts(s, sinfo->project_counts);
+	undo_state_counts(s, sinfo->alljobcounts);
+	s += "\n";
+
+	for (auto qinfo : sinfo->queues) {
+		s += "queue " + qinfo->name + " sc=" + std::to_string(qinfo->sc.running) + "/" +
+		     std::to_string(qinfo->sc.queued) + "/" + std::to_string(qinfo->sc.expired);
+		undo_state_res(s, qinfo->qres);
+		undo_state_resresvs(s, qinfo->running_jobs, true);
+		undo_state_counts(s, qinfo->user_counts);
+		undo_state_counts(s, qinfo->alljobcounts);
+		s += "\n";
+		if (!sinfo->pset_metadata_stale) {
+			for (i = 0; i < qinfo->num_parts; i++)
+				undo_state_nodepart(s, qinfo->nodepart[i]);
+			undo_state_nodepart(s, qinfo->allpart);
+		}
+	}
+
+	for (i = 0; sinfo->nodes != NULL && sinfo->nodes[i] != NULL; i++) {
+		node_info *n = sinfo->nodes[i];
+
+		s += "node " + n->name + " state=" +
+		     std::to_string(n->is_down) + std::to_string(n->is_free) +
+		     std::to_string(n->is_offline) + std::to_string(n->is_job_exclusive) +
+		     std::to_string(n->is_resv_exclusive) + std::to_string(n->is_busy) +
+		     std::to_string(n->is_job_busy) + std::to_string(n->is_provisioning) +
+		     " jobs=" + std::to_string(n->num_jobs) + " resvs=" + std::to_string(n->num_run_resv);
+		undo_state_resresvs(s, n->job_arr, false);
+		undo_state_res(s, n->res);
+		s += " events";
+		for (te_list *tel = n->node_events; tel != NULL; tel = tel->next)
+			s += " " + tel->event->name;
+		s += "\n";
+	}
+
+	if (!sinfo->pset_metadata_stale) {
+		for (i = 0; i < sinfo->num_parts; i++)
+			undo_state_nodepart(s, sinfo->nodepart[i]);
+		undo_state_nodepart(s, sinfo->allpart);
+	}
+
+	for (i = 0; sinfo->buckets != NULL && sinfo->buckets[i] != NULL; i++) {
+		node_bucket *bkt = sinfo->buckets[i];
+
+		s += std::string("bucket ") + bkt->name + " " + std::to_string(bkt->free_pool->truth_ct) + "/" +
+		     std::to_string(bkt->busy_later_pool->truth_ct) + "/" + std::to_string(bkt->busy_pool->truth_ct) + "\n";
+	}
+
+	for (i = 0; sinfo->jobs != NULL && sinfo->jobs[i] != NULL; i++) {
+		resource_resv *rr = sinfo->jobs[i];
+		job_info *job = rr->job;
+
+		s += "job " + rr->name + " state=" +
+		     std::to_string(job->is_queued) + std::to_string(job->is_running) +
+		     std::to_string(job->is_exiting) + std::to_string(job->is_expired) +
+		     " can_not_run=" + std::to_string(rr->can_not_run) +
+		     " start=" + std::to_string(rr->start) + " end=" + std::to_string(rr->end) +
+		     " stime=" + std::to_string(job->stime) + " est=" + std::to_string(job->est_start_time);
+		if (!rr->nspec_arr.empty()) {
+			char *exec = create_execvnode(rr->nspec_arr);
+
+			s += std::string(" exec=") + (exec != NULL ? exec : "");
+		}
+		s += "\n";
+	}
+
+	s += "calendar eol=" + std::to_string(sinfo->calendar->eol);
+	if (sinfo->calendar->next_event != NULL)
+		s += " next=" + sinfo->calendar->next_event->name + "@" +
+		     std::to_string(sinfo->calendar->next_event->event_time);
+	s += "\n";
+	for (timed_event *te = sinfo->calendar->events; te != NULL; te = te->next)
+		s += "event " + te->name + " type=" + std::to_string(te->event_type) +
+		     " time=" + std::to_string(te->event_time) + " disabled=" + std::to_string(te->disabled) + "\n";
+
+	return s;
+}
+
+/**
+ * @brief	the first line where two descriptions made by undo_state() differ
+ *
+ * @param[in]	a	-	first description
+ * @param[in]	b	-	second description
+ *
+ * @return	the two lines, separated by " / "
+ */
+static std::string
+undo_state_diff(const std::string &a, const std::string &b)
+{
+	size_t i = 0;
+	size_t ea;
+	size_t eb;
+
+	/* find the start of the first line that differs */
+	while (i < a.size() && i < b.size()) {
+		ea = a.find('\n', i);
+		eb = b.find('\n', i);
+		if (ea != eb || a.compare(i, ea - i, b, i, eb - i) != 0)
+			break;
+		i = ea + 1;
+	}
+	ea = a.find('\n', i);
+	eb = b.find('\n', i);
+	return a.substr(i, ea == std::string::npos ? std::string::npos : ea - i) + " / " +
+	       b.substr(i, eb == std::string::npos ? std::string::npos : eb - i);
+}
+
+/**
+ * @brief
+ * 		in check mode, find the start time of resresv twice: once in sinfo
+ *		with the undo log and once in a copy of sinfo, the way it was
+ *		done before the undo log.  Log a mismatch if the two simulations
+ *		find a different start time or execvnode, leave the universes in
+ *		a different state, or if the rollback does not put sinfo back the
+ *		way it was.  Does nothing if check mode is off or the undo log
+ *		can not be used for resresv.
+ *
+ * @param[in]	sinfo	-	the universe
+ * @param[in]	resresv	-	the job to find a start time for
+ * @param[in]	flags	-	flags for calc_run_time()
+ *
+ * @return	void
+ */
+void
+sim_undo_check(server_info *sinfo, resource_resv *resresv, int flags)
+{
+	server_info *nsinfo;
+	resource_resv *njob;
+	std::string before;
+	std::string sim_undo;
+	std::string sim_copy;
+	std::string after;
+	std::string exec_undo;
+	std::string exec_copy;
+	time_t start_undo;
+	time_t start_copy;
+	const char *what = NULL;
+	std::string diff;
+
+	if (!undo_check || !sim_undo_possible(sinfo, resresv))
+		return;
+
+	try {
+		nsinfo = new server_info(*sinfo);
+	} catch (std::exception &e) {
+		return;
+	}
+	if ((njob = find_resource_resv_by_indrank(nsinfo->jobs, resresv->resresv_ind, resresv->rank)) == NULL ||
+	    !sim_undo_begin(sinfo)) {
+		delete nsinfo;
+		return;
+	}
+
+	before = undo_state(sinfo);
+	sim_undo_save_resresv(resresv);
+	start_undo = calc_run_time(resresv->name, sinfo, flags);
+	if (start_undo > 0 && !resresv->nspec_arr.empty())
+		exec_undo = create_execvnode(resresv->nspec_arr);
+	sim_undo = undo_state(sinfo);
+	sim_undo_rollback();
+	after = undo_state(sinfo);
+
+	start_copy = calc_run_time(njob->name, nsinfo, flags);
+	if (start_copy > 0 && !njob->nspec_arr.empty())
+		exec_copy = create_execvnode(njob->nspec_arr);
+	sim_copy = undo_state(nsinfo);
+	delete nsinfo;
+
+	undo_checked++;
+	if (start_undo != start_copy) {
+		what = "start time differs from the copy";
+		diff = std::to_string(start_undo) + " / " + std::to_string(start_copy);
+	} else if (exec_undo != exec_copy) {
+		what = "execvnode differs from the copy";
+		diff = exec_undo + " / " + exec_copy;
+	} else if (sim_undo != sim_copy) {
+		what = "simulated universe differs from the copy";
+		diff = undo_state_diff(sim_undo, sim_copy);
+	} else if (before != after) {
+		what = "rollback did not restore the universe";
+		diff = undo_state_diff(before, after);
+	}
+	if (what != NULL) {
+		undo_mismatches++;
+		log_eventf(PBSEVENT_DEBUG, PBS_EVENTCLASS_JOB, LOG_WARNING, resresv->name,
+			   "Undo log check: %s: %.800s", what, diff.c_str());
+	}
+}
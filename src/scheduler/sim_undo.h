@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+#ifndef _SIM_UNDO_H
+#define _SIM_UNDO_H
+
+#include "data_types.h"
+
+/*
+ *	sim_undo_possible - can a start time estimate for resresv be simulated
+ *			    in place with an undo log instead of in a copy of sinfo
+ */
+bool sim_undo_possible(server_info *sinfo, resource_resv *resresv);
+
+/*
+ *	sim_undo_begin - start recording changes made to sinfo
+ */
+int sim_undo_begin(server_info *sinfo);
+
+/*
+ *	sim_undo_rollback - undo every change recorded since sim_undo_begin()
+ */
+void sim_undo_rollback(void);
+
+/*
+ *	sim_undo_active - are changes being recorded
+ */
+bool sim_undo_active(void);
+
+/*
+ *	sim_undo_save_* - record the state of an object before it is modified
+ *			  They do nothing if no changes are being recorded.
+ */
+void sim_undo_save_resresv(resource_resv *resresv);
+void sim_undo_save_node(node_info *ninfo);
+void sim_undo_save_queue(queue_info *qinfo);
+void sim_undo_save_nodepart(node_partition *np);
+void sim_undo_save_nodepart_array(node_partition **nodepart);
+void sim_undo_save_bucket(node_bucket *bkt);
+void sim_undo_save_order(void **arr, int len);
+void sim_undo_save_event(timed_event *te);
+
+/*
+ *	sim_undo_add_event - record an event added to calendar
+ */
+void sim_undo_add_event(event_list *calendar, timed_event *te);
+
+/*
+ *	sim_undo_set_check - compare every simulation done with the undo log
+ *			     against the same simulation in a copy of sinfo
+ */
+void sim_undo_set_check(bool check);
+
+/*
+ *	sim_undo_check - in check mode, simulate a start time for resresv both ways and compare
+ */
+void sim_undo_check(server_info *sinfo, resource_resv *resresv, int flags);
+
+/*
+ *	sim_undo_check_results - simulations compared and how many of them differed
+ */
+void sim_undo_check_results(int *checked, int *mismatches);
+
+#endif /* _SIM_UNDO_H */
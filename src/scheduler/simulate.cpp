@@ -54,8 +54,10 @@
  * 	find_prev_timed_event()
  * 	set_timed_event_disabled()
  * 	find_timed_event()
+ * 	find_calendar_event()
  * 	perform_event()
  * 	exists_run_event()
+ * 	earliest_fit_time()
  * 	calc_run_time()
  * 	create_event_list()
  * 	create_events()
@@ -90,6 +92,9 @@
 #include <string.h>
 #include <errno.h>
 #include <log.h>
+#include <algorithm>
+#include <unordered_set>
+#include <vector>
 
 #include "simulate.h"
 #include "data_types.h"
@@ -108,6 +113,7 @@
 #include "globals.h"
 #include "check.h"
 #include "buckets.h"
+#include "sim_undo.h"
 #ifdef NAS /* localmod 030 */
 #include "site_code.h"
 #endif /* localmod 030 */
@@ -481,6 +487,7 @@ set_timed_event_disabled(timed_event *te, int disabled)
 	if (te == NULL)
 		return;
 
+	sim_undo_save_event(te);
 	te->disabled = disabled ? 1 : 0;
 }
 
@@ -561,6 +568,94 @@ find_timed_event(timed_event *te_list, time_t event_time)
 	return find_timed_event(te_list, "", 0, TIMED_NOEVENT, event_time);
 }
 
+/**
+ * @brief
+ * 		find an event in a calendar.  The time index takes us straight
+ *		to the events at event_time, so only they are searched.
+ *
+ * @param[in]	calendar	- calendar to search
+ * @param[in]	name		- name of the event or "" to ignore
+ * @param[in]	event_type	- event type or TIMED_NOEVENT to ignore
+ * @param[in]	event_time	- time of the event
+ *
+ * @return	found timed_event
+ * @retval	NULL	: not found
+ */
+timed_event *
+find_calendar_event(event_list *calendar, const std::string &name,
+		    enum timed_event_types event_type, time_t event_time)
+{
+	timed_event *te;
+
+	if (calendar == NULL)
+		return NULL;
+
+	auto it = calendar->time_index.find(event_time);
+	if (it == calendar->time_index.end())
+		return NULL;
+
+	for (te = it->second; te != NULL && te->event_time == event_time; te = te->next) {
+		if ((name.empty() || te->name == name) &&
+		    (event_type == TIMED_NOEVENT || te->event_type == event_type))
+			return te;
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief
+ * 		link a timed_event into a calendar's sorted list of events.
+ *		The same order as add_timed_event() is kept, but the place
+ *		to insert is found through the time index instead of walking
+ *		the list.
+ *
+ * @param[in,out]	calendar	- calendar to add to
+ * @param[in]		te		- timed_event to add
+ *
+ * @return	void
+ */
+static void
+insert_calendar_event(event_list *calendar, timed_event *te)
+{
+	auto &idx = calendar->time_index;
+	timed_event *before = NULL; /* te goes in front of this event, NULL for the end */
+	timed_event *last = NULL;
+	auto it = idx.find(te->event_time);
+
+	if (it != idx.end() && te->event_type == TIMED_END_EVENT) {
+		/* end events come first at a time */
+		before = it->second;
+		it->second = te;
+	} else {
+		auto next_it = idx.upper_bound(te->event_time);
+		if (next_it != idx.end())
+			before = next_it->second;
+		else if (!idx.empty())
+			for (last = idx.rbegin()->second; last->next != NULL; last = last->next)
+				;
+		if (it == idx.end())
+			idx.emplace_hint(next_it, te->event_time, te);
+	}
+
+	if (before != NULL) {
+		te->next = before;
+		te->prev = before->prev;
+		if (before->prev != NULL)
+			before->prev->next = te;
+		else
+			calendar->events = te;
+		before->prev = te;
+	} else {
+		te->next = NULL;
+		te->prev = last;
+		if (last != NULL)
+			last->next = te;
+		else
+			calendar->events = te;
+	}
+}
+
 /**
  * @brief
  * 		takes a timed_event and performs any actions
@@ -693,6 +788,259 @@ exists_resv_event(event_list *calendar, time_t end)
 	return 0;
 }
 
+/**
+ * @brief
+ * 		free consumable resources of the nodes a job can run on, swept
+ *		forward through the calendar.  Used by earliest_fit_time().
+ */
+struct fit_profile {
+	std::vector<resdef *> defs;		/* the consumable resources the job requests */
+	std::vector<sch_resource_t> demand;	/* total amount of each def the job requests */
+	std::vector<sch_resource_t> total_free;	/* free amount of each def over all nodes */
+	std::vector<std::vector<sch_resource_t>> chunk_amt; /* amount of each def per chunk */
+	std::vector<long long> chunk_need;	/* number of each chunk */
+	std::vector<long long> chunk_fits;	/* number of each chunk the nodes can hold */
+	std::vector<int> pos;			/* node_ind -> node's position in free, -1 if not used */
+	std::vector<sch_resource_t> free;	/* free amount of each def on each node */
+};
+
+/**
+ * @brief
+ * 		number of chunks a node can hold, capped at the number needed
+ *
+ * @param[in]	fp	-	the profile
+ * @param[in]	n	-	node's position in the profile
+ * @param[in]	c	-	chunk index
+ *
+ * @return	long long
+ */
+static long long
+fit_profile_chunks(fit_profile &fp, int n, int c)
+{
+	long long fits = fp.chunk_need[c];
+	int num_defs = fp.defs.size();
+
+	for (int d = 0; d < num_defs; d++) {
+		sch_resource_t amt = fp.chunk_amt[c][d];
+		sch_resource_t avail = fp.free[n * num_defs + d];
+
+		if (amt <= 0 || avail == SCHD_INFINITY_RES)
+			continue;
+		if (avail < amt)
+			return 0;
+		if (avail / amt < fits)
+			fits = static_cast<long long>(avail / amt);
+	}
+
+	return fits;
+}
+
+/**
+ * @brief
+ * 		take or give back the resources of a job or reservation on the
+ *		nodes of a profile
+ *
+ * @param[in,out]	fp	-	the profile
+ * @param[in]		sinfo	-	the universe fp is of
+ * @param[in]		rr	-	job or reservation
+ * @param[in]		sign	-	-1 to take resources, 1 to give them back
+ *
+ * @return	void
+ */
+static void
+fit_profile_update(fit_profile &fp, server_info *sinfo, resource_resv *rr, int sign)
+{
+	int num_defs = fp.defs.size();
+	int num_chunks = fp.chunk_need.size();
+
+	for (auto ns : rr->nspec_arr) {
+		node_info *ninfo = ns->ninfo;
+		int n;
+
+		/* reservation nodes are copies, jobs in a reservation don't use our nodes */
+		if (ninfo == NULL || ninfo->node_ind < 0 || ninfo->node_ind >= sinfo->num_nodes ||
+		    sinfo->unordered_nodes[ninfo->node_ind] != ninfo)
+			continue;
+		n = fp.pos[ninfo->node_ind];
+		if (n < 0)
+			continue;
+
+		for (int c = 0; c < num_chunks; c++)
+			fp.chunk_fits[c] -= fit_profile_chunks(fp, n, c);
+
+		for (resource_req *req = ns->resreq; req != NULL; req = req->next) {
+			for (int d = 0; d < num_defs; d++) {
+				if (req->def == fp.defs[d] && fp.free[n * num_defs + d] != SCHD_INFINITY_RES) {
+					fp.free[n * num_defs + d] += sign * req->amount;
+					fp.total_free[d] += sign * req->amount;
+				}
+			}
+		}
+
+		for (int c = 0; c < num_chunks; c++)
+			fp.chunk_fits[c] += fit_profile_chunks(fp, n, c);
+	}
+}
+
+/**
+ * @brief
+ * 		could the job fit on the nodes of a profile as they are now
+ *
+ * @param[in]	fp	-	the profile
+ *
+ * @return	bool
+ */
+static bool
+fit_profile_fits(fit_profile &fp)
+{
+	for (size_t c = 0; c < fp.chunk_need.size(); c++)
+		if (fp.chunk_fits[c] < fp.chunk_need[c])
+			return false;
+
+	for (size_t d = 0; d < fp.defs.size(); d++)
+		if (fp.total_free[d] < fp.demand[d])
+			return false;
+
+	return true;
+}
+
+/**
+ * @brief
+ * 		find a time before which a job can not run on the nodes.
+ *
+ * @par
+ *		The free consumable resources of the nodes the job can run on
+ *		are swept forward through the calendar: end events give back
+ *		resources and run events take them.  At each event time we check
+ *		if each chunk of the job could fit somewhere by resources alone.
+ *		Placement, non-consumable resources, node state and limits are
+ *		ignored and only make the answer earlier, so the job can not run
+ *		before the time returned.  calc_run_time() uses this to skip
+ *		placing the job at calendar events where it can't fit.
+ *
+ * @param[in]	sinfo	-	the universe, at the start of the simulation
+ * @param[in]	resresv	-	the job
+ *
+ * @return	time_t
+ * @retval	the first event time the job could fit at, or the time of the
+ *		last enabled event if it never fits
+ * @retval	sinfo->server_time	: the job may fit now, or no time can be found
+ */
+time_t
+earliest_fit_time(server_info *sinfo, resource_resv *resresv)
+{
+	fit_profile fp;
+	std::unordered_set<resource_resv *> started;
+	node_info **ninfo_arr;
+	timed_event *te;
+	time_t last_time;
+	int num_defs;
+	int num_chunks;
+	int i;
+
+	if (sinfo == NULL || resresv == NULL || sinfo->calendar == NULL)
+		return sinfo == NULL ? 0 : sinfo->server_time;
+
+	if (!resresv->is_job || resresv->job == NULL || resresv->job->resv != NULL ||
+	    resresv->select == NULL || resresv->select->chunks == NULL ||
+	    resresv->node_set_str != NULL || sinfo->unordered_nodes == NULL)
+		return sinfo->server_time;
+
+	if (resresv->ninfo_arr != NULL)
+		ninfo_arr = resresv->ninfo_arr;
+	else if (resresv->job->queue != NULL && resresv->job->queue->has_nodes)
+		ninfo_arr = resresv->job->queue->nodes;
+	else
+		ninfo_arr = sinfo->unassoc_nodes;
+	if (ninfo_arr == NULL)
+		return sinfo->server_time;
+
+	for (i = 0; resresv->select->chunks[i] != NULL; i++) {
+		for (resource_req *req = resresv->select->chunks[i]->req; req != NULL; req = req->next) {
+			if (req->def == NULL || !req->def->type.is_consumable ||
+			    sinfo->policy->resdef_to_check.find(req->def) == sinfo->policy->resdef_to_check.end())
+				continue;
+			if (std::find(fp.defs.begin(), fp.defs.end(), req->def) == fp.defs.end())
+				fp.defs.push_back(req->def);
+		}
+	}
+	if (fp.defs.empty())
+		return sinfo->server_time;
+
+	num_defs = fp.defs.size();
+	num_chunks = i;
+	fp.demand.assign(num_defs, 0);
+	fp.total_free.assign(num_defs, 0);
+	fp.chunk_amt.assign(num_chunks, std::vector<sch_resource_t>(num_defs, 0));
+	fp.chunk_fits.assign(num_chunks, 0);
+	for (int c = 0; c < num_chunks; c++) {
+		chunk *chk = resresv->select->chunks[c];
+
+		fp.chunk_need.push_back(chk->num_chunks);
+		for (resource_req *req = chk->req; req != NULL; req = req->next) {
+			for (int d = 0; d < num_defs; d++) {
+				if (req->def == fp.defs[d]) {
+					fp.chunk_amt[c][d] = req->amount;
+					fp.demand[d] += req->amount * chk->num_chunks;
+				}
+			}
+		}
+	}
+
+	fp.pos.assign(sinfo->num_nodes, -1);
+	for (i = 0; ninfo_arr[i] != NULL; i++) {
+		node_info *ninfo = ninfo_arr[i];
+		int n = fp.free.size() / num_defs;
+
+		if (ninfo->node_ind < 0 || ninfo->node_ind >= sinfo->num_nodes)
+			continue;
+		fp.pos[ninfo->node_ind] = n;
+		for (int d = 0; d < num_defs; d++) {
+			schd_resource *res = find_resource(ninfo->res, fp.defs[d]);
+			sch_resource_t avail;
+
+			if (res == NULL || res->indirect_res != NULL || res->avail == SCHD_INFINITY_RES)
+				avail = SCHD_INFINITY_RES;
+			else
+				avail = res->avail - res->assigned;
+			fp.free.push_back(avail);
+			fp.total_free[d] += avail;
+		}
+		for (int c = 0; c < num_chunks; c++)
+			fp.chunk_fits[c] += fit_profile_chunks(fp, n, c);
+	}
+
+	if (fit_profile_fits(fp))
+		return sinfo->server_time;
+
+	last_time = sinfo->server_time;
+	for (te = sinfo->calendar->next_event; te != NULL; te = te->next) {
+		if (!te->disabled) {
+			auto rr = static_cast<resource_resv *>(te->event_ptr);
+
+			if (te->event_type == TIMED_RUN_EVENT) {
+				fit_profile_update(fp, sinfo, rr, -1);
+				started.insert(rr);
+			} else if (te->event_type == TIMED_END_EVENT) {
+				/* only give back what is in use now or was taken by a run event */
+				bool running = rr->is_job ? (rr->job != NULL && rr->job->is_running) :
+							    (rr->resv != NULL && rr->resv->is_running);
+				if (running || started.find(rr) != started.end())
+					fit_profile_update(fp, sinfo, rr, 1);
+			}
+			last_time = te->event_time;
+		}
+
+		/* check once all events at this time are done */
+		if (te->next != NULL && te->next->event_time == te->event_time)
+			continue;
+		if (fit_profile_fits(fp))
+			return te->event_time;
+	}
+
+	return last_time;
+}
+
 /**
  * @brief
  * 		calculate the run time of a resresv through simulation of
@@ -726,6 +1074,7 @@ calc_run_time(const std::string &name, server_info *sinfo, int flags)
 	std::vector<nspec *> nspec_arr;
 	unsigned int ok_flags = NO_ALLPART;
 	queue_info *qinfo = NULL;
+	time_t min_start;		/* the resresv can not fit on the nodes before this */
 
 	if (name.empty() || sinfo == NULL)
 		return (time_t) -1;
@@ -749,13 +1098,16 @@ calc_run_time(const std::string &name, server_info *sinfo, int flags)
 	if (err == NULL)
 		return (time_t) 0;
 
+	min_start = earliest_fit_time(sinfo, resresv);
+
 	do {
 		/* policy is used from sinfo instead of being passed into calc_run_time()
 		 * because it's being simulated/updated in simulate_events()
 		 */
 
 		auto desc = describe_simret(ret);
-		if (desc > 0 || (desc == 0 && policy_change_info(sinfo, resresv))) {
+		if (event_time >= min_start &&
+		    (desc > 0 || (desc == 0 && policy_change_info(sinfo, resresv)))) {
 			clear_schd_error(err);
 			nspec_arr = is_ok_to_run(sinfo->policy, sinfo, qinfo, resresv, ok_flags, err);
 		}
@@ -842,7 +1194,7 @@ create_event_list(server_info *sinfo)
 	if (elist == NULL)
 		return NULL;
 
-	elist->events = create_events(sinfo);
+	create_events(sinfo, elist);
 
 	elist->next_event = elist->events;
 	elist->first_run_event = find_timed_event(elist->events, TIMED_RUN_EVENT);
@@ -854,18 +1206,20 @@ create_event_list(server_info *sinfo)
 
 /**
  * @brief
- *		create_events - creates an timed_event list from running jobs
+ *		create_events - creates the timed_events of running jobs
  *			    and confirmed reservations
  *
  * @param[in] sinfo - server universe to act upon
+ * @param[in,out] elist - empty event list to add the events to
  *
- * @return	timed_event list
+ * @return	int
+ * @retval	1	: success
+ * @retval	0	: failure, elist is left empty
  *
  */
-timed_event *
-create_events(server_info *sinfo)
+int
+create_events(server_info *sinfo, event_list *elist)
 {
-	timed_event *events = NULL;
 	timed_event *te = NULL;
 	resource_resv **all = NULL;
 	int errflag = 0;
@@ -900,7 +1254,7 @@ create_events(server_info *sinfo)
 				errflag++;
 				break;
 			}
-			events = add_timed_event(events, te);
+			insert_calendar_event(elist, te);
 		}
 
 		if (sinfo->use_hard_duration)
@@ -912,7 +1266,7 @@ create_events(server_info *sinfo)
 			errflag++;
 			break;
 		}
-		events = add_timed_event(events, te);
+		insert_calendar_event(elist, te);
 	}
 
 	/* for nodes that are in state=sleep add a timed event */
@@ -925,19 +1279,21 @@ create_events(server_info *sinfo)
 				errflag++;
 				break;
 			}
-			events = add_timed_event(events, te);
+			insert_calendar_event(elist, te);
 		}
 	}
 
 	/* A malloc error was encountered, free all allocated memory and return */
 	if (errflag > 0) {
-		free_timed_event_list(events);
+		free_timed_event_list(elist->events);
+		elist->events = NULL;
+		elist->time_index.clear();
 		free(all_resresv_copy);
 		return 0;
 	}
 
 	free(all_resresv_copy);
-	return events;
+	return 1;
 }
 
 /**
@@ -952,7 +1308,7 @@ new_event_list()
 {
 	event_list *elist;
 
-	if ((elist = static_cast<event_list *>(malloc(sizeof(event_list)))) == NULL) {
+	if ((elist = new event_list()) == NULL) {
 		log_err(errno, __func__, MEM_ERR_MSG);
 		return NULL;
 	}
@@ -980,6 +1336,8 @@ event_list *
 dup_event_list(event_list *oelist, server_info *nsinfo)
 {
 	event_list *nelist;
+	timed_event *ote;
+	timed_event *nte;
 
 	if (oelist == NULL || nsinfo == NULL)
 		return NULL;
@@ -1000,28 +1358,32 @@ dup_event_list(event_list *oelist, server_info *nsinfo)
 		}
 	}
 
-	if (oelist->next_event != NULL) {
-		nelist->next_event = find_timed_event(nelist->events, oelist->next_event->name,
-						      oelist->next_event->event_type,
-						      oelist->next_event->event_time);
-		if (nelist->next_event == NULL) {
-			log_event(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING,
-				  oelist->next_event->name, "can't find next event in duplicated list");
-			free_event_list(nelist);
-			return NULL;
-		}
+	/* The duplicated list is in the same order as the original.  Walk both
+	 * together to rebuild the time index and to find the new next_event and
+	 * first_run_event without searching for them.
+	 */
+	for (ote = oelist->events, nte = nelist->events; ote != NULL && nte != NULL;
+	     ote = ote->next, nte = nte->next) {
+		if (nte->prev == NULL || nte->prev->event_time != nte->event_time)
+			nelist->time_index.emplace_hint(nelist->time_index.end(), nte->event_time, nte);
+		if (ote == oelist->next_event)
+			nelist->next_event = nte;
+		if (ote == oelist->first_run_event)
+			nelist->first_run_event = nte;
 	}
 
-	if (oelist->first_run_event != NULL) {
-		nelist->first_run_event =
-			find_timed_event(nelist->events, oelist->first_run_event->name, TIMED_RUN_EVENT,
-					 oelist->first_run_event->event_time);
-		if (nelist->first_run_event == NULL) {
-			log_event(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING, oelist->first_run_event->name,
-				  "can't find first run event event in duplicated list");
-			free_event_list(nelist);
-			return NULL;
-		}
+	if (oelist->next_event != NULL && nelist->next_event == NULL) {
+		log_event(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING,
+			  oelist->next_event->name, "can't find next event in duplicated list");
+		free_event_list(nelist);
+		return NULL;
+	}
+
+	if (oelist->first_run_event != NULL && nelist->first_run_event == NULL) {
+		log_event(PBSEVENT_SCHED, PBS_EVENTCLASS_SCHED, LOG_WARNING, oelist->first_run_event->name,
+			  "can't find first run event event in duplicated list");
+		free_event_list(nelist);
+		return NULL;
 	}
 
 	return nelist;
@@ -1040,7 +1402,7 @@ free_event_list(event_list *elist)
 		return;
 
 	free_timed_event_list(elist->events);
-	free(elist);
+	delete elist;
 }
 
 /**
@@ -1146,23 +1508,23 @@ free_te_list(te_list *tel)
 /*
  * @brief te_list copy constructor
  * @param[in] ote - te_list to copy
- * @param[in] new_timed_even_list - new timed events
+ * @param[in] new_calendar - calendar holding the new timed events
  *
  * @return copied te_list
  */
 te_list *
-dup_te_list(te_list *ote, timed_event *new_timed_event_list)
+dup_te_list(te_list *ote, event_list *new_calendar)
 {
 	te_list *nte;
 
-	if (ote == NULL || new_timed_event_list == NULL)
+	if (ote == NULL || new_calendar == NULL)
 		return NULL;
 
 	nte = new_te_list();
 	if (nte == NULL)
 		return NULL;
 
-	nte->event = find_timed_event(new_timed_event_list, ote->event->name, ote->event->event_type, ote->event->event_time);
+	nte->event = find_calendar_event(new_calendar, ote->event->name, ote->event->event_type, ote->event->event_time);
 
 	return nte;
 }
@@ -1170,24 +1532,24 @@ dup_te_list(te_list *ote, timed_event *new_timed_event_list)
 /*
  * @brief copy constructor for a list of te_list structures
  * @param[in] ote - te_list to copy
- * @param[in] new_timed_even_list - new timed events
+ * @param[in] new_calendar - calendar holding the new timed events
  *
  * @return copied te_list list
  */
 
 te_list *
-dup_te_lists(te_list *ote, timed_event *new_timed_event_list)
+dup_te_lists(te_list *ote, event_list *new_calendar)
 {
 	te_list *nte;
 	te_list *end_te = NULL;
 	te_list *cur;
 	te_list *nte_head = NULL;
 
-	if (ote == NULL || new_timed_event_list == NULL)
+	if (ote == NULL || new_calendar == NULL)
 		return NULL;
 
 	for (cur = ote; cur != NULL; cur = cur->next) {
-		nte = dup_te_list(cur, new_timed_event_list);
+		nte = dup_te_list(cur, new_calendar);
 		if (nte == NULL) {
 			free_te_list(nte_head);
 			return NULL;
@@ -1440,7 +1802,7 @@ add_event(event_list *calendar, timed_event *te)
 	if (calendar->events == NULL)
 		events_is_null = 1;
 
-	calendar->events = add_timed_event(calendar->events, te);
+	insert_calendar_event(calendar, te);
 
 	/* empty event list - the new event is the only event */
 	if (events_is_null)
@@ -1454,7 +1816,7 @@ add_event(event_list *calendar, timed_event *te)
 				calendar->next_event = te;
 			else if (te->event_time == calendar->next_event->event_time) {
 				calendar->next_event =
-					find_timed_event(calendar->events, te->event_time);
+					find_calendar_event(calendar, "", TIMED_NOEVENT, te->event_time);
 			}
 		}
 	}
@@ -1472,6 +1834,8 @@ add_event(event_list *calendar, timed_event *te)
 	if (calendar->eol && calendar->next_event != NULL)
 		calendar->eol = 0;
 
+	sim_undo_add_event(calendar, te);
+
 	return 1;
 }
 
@@ -1550,8 +1914,17 @@ delete_event(server_info *sinfo, timed_event *e)
 	if (calendar->next_event == e)
 		calendar->next_event = e->next;
 
+	/* any run event before e has already been simulated */
 	if (calendar->first_run_event == e)
-		calendar->first_run_event = find_timed_event(calendar->events, TIMED_RUN_EVENT);
+		calendar->first_run_event = find_next_timed_event(e, 0, TIMED_RUN_EVENT);
+
+	auto it = calendar->time_index.find(e->event_time);
+	if (it != calendar->time_index.end() && it->second == e) {
+		if (e->next != NULL && e->next->event_time == e->event_time)
+			it->second = e->next;
+		else
+			calendar->time_index.erase(it);
+	}
 
 	if (e->prev == NULL)
 		calendar->events = e->next;
@@ -139,6 +139,13 @@ timed_event *find_timed_event(timed_event *te_list, enum timed_event_types event
 timed_event *find_timed_event(timed_event *te_list, const std::string &name, enum timed_event_types event_type, time_t event_time);
 timed_event *find_timed_event(timed_event *te_list, time_t event_time);
 
+/*
+ *	find_calendar_event - find an event in a calendar by its time
+ *			      through the calendar's time index
+ */
+timed_event *find_calendar_event(event_list *calendar, const std::string &name,
+				 enum timed_event_types event_type, time_t event_time);
+
 /*
  *      next_event - move an event_list to the next event and return it
  *
@@ -189,16 +196,19 @@ int exists_run_event_on_node(node_info *ninf, time_t end);
 /* Checks if a reservation run event exists between now and 'end' */
 int exists_resv_event(event_list *calendar, time_t end);
 
+/* find a time before which a job can not fit on the nodes */
+time_t earliest_fit_time(server_info *sinfo, resource_resv *resresv);
+
 /*
  *      create_events - creates an timed_event list from running jobs
  *                          and confirmed reservations
  *
  *        \param sinfo - server universe to act upon
- *        \param flags -
+ *        \param elist - event list to add the events to
  *
- *        \return timed_event list
+ *        \return 1 success / 0 failure
  */
-timed_event *create_events(server_info *sinfo);
+int create_events(server_info *sinfo, event_list *elist);
 
 /*
  * new_event_list() - event_list constructor
@@ -442,8 +452,8 @@ generic_sim(event_list *calendar, unsigned int event_mask, time_t end, int defau
 
 te_list *new_te_list();
 
-te_list *dup_te_list(te_list *ote, timed_event *new_timed_event_list);
-te_list *dup_te_lists(te_list *ote, timed_event *new_timed_event_list);
+te_list *dup_te_list(te_list *ote, event_list *new_calendar);
+te_list *dup_te_lists(te_list *ote, event_list *new_calendar);
 
 void free_te_list(te_list *tel);
 
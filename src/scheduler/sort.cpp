@@ -68,6 +68,11 @@
  * 	cmp_aoe()
  * 	cmp_job_preemption_time_asc()
  * 	sort_jobs()
+ * 	sort_keys_chunk()
+ * 	sort_job_array()
+ * 	sort_node_array()
+ * 	sort_nodepart_array()
+ * 	sort_moved_nodes()
  * 	swapfunc()
  * 	med3()
  * 	qsort()
@@ -86,13 +91,23 @@
 #include "resource.h"
 #include "resource_resv.h"
 #include "server_info.h"
+#include "multi_threading.h"
+#include "queue.h"
+#include "profile.h"
 #include "sort.h"
 #include <errno.h>
 #include <log.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <climits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 #ifdef NAS
 #include "site_code.h"
 #endif
@@ -1132,6 +1147,7 @@ cmp_resv_state(const void *r1, const void *r2)
 void
 sort_jobs(status *policy, server_info *sinfo)
 {
+	prof_scope prof("sort_jobs");
 	/** sort jobs in such a way that Higher Priority jobs come on top
 	 * followed by preempted jobs and then normal jobs
 	 */
@@ -1146,8 +1162,7 @@ sort_jobs(status *policy, server_info *sinfo)
 			 */
 			for (auto qinfo : sinfo->queues) {
 				if (qinfo->sc.total > 0) {
-					qsort(qinfo->jobs, qinfo->sc.total,
-					      sizeof(resource_resv *), cmp_sort);
+					sort_job_array(qinfo->jobs, qinfo->sc.total);
 				}
 			}
 			for (auto qinfo : sinfo->queues) {
@@ -1160,24 +1175,520 @@ sort_jobs(status *policy, server_info *sinfo)
 		}
 		/** Sort on entire complex **/
 		else if (!policy->by_queue && !policy->round_robin) {
-			qsort(sinfo->jobs, count_array(sinfo->jobs), sizeof(resource_resv *), cmp_sort);
+			sort_job_array(sinfo->jobs, count_array(sinfo->jobs));
 		}
 	} else if (policy->by_queue) {
 		for (auto qinfo : sinfo->queues) {
-			qsort(qinfo->jobs, count_array(qinfo->jobs), sizeof(resource_resv *), cmp_sort);
+			sort_job_array(qinfo->jobs, count_array(qinfo->jobs));
 		}
-		qsort(sinfo->jobs, count_array(sinfo->jobs), sizeof(resource_resv *), cmp_sort);
+		sort_job_array(sinfo->jobs, count_array(sinfo->jobs));
 	} else if (policy->round_robin) {
 		if (sinfo->queue_list != NULL) {
 			int queue_list_size = count_array(sinfo->queue_list);
 			for (int i = 0; i < queue_list_size; i++) {
 				int queue_index_size = count_array(sinfo->queue_list[i]);
 				for (int j = 0; j < queue_index_size; j++) {
-					qsort(sinfo->queue_list[i][j]->jobs, count_array(sinfo->queue_list[i][j]->jobs),
-					      sizeof(resource_resv *), cmp_sort);
+					sort_job_array(sinfo->queue_list[i][j]->jobs, count_array(sinfo->queue_list[i][j]->jobs));
 				}
 			}
 		}
 	} else
-		qsort(sinfo->jobs, count_array(sinfo->jobs), sizeof(resource_resv *), cmp_sort);
+		sort_job_array(sinfo->jobs, count_array(sinfo->jobs));
+}
+
+/* words of a job's packed sort key ahead of the job_sort_key words:
+ * runnable, preempt priority, preempted time, formula value and fairshare
+ */
+#define JOB_SORT_KEY_FIXED 5
+
+/*
+ * The packed sort keys of an array of jobs, nodes or placement sets.  The
+ * sort key tuple of each object is computed once into nkeys words whose
+ * unsigned order is the sort order of cmp_sort() and multi_node_sort(),
+ * so the sort itself compares plain integers instead of looking up
+ * resources by name on every comparison.
+ */
+struct sort_keys {
+	void **objs;					/* objects to sort */
+	int num;					/* number of objects */
+	int nkeys;					/* words per object */
+	enum sort_obj_type obj_type;			/* SOBJ_JOB, SOBJ_NODE or SOBJ_PARTITION */
+	std::vector<unsigned long long> keys;		/* num * nkeys words */
+	std::vector<int> idx;				/* order of the objects */
+	std::unordered_map<group_info *, unsigned long long> fs_order; /* fairshare order of jobs' groups */
+};
+
+/* compare two objects of a sort_keys by their packed keys */
+struct cmp_sort_keys {
+	const sort_keys *sk;
+
+	bool
+	operator()(int i1, int i2) const
+	{
+		const unsigned long long *k1 = &sk->keys[(size_t) i1 * sk->nkeys];
+		const unsigned long long *k2 = &sk->keys[(size_t) i2 * sk->nkeys];
+
+		for (int i = 0; i < sk->nkeys; i++) {
+			if (k1[i] != k2[i])
+				return k1[i] < k2[i];
+		}
+		return false;
+	}
+};
+
+/**
+ * @brief
+ * 		encode a number into a sort key word.  The bits of a double are
+ *		flipped so the unsigned order of the words is the numeric order.
+ *
+ * @param[in]	v	-	number to encode
+ * @param[in]	order	-	ASC or DESC
+ *
+ * @return	unsigned long long
+ */
+static unsigned long long
+sort_key_word(double v, enum sort_order order)
+{
+	unsigned long long bits;
+
+	if (v == 0)
+		v = 0; /* -0.0 sorts with 0.0 */
+	memcpy(&bits, &v, sizeof(bits));
+	if (bits & (1ULL << 63))
+		bits = ~bits;
+	else
+		bits |= (1ULL << 63);
+
+	return order == DESC ? ~bits : bits;
+}
+
+/**
+ * @brief
+ * 		fill in the packed sort key of a job the way cmp_sort() orders jobs
+ *
+ * @param[in,out]	sk	-	sort keys
+ * @param[in]	i	-	index of the job
+ *
+ * @return void
+ */
+static void
+fill_job_sort_key(sort_keys *sk, int i)
+{
+	resource_resv *r = static_cast<resource_resv *>(sk->objs[i]);
+	unsigned long long *key = &sk->keys[(size_t) i * sk->nkeys];
+	int k = JOB_SORT_KEY_FIXED;
+
+	key[0] = in_runnable_state(r) ? 0 : 1;
+	key[1] = key[2] = key[3] = key[4] = 0;
+	if (r->job != NULL) {
+		key[1] = sort_key_word(r->job->preempt, DESC);
+		/* preempted jobs come first, the earliest preempted first */
+		if (r->job->time_preempted == UNSPECIFIED)
+			key[2] = ULLONG_MAX;
+		else
+			key[2] = sort_key_word(r->job->time_preempted, ASC);
+		key[3] = sort_key_word(r->job->formula_value, DESC);
+#ifndef NAS /* localmod 041 */
+		if (r->server->policy->fair_share && r->job->ginfo != NULL) {
+			auto fs = sk->fs_order.find(r->job->ginfo);
+			if (fs != sk->fs_order.end())
+				key[4] = fs->second;
+		}
+#endif /* localmod 041 */
+	}
+
+	for (const auto &si : *cstat.sort_by)
+		key[k++] = sort_key_word(find_resresv_amount(r, si.res_name, si.def), si.order);
+
+	key[k++] = sort_key_word(r->qrank, ASC);
+	key[k] = sort_key_word(r->rank, ASC);
+}
+
+/**
+ * @brief
+ * 		fill in the packed sort key of a node or placement set the way
+ *		multi_node_sort() and multi_nodepart_sort() order them
+ *
+ * @param[in,out]	sk	-	sort keys
+ * @param[in]	i	-	index of the node or placement set
+ *
+ * @return void
+ */
+static void
+fill_node_sort_key(sort_keys *sk, int i)
+{
+	unsigned long long *key = &sk->keys[(size_t) i * sk->nkeys];
+	int k = 0;
+
+	for (const auto &si : *cstat.node_sort) {
+		sch_resource_t v;
+
+		if (sk->obj_type == SOBJ_NODE)
+			v = find_node_amount(static_cast<node_info *>(sk->objs[i]), si.res_name, si.def, si.res_type);
+		else
+			v = find_nodepart_amount(static_cast<node_partition *>(sk->objs[i]), si.res_name, si.def, si.res_type);
+		key[k++] = sort_key_word(v, si.order);
+	}
+
+	if (sk->obj_type == SOBJ_NODE)
+		key[k] = sort_key_word(static_cast<node_info *>(sk->objs[i])->rank, ASC);
+	else
+		key[k] = sort_key_word(static_cast<node_partition *>(sk->objs[i])->rank, ASC);
+}
+
+/**
+ * @brief
+ * 		fill in the packed sort keys of a range of objects
+ *
+ * @param[in,out]	sk	-	sort keys
+ * @param[in]	sidx	-	first object
+ * @param[in]	eidx	-	last object
+ *
+ * @return void
+ */
+static void
+fill_sort_keys(sort_keys *sk, int sidx, int eidx)
+{
+	for (int i = sidx; i <= eidx; i++) {
+		if (sk->obj_type == SOBJ_JOB)
+			fill_job_sort_key(sk, i);
+		else
+			fill_node_sort_key(sk, i);
+	}
+}
+
+/**
+ * @brief
+ * 		std::stable_sort() compare function for jobs by cmp_fairshare()
+ *
+ * @return	bool
+ * @retval	true	: r1's group is more deserving
+ */
+static bool
+cmp_fairshare_less(resource_resv *r1, resource_resv *r2)
+{
+	return cmp_fairshare(&r1, &r2) < 0;
+}
+
+/**
+ * @brief
+ * 		allocate the packed sort keys for an array of objects.  For jobs,
+ *		the groups of the jobs are put in fairshare order once here so
+ *		compare_path() is not called on every comparison.
+ *
+ * @param[in,out]	sk	-	sort keys to set up
+ * @param[in]	objs	-	objects to sort
+ * @param[in]	num	-	number of objects
+ * @param[in]	obj_type	-	SOBJ_JOB, SOBJ_NODE or SOBJ_PARTITION
+ *
+ * @return void
+ */
+static void
+init_sort_keys(sort_keys *sk, void **objs, int num, enum sort_obj_type obj_type)
+{
+	sk->objs = objs;
+	sk->num = num;
+	sk->obj_type = obj_type;
+	if (obj_type == SOBJ_JOB)
+		sk->nkeys = JOB_SORT_KEY_FIXED + cstat.sort_by->size() + 2;
+	else
+		sk->nkeys = cstat.node_sort->size() + 1;
+	sk->keys.resize((size_t) num * sk->nkeys);
+	sk->idx.resize(num);
+	for (int i = 0; i < num; i++)
+		sk->idx[i] = i;
+
+#ifndef NAS /* localmod 041 */
+	if (obj_type == SOBJ_JOB) {
+		std::vector<resource_resv *> groups;
+		std::unordered_set<group_info *> seen;
+
+		for (int i = 0; i < num; i++) {
+			resource_resv *r = static_cast<resource_resv *>(objs[i]);
+
+			if (r->job != NULL && r->job->ginfo != NULL && r->server->policy->fair_share &&
+			    seen.insert(r->job->ginfo).second)
+				groups.push_back(r);
+		}
+		/* compare_path() is not a strict weak order, stable_sort() copes with that */
+		std::stable_sort(groups.begin(), groups.end(), cmp_fairshare_less);
+		for (size_t i = 0, ord = 0; i < groups.size(); i++) {
+			if (i > 0 && cmp_fairshare(&groups[i - 1], &groups[i]) != 0)
+				ord++;
+			sk->fs_order[groups[i]->job->ginfo] = ord;
+		}
+	}
+#endif /* localmod 041 */
+}
+
+/**
+ * @brief	pthread routine to work on a chunk of packed sort keys.  Either
+ *		fill in and sort the keys of the chunk, or merge two sorted
+ *		neighbouring chunks.
+ *
+ * @param[in,out]	data - th_data_sort_keys object
+ *
+ * @return void
+ */
+void
+sort_keys_chunk(th_data_sort_keys *data)
+{
+	sort_keys *sk;
+	cmp_sort_keys cmp;
+
+	if (data == NULL)
+		return;
+
+	sk = data->sk;
+	cmp.sk = sk;
+	if (data->midx < 0) {
+		fill_sort_keys(sk, data->sidx, data->eidx);
+		std::sort(sk->idx.begin() + data->sidx, sk->idx.begin() + data->eidx + 1, cmp);
+	} else
+		std::inplace_merge(sk->idx.begin() + data->sidx, sk->idx.begin() + data->midx,
+				   sk->idx.begin() + data->eidx + 1, cmp);
+}
+
+/**
+ * @brief
+ * 		queue a sort_keys_chunk() task for the worker threads
+ *
+ * @return int
+ * @retval 1 the task was queued
+ * @retval 0 error, the caller does the work itself
+ */
+static int
+queue_sort_keys_task(ds_queue *done_queue, sort_keys *sk, int sidx, int midx, int eidx)
+{
+	th_data_sort_keys *tdata;
+
+	tdata = static_cast<th_data_sort_keys *>(malloc(sizeof(th_data_sort_keys)));
+	if (tdata == NULL) {
+		log_err(errno, __func__, MEM_ERR_MSG);
+		return 0;
+	}
+	tdata->sk = sk;
+	tdata->sidx = sidx;
+	tdata->midx = midx;
+	tdata->eidx = eidx;
+	if (!queue_task_for_threads_to(done_queue, TS_SORT_KEYS, 0, tdata)) {
+		free(tdata);
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief
+ * 		wait for the sort_keys_chunk() tasks on a queue to finish
+ *
+ * @return void
+ */
+static void
+wait_sort_keys_tasks(ds_queue *done_queue, int num_tasks)
+{
+	for (int i = 0; i < num_tasks; i++) {
+		th_task_info *task = wait_for_task_result_on(done_queue);
+
+		free(task->thread_data);
+		free(task);
+	}
+}
+
+/**
+ * @brief
+ * 		compute and sort the packed sort keys.  On the main thread, large
+ *		arrays are split into chunks which the worker threads fill in
+ *		and sort, and the sorted chunks are then merged pairwise, the
+ *		merges of a pass also running on the worker threads.  The keys
+ *		end in the object's unique rank, so the order is the same no
+ *		matter how the work was split.
+ *
+ * @param[in,out]	sk	-	sort keys
+ *
+ * @return void
+ */
+static void
+run_sort_keys(sort_keys *sk)
+{
+	th_data_sort_keys tdata;
+	ds_queue *done_queue = NULL;
+	int chunk_size;
+	int tid;
+
+	tid = *((int *) pthread_getspecific(th_id_key));
+	chunk_size = mt_chunk_size(sk->num);
+	if (tid == 0 && num_threads > 1 && sk->num > chunk_size)
+		done_queue = new_ds_queue();
+
+	if (done_queue == NULL) {
+		tdata.sk = sk;
+		tdata.sidx = 0;
+		tdata.midx = -1;
+		tdata.eidx = sk->num - 1;
+		sort_keys_chunk(&tdata);
+		return;
+	}
+
+	for (int width = 0; width < sk->num; width = (width == 0) ? chunk_size : width * 2) {
+		int num_tasks = 0;
+		int step = (width == 0) ? chunk_size : width * 2;
+
+		for (int s = 0; s < sk->num; s += step) {
+			int e = std::min(s + step, sk->num) - 1;
+			int m = (width == 0) ? -1 : s + width;
+
+			if (m > e)
+				continue; /* odd chunk out, nothing to merge it with this pass */
+			if (queue_sort_keys_task(done_queue, sk, s, m, e))
+				num_tasks++;
+			else {
+				tdata.sk = sk;
+				tdata.sidx = s;
+				tdata.midx = m;
+				tdata.eidx = e;
+				sort_keys_chunk(&tdata);
+			}
+		}
+		wait_sort_keys_tasks(done_queue, num_tasks);
+	}
+	free_ds_queue(done_queue);
+}
+
+/**
+ * @brief
+ * 		put an array of objects in the order of its sort keys
+ *
+ * @param[in]	sk	-	sorted sort keys
+ *
+ * @return void
+ */
+static void
+apply_sort_keys(sort_keys *sk)
+{
+	std::vector<void *> objs(sk->objs, sk->objs + sk->num);
+
+	for (int i = 0; i < sk->num; i++)
+		sk->objs[i] = objs[sk->idx[i]];
+}
+
+/**
+ * @brief
+ * 		sort an array of jobs in the order of cmp_sort()
+ *
+ * @param[in,out]	jobs	-	jobs to sort
+ * @param[in]	num	-	number of jobs
+ *
+ * @return void
+ */
+void
+sort_job_array(resource_resv **jobs, int num)
+{
+	sort_keys sk;
+
+	if (jobs == NULL || num <= 1)
+		return;
+
+	init_sort_keys(&sk, reinterpret_cast<void **>(jobs), num, SOBJ_JOB);
+	run_sort_keys(&sk);
+	apply_sort_keys(&sk);
+}
+
+/**
+ * @brief
+ * 		sort an array of nodes in the order of multi_node_sort()
+ *
+ * @param[in,out]	nodes	-	nodes to sort
+ * @param[in]	num	-	number of nodes
+ *
+ * @return void
+ */
+void
+sort_node_array(node_info **nodes, int num)
+{
+	sort_keys sk;
+
+	if (nodes == NULL || num <= 1)
+		return;
+
+	init_sort_keys(&sk, reinterpret_cast<void **>(nodes), num, SOBJ_NODE);
+	run_sort_keys(&sk);
+	apply_sort_keys(&sk);
+}
+
+/**
+ * @brief
+ * 		sort an array of placement sets in the order of multi_nodepart_sort()
+ *
+ * @param[in,out]	nodepart	-	placement sets to sort
+ * @param[in]	num	-	number of placement sets
+ *
+ * @return void
+ */
+void
+sort_nodepart_array(node_partition **nodepart, int num)
+{
+	sort_keys sk;
+
+	if (nodepart == NULL || num <= 1)
+		return;
+
+	init_sort_keys(&sk, reinterpret_cast<void **>(nodepart), num, SOBJ_PARTITION);
+	run_sort_keys(&sk);
+	apply_sort_keys(&sk);
+}
+
+/**
+ * @brief
+ * 		re-sort a sorted array of nodes after a job or reservation ran on
+ *		some of them.  Only the nodes it ran on are sorted, and then
+ *		merged back in with the others.  If the others are out of order,
+ *		e.g. because resources of theirs are indirect to a node the job
+ *		ran on, the whole array is sorted.
+ *
+ * @param[in,out]	nodes	-	nodes to sort
+ * @param[in]	num	-	number of nodes
+ * @param[in]	ns_arr	-	where the job or reservation ran
+ *
+ * @return void
+ */
+void
+sort_moved_nodes(node_info **nodes, int num, const std::vector<nspec *> &ns_arr)
+{
+	sort_keys sk;
+	cmp_sort_keys cmp;
+	std::unordered_set<int> moved; /* ranks, so copies of the nodes match too */
+	std::vector<int> rest;
+	std::vector<int> moved_idx;
+
+	if (nodes == NULL || num <= 1)
+		return;
+
+	for (auto ns : ns_arr)
+		moved.insert(ns->ninfo->rank);
+
+	init_sort_keys(&sk, reinterpret_cast<void **>(nodes), num, SOBJ_NODE);
+	fill_sort_keys(&sk, 0, num - 1);
+	cmp.sk = &sk;
+
+	rest.reserve(num);
+	for (int i = 0; i < num; i++) {
+		if (moved.find(nodes[i]->rank) != moved.end())
+			moved_idx.push_back(i);
+		else {
+			if (!rest.empty() && cmp(i, rest.back())) {
+				/* the unmoved nodes are out of order too, sort them all */
+				std::sort(sk.idx.begin(), sk.idx.end(), cmp);
+				apply_sort_keys(&sk);
+				return;
+			}
+			rest.push_back(i);
+		}
+	}
+	if (moved_idx.empty())
+		return;
+
+	std::sort(moved_idx.begin(), moved_idx.end(), cmp);
+	std::merge(rest.begin(), rest.end(), moved_idx.begin(), moved_idx.end(), sk.idx.begin(), cmp);
+	apply_sort_keys(&sk);
 }
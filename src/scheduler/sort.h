@@ -189,4 +189,15 @@ int cmp_resv_state(const void *r1, const void *r2);
  */
 void sort_jobs(status *policy, server_info *sinfo);
 
+/* pthread routine to fill in, sort or merge a chunk of packed sort keys */
+void sort_keys_chunk(th_data_sort_keys *data);
+
+/* sort jobs, nodes and placement sets on their packed sort keys */
+void sort_job_array(resource_resv **jobs, int num);
+void sort_node_array(node_info **nodes, int num);
+void sort_nodepart_array(node_partition **nodepart, int num);
+
+/* re-sort sorted nodes after a job or reservation ran on some of them */
+void sort_moved_nodes(node_info **nodes, int num, const std::vector<nspec *> &ns_arr);
+
 #endif /* _SORT_H */
@@ -0,0 +1,369 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    sort_bench.cpp
+ *
+ * @brief
+ * 		sort_bench.cpp - microbenchmark of job and node sorting.  Sorts
+ *		jobs and nodes both with qsort() and the multi key compare
+ *		functions and on their packed sort keys, then runs jobs on a few
+ *		nodes at a time and re-sorts the nodes both with qsort() and by
+ *		merging only the moved nodes back in.  Checks the orders are the
+ *		same and reports the time each took.
+ *
+ *	usage: pbs_sched_sort_bench [-j num_jobs] [-n num_nodes] [-r num_runs] [-t num_threads]
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include <vector>
+
+#include <pbs_internal.h>
+#include <log.h>
+#include "data_types.h"
+#include "constant.h"
+#include "globals.h"
+#include "job_info.h"
+#include "multi_threading.h"
+#include "resource.h"
+#include "resource_resv.h"
+#include "server_info.h"
+#include "sort.h"
+
+#define BENCH_DEFAULT_JOBS 200000
+#define BENCH_DEFAULT_NODES 50000
+#define BENCH_DEFAULT_RUNS 200
+#define BENCH_NODES_PER_RUN 4
+#define BENCH_GROUPS 16
+
+/**
+ * @brief
+ * 		current wall clock time in seconds
+ *
+ * @return	double
+ */
+static double
+bench_time(void)
+{
+	struct timeval tv;
+
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+/**
+ * @brief
+ * 		add a resource definition to allres
+ *
+ * @param[in]	name	-	resource name
+ * @param[in]	type	-	server attribute type (ATR_TYPE_*)
+ *
+ * @return	resdef *
+ */
+static resdef *
+bench_add_resdef(const char *name, int type)
+{
+	resdef *def = new resdef(const_cast<char *>(name), ATR_DFLAG_CVTSLT, conv_rsc_type(type));
+	allres[name] = def;
+	if (def->type.is_consumable)
+		consres.insert(def);
+	return def;
+}
+
+/**
+ * @brief
+ * 		shuffle an array the same way on every run
+ *
+ * @param[in,out]	arr	-	array to shuffle
+ * @param[in]	num	-	number of elements
+ *
+ * @return	void
+ */
+static void
+bench_shuffle(void **arr, int num)
+{
+	unsigned long long seed = 88172645463325252ULL;
+
+	for (int i = num - 1; i > 0; i--) {
+		int j;
+		void *tmp;
+
+		seed ^= seed << 13;
+		seed ^= seed >> 7;
+		seed ^= seed << 17;
+		j = seed % (i + 1);
+		tmp = arr[i];
+		arr[i] = arr[j];
+		arr[j] = tmp;
+	}
+}
+
+/**
+ * @brief
+ * 		count where two arrays differ
+ *
+ * @return	int
+ */
+static int
+bench_mismatches(void **a1, void **a2, int num)
+{
+	int mismatch = 0;
+
+	for (int i = 0; i < num; i++) {
+		if (a1[i] != a2[i])
+			mismatch++;
+	}
+	return mismatch;
+}
+
+/**
+ * @brief
+ * 		The entry point of pbs_sched_sort_bench
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	1	: orders differ or error
+ */
+int
+main(int argc, char *argv[])
+{
+	int num_jobs = BENCH_DEFAULT_JOBS;
+	int num_nodes = BENCH_DEFAULT_NODES;
+	int num_runs = BENCH_DEFAULT_RUNS;
+	int nthreads = 1;
+	std::vector<sort_info> job_sort;
+	std::vector<sort_info> node_sort;
+	std::vector<group_info *> groups;
+	resource_resv **jobs1;
+	resource_resv **jobs2;
+	node_info **nodes1;
+	node_info **nodes2;
+	double start;
+	double qsort_time;
+	double key_time;
+	int mismatch = 0;
+	int c;
+	int i;
+
+	while ((c = getopt(argc, argv, "j:n:r:t:")) != -1) {
+		switch (c) {
+			case 'j':
+				num_jobs = atoi(optarg);
+				break;
+			case 'n':
+				num_nodes = atoi(optarg);
+				break;
+			case 'r':
+				num_runs = atoi(optarg);
+				break;
+			case 't':
+				nthreads = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-j num_jobs] [-n num_nodes] [-r num_runs] [-t num_threads]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (num_nodes < BENCH_NODES_PER_RUN)
+		num_nodes = BENCH_NODES_PER_RUN;
+
+	if (!init_multi_threading(nthreads)) {
+		fprintf(stderr, "can not start worker threads\n");
+		return 1;
+	}
+
+	auto ncpus = bench_add_resdef("ncpus", ATR_TYPE_LONG);
+	auto mem = bench_add_resdef("mem", ATR_TYPE_SIZE);
+
+	job_sort.push_back(sort_info{"ncpus", ncpus, DESC, RF_REQUEST});
+	job_sort.push_back(sort_info{SORT_JOB_PRIORITY, NULL, DESC, RF_NONE});
+	node_sort.push_back(sort_info{"ncpus", ncpus, DESC, RF_UNUSED});
+	node_sort.push_back(sort_info{"mem", mem, ASC, RF_AVAIL});
+	cstat.sort_by = &job_sort;
+	cstat.node_sort = &node_sort;
+
+	auto sinfo = new server_info("bench");
+	sinfo->policy = new status();
+	sinfo->policy->fair_share = 1;
+
+	auto root = new group_info("root");
+	root->gpath.push_back(root);
+	for (i = 0; i < BENCH_GROUPS; i++) {
+		char name[32];
+
+		snprintf(name, sizeof(name), "group%d", i);
+		auto ginfo = new group_info(name);
+		ginfo->tree_percentage = 1.0 / BENCH_GROUPS;
+		ginfo->temp_usage = 1 + (i * 37) % 11;
+		ginfo->gpath.push_back(root);
+		ginfo->gpath.push_back(ginfo);
+		groups.push_back(ginfo);
+	}
+
+	jobs1 = static_cast<resource_resv **>(calloc(num_jobs + 1, sizeof(resource_resv *)));
+	jobs2 = static_cast<resource_resv **>(calloc(num_jobs + 1, sizeof(resource_resv *)));
+	nodes1 = static_cast<node_info **>(calloc(num_nodes + 1, sizeof(node_info *)));
+	nodes2 = static_cast<node_info **>(calloc(num_nodes + 1, sizeof(node_info *)));
+	if (jobs1 == NULL || jobs2 == NULL || nodes1 == NULL || nodes2 == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	for (i = 0; i < num_jobs; i++) {
+		char name[PBS_MAXSVRJOBID + 1];
+		char val[64];
+
+		snprintf(name, sizeof(name), "%d.bench", i);
+		auto resresv = new resource_resv(name);
+		resresv->is_job = 1;
+		resresv->rank = i + 1;
+		resresv->qrank = i % 1000;
+		resresv->server = sinfo;
+		resresv->job = new_job_info();
+		resresv->job->is_queued = (i % 10) != 0;
+		resresv->job->preempt = 10 * (i % 3);
+		resresv->job->time_preempted = (i % 50) == 0 ? i : UNSPECIFIED;
+		resresv->job->formula_value = (i * 7919L) % 100;
+		resresv->job->priority = i % 1024;
+		resresv->job->ginfo = groups[i % BENCH_GROUPS];
+		snprintf(val, sizeof(val), "%d", 1 + i % 64);
+		resresv->resreq = create_resource_req("ncpus", val);
+		jobs1[i] = resresv;
+	}
+
+	for (i = 0; i < num_nodes; i++) {
+		char name[PBS_MAXHOSTNAME + 1];
+		char val[64];
+
+		snprintf(name, sizeof(name), "node%d", i);
+		auto ninfo = new node_info(name);
+		ninfo->rank = i + 1;
+		snprintf(val, sizeof(val), "%d", 64);
+		ninfo->res = create_resource("ncpus", val, RF_AVAIL);
+		ninfo->res->assigned = (i * 7919L) % 64;
+		snprintf(val, sizeof(val), "%dgb", 64 * (1 + i % 4));
+		ninfo->res->next = create_resource("mem", val, RF_AVAIL);
+		nodes1[i] = ninfo;
+	}
+
+	bench_shuffle(reinterpret_cast<void **>(jobs1), num_jobs);
+	memcpy(jobs2, jobs1, num_jobs * sizeof(resource_resv *));
+	bench_shuffle(reinterpret_cast<void **>(nodes1), num_nodes);
+	memcpy(nodes2, nodes1, num_nodes * sizeof(node_info *));
+
+	printf("jobs: %d\n", num_jobs);
+	printf("nodes: %d\n", num_nodes);
+	printf("threads: %d\n", num_threads);
+
+	start = bench_time();
+	qsort(jobs1, num_jobs, sizeof(resource_resv *), cmp_sort);
+	qsort_time = bench_time() - start;
+
+	start = bench_time();
+	sort_job_array(jobs2, num_jobs);
+	key_time = bench_time() - start;
+	mismatch += bench_mismatches(reinterpret_cast<void **>(jobs1), reinterpret_cast<void **>(jobs2), num_jobs);
+
+	printf("sort jobs qsort: %.3fs\n", qsort_time);
+	printf("sort jobs keys: %.3fs\n", key_time);
+	if (key_time > 0)
+		printf("sort jobs speedup: %.1fx\n", qsort_time / key_time);
+
+	start = bench_time();
+	qsort(nodes1, num_nodes, sizeof(node_info *), multi_node_sort);
+	qsort_time = bench_time() - start;
+
+	start = bench_time();
+	sort_node_array(nodes2, num_nodes);
+	key_time = bench_time() - start;
+	mismatch += bench_mismatches(reinterpret_cast<void **>(nodes1), reinterpret_cast<void **>(nodes2), num_nodes);
+
+	printf("sort nodes qsort: %.3fs\n", qsort_time);
+	printf("sort nodes keys: %.3fs\n", key_time);
+	if (key_time > 0)
+		printf("sort nodes speedup: %.1fx\n", qsort_time / key_time);
+
+	/* run jobs on the nodes at the front, the way the nodes are re-sorted
+	 * after each job run when sorting by unused resources
+	 */
+	qsort_time = 0;
+	key_time = 0;
+	for (int r = 0; r < num_runs; r++) {
+		std::vector<nspec *> ns_arr;
+
+		for (i = 0; i < BENCH_NODES_PER_RUN; i++) {
+			nspec *ns = new nspec();
+
+			ns->ninfo = nodes1[i];
+			ns->ninfo->res->assigned += 1 + (r + i) % 8;
+			ns_arr.push_back(ns);
+		}
+
+		start = bench_time();
+		qsort(nodes1, num_nodes, sizeof(node_info *), multi_node_sort);
+		qsort_time += bench_time() - start;
+
+		start = bench_time();
+		sort_moved_nodes(nodes2, num_nodes, ns_arr);
+		key_time += bench_time() - start;
+		mismatch += bench_mismatches(reinterpret_cast<void **>(nodes1), reinterpret_cast<void **>(nodes2), num_nodes);
+
+		for (auto ns : ns_arr)
+			delete ns;
+	}
+
+	printf("runs: %d\n", num_runs);
+	printf("re-sort nodes qsort: %.3fs\n", qsort_time);
+	printf("re-sort moved nodes: %.3fs\n", key_time);
+	if (key_time > 0)
+		printf("re-sort speedup: %.1fx\n", qsort_time / key_time);
+	printf("mismatches: %d\n", mismatch);
+
+	if (num_threads > 1)
+		kill_threads();
+
+	return mismatch != 0;
+}
@@ -313,7 +313,7 @@ update_sj_parent(job *parent, job *sj, char *sjid, char oldstate, char newstate)
 				set_jattr_l_slim(parent, JOB_ATR_stageout_status, e, SET);
 		}
 	}
-	job_save_db(parent);
+	job_save_db_async(parent);
 }
 
 /**
@@ -0,0 +1,367 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+
+/**
+ * @file    dis_bench.c
+ *
+ * @brief
+ * 		dis_bench.c - benchmark of the DIS codec.
+ *		Records shaped like the attribute entries of a status reply
+ *		(counts, names, values, flags, times and floats) are encoded
+ *		into memory and decoded back, once with the ASCII encoding and
+ *		once with the binary one, and for each the encoded size and the
+ *		encode and decode throughput are reported.  Every decoded value
+ *		is checked against the one encoded.
+ *
+ *	usage: pbs_dis_bench [-n records] [-r rounds]
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "pbs_ifl.h"
+#include "dis.h"
+#include "pbs_client_thread.h"
+
+#define BENCH_DEFAULT_RECORDS 200000
+#define BENCH_DEFAULT_ROUNDS 3
+#define BENCH_VALUES_PER_RECORD 9
+#define BENCH_FLUSH_RECORDS 100 /* records per packet, as a reply of a few jobs */
+#define BENCH_FD 0
+
+static pbs_tcp_chan_t *bench_chan = NULL;
+static char *bench_mem = NULL; /* what was sent, read back by the decoder */
+static size_t bench_mem_size = 0;
+static size_t bench_wpos = 0;
+static size_t bench_rpos = 0;
+
+static const char *bench_names[] = {
+	"Job_Name", "Job_Owner", "resources_used", "job_state", "queue",
+	"Resource_List", "exec_host", "ctime", "Variable_List"};
+#define BENCH_NUM_NAMES (sizeof(bench_names) / sizeof(bench_names[0]))
+
+/**
+ * @brief
+ * 		current monotonic time in nanoseconds
+ *
+ * @return	long long
+ */
+static long long
+bench_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief
+ * 		in-memory transport: the channel of the only stream
+ */
+static pbs_tcp_chan_t *
+bench_get_chan(int fd)
+{
+	return bench_chan;
+}
+
+/**
+ * @brief
+ * 		in-memory transport: set the channel of the only stream
+ */
+static int
+bench_set_chan(int fd, pbs_tcp_chan_t *chan)
+{
+	bench_chan = chan;
+	return 0;
+}
+
+/**
+ * @brief
+ * 		in-memory transport: append sent bytes to the memory buffer
+ */
+static int
+bench_send(int fd, void *data, int len)
+{
+	if (bench_wpos + len > bench_mem_size) {
+		size_t size = bench_mem_size ? bench_mem_size * 2 : 1024 * 1024;
+		char *tmp;
+
+		while (bench_wpos + len > size)
+			size *= 2;
+		if ((tmp = realloc(bench_mem, size)) == NULL)
+			return -1;
+		bench_mem = tmp;
+		bench_mem_size = size;
+	}
+	memcpy(bench_mem + bench_wpos, data, len);
+	bench_wpos += len;
+	return len;
+}
+
+/**
+ * @brief
+ * 		in-memory transport: read back what was sent
+ */
+static int
+bench_recv(int fd, void *data, int len)
+{
+	if (bench_rpos + len > bench_wpos)
+		return -1;
+	memcpy(data, bench_mem + bench_rpos, len);
+	bench_rpos += len;
+	return len;
+}
+
+/**
+ * @brief
+ * 		encode the records
+ *
+ * @param[in]	num_records	-	number of records
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	!=0	: DIS error
+ */
+static int
+bench_encode(int num_records)
+{
+	int rc = 0;
+	int i;
+
+	for (i = 0; i < num_records && rc == 0; i++) {
+		const char *name = bench_names[i % BENCH_NUM_NAMES];
+
+		rc = diswui(BENCH_FD, i);
+		if (rc == 0)
+			rc = diswst(BENCH_FD, name);
+		if (rc == 0)
+			rc = diswst(BENCH_FD, "walltime");
+		if (rc == 0)
+			rc = diswst(BENCH_FD, "user@host.example.com");
+		if (rc == 0)
+			rc = diswui(BENCH_FD, 0x40);
+		if (rc == 0)
+			rc = diswsi(BENCH_FD, -i);
+		if (rc == 0)
+			rc = diswul(BENCH_FD, 1700000000UL + i);
+		if (rc == 0)
+			rc = diswull(BENCH_FD, 0xFFFFFFFFFFFFULL - i);
+		if (rc == 0)
+			rc = diswf(BENCH_FD, (i % 1000) * 0.25);
+		if (rc == 0 && (i % BENCH_FLUSH_RECORDS) == BENCH_FLUSH_RECORDS - 1)
+			rc = dis_flush(BENCH_FD);
+	}
+	if (rc == 0)
+		rc = dis_flush(BENCH_FD);
+	return rc;
+}
+
+/**
+ * @brief
+ * 		compare a decoded string with the one encoded and free it
+ *
+ * @return	int
+ * @retval	0	: same
+ * @retval	1	: different or DIS error
+ */
+static int
+bench_check_str(char *s, int rc, const char *expect)
+{
+	int bad = (rc != 0 || s == NULL || strcmp(s, expect) != 0);
+
+	free(s);
+	return bad;
+}
+
+/**
+ * @brief
+ * 		decode the records and check every value
+ *
+ * @param[in]	num_records	-	number of records
+ *
+ * @return	long
+ * @retval	number of values which did not decode to what was encoded
+ */
+static long
+bench_decode(int num_records)
+{
+	long bad = 0;
+	int rc;
+	int i;
+
+	for (i = 0; i < num_records; i++) {
+		if (disrui(BENCH_FD, &rc) != (unsigned int) i || rc)
+			bad++;
+		bad += bench_check_str(disrst(BENCH_FD, &rc), rc, bench_names[i % BENCH_NUM_NAMES]);
+		bad += bench_check_str(disrst(BENCH_FD, &rc), rc, "walltime");
+		bad += bench_check_str(disrst(BENCH_FD, &rc), rc, "user@host.example.com");
+		if (disrui(BENCH_FD, &rc) != 0x40 || rc)
+			bad++;
+		if (disrsi(BENCH_FD, &rc) != -i || rc)
+			bad++;
+		if (disrul(BENCH_FD, &rc) != 1700000000UL + i || rc)
+			bad++;
+		if (disrull(BENCH_FD, &rc) != 0xFFFFFFFFFFFFULL - i || rc)
+			bad++;
+		if (disrf(BENCH_FD, &rc) != (float) ((i % 1000) * 0.25) || rc)
+			bad++;
+		if (bad != 0)
+			break;
+	}
+	return bad;
+}
+
+/**
+ * @brief
+ * 		run the benchmark with one encoding and report the results
+ *
+ * @param[in]	num_records	-	number of records
+ * @param[in]	rounds	-	encode/decode rounds, the best one is reported
+ * @param[in]	binary	-	use the binary encoding
+ *
+ * @return	int
+ * @retval	0	: every value round-tripped
+ * @retval	1	: error
+ */
+static int
+bench_run(int num_records, int rounds, int binary)
+{
+	long long enc;
+	long long dec;
+	long long best_enc = 0;
+	long long best_dec = 0;
+	double values = (double) num_records * BENCH_VALUES_PER_RECORD;
+	double mb;
+	int r;
+
+	for (r = 0; r < rounds; r++) {
+		bench_wpos = 0;
+		bench_rpos = 0;
+		dis_set_binary(BENCH_FD, binary);
+
+		enc = bench_nsec();
+		if (bench_encode(num_records) != 0) {
+			fprintf(stderr, "%s: encode failed\n", binary ? "binary" : "ascii");
+			return 1;
+		}
+		enc = bench_nsec() - enc;
+
+		dec = bench_nsec();
+		if (bench_decode(num_records) != 0) {
+			fprintf(stderr, "%s: decoded values differ from the encoded ones\n", binary ? "binary" : "ascii");
+			return 1;
+		}
+		dec = bench_nsec() - dec;
+		if (bench_rpos != bench_wpos) {
+			fprintf(stderr, "%s: %zu of %zu bytes decoded\n", binary ? "binary" : "ascii", bench_rpos, bench_wpos);
+			return 1;
+		}
+
+		if (r == 0 || enc < best_enc)
+			best_enc = enc;
+		if (r == 0 || dec < best_dec)
+			best_dec = dec;
+	}
+
+	mb = bench_wpos / (1024.0 * 1024.0);
+	printf("%-6s: %d records, %.2fMB, encode %.3fs %.1fMB/s %.0f values/s, "
+	       "decode %.3fs %.1fMB/s %.0f values/s\n",
+	       binary ? "binary" : "ascii", num_records, mb,
+	       best_enc / 1e9, mb / (best_enc / 1e9), values / (best_enc / 1e9),
+	       best_dec / 1e9, mb / (best_dec / 1e9), values / (best_dec / 1e9));
+	return 0;
+}
+
+/**
+ * @brief
+ * 		The entry point of pbs_dis_bench
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	1	: values did not round-trip or error
+ */
+int
+main(int argc, char *argv[])
+{
+	int num_records = BENCH_DEFAULT_RECORDS;
+	int rounds = BENCH_DEFAULT_ROUNDS;
+	int rc = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:r:")) != -1) {
+		switch (c) {
+			case 'n':
+				num_records = atoi(optarg);
+				break;
+			case 'r':
+				rounds = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-n records] [-r rounds]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (num_records < 1 || rounds < 1) {
+		fprintf(stderr, "records and rounds must be positive\n");
+		return 1;
+	}
+
+	/* sets up the DIS tables */
+	if (pbs_client_thread_init_thread_context() != 0) {
+		fprintf(stderr, "cannot initialize the thread context\n");
+		return 1;
+	}
+	pfn_transport_get_chan = bench_get_chan;
+	pfn_transport_set_chan = bench_set_chan;
+	pfn_transport_recv = bench_recv;
+	pfn_transport_send = bench_send;
+	dis_setup_chan(BENCH_FD, bench_get_chan);
+
+	rc |= bench_run(num_records, rounds, 0);
+	rc |= bench_run(num_records, rounds, 1);
+
+	dis_destroy_chan(BENCH_FD);
+	free(bench_mem);
+	return rc;
+}
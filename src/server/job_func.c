@@ -314,6 +314,9 @@ job_delete_attr(job *pjob, int attr_idx)
 	db_attr_list.attr_count = 0;
 	CLEAR_HEAD(db_attr_list.attrs);
 
+	/* a queued save of the attribute must not bring it back */
+	job_save_wait(pjob);
+
 	if (is_jattr_set(pjob, attr_idx)) {
 		attr_def = job_attr_def[attr_idx];
 		if ((index = find_attr(job_attr_idx, job_attr_def, attr_def.at_name)) < 0) {
@@ -416,6 +419,7 @@ job_alloc(void)
 	pj->ji_deletehistory = 0;
 	pj->ji_script = NULL;
 	pj->ji_prov_startjob_task = NULL;
+	pj->ji_histidx = -1;
 #endif
 	pj->ji_qs.ji_jsversion = JSVERSION;
 	pj->ji_momhandle = -1;		/* mark mom connection invalid */
@@ -551,6 +555,7 @@ job_free(job *pj)
 		badplace *bp;
 
 		free_job_work_tasks(pj);
+		svr_histjob_unindex(pj);
 
 		/* free any bad destination structs */
 
@@ -1245,6 +1250,7 @@ job_purge(job *pjob)
 
 #else
 	/* delete job and dependants from database */
+	job_save_wait(pjob);
 	obj.pbs_db_obj_type = PBS_DB_JOB;
 	obj.pbs_db_un.pbs_db_job = &dbjob;
 	strcpy(dbjob.ji_jobid, pjob->ji_qs.ji_jobid);
@@ -49,9 +49,13 @@
 #include <fcntl.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <time.h>
 
 #include <unistd.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/time.h>
 #include "server_limits.h"
 #include "list_link.h"
 #include "attribute.h"
@@ -61,13 +65,16 @@
 #include "log.h"
 #include "pbs_nodes.h"
 #include "svrfunc.h"
+#include "work_task.h"
 #include <memory.h>
 #include "libutil.h"
 #include "pbs_db.h"
 
 #define MAX_SAVE_TRIES 3
+#define JOB_SAVE_STATS_INTERVAL 600 /* seconds between logging write-behind stats */
 
 extern void *svr_db_conn;
+extern char conn_db_host[];
 extern int server_init_type;
 extern pbs_list_head svr_allresvs;
 #define BACKTRACE_BUF_SIZE 50
@@ -79,6 +86,48 @@ extern time_t time_now;
 job *recov_job_cb(pbs_db_obj_info_t *dbobj, int *refreshed);
 resc_resv *recov_resv_cb(pbs_db_obj_info_t *dbobj, int *refreshed);
 
+/*
+ * Write-behind job saves
+ *
+ * job_save_db_async() converts the job to its database form right away,
+ * on the main thread, and queues it for the DB thread, which commits
+ * whatever is queued in one transaction over its own connection.  A job
+ * saved again before the DB thread took its previous save has the two
+ * merged into one row update.  Saves are committed in the order queued,
+ * job_save_wait() waits for those of a job to be committed.
+ */
+typedef struct job_save_ent {
+	struct job_save_ent *next;
+	unsigned long seq;	 /* order in which saves were queued */
+	int savetype;		 /* OBJ_SAVE_QS and such */
+	struct timeval queued;	 /* when first queued, for the save latency */
+	pbs_db_job_info_t dbjob; /* what to save */
+} job_save_ent_t;
+
+static struct {
+	pthread_mutex_t mutex;
+	pthread_cond_t work;	     /* tells DB thread saves are queued */
+	pthread_cond_t done;	     /* tells waiters saves were committed */
+	pthread_t thread;
+	int running;		     /* DB thread is connected and taking saves */
+	int stop;		     /* DB thread to exit once the queue is empty */
+	int failed;		     /* DB thread could not commit, errmsg says why */
+	char *errmsg;
+	job_save_ent_t *head;	     /* queued saves not yet taken */
+	job_save_ent_t *tail;
+	unsigned long seq;	     /* seq of the last queued save */
+	unsigned long taken;	     /* seq of the last save taken by DB thread */
+	unsigned long committed;     /* seq of the last save committed */
+	/* stats since last logged */
+	unsigned long nsaves;	     /* job_save_db_async() calls */
+	unsigned long ncoalesced;    /* saves merged into a queued one */
+	unsigned long nbatches;	     /* transactions committed */
+	unsigned long nrows;	     /* rows saved by those */
+	unsigned long maxbatch;	     /* most rows in one transaction */
+	double latency;		     /* total of queued to committed seconds */
+	double maxlatency;
+} jsq = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER};
+
 /**
  * @brief
  *		convert job structure to DB format
@@ -237,6 +286,9 @@ job_save_db(job *pjob)
 	int old_mtime, old_flags;
 	char *conn_db_err = NULL;
 
+	/* earlier write-behind saves of the job must not overwrite this one */
+	job_save_wait(pjob);
+
 	old_mtime = get_jattr_long(pjob, JOB_ATR_mtime);
 	old_flags = (get_jattr(pjob, JOB_ATR_mtime))->at_flags;
 
@@ -274,6 +326,416 @@ done:
 	return (rc);
 }
 
+/**
+ * @brief
+ *	Merge a save of a job into a queued one of the same job that the DB
+ *	thread has not taken yet.  Attributes of the later save replace those
+ *	of the same name and resource in the earlier one.
+ *
+ * @param[in,out] pent - the queued save
+ * @param[in]	  dbjob - the later save, its attribute list is emptied
+ * @param[in]	  savetype - savetype of the later save
+ *
+ * @return void
+ *
+ * @par MT-safe: No, call with jsq.mutex held
+ */
+static void
+job_save_merge(job_save_ent_t *pent, pbs_db_job_info_t *dbjob, int savetype)
+{
+	svrattrl *pal;
+	svrattrl *pold;
+	svrattrl *pnext;
+
+	/*
+	 * job_to_db() fills the quick save fields only when they changed,
+	 * otherwise those of the earlier save are still the latest
+	 */
+	if (savetype & OBJ_SAVE_QS)
+		memcpy(&pent->dbjob, dbjob, offsetof(pbs_db_job_info_t, db_attr_list));
+	pent->savetype |= savetype;
+
+	while ((pal = (svrattrl *) GET_NEXT(dbjob->db_attr_list.attrs)) != NULL) {
+		delete_link(&pal->al_link);
+		for (pold = (svrattrl *) GET_NEXT(pent->dbjob.db_attr_list.attrs); pold; pold = pnext) {
+			pnext = (svrattrl *) GET_NEXT(pold->al_link);
+			if (strcmp(pold->al_name, pal->al_name) != 0)
+				continue;
+			if ((pold->al_resc == NULL) != (pal->al_resc == NULL))
+				continue;
+			if (pold->al_resc && strcmp(pold->al_resc, pal->al_resc) != 0)
+				continue;
+			delete_link(&pold->al_link);
+			free(pold);
+			pent->dbjob.db_attr_list.attr_count--;
+		}
+		append_link(&pent->dbjob.db_attr_list.attrs, &pal->al_link, pal);
+		pent->dbjob.db_attr_list.attr_count++;
+	}
+	dbjob->db_attr_list.attr_count = 0;
+}
+
+/**
+ * @brief
+ *	Free a write-behind save entry
+ *
+ * @param[in]	pent - entry to free
+ *
+ * @return void
+ */
+static void
+job_save_free(job_save_ent_t *pent)
+{
+	free_db_attr_list(&pent->dbjob.db_attr_list);
+	free(pent);
+}
+
+/**
+ * @brief
+ *	Save job to database from the DB thread, the job's attributes
+ *	are converted right away, committing them is left to the DB thread.
+ *	New jobs, and all saves when the DB thread is not running, are saved
+ *	synchronously through job_save_db().
+ *
+ * @param[in]	pjob - The job to save
+ *
+ * @return      Error code
+ * @retval	 0 - Success
+ * @retval	-1 - Failure
+ *
+ * @par MT-safe: No
+ */
+int
+job_save_db_async(job *pjob)
+{
+	job_save_ent_t *pent;
+	job_save_ent_t *pend;
+	int savetype;
+
+	if (!jsq.running || pjob->newobj)
+		return (job_save_db(pjob));
+
+	job_save_check();
+
+	if ((pent = calloc(1, sizeof(job_save_ent_t))) == NULL) {
+		log_err(errno, __func__, "Out of memory");
+		return (job_save_db(pjob));
+	}
+	CLEAR_HEAD(pent->dbjob.db_attr_list.attrs);
+
+	if ((savetype = job_to_db(pjob, &pent->dbjob)) == -1) {
+		job_save_free(pent);
+		log_errf(PBSE_INTERNAL, __func__, "Failed to save job %s", pjob->ji_qs.ji_jobid);
+		panic_stop_db();
+		return -1;
+	}
+
+	/* nothing changed since the last save */
+	if (savetype == 0 && pent->dbjob.db_attr_list.attr_count == 0) {
+		job_save_free(pent);
+		return 0;
+	}
+
+	/* as in job_save_db(), mtime is that of the save, the DB gets it too */
+	set_jattr_l_slim(pjob, JOB_ATR_mtime, time_now, SET);
+	pent->savetype = savetype;
+	gettimeofday(&pent->queued, NULL);
+
+	pthread_mutex_lock(&jsq.mutex);
+	jsq.nsaves++;
+	pend = (job_save_ent_t *) pjob->ji_savepend;
+	if (pend != NULL && pjob->ji_saveseq > jsq.taken) {
+		job_save_merge(pend, &pent->dbjob, savetype);
+		jsq.ncoalesced++;
+		pthread_mutex_unlock(&jsq.mutex);
+		job_save_free(pent);
+		return 0;
+	}
+	pent->seq = ++jsq.seq;
+	if (jsq.tail)
+		jsq.tail->next = pent;
+	else
+		jsq.head = pent;
+	jsq.tail = pent;
+	pjob->ji_saveseq = pent->seq;
+	pjob->ji_savepend = pent;
+	pthread_cond_signal(&jsq.work);
+	pthread_mutex_unlock(&jsq.mutex);
+
+	return 0;
+}
+
+/**
+ * @brief
+ *	Wait until the write-behind saves of a job are in the database
+ *
+ * @param[in]	pjob - the job
+ *
+ * @return void
+ *
+ * @par MT-safe: No
+ */
+void
+job_save_wait(job *pjob)
+{
+	if (pjob->ji_saveseq == 0)
+		return;
+
+	pthread_mutex_lock(&jsq.mutex);
+	while (jsq.committed < pjob->ji_saveseq && jsq.running && !jsq.failed)
+		pthread_cond_wait(&jsq.done, &jsq.mutex);
+	pthread_mutex_unlock(&jsq.mutex);
+
+	job_save_check();
+	pjob->ji_saveseq = 0;
+	pjob->ji_savepend = NULL;
+}
+
+/**
+ * @brief
+ *	Stop the server if the DB thread failed to commit saves,
+ *	as job_save_db() does when a save fails.
+ *
+ * @return void
+ *
+ * @par MT-safe: No
+ */
+void
+job_save_check(void)
+{
+	if (!jsq.failed)
+		return;
+
+	log_errf(PBSE_INTERNAL, __func__, "Failed to save jobs %s", jsq.errmsg ? jsq.errmsg : "");
+	panic_stop_db();
+}
+
+/**
+ * @brief
+ *	Commit a batch of write-behind saves in one transaction
+ *
+ * @param[in]	conn - DB thread's connection
+ * @param[in]	head - saves to commit, in order
+ *
+ * @return	int
+ * @retval	0 - Success
+ * @retval	-1 - Failure
+ */
+static int
+job_save_batch(void *conn, job_save_ent_t *head)
+{
+	job_save_ent_t *pent;
+	pbs_db_obj_info_t obj;
+
+	if (pbs_db_begin_trx(conn) != 0)
+		return -1;
+
+	obj.pbs_db_obj_type = PBS_DB_JOB;
+	for (pent = head; pent; pent = pent->next) {
+		obj.pbs_db_un.pbs_db_job = &pent->dbjob;
+		/* 1 is a job gone from the DB already, which is no error */
+		if (pbs_db_save_obj(conn, &obj, pent->savetype) == -1) {
+			pbs_db_end_trx(conn, 0);
+			return -1;
+		}
+	}
+
+	return (pbs_db_end_trx(conn, 1));
+}
+
+/**
+ * @brief
+ *	DB thread: take whatever saves are queued, and commit them in one
+ *	transaction, until told to stop.  Only talks to the main thread
+ *	through jsq, logging is left to the main thread.
+ *
+ * @param[in]	arg - unused
+ *
+ * @return void *
+ */
+static void *
+job_save_thread(void *arg)
+{
+	sigset_t set;
+	void *conn = NULL;
+	job_save_ent_t *head;
+	job_save_ent_t *pent;
+	job_save_ent_t *pnext;
+	struct timeval now;
+	unsigned long n;
+	double lat;
+	char *conn_db_err = NULL;
+	int rc;
+
+	sigfillset(&set);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+	rc = pbs_db_connect(&conn, conn_db_host, pbs_conf.pbs_data_service_port, PBS_DB_CNT_TIMEOUT_NORMAL);
+
+	pthread_mutex_lock(&jsq.mutex);
+	jsq.running = (rc == 0);
+	jsq.failed = (rc != 0);
+	pthread_cond_broadcast(&jsq.done);
+	if (rc != 0) {
+		pthread_mutex_unlock(&jsq.mutex);
+		return NULL;
+	}
+
+	for (;;) {
+		while (jsq.head == NULL && !jsq.stop)
+			pthread_cond_wait(&jsq.work, &jsq.mutex);
+		if (jsq.head == NULL)
+			break;
+
+		head = jsq.head;
+		jsq.head = jsq.tail = NULL;
+		jsq.taken = jsq.seq;
+		pthread_mutex_unlock(&jsq.mutex);
+
+		rc = job_save_batch(conn, head);
+		if (rc != 0)
+			pbs_db_get_errmsg(PBS_DB_ERR, &conn_db_err);
+
+		gettimeofday(&now, NULL);
+		pthread_mutex_lock(&jsq.mutex);
+		if (rc != 0) {
+			jsq.failed = 1;
+			free(jsq.errmsg);
+			jsq.errmsg = conn_db_err;
+			conn_db_err = NULL;
+		}
+		for (n = 0, pent = head; pent; pent = pnext, n++) {
+			pnext = pent->next;
+			if (rc == 0) {
+				jsq.committed = pent->seq;
+				lat = (now.tv_sec - pent->queued.tv_sec) + (now.tv_usec - pent->queued.tv_usec) / 1000000.0;
+				jsq.latency += lat;
+				if (lat > jsq.maxlatency)
+					jsq.maxlatency = lat;
+			}
+			job_save_free(pent);
+		}
+		if (rc == 0) {
+			jsq.nbatches++;
+			jsq.nrows += n;
+			if (n > jsq.maxbatch)
+				jsq.maxbatch = n;
+		}
+		pthread_cond_broadcast(&jsq.done);
+		if (rc != 0)
+			break;
+	}
+	jsq.running = 0;
+	pthread_cond_broadcast(&jsq.done);
+	pthread_mutex_unlock(&jsq.mutex);
+
+	pbs_db_disconnect(conn);
+	return NULL;
+}
+
+/**
+ * @brief
+ *	Log and reset the write-behind save statistics
+ *
+ * @param[in]	ptask - work task
+ *
+ * @return void
+ */
+static void
+job_save_stats_log(struct work_task *ptask)
+{
+	if (ptask)
+		(void) set_task(WORK_Timed, time_now + JOB_SAVE_STATS_INTERVAL, job_save_stats_log, NULL);
+
+	if (!will_log_event(PBSEVENT_DEBUG2))
+		return;
+
+	pthread_mutex_lock(&jsq.mutex);
+	log_eventf(PBSEVENT_DEBUG2, PBS_EVENTCLASS_SERVER, LOG_DEBUG, __func__,
+		   "job saves=%lu coalesced=%lu transactions=%lu rows/transaction avg=%.1f max=%lu latency avg=%.3fs max=%.3fs",
+		   jsq.nsaves, jsq.ncoalesced, jsq.nbatches,
+		   jsq.nbatches ? (double) jsq.nrows / jsq.nbatches : 0.0, jsq.maxbatch,
+		   jsq.nrows ? jsq.latency / jsq.nrows : 0.0, jsq.maxlatency);
+	jsq.nsaves = jsq.ncoalesced = jsq.nbatches = jsq.nrows = jsq.maxbatch = 0;
+	jsq.latency = jsq.maxlatency = 0;
+	pthread_mutex_unlock(&jsq.mutex);
+}
+
+/**
+ * @brief
+ *	In a child of the server, saves are never made from the DB thread,
+ *	which the child does not have.
+ */
+static void
+job_save_atfork_child(void)
+{
+	pthread_mutex_init(&jsq.mutex, NULL);
+	pthread_cond_init(&jsq.work, NULL);
+	pthread_cond_init(&jsq.done, NULL);
+	jsq.running = 0;
+}
+
+/**
+ * @brief
+ *	Start the DB thread for write-behind job saves, and wait for it
+ *	to connect to the database
+ *
+ * @return	int
+ * @retval	0 - Success
+ * @retval	-1 - Failure, job saves stay synchronous
+ */
+int
+init_job_save_queue(void)
+{
+	static int atfork_done = 0;
+
+	if (!atfork_done) {
+		if (pthread_atfork(NULL, NULL, job_save_atfork_child) != 0)
+			return -1;
+		atfork_done = 1;
+	}
+
+	jsq.stop = 0;
+	jsq.failed = 0;
+	if (pthread_create(&jsq.thread, NULL, job_save_thread, NULL) != 0)
+		return -1;
+
+	pthread_mutex_lock(&jsq.mutex);
+	while (!jsq.running && !jsq.failed)
+		pthread_cond_wait(&jsq.done, &jsq.mutex);
+	pthread_mutex_unlock(&jsq.mutex);
+
+	if (!jsq.running) {
+		pthread_join(jsq.thread, NULL);
+		jsq.failed = 0;
+		return -1;
+	}
+
+	(void) set_task(WORK_Timed, time_now + JOB_SAVE_STATS_INTERVAL, job_save_stats_log, NULL);
+	return 0;
+}
+
+/**
+ * @brief
+ *	Commit all queued saves and stop the DB thread
+ *
+ * @return void
+ */
+void
+shutdown_job_save_queue(void)
+{
+	if (!jsq.running)
+		return;
+
+	pthread_mutex_lock(&jsq.mutex);
+	jsq.stop = 1;
+	pthread_cond_signal(&jsq.work);
+	pthread_mutex_unlock(&jsq.mutex);
+
+	pthread_join(jsq.thread, NULL);
+	job_save_check();
+}
+
 /**
  * @brief
  *	Utility function called inside job_recov_db
@@ -332,6 +794,9 @@ job_recov_db(char *jid, job *pjob)
 
 	strcpy(dbjob.ji_jobid, jid);
 
+	if (pjob != NULL)
+		job_save_wait(pjob);
+
 	rc = pbs_db_load_obj(conn, &obj);
 	if (rc == -2)
 		return pjob; /* no change in job, return the same job */
@@ -0,0 +1,270 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+/**
+ * @file    log_bench.c
+ *
+ * @brief
+ * 		log_bench.c - benchmark of daemon event logging.
+ *		Threads log records as fast as they can, first with the log
+ *		written by the calling threads and then through the log writer
+ *		thread, and for each mode the records per second (until the
+ *		last record is in the file) and the time a caller spends in
+ *		log_record() are reported.  The records in each log file are
+ *		counted to check that none were lost.
+ *
+ *	usage: pbs_log_bench [-n records_per_thread] [-t threads] [-d directory] [-H]
+ *
+ */
+#include <pbs_config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <limits.h>
+
+#include "log.h"
+
+#define BENCH_DEFAULT_RECORDS 200000
+#define BENCH_DEFAULT_THREADS 4
+#define BENCH_OBJNAME "log_bench"
+
+static int num_records = BENCH_DEFAULT_RECORDS;
+
+/**
+ * @brief
+ * 		current monotonic time in nanoseconds
+ *
+ * @return	long long
+ */
+static long long
+bench_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/**
+ * @brief
+ * 		qsort comparison of latencies
+ */
+static int
+bench_cmp_lat(const void *a, const void *b)
+{
+	unsigned int la = *(const unsigned int *) a;
+	unsigned int lb = *(const unsigned int *) b;
+
+	return (la > lb) - (la < lb);
+}
+
+/**
+ * @brief
+ * 		a logging thread: log num_records records and note how long
+ *		each log_record() call took
+ *
+ * @param[in]	arg	-	array to hold the latency of each record in ns
+ *
+ * @return	void *
+ */
+static void *
+bench_thread(void *arg)
+{
+	unsigned int *lat = (unsigned int *) arg;
+	char msg[LOG_BUF_SIZE];
+	long long start;
+	int i;
+
+	for (i = 0; i < num_records; i++) {
+		snprintf(msg, sizeof(msg), "Job Queued at request of user@host.example.com, owner = user@host.example.com, job name = STDIN, queue = workq, record %d", i);
+		start = bench_nsec();
+		log_record(PBSEVENT_JOB, PBS_EVENTCLASS_JOB, LOG_INFO, BENCH_OBJNAME, msg);
+		lat[i] = (unsigned int) (bench_nsec() - start);
+	}
+	return NULL;
+}
+
+/**
+ * @brief
+ * 		count the records the benchmark threads made in a log file
+ *
+ * @param[in]	path	-	the log file
+ *
+ * @return	long
+ */
+static long
+bench_count_records(const char *path)
+{
+	char line[LOG_BUF_SIZE * 2];
+	FILE *fp;
+	long count = 0;
+
+	if ((fp = fopen(path, "r")) == NULL)
+		return -1;
+	while (fgets(line, sizeof(line), fp) != NULL)
+		if (strstr(line, ";" BENCH_OBJNAME ";") != NULL)
+			count++;
+	fclose(fp);
+	return count;
+}
+
+/**
+ * @brief
+ * 		run the benchmark in one logging mode and report the results
+ *
+ * @param[in]	dir	-	directory for the log file
+ * @param[in]	num_threads	-	number of logging threads
+ * @param[in]	async	-	log through the log writer thread
+ *
+ * @return	int
+ * @retval	0	: all records are in the log file
+ * @retval	1	: records missing or error
+ */
+static int
+bench_run(const char *dir, int num_threads, int async)
+{
+	char path[PATH_MAX];
+	pthread_t *tids;
+	unsigned int *lat;
+	long total = (long) num_records * num_threads;
+	long found;
+	long long start;
+	long long elapsed;
+	int i;
+
+	snprintf(path, sizeof(path), "%s/pbs_log_bench.%ld.%s", dir, (long) getpid(), async ? "async" : "sync");
+	if (log_open(path, (char *) dir) != 0) {
+		fprintf(stderr, "cannot open log file %s\n", path);
+		return 1;
+	}
+	if (async && log_async_start() != 0) {
+		fprintf(stderr, "cannot start the log writer thread\n");
+		log_close(0);
+		return 1;
+	}
+
+	tids = (pthread_t *) malloc(num_threads * sizeof(pthread_t));
+	lat = (unsigned int *) malloc(total * sizeof(unsigned int));
+	if (tids == NULL || lat == NULL) {
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	start = bench_nsec();
+	for (i = 0; i < num_threads; i++)
+		pthread_create(&tids[i], NULL, bench_thread, lat + (long) i * num_records);
+	for (i = 0; i < num_threads; i++)
+		pthread_join(tids[i], NULL);
+	/* closing stops the writer thread once every record is written */
+	log_close(0);
+	elapsed = bench_nsec() - start;
+
+	qsort(lat, total, sizeof(unsigned int), bench_cmp_lat);
+	printf("%-5s: %d threads, %ld records in %.3fs, %.0f records/s, "
+	       "log_record() p50 %.2fus p99 %.2fus p99.9 %.2fus max %.2fus\n",
+	       async ? "async" : "sync", num_threads, total, elapsed / 1e9,
+	       total / (elapsed / 1e9),
+	       lat[total / 2] / 1e3, lat[total * 99 / 100] / 1e3,
+	       lat[total * 999 / 1000] / 1e3, lat[total - 1] / 1e3);
+
+	found = bench_count_records(path);
+	unlink(path);
+	free(tids);
+	free(lat);
+	if (found != total) {
+		fprintf(stderr, "%s: %ld of %ld records in the log file\n",
+			async ? "async" : "sync", found, total);
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ * 		The entry point of pbs_log_bench
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	1	: records lost or error
+ */
+int
+main(int argc, char *argv[])
+{
+	int num_threads = BENCH_DEFAULT_THREADS;
+	const char *dir = "/tmp";
+	int highres = 0;
+	int rc = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "n:t:d:H")) != -1) {
+		switch (c) {
+			case 'n':
+				num_records = atoi(optarg);
+				break;
+			case 't':
+				num_threads = atoi(optarg);
+				break;
+			case 'd':
+				dir = optarg;
+				break;
+			case 'H':
+				highres = 1;
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-n records_per_thread] [-t threads] [-d directory] [-H]\n", argv[0]);
+				return 1;
+		}
+	}
+	if (num_records < 1 || num_threads < 1) {
+		fprintf(stderr, "records and threads must be positive\n");
+		return 1;
+	}
+
+	set_msgdaemonname("pbs_log_bench");
+	set_log_conf(NULL, NULL, 0, 0, 0, highres);
+
+	rc |= bench_run(dir, num_threads, 0);
+	rc |= bench_run(dir, num_threads, 1);
+
+	return rc;
+}
@@ -4314,6 +4314,8 @@ is_request(int stream, int version)
 	job *pjob;
 	unsigned long ipaddr;
 	unsigned long port;
+	unsigned int dis_version;
+	int dis_ret;
 	struct sockaddr_in *addr;
 	struct pbsnode *np = NULL;
 	attribute *pala;
@@ -4369,6 +4371,10 @@ is_request(int stream, int version)
 
 		DBPRT(("%s: IS_HELLOSVR addr: %s, port %lu\n", __func__, netaddr(addr), port))
 
+		/* an older Mom does not offer binary DIS, reading it gives DIS_EOD */
+		dis_version = disrui(stream, &dis_ret);
+		dis_set_binary(stream, dis_ret == DIS_SUCCESS && dis_version >= DIS_BINARY_VERSION && pbs_conf.pbs_dis_binary);
+
 		if ((pmom = tfind2(ipaddr, port, &ipaddrs)) == NULL) {
 			badconstr = "tfind2:pmom";
 			goto badcon;
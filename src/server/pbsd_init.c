@@ -1432,6 +1432,12 @@ pbsd_init_job(job *pjob, int type)
 			case JOB_SUBSTATE_TERMINATED:
 				if (pbsd_init_reque(pjob, KEEP_STATE) == -1)
 					return -1;
+				if (!(is_jattr_set(pjob, JOB_ATR_history_timestamp))) {
+					svr_histjob_index(pjob);
+					if (is_jattr_set(pjob, JOB_ATR_history_timestamp))
+						job_save_db(pjob);
+				} else
+					svr_histjob_index(pjob);
 				break;
 
 			case JOB_SUBSTATE_RERUN:
@@ -1675,8 +1681,7 @@ static void
 change_logs(int sig)
 {
 	acct_close();
-	log_close(1);
-	log_open(log_file, path_log);
+	log_reopen(log_file, path_log);
 	(void) acct_open(acct_file);
 }
 
@@ -1129,6 +1129,21 @@ main(int argc, char **argv)
 		return (3);
 	}
 
+	/* start the threads sending large status replies */
+	if (init_reply_pool() != 0)
+		log_event(PBSEVENT_SYSTEM | PBSEVENT_ADMIN, PBS_EVENTCLASS_SERVER,
+			  LOG_WARNING, msg_daemonname, "could not start reply threads, replies sent by main thread");
+
+	/* start the thread saving job state changes to the database */
+	if (init_job_save_queue() != 0)
+		log_event(PBSEVENT_SYSTEM | PBSEVENT_ADMIN, PBS_EVENTCLASS_SERVER,
+			  LOG_WARNING, msg_daemonname, "could not start job save thread, jobs saved by main thread");
+
+	/* hand the writing of the server log to a writer thread */
+	if (pbs_conf.pbs_log_async && log_async_start() != 0)
+		log_event(PBSEVENT_SYSTEM | PBSEVENT_ADMIN, PBS_EVENTCLASS_SERVER,
+			  LOG_WARNING, msg_daemonname, "could not start log writer thread, logging synchronously");
+
 	sprintf(log_buffer, "Out of memory");
 	if (pbs_conf.pbs_leaf_name) {
 		char *p;
@@ -1405,6 +1420,9 @@ main(int argc, char **argv)
 			log_err(-1, msg_daemonname, "wait_requst failed");
 		}
 
+		/* stop if saving jobs to the database failed */
+		job_save_check();
+
 		if (reap_child_flag)  /* check again incase signal arrived */
 			reap_child(); /* before they were blocked          */
 
@@ -1427,6 +1445,9 @@ main(int argc, char **argv)
 	}
 	DBPRT(("Server out of main loop, state is %ld\n", state))
 
+	/* commit the queued job saves */
+	shutdown_job_save_queue();
+
 	/* set the current seq id to the last id before final save */
 	server.sv_qs.sv_lastid = server.sv_qs.sv_jobidnumber;
 	svr_save_db(&server); /* final recording of server */
@@ -1482,7 +1503,8 @@ main(int argc, char **argv)
 	pbs_python_ext_shutdown_interpreter(&svr_interp_data); /* stop python if started */
 
 	shutdown_ack();
-	net_close(-1); /* close all network connections */
+	shutdown_reply_pool(); /* finish sending replies before closing */
+	net_close(-1);	       /* close all network connections */
 	tpp_shutdown();
 
 	/*
@@ -0,0 +1,678 @@
+/*
+ * Copyright (C) 1994-2021 Altair Engineering, Inc.
+ * For more information, contact Altair at www.altair.com.
+ *
+ * This file is part of both the OpenPBS software ("OpenPBS")
+ * and the PBS Professional ("PBS Pro") software.
+ *
+ * Open Source License Information:
+ *
+ * OpenPBS is free software. You can redistribute it and/or modify it under
+ * the terms of the GNU Affero General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or (at your
+ * option) any later version.
+ *
+ * OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+ * License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Commercial License Information:
+ *
+ * PBS Pro is commercially licensed software that shares a common core with
+ * the OpenPBS software.  For a copy of the commercial license terms and
+ * conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+ * Altair Legal Department.
+ *
+ * Altair's dual-license business model allows companies, individuals, and
+ * organizations to create proprietary derivative works of OpenPBS and
+ * distribute them - whether embedded or bundled with other software -
+ * under a commercial license agreement.
+ *
+ * Use of Altair's trademarks, including but not limited to "PBS™",
+ * "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+ * subject to Altair's trademark licensing policies.
+ */
+
+
+/**
+ * @file    reply_pool.c
+ *
+ * @brief
+ * 		Send large status replies to clients from a pool of threads, so the
+ * 		main loop can go on serving other requests (e.g. qsub) while a big
+ * 		qstat reply is being encoded and written out.
+ *
+ * 		The status itself is still gathered by the main thread, which is the
+ * 		only thread looking at jobs, nodes, queues, etc., so every reply is a
+ * 		consistent snapshot of the server.  The reply is then detached from
+ * 		all server data, the connection is taken out of the poll lists and
+ * 		the reply is handed to a thread which encodes and sends it on the
+ * 		connection's own DIS channel.  A job status reply built in an arena
+ * 		(see status_job()) needs no detaching, its entries are its own and the
+ * 		cached encodings they point to are held by the arena, which is given
+ * 		back to the main thread to be destroyed once the reply is sent.
+ * 		A streamed job status (see status_stream()) is already encoded by
+ * 		the main thread into the DIS buffer of the connection; each part of
+ * 		it is handed over as that buffer, which the thread only has to write
+ * 		out, and the main thread goes on encoding the next part in a new one.
+ * 		All the parts of a reply (see
+ * 		reply_send_status_part()) go to the same thread, in order.  When the
+ * 		last part has been sent, the main thread is woken through a pipe and
+ * 		resumes polling the connection, or closes it if sending failed.
+ *
+ *	init_reply_pool()	- start the threads
+ *	shutdown_reply_pool()	- stop the threads once all replies are sent
+ *	reply_pool_send()	- hand a reply to the threads
+ *
+ */
+
+#include <pbs_config.h> /* the master config generated by configure */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include "libpbs.h"
+#include "dis.h"
+#include "log.h"
+#include "pbs_error.h"
+#include "server_limits.h"
+#include "list_link.h"
+#include "net_connect.h"
+#include "attribute.h"
+#include "credential.h"
+#include "batch_request.h"
+#include "pbs_arena.h"
+#include "work_task.h"
+#include "pbs_nodes.h"
+#include "svrfunc.h"
+
+/* number of threads sending replies */
+#define REPLY_POOL_THREADS 4
+
+/* status replies with fewer objects than this are sent by the main thread */
+#define REPLY_POOL_MIN_STATUS 64
+
+struct reply_stream;
+
+/* arena of a sent reply, allocated in the arena itself */
+typedef struct reply_arena {
+	pbs_list_link ra_link;
+	pbs_arena *ra_arena;
+} reply_arena_t;
+
+/* one reply, or part of a reply, to send */
+typedef struct reply_task {
+	pbs_list_link rt_link;
+	struct reply_stream *rt_stream; /* connection the reply is for */
+	struct batch_reply rt_reply;	/* the detached reply */
+	reply_arena_t *rt_arena;	/* arena of rt_reply, if any */
+	pbs_tcp_chan_t *rt_chan;	/* encoded streamed part, rt_reply is unused */
+} reply_task_t;
+
+/*
+ * A connection handed to the threads.  Only the main thread looks at the
+ * list of streams; rs_rc and rs_errno are only set by the thread sending on
+ * the connection and read by the main thread once the last reply is done.
+ */
+typedef struct reply_stream {
+	pbs_list_link rs_link;
+	int rs_sock;		/* connection socket */
+	pbs_tcp_chan_t *rs_chan; /* DIS channel of rs_sock */
+	int rs_rc;		/* result of the first failed send */
+	int rs_errno;		/* tcp errno of the first failed send */
+	reply_task_t rs_last;	/* last reply, always available */
+} reply_stream_t;
+
+/* queue of replies for one thread */
+typedef struct reply_queue {
+	pthread_t rq_thread;
+	pthread_mutex_t rq_lock;
+	pthread_cond_t rq_cond;
+	pbs_list_head rq_tasks;
+} reply_queue_t;
+
+static reply_queue_t reply_queues[REPLY_POOL_THREADS];
+static int reply_pool_running = 0;
+static int reply_pool_stop = 0;
+
+static pbs_list_head reply_streams; /* main thread only */
+
+/* streams whose last reply is done, to be finished by the main thread */
+static pthread_mutex_t reply_done_lock = PTHREAD_MUTEX_INITIALIZER;
+static pbs_list_head reply_done;
+static pbs_list_head reply_arenas_done; /* arenas of sent replies to destroy */
+static int reply_done_pipe[2] = {-1, -1};
+
+/**
+ * @brief
+ * 		make a copy of an attribute list which owns all its data
+ *
+ * @par
+ * 		Status replies link in svrattrl entries which are shared with the
+ * 		encoded attribute cache of the object (see svrcached()), or point to
+ * 		the cached entry's data.  Such entries are not to be touched outside
+ * 		the main thread, so a reply sent by a thread gets its own copy.
+ *
+ * @param[in,out]	phead - list to replace by a copy
+ *
+ * @return	int
+ * @retval	0	- success
+ * @retval	-1	- out of memory, list is unchanged
+ */
+static int
+detach_attrlist(pbs_list_head *phead)
+{
+	pbs_list_head copy;
+	svrattrl *pal;
+	svrattrl *pnew;
+	size_t nsz;
+	size_t rsz;
+	size_t vsz;
+
+	CLEAR_HEAD(copy);
+	for (pal = (svrattrl *) GET_NEXT(*phead); pal; pal = (svrattrl *) GET_NEXT(pal->al_link)) {
+		nsz = strlen(pal->al_name) + 1;
+		rsz = (pal->al_rescln && pal->al_resc) ? strlen(pal->al_resc) + 1 : 0;
+		vsz = pal->al_value ? strlen(pal->al_value) + 1 : 1;
+		pnew = attrlist_alloc(nsz, rsz, vsz);
+		if (pnew == NULL) {
+			free_attrlist(&copy);
+			return -1;
+		}
+		memcpy(pnew->al_name, pal->al_name, nsz);
+		if (rsz)
+			memcpy(pnew->al_resc, pal->al_resc, rsz);
+		if (pal->al_value)
+			memcpy(pnew->al_value, pal->al_value, vsz);
+		else
+			pnew->al_value[0] = '\0';
+		pnew->al_op = pal->al_op;
+		pnew->al_flags = pal->al_flags;
+		pnew->al_refct = 1;
+		append_link(&copy, &pnew->al_link, pnew);
+	}
+	free_attrlist(phead);
+	list_move(&copy, phead);
+	return 0;
+}
+
+/**
+ * @brief
+ * 		move the reply of a request into a task, leaving the request with an
+ * 		empty reply.  The attribute lists of a status reply are detached,
+ * 		unless the reply is built in an arena.
+ *
+ * @param[in,out]	preq - request whose reply is moved
+ * @param[out]		ptask - task to get the reply
+ *
+ * @return	int
+ * @retval	0	- success
+ * @retval	-1	- out of memory, nothing moved
+ */
+static int
+move_reply(struct batch_request *preq, reply_task_t *ptask)
+{
+	struct batch_reply *preply = &preq->rq_reply;
+	struct brp_status *pstat;
+	reply_arena_t *pra = NULL;
+
+	if (preply->brp_arena != NULL) {
+		/* the arena is destroyed by the main thread, see reply_pool_done() */
+		pra = (reply_arena_t *) pbs_arena_alloc(preply->brp_arena, sizeof(reply_arena_t));
+		if (pra == NULL)
+			return -1;
+		CLEAR_LINK(pra->ra_link);
+		pra->ra_arena = preply->brp_arena;
+	} else if (preply->brp_choice == BATCH_REPLY_CHOICE_Status) {
+		pstat = (struct brp_status *) GET_NEXT(preply->brp_un.brp_status);
+		for (; pstat; pstat = (struct brp_status *) GET_NEXT(pstat->brp_stlink)) {
+			if (detach_attrlist(&pstat->brp_attr) != 0)
+				return -1;
+		}
+	}
+
+	ptask->rt_reply = *preply;
+	ptask->rt_arena = pra;
+	if (preply->brp_choice == BATCH_REPLY_CHOICE_Status) {
+		CLEAR_HEAD(ptask->rt_reply.brp_un.brp_status);
+		list_move(&preply->brp_un.brp_status, &ptask->rt_reply.brp_un.brp_status);
+	}
+	preply->brp_choice = BATCH_REPLY_CHOICE_NULL;
+	preply->brp_arena = NULL;
+	return 0;
+}
+
+/**
+ * @brief
+ * 		move a part of a streamed status into a task, see status_stream().
+ *
+ * @par
+ * 		The reply header ending the part is encoded after the job status
+ * 		already in the DIS buffer of the connection, then the buffer is
+ * 		moved into a copy of the channel, which also carries the settings
+ * 		the thread needs to write it out (binary integers, encryption).  The
+ * 		connection is left with an empty buffer for the next part.
+ *
+ * @param[in,out]	preq - request whose reply part is moved
+ * @param[out]		ptask - task to get the encoded part
+ *
+ * @return	int
+ * @retval	0	- success
+ * @retval	-1	- failure, nothing moved
+ */
+static int
+move_stream_part(struct batch_request *preq, reply_task_t *ptask)
+{
+	pbs_tcp_chan_t *chan = ptask->rt_stream->rs_chan;
+	pbs_tcp_chan_t *copy;
+
+	if ((copy = (pbs_tcp_chan_t *) malloc(sizeof(pbs_tcp_chan_t))) == NULL)
+		return -1;
+	preq->rq_reply.brp_count = 0; /* already encoded, see status_stream() */
+	if (encode_DIS_reply(preq->rq_conn, &preq->rq_reply) != 0) {
+		free(copy);
+		return -1;
+	}
+	*copy = *chan;
+	memset(&copy->readbuf, 0, sizeof(copy->readbuf));
+	memset(&chan->writebuf, 0, sizeof(chan->writebuf));
+	ptask->rt_chan = copy;
+	reply_free(&preq->rq_reply);
+	memset(&ptask->rt_reply, 0, sizeof(ptask->rt_reply));
+	return 0;
+}
+
+/**
+ * @brief
+ * 		find the stream of a connection handed to the threads
+ *
+ * @param[in]	sock - connection socket
+ *
+ * @return	reply_stream_t *
+ * @retval	NULL	- the connection is not handed to the threads
+ */
+static reply_stream_t *
+find_reply_stream(int sock)
+{
+	reply_stream_t *pstream;
+
+	pstream = (reply_stream_t *) GET_NEXT(reply_streams);
+	while (pstream) {
+		if (pstream->rs_sock == sock)
+			return pstream;
+		pstream = (reply_stream_t *) GET_NEXT(pstream->rs_link);
+	}
+	return NULL;
+}
+
+/**
+ * @brief
+ * 		queue a task for the thread sending on its connection
+ *
+ * @param[in]	ptask - task to queue
+ */
+static void
+queue_reply_task(reply_task_t *ptask)
+{
+	reply_queue_t *pq = &reply_queues[ptask->rt_stream->rs_sock % REPLY_POOL_THREADS];
+
+	pthread_mutex_lock(&pq->rq_lock);
+	CLEAR_LINK(ptask->rt_link);
+	append_link(&pq->rq_tasks, &ptask->rt_link, ptask);
+	pthread_cond_signal(&pq->rq_cond);
+	pthread_mutex_unlock(&pq->rq_lock);
+}
+
+/**
+ * @brief
+ * 		encode and send one reply on its connection
+ *
+ * @param[in]	ptask - task with the reply to send
+ */
+static void
+send_reply_task(reply_task_t *ptask)
+{
+	reply_stream_t *pstream = ptask->rt_stream;
+	int sock = pstream->rs_sock;
+	int rc;
+
+	/* once a part failed, the rest of the reply is dropped */
+	if (pstream->rs_rc != 0)
+		return;
+
+	if (DIS_tcp_set_thread_chan(sock, ptask->rt_chan ? ptask->rt_chan : pstream->rs_chan,
+				    PBS_DIS_TCP_TIMEOUT_REPLY) != 0) {
+		pstream->rs_rc = PBSE_SYSTEM;
+		return;
+	}
+	if (ptask->rt_chan != NULL)
+		rc = dis_flush(sock); /* already encoded, see move_stream_part() */
+	else
+		rc = encode_DIS_reply(sock, &ptask->rt_reply);
+	if (rc == 0 && ptask->rt_chan == NULL)
+		rc = dis_flush(sock);
+	if (rc != 0) {
+		pstream->rs_rc = rc;
+		pstream->rs_errno = DIS_tcp_thread_errno(sock);
+	}
+	(void) DIS_tcp_set_thread_chan(sock, NULL, 0);
+}
+
+/**
+ * @brief
+ * 		body of a reply thread, sends the replies queued for it in order
+ *
+ * @param[in]	data - the thread's reply_queue_t
+ *
+ * @return	NULL
+ */
+static void *
+reply_thread(void *data)
+{
+	reply_queue_t *pq = (reply_queue_t *) data;
+	reply_task_t *ptask;
+	reply_stream_t *pstream;
+	reply_arena_t *pra;
+	sigset_t allsigs;
+	char c = 0;
+
+	/* signals are for the main thread */
+	sigfillset(&allsigs);
+	pthread_sigmask(SIG_BLOCK, &allsigs, NULL);
+
+	while (1) {
+		pthread_mutex_lock(&pq->rq_lock);
+		while ((ptask = (reply_task_t *) GET_NEXT(pq->rq_tasks)) == NULL && !reply_pool_stop)
+			pthread_cond_wait(&pq->rq_cond, &pq->rq_lock);
+		if (ptask != NULL)
+			delete_link(&ptask->rt_link);
+		pthread_mutex_unlock(&pq->rq_lock);
+		if (ptask == NULL)
+			break; /* stopping and nothing left to send */
+
+		send_reply_task(ptask);
+		pra = ptask->rt_arena;
+		if (pra != NULL) {
+			/* the arena holds references to cached data, see move_reply() */
+			ptask->rt_reply.brp_arena = NULL;
+			ptask->rt_reply.brp_choice = BATCH_REPLY_CHOICE_NULL;
+			ptask->rt_arena = NULL;
+		}
+		reply_free(&ptask->rt_reply);
+		if (ptask->rt_chan != NULL) {
+			free(ptask->rt_chan->writebuf.tdis_data);
+			free(ptask->rt_chan);
+			ptask->rt_chan = NULL;
+		}
+
+		pstream = ptask->rt_stream;
+		if (ptask != &pstream->rs_last) {
+			free(ptask);
+			if (pra == NULL)
+				continue;
+			pstream = NULL;
+		}
+
+		/* give the arena, and the connection after its last reply, back to the main thread */
+		pthread_mutex_lock(&reply_done_lock);
+		if (pra != NULL)
+			append_link(&reply_arenas_done, &pra->ra_link, pra);
+		if (pstream != NULL)
+			append_link(&reply_done, &pstream->rs_link, pstream);
+		pthread_mutex_unlock(&reply_done_lock);
+		while (write(reply_done_pipe[1], &c, 1) == -1 && errno == EINTR)
+			;
+	}
+	return NULL;
+}
+
+/**
+ * @brief
+ * 		destroy the arenas of the sent replies and finish the connections
+ * 		whose replies are all sent: resume polling them, or close them if
+ * 		sending failed.  Called from the main loop when the threads write to
+ * 		the pipe.
+ *
+ * @param[in]	fd - read end of the pipe
+ */
+static void
+reply_pool_done(int fd)
+{
+	char buf[64];
+	pbs_list_head done;
+	pbs_list_head arenas;
+	reply_stream_t *pstream;
+	reply_arena_t *pra;
+	char hn[PBS_MAXHOSTNAME + 1];
+
+	while (fd >= 0 && read(fd, buf, sizeof(buf)) > 0)
+		;
+
+	CLEAR_HEAD(done);
+	CLEAR_HEAD(arenas);
+	pthread_mutex_lock(&reply_done_lock);
+	list_move(&reply_done, &done);
+	list_move(&reply_arenas_done, &arenas);
+	pthread_mutex_unlock(&reply_done_lock);
+
+	while ((pra = (reply_arena_t *) GET_NEXT(arenas)) != NULL) {
+		delete_link(&pra->ra_link);
+		pbs_arena_destroy(pra->ra_arena);
+	}
+
+	while ((pstream = (reply_stream_t *) GET_NEXT(done)) != NULL) {
+		delete_link(&pstream->rs_link);
+		if (pstream->rs_rc != 0) {
+			if (get_connecthost(pstream->rs_sock, hn, PBS_MAXHOSTNAME) == -1)
+				strcpy(hn, "??");
+			(void) sprintf(log_buffer, "DIS reply failure, %d, to host %s, errno=%d",
+				       pstream->rs_rc, hn, pstream->rs_errno);
+			/* if EAGAIN - then write was blocked and timed-out, note it */
+			if (pstream->rs_errno == EAGAIN)
+				strcat(log_buffer, " write timed out");
+			log_event(PBSEVENT_SYSTEM, PBS_EVENTCLASS_REQUEST, LOG_WARNING,
+				  __func__, log_buffer);
+			close_client(pstream->rs_sock);
+		} else if (resume_conn(pstream->rs_sock) != 0) {
+			close_client(pstream->rs_sock);
+		}
+		free(pstream);
+	}
+}
+
+/**
+ * @brief
+ * 		hand a reply, or a part of one, to the reply threads
+ *
+ * @par Functionality:
+ * 		Once the first part of a reply was handed to the threads, the rest
+ * 		of it has to go to the threads too, as the connection belongs to them
+ * 		until the last part is sent.  Otherwise only large status replies
+ * 		over tcp are handed to the threads; for a streamed status that is
+ * 		one whose first part holds enough jobs.
+ *
+ * @param[in,out]	preq - request whose reply is sent, the reply is
+ * 			       moved out of it on success
+ * @param[in]		last - 1 if this is the last reply on the request
+ *
+ * @return	int
+ * @retval	0	- reply handed to the threads
+ * @retval	-1	- reply not taken, send it from the main thread
+ * @retval	>0	- PBS error, the part was not sent
+ */
+int
+reply_pool_send(struct batch_request *preq, int last)
+{
+	int sock = preq->rq_conn;
+	reply_stream_t *pstream;
+	reply_task_t *ptask;
+
+	if (!reply_pool_running || preq->prot != PROT_TCP || sock < 0)
+		return -1;
+
+	pstream = find_reply_stream(sock);
+	if (pstream == NULL) {
+		pbs_tcp_chan_t *chan;
+
+		if (preq->rq_reply.brp_choice != BATCH_REPLY_CHOICE_Status ||
+		    preq->rq_reply.brp_count < REPLY_POOL_MIN_STATUS)
+			return -1;
+
+		DIS_tcp_funcs();
+		if ((chan = transport_get_chan(sock)) == NULL)
+			return -1;
+		if ((pstream = (reply_stream_t *) calloc(1, sizeof(reply_stream_t))) == NULL)
+			return -1;
+		pstream->rs_sock = sock;
+		pstream->rs_chan = chan;
+		pstream->rs_last.rt_stream = pstream;
+
+		if (suspend_conn(sock) != 0) {
+			free(pstream);
+			return -1;
+		}
+		CLEAR_LINK(pstream->rs_link);
+		append_link(&reply_streams, &pstream->rs_link, pstream);
+	}
+
+	if (last) {
+		/* the connection goes back to the main thread after this one */
+		ptask = &pstream->rs_last;
+		delete_link(&pstream->rs_link);
+		if ((preq->rq_stream ? move_stream_part(preq, ptask) : move_reply(preq, ptask)) != 0) {
+			/* drop any streamed status left unsent, see move_stream_part() */
+			if (preq->rq_stream)
+				dis_clear_buf(&pstream->rs_chan->writebuf);
+			reply_free(&preq->rq_reply);
+			memset(&ptask->rt_reply, 0, sizeof(ptask->rt_reply));
+			ptask->rt_reply.brp_code = PBSE_SYSTEM;
+			ptask->rt_reply.brp_choice = BATCH_REPLY_CHOICE_NULL;
+		}
+	} else {
+		if ((ptask = (reply_task_t *) calloc(1, sizeof(reply_task_t))) == NULL)
+			return PBSE_SYSTEM;
+		ptask->rt_stream = pstream;
+		if ((preq->rq_stream ? move_stream_part(preq, ptask) : move_reply(preq, ptask)) != 0) {
+			free(ptask);
+			return PBSE_SYSTEM;
+		}
+	}
+	queue_reply_task(ptask);
+	return 0;
+}
+
+/**
+ * @brief
+ * 		a forked child has no reply threads, it sends its replies itself
+ */
+static void
+reply_pool_atfork_child(void)
+{
+	reply_pool_running = 0;
+}
+
+/**
+ * @brief
+ * 		start the reply threads
+ *
+ * @return	int
+ * @retval	0	- success
+ * @retval	-1	- failure, replies are sent by the main thread
+ */
+int
+init_reply_pool(void)
+{
+	conn_t *conn;
+	int i;
+
+	CLEAR_HEAD(reply_streams);
+	CLEAR_HEAD(reply_done);
+	CLEAR_HEAD(reply_arenas_done);
+
+	if (pipe(reply_done_pipe) == -1) {
+		log_err(errno, __func__, "pipe");
+		return -1;
+	}
+	for (i = 0; i < 2; i++) {
+		(void) fcntl(reply_done_pipe[i], F_SETFL, O_NONBLOCK);
+		(void) fcntl(reply_done_pipe[i], F_SETFD, FD_CLOEXEC);
+	}
+	if ((conn = add_conn(reply_done_pipe[0], ChildPipe, (pbs_net_t) 0, 0, NULL, reply_pool_done)) == NULL) {
+		log_err(-1, __func__, "could not add reply pool pipe to connection table");
+		close(reply_done_pipe[0]);
+		close(reply_done_pipe[1]);
+		reply_done_pipe[0] = reply_done_pipe[1] = -1;
+		return -1;
+	}
+	conn->cn_authen |= PBS_NET_CONN_AUTHENTICATED | PBS_NET_CONN_NOTIMEOUT;
+
+	reply_pool_stop = 0;
+	for (i = 0; i < REPLY_POOL_THREADS; i++) {
+		reply_queue_t *pq = &reply_queues[i];
+
+		pthread_mutex_init(&pq->rq_lock, NULL);
+		pthread_cond_init(&pq->rq_cond, NULL);
+		CLEAR_HEAD(pq->rq_tasks);
+		if (pthread_create(&pq->rq_thread, NULL, reply_thread, pq) != 0) {
+			log_err(errno, __func__, "could not create reply thread");
+			break;
+		}
+	}
+	if (i < REPLY_POOL_THREADS) {
+		int created = i;
+
+		reply_pool_stop = 1;
+		for (i = 0; i < created; i++) {
+			pthread_mutex_lock(&reply_queues[i].rq_lock);
+			pthread_cond_signal(&reply_queues[i].rq_cond);
+			pthread_mutex_unlock(&reply_queues[i].rq_lock);
+			pthread_join(reply_queues[i].rq_thread, NULL);
+		}
+		close_conn(reply_done_pipe[0]);
+		close(reply_done_pipe[1]);
+		reply_done_pipe[0] = reply_done_pipe[1] = -1;
+		return -1;
+	}
+
+	(void) pthread_atfork(NULL, NULL, reply_pool_atfork_child);
+	reply_pool_running = 1;
+	return 0;
+}
+
+/**
+ * @brief
+ * 		stop the reply threads after they sent all the replies handed to
+ * 		them, and give the connections back to the main thread
+ */
+void
+shutdown_reply_pool(void)
+{
+	int i;
+
+	if (!reply_pool_running)
+		return;
+	reply_pool_running = 0;
+
+	for (i = 0; i < REPLY_POOL_THREADS; i++) {
+		pthread_mutex_lock(&reply_queues[i].rq_lock);
+		reply_pool_stop = 1;
+		pthread_cond_signal(&reply_queues[i].rq_cond);
+		pthread_mutex_unlock(&reply_queues[i].rq_lock);
+	}
+	for (i = 0; i < REPLY_POOL_THREADS; i++)
+		pthread_join(reply_queues[i].rq_thread, NULL);
+
+	reply_pool_done(reply_done_pipe[0]);
+	close_conn(reply_done_pipe[0]);
+	close(reply_done_pipe[1]);
+	reply_done_pipe[0] = reply_done_pipe[1] = -1;
+}
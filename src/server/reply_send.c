@@ -73,6 +73,7 @@
 #include "attribute.h"
 #include "credential.h"
 #include "batch_request.h"
+#include "pbs_arena.h"
 #include "work_task.h"
 #include "pbs_nodes.h"
 #include "svrfunc.h"
@@ -256,7 +257,19 @@ reply_send_status_part(struct batch_request *preq)
 	if (preq->rq_conn >= 0) {
 		struct batch_reply *preply = &preq->rq_reply;
 		preply->brp_is_part = 1;
+#ifndef PBS_MOM
+		/* large status replies are sent by the reply threads */
+		rc = reply_pool_send(preq, 0);
+		if (rc == -1) {
+			if (preq->rq_stream)
+				preply->brp_count = 0; /* already encoded, see status_stream() */
+			rc = dis_reply_write(preq->rq_conn, preq);
+		}
+#else
+		if (preq->rq_stream)
+			preply->brp_count = 0; /* already encoded, see status_stream() */
 		rc = dis_reply_write(preq->rq_conn, preq);
+#endif /* PBS_MOM */
 		if (rc != PBSE_NONE)
 			return rc;
 		reply_free(&preq->rq_reply);
@@ -362,6 +375,15 @@ reply_send(struct batch_request *request)
 		 * Otherwise, the reply is to be sent to a remote client
 		 */
 		if (rc == PBSE_NONE) {
+#ifndef PBS_MOM
+			/* large status replies are sent by the reply threads */
+			if (reply_pool_send(request, 1) == 0) {
+				free_br(request);
+				return rc;
+			}
+#endif /* PBS_MOM */
+			if (request->rq_stream)
+				request->rq_reply.brp_count = 0; /* already encoded, see status_stream() */
 			rc = dis_reply_write(sfds, request);
 		}
 	}
@@ -417,6 +439,11 @@ reply_ack(struct batch_request *preq)
  * 		Free any sub-structures that might hang from the basic
  * 		batch_reply structure, the reply structure itself IS NOT FREED.
  *
+ * @par
+ * 		A status reply built in an arena (see status_job()) is released by
+ * 		destroying the arena, which also drops the references it holds on
+ * 		cached attribute encodings.
+ *
  * @param[in]	prep	- basic batch_reply structure
  */
 void
@@ -445,7 +472,10 @@ reply_free(struct batch_reply *prep)
 		}
 
 	} else if (prep->brp_choice == BATCH_REPLY_CHOICE_Status) {
-		pstat = (struct brp_status *) GET_NEXT(prep->brp_un.brp_status);
+		/* the entries of a reply with an arena all live in the arena */
+		pstat = NULL;
+		if (prep->brp_arena == NULL)
+			pstat = (struct brp_status *) GET_NEXT(prep->brp_un.brp_status);
 		while (pstat) {
 			pstatx = (struct brp_status *) GET_NEXT(pstat->brp_stlink);
 			free_attrlist(&pstat->brp_attr);
@@ -469,6 +499,10 @@ reply_free(struct batch_reply *prep)
 		(void) free(prep->brp_un.brp_rescq.brq_resvd);
 		(void) free(prep->brp_un.brp_rescq.brq_down);
 	}
+	if (prep->brp_arena != NULL) {
+		pbs_arena_destroy(prep->brp_arena);
+		prep->brp_arena = NULL;
+	}
 	prep->brp_choice = BATCH_REPLY_CHOICE_NULL;
 }
 
@@ -79,6 +79,8 @@ req_connect(struct batch_request *preq)
 	if (preq->rq_extend != NULL) {
 		if (strcmp(preq->rq_extend, QSUB_DAEMON) == 0)
 			conn->cn_authen |= PBS_NET_CONN_FROM_QSUB_DAEMON;
+		else if (pbs_conf.pbs_dis_binary && strcmp(preq->rq_extend, DIS_BINARY_EXTEND) == 0)
+			dis_set_binary(preq->rq_conn, 1); /* starting with this ack */
 	}
 
 	reply_ack(preq);
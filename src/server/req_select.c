@@ -89,6 +89,7 @@ static void free_sellist(struct select_list *pslist);
 static int sel_attr(attribute *, struct select_list *);
 static int select_job(job *, struct select_list *, int, int);
 static int select_subjob(char, struct select_list *);
+static int job_unchanged_since(job *, long);
 
 /**
  * @brief
@@ -300,6 +301,28 @@ add_select_array_entries(job *pjob, int dosub, char *statelist,
 	return ct;
 }
 
+/**
+ * @brief
+ * 	Check if a job is unchanged since the given status sequence number.
+ * 	Array jobs are always reported as changed as their subjob states are
+ * 	not tracked through their attributes.
+ *
+ * @param[in,out] pjob - job to check
+ * @param[in]     seq  - status sequence number of the client's earlier query
+ *
+ * @return int
+ * @retval 1 - job is unchanged
+ * @retval 0 - job changed
+ */
+static int
+job_unchanged_since(job *pjob, long seq)
+{
+	if (pjob->ji_qs.ji_svrflags & JOB_SVFLG_ArrayJob)
+		return 0;
+	update_job_modseq(pjob);
+	return (pjob->ji_modseq <= seq);
+}
+
 /**
  * @brief
  * 	Service both the Select Job Request and the (special for the scheduler)
@@ -327,7 +350,9 @@ req_selectjobs(struct batch_request *preq)
 	struct brp_select **pselx;
 	int dosubjobs = 0;
 	int dohistjobs = 0;
+	long delta_since = -1;
 	char *pstate = NULL;
+	char *pc;
 	int rc;
 	struct select_list *selistp;
 	pbs_sched *psched;
@@ -341,7 +366,7 @@ req_selectjobs(struct batch_request *preq)
 		 */
 		if (strchr(preq->rq_extend, 'T') || strchr(preq->rq_extend, 't'))
 			dosubjobs = 1;
-		else if (strchr(preq->rq_extend, 'S'))
+		else if (strchr(preq->rq_extend, EXTEND_OPT_SCHED_JOBS))
 			dosubjobs = 2;
 		/*
 		 * If the letter x is in the extend string, Check if the server is
@@ -356,6 +381,15 @@ req_selectjobs(struct batch_request *preq)
 			}
 			dohistjobs = 1;
 		}
+		/*
+		 * If the letter D followed by a status sequence number is in the
+		 * extend string, jobs which have not changed since then are
+		 * returned with no attributes.  The client is expected to have
+		 * kept them from an earlier reply, see update_job_modseq().
+		 */
+		if (preq->rq_type != PBS_BATCH_SelectJobs &&
+		    (pc = strchr(preq->rq_extend, EXTEND_OPT_DELTA)) != NULL)
+			delta_since = strtol(pc + 1, NULL, 10);
 	}
 
 	/*
@@ -441,6 +475,10 @@ req_selectjobs(struct batch_request *preq)
 								plist = (svrattrl *) GET_NEXT(preq->rq_ind.rq_select.rq_rtnattr);
 							}
 						}
+					} else if (delta_since >= 0 && job_unchanged_since(pjob, delta_since)) {
+						rc = status_job_unchanged(pjob, preq, &preply->brp_un.brp_status);
+						if (rc)
+							goto out;
 					} else {
 						rc = status_job(pjob, preq, plist, &preply->brp_un.brp_status, &bad, 0);
 						if (rc && rc != PBSE_PERM)
@@ -86,6 +86,7 @@
 #include "pbs_nodes.h"
 #include "svrfunc.h"
 #include "net_connect.h"
+#include "dis.h"
 #include "pbs_license.h"
 #include "resource.h"
 #include "pbs_sched.h"
@@ -111,7 +112,7 @@ extern pbs_license_counts license_counts;
 
 /* Extern Functions */
 
-extern int status_attrib(svrattrl *, void *, attribute_def *, attribute *, int, int, pbs_list_head *, int *);
+extern int status_attrib(svrattrl *, void *, attribute_def *, attribute *, int, int, pbs_list_head *, struct pbs_arena *, int *);
 extern int status_nodeattrib(svrattrl *, struct pbsnode *, int, int, pbs_list_head *, int *);
 
 extern int svr_chk_histjob(job *);
@@ -302,7 +303,8 @@ req_stat_job(struct batch_request *preq)
 	 * the sub jobs. If 'x' is there, then check if the server is
 	 * configured for history job info. If not set or set to FALSE,
 	 * return with PBSE_JOBHISTNOTSET error. Otherwise select history
-	 * jobs.
+	 * jobs.  EXTEND_OPT_STREAM asks for each job to be encoded to the
+	 * client as it is statused, see status_stream().
 	 */
 	if (preq->rq_extend) {
 		if (strchr(preq->rq_extend, (int) 't'))
@@ -314,6 +316,11 @@ req_stat_job(struct batch_request *preq)
 			}
 			dohistjobs = 1; /* status history jobs */
 		}
+		if (strchr(preq->rq_extend, (int) EXTEND_OPT_STREAM) &&
+		    preq->prot == PROT_TCP && preq->rq_conn >= 0) {
+			preq->rq_stream = 1;
+			DIS_tcp_funcs(); /* setup for DIS over tcp */
+		}
 	}
 
 	/*
@@ -528,7 +535,7 @@ status_que(pbs_queue *pque, struct batch_request *preq, pbs_list_head *pstathd)
 	bad = 0;
 	pal = (svrattrl *) GET_NEXT(preq->rq_ind.rq_status.rq_attr);
 	if (status_attrib(pal, que_attr_idx, que_attr_def, pque->qu_attr, QA_ATR_LAST,
-			  preq->rq_perm, &pstat->brp_attr, &bad))
+			  preq->rq_perm, &pstat->brp_attr, NULL, &bad))
 		rc = PBSE_NOATTR;
 
 	if (is_attr_set(qattr))
@@ -741,6 +748,7 @@ req_stat_svr(struct batch_request *preq)
 
 	/* update count and state counts from sv_numjobs and sv_jobstates */
 	set_sattr_l_slim(SVR_ATR_TotalJobs, server.sv_qs.sv_numjobs, SET);
+	set_sattr_l_slim(SVR_ATR_status_seq, server.sv_status_seq, SET);
 	update_state_ct(get_sattr(SVR_ATR_JobsByState), server.sv_jobstates, &svr_attr_def[SVR_ATR_JobsByState]);
 
 	update_license_ct();
@@ -780,7 +788,7 @@ req_stat_svr(struct batch_request *preq)
 	bad = 0;
 	pal = (svrattrl *) GET_NEXT(preq->rq_ind.rq_status.rq_attr);
 	if (status_attrib(pal, svr_attr_idx, svr_attr_def, server.sv_attr, SVR_ATR_LAST,
-			  preq->rq_perm, &pstat->brp_attr, &bad))
+			  preq->rq_perm, &pstat->brp_attr, NULL, &bad))
 		reply_badattr(PBSE_NOATTR, bad, pal, preq);
 	else
 		reply_send(preq);
@@ -821,7 +829,7 @@ status_sched(pbs_sched *psched, struct batch_request *preq, pbs_list_head *pstat
 	bad = 0;
 	pal = (svrattrl *) GET_NEXT(preq->rq_ind.rq_status.rq_attr);
 	if (status_attrib(pal, sched_attr_idx, sched_attr_def, psched->sch_attr, SCHED_ATR_LAST,
-			  preq->rq_perm, &pstat->brp_attr, &bad))
+			  preq->rq_perm, &pstat->brp_attr, NULL, &bad))
 		reply_badattr(PBSE_NOATTR, bad, pal, preq);
 
 	return (rc);
@@ -1036,7 +1044,7 @@ status_resv(resc_resv *presv, struct batch_request *preq, pbs_list_head *pstathd
 	pal = (svrattrl *) GET_NEXT(preq->rq_ind.rq_status.rq_attr);
 
 	if (status_attrib(pal, resv_attr_idx, resv_attr_def, presv->ri_wattr,
-			  RESV_ATR_LAST, preq->rq_perm, &pstat->brp_attr, &bad) == 0)
+			  RESV_ATR_LAST, preq->rq_perm, &pstat->brp_attr, NULL, &bad) == 0)
 		return (0);
 	else
 		return (PBSE_NOATTR);
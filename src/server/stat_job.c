@@ -46,14 +46,24 @@
  * 	stat_job.c	-	Functions which support the Status Job Batch Request.
  *
  * Included funtions are:
+ *	svrcache_release()
+ *	svrcache_refer()
+ *	svrcache_get()
  *	svrcached()
  *	status_attrib()
+ *	status_arena()
+ *	status_stream_entries()
+ *	status_stream_attrib()
+ *	status_stream()
+ *	update_job_modseq()
  *	status_job()
+ *	status_job_unchanged()
  *	status_subjob()
  *
  */
 #include <sys/types.h>
 #include <stdlib.h>
+#include <string.h>
 #include "libpbs.h"
 #include <ctype.h>
 #include <time.h>
@@ -63,6 +73,7 @@
 #include "server.h"
 #include "credential.h"
 #include "batch_request.h"
+#include "pbs_arena.h"
 #include "job.h"
 #include "reservation.h"
 #include "queue.h"
@@ -81,37 +92,131 @@ extern struct server server;
 extern char statechars[];
 extern time_t time_now;
 
+/* a cached encoding referred to by more replies than this is copied, al_refct is 16 bits */
+#define SVRCACHE_MAX_REFS 30000
+
+/**
+ * @brief
+ * 		svrcache_release - drop the references the entries of a status built
+ *		in an arena hold on cached svrattrl lists, freeing a list if it was
+ *		the last reference.  Called when the arena is destroyed.
+ * @par
+ *		The entry referring to the head of a cached list has its al_sister
+ *		pointing to that list, see svrcache_refer().
+ *
+ * @param[in]	arg	-	head of the attribute list of the status
+ */
+static void
+svrcache_release(void *arg)
+{
+	svrattrl *pal;
+	svrattrl *working;
+	svrattrl *sister;
+
+	for (pal = (svrattrl *) GET_NEXT(*(pbs_list_head *) arg); pal; pal = (svrattrl *) GET_NEXT(pal->al_link)) {
+		if ((working = pal->al_sister) == NULL)
+			continue;
+		for (sister = working->al_sister; sister; sister = sister->al_sister)
+			sister->al_refct--;
+		if (--working->al_refct <= 0) {
+			while (working) {
+				sister = working->al_sister;
+				delete_link(&working->al_link);
+				(void) free(working);
+				working = sister;
+			}
+		}
+	}
+}
+
+/**
+ * @brief
+ * 		svrcache_refer - add a cached svrattrl list to a status built in an
+ *		arena.
+ * @par
+ *		The cached entries are not linked in, the status gets entries from the
+ *		arena pointing to the cached data, and holds a reference on the
+ *		cached list until the arena is destroyed, so the data stays valid
+ *		even if the attribute changes meanwhile.  If the list is referred to
+ *		too many times already, the entries are copied into the arena instead.
+ *
+ * @param[in,out]	encoded	-	head of the cached svrattrl list
+ * @param[in,out]	phead	-	list of new attribute values
+ * @param[in]		arena	-	arena of the reply
+ */
+static void
+svrcache_refer(svrattrl *encoded, pbs_list_head *phead, pbs_arena *arena)
+{
+	svrattrl *working;
+	svrattrl *wcopy;
+	svrattrl *pal;
+	int shared;
+
+	shared = encoded->al_refct < SVRCACHE_MAX_REFS;
+	for (working = encoded; working; working = working->al_sister) {
+		if (shared) {
+			wcopy = (svrattrl *) pbs_arena_alloc(arena, sizeof(svrattrl));
+			if (wcopy == NULL)
+				break;
+			*wcopy = *working;
+		} else {
+			/* the data follows the structure, see attrlist_alloc() */
+			wcopy = (svrattrl *) pbs_arena_alloc(arena, working->al_tsize);
+			if (wcopy == NULL)
+				break;
+			memcpy(wcopy, working, working->al_tsize);
+			wcopy->al_name = (char *) wcopy + sizeof(svrattrl);
+			if (working->al_resc)
+				wcopy->al_resc = wcopy->al_name + (working->al_resc - working->al_name);
+			wcopy->al_value = wcopy->al_name + (working->al_value - working->al_name);
+		}
+		CLEAR_LINK(wcopy->al_link);
+		wcopy->al_sister = NULL;
+		wcopy->al_refct = 1;
+		append_link(phead, &wcopy->al_link, wcopy);
+		if (shared && working == encoded) {
+			/* hold the whole list, svrcache_release() drops it */
+			for (pal = encoded; pal; pal = pal->al_sister)
+				pal->al_refct++;
+			wcopy->al_sister = encoded;
+		}
+	}
+}
+
 /**
  * @brief
- * 		svrcached - either link in (to phead) a cached svrattrl struct which is
- *		pointed to by the attribute, or if the cached struct isn't there or
- *		is out of date, then replace it with a new svrattrl structure.
+ * 		svrcache_get - get the cached svrattrl list of an attribute, encoding
+ *		and caching a new one if it isn't there or is out of date.
  * @par
- *		When replacing, unlink and delete old one if the reference count goes
- *		to zero.
+ *		When replacing, the old one is deleted if the reference count goes
+ *		to zero.  The new list is held only by the cache, it is not linked
+ *		to any status.
  *
  * @par[in,out]	pat	-	attribute structure which contains a cached svrattrl struct
- * @par[in,out]	phead	-	list of new attribute values
  * @par[in]	pdef	-	attribute for any parent object.
  *
+ * @return	svrattrl *
+ * @retval	head of the cached list, chained through al_sister
+ * @retval	NULL	: nothing to status for the attribute
+ *
  * @note
  *	If an attribute has the ATR_DFLAG_HIDDEN flag set, then no
  *	need to obtain and cache new svrattrl values.
  */
-
-static void
-svrcached(attribute *pat, pbs_list_head *phead, attribute_def *pdef)
+static svrattrl *
+svrcache_get(attribute *pat, attribute_def *pdef)
 {
 	svrattrl *working = NULL;
 	svrattrl *wcopy;
 	svrattrl *encoded;
+	pbs_list_head newlist;
 
 	if (pdef == NULL)
-		return;
+		return NULL;
 
 	if ((pdef->at_flags & ATR_DFLAG_HIDDEN) &&
 	    (get_sattr_long(SVR_ATR_show_hidden_attribs) == 0)) {
-		return;
+		return NULL;
 	}
 	if (pat->at_flags & ATR_VFLAG_MODCACHE) {
 		/* free old cache value if the value has changed */
@@ -123,54 +228,85 @@ svrcached(attribute *pat, pbs_list_head *phead, attribute_def *pdef)
 		else
 			encoded = pat->at_user_encoded;
 	}
+	if (encoded != NULL || !is_attr_set(pat))
+		return encoded;
+
+	/* encode and cache new svrattrl structure */
+	CLEAR_HEAD(newlist);
+	(void) pdef->at_encode(pat, &newlist, pdef->at_name,
+			       NULL, ATR_ENCODE_CLIENT, &working);
+	if (working == NULL)
+		free_attrlist(&newlist);
+	while ((wcopy = (svrattrl *) GET_NEXT(newlist)) != NULL)
+		delete_link(&wcopy->al_link);
+	if (resc_access_perm & PRIV_READ)
+		pat->at_priv_encoded = working;
+	else
+		pat->at_user_encoded = working;
 
-	if ((encoded == NULL) || (pat->at_flags & ATR_VFLAG_MODCACHE)) {
-		if (is_attr_set(pat)) {
-			/* encode and cache new svrattrl structure */
-			(void) pdef->at_encode(pat, phead, pdef->at_name,
-					       NULL, ATR_ENCODE_CLIENT, &working);
-			if (resc_access_perm & PRIV_READ)
-				pat->at_priv_encoded = working;
-			else
-				pat->at_user_encoded = working;
-
-			pat->at_flags &= ~ATR_VFLAG_MODCACHE;
-			while (working) {
-				working->al_refct++; /* incr ref count */
-				working = working->al_sister;
-			}
+	pat->at_flags &= ~ATR_VFLAG_MODCACHE;
+	return working;
+}
+
+/**
+ * @brief
+ * 		svrcached - link in (to phead) the cached svrattrl struct of an
+ *		attribute, see svrcache_get().
+ * @par
+ *		If the reply is built in an arena, the cached struct is never linked
+ *		in, the reply refers to it through entries allocated in the arena,
+ *		see svrcache_refer().
+ *
+ * @par[in,out]	pat	-	attribute structure which contains a cached svrattrl struct
+ * @par[in,out]	phead	-	list of new attribute values
+ * @par[in]	pdef	-	attribute for any parent object.
+ * @par[in]	arena	-	arena of the reply, or NULL
+ */
+
+static void
+svrcached(attribute *pat, pbs_list_head *phead, attribute_def *pdef, pbs_arena *arena)
+{
+	svrattrl *working;
+	svrattrl *wcopy;
+	svrattrl *encoded;
+
+	if ((encoded = svrcache_get(pat, pdef)) == NULL)
+		return;
+
+	if (arena != NULL) {
+		svrcache_refer(encoded, phead, arena);
+		return;
+	}
+
+	/* can use the existing cached svrattrl struture */
+
+	working = encoded;
+	if (working->al_refct < 2) {
+		while (working) {
+			CLEAR_LINK(working->al_link);
+			if (phead != NULL)
+				append_link(phead, &working->al_link, working);
+			working->al_refct++; /* incr ref count */
+			working = working->al_sister;
 		}
 	} else {
-		/* can use the existing cached svrattrl struture */
-
-		working = encoded;
-		if (working->al_refct < 2) {
-			while (working) {
-				CLEAR_LINK(working->al_link);
-				if (phead != NULL)
-					append_link(phead, &working->al_link, working);
-				working->al_refct++; /* incr ref count */
+		/*
+		 * already linked in, must make a copy to link
+		 * NOTE: the copy points to the original's data
+		 * so it should be freed by itself, hence the
+		 * ref count is set to 1 and the sisters are not
+		 * linked in
+		 */
+		while (working) {
+			wcopy = malloc(sizeof(struct svrattrl));
+			if (wcopy) {
+				*wcopy = *working;
 				working = working->al_sister;
-			}
-		} else {
-			/*
-			 * already linked in, must make a copy to link
-			 * NOTE: the copy points to the original's data
-			 * so it should be freed by itself, hence the
-			 * ref count is set to 1 and the sisters are not
-			 * linked in
-			 */
-			while (working) {
-				wcopy = malloc(sizeof(struct svrattrl));
-				if (wcopy) {
-					*wcopy = *working;
-					working = working->al_sister;
-					CLEAR_LINK(wcopy->al_link);
-					if (phead != NULL)
-						append_link(phead, &wcopy->al_link, wcopy);
-					wcopy->al_refct = 1;
-					wcopy->al_sister = NULL;
-				}
+				CLEAR_LINK(wcopy->al_link);
+				if (phead != NULL)
+					append_link(phead, &wcopy->al_link, wcopy);
+				wcopy->al_refct = 1;
+				wcopy->al_sister = NULL;
 			}
 		}
 	}
@@ -186,6 +322,9 @@ svrcached(attribute *pat, pbs_list_head *phead, attribute_def *pdef)
  * @param[in]		limit	-	limit on size of def array
  * @param[in]		priv	-	user-client privilege
  * @param[in,out]	phead	-	pbs_list_head
+ * @param[in]		arena	-	arena the reply is built in, or NULL.  The
+ *					caller arranges for svrcache_release() to be
+ *					called on phead when the arena is destroyed.
  * @param[out]		bad 	-	RETURN: index of first bad attribute
  *
  * @return	int
@@ -194,7 +333,7 @@ svrcached(attribute *pat, pbs_list_head *phead, attribute_def *pdef)
  */
 
 int
-status_attrib(svrattrl *pal, void *pidx, attribute_def *padef, attribute *pattr, int limit, int priv, pbs_list_head *phead, int *bad)
+status_attrib(svrattrl *pal, void *pidx, attribute_def *padef, attribute *pattr, int limit, int priv, pbs_list_head *phead, pbs_arena *arena, int *bad)
 {
 	int index;
 	int nth = 0;
@@ -213,20 +352,206 @@ status_attrib(svrattrl *pal, void *pidx, attribute_def *padef, attribute *pattr,
 				return (-1);
 			}
 			if ((padef + index)->at_flags & priv) {
-				svrcached(pattr + index, phead, padef + index);
+				svrcached(pattr + index, phead, padef + index, arena);
 			}
 			pal = (svrattrl *) GET_NEXT(pal->al_link);
 		}
 	} else { /* non specified, return all readable attributes */
 		for (index = 0; index < limit; index++) {
 			if ((padef + index)->at_flags & priv) {
-				svrcached(pattr + index, phead, padef + index);
+				svrcached(pattr + index, phead, padef + index, arena);
+			}
+		}
+	}
+	return (0);
+}
+
+/**
+ * @brief
+ * 		status_arena - get the arena the job status reply of a request is
+ *		built in, creating it with the first job.
+ * @par
+ *		The status entries and the references to the cached attribute
+ *		encodings of all the jobs in the reply are allocated in the arena and
+ *		released at once by reply_free().
+ *
+ * @param[in,out]	preq	-	request structure
+ *
+ * @return	pbs_arena *
+ * @retval	NULL	: out of memory
+ */
+static pbs_arena *
+status_arena(struct batch_request *preq)
+{
+	if (preq->rq_reply.brp_arena == NULL)
+		preq->rq_reply.brp_arena = pbs_arena_create(0);
+	return preq->rq_reply.brp_arena;
+}
+
+/**
+ * @brief
+ * 		status_stream_entries - count or encode the cached entries of one
+ *		attribute, see status_stream_attrib().
+ *
+ * @param[in,out]	pat	-	attribute
+ * @param[in]		pdef	-	attribute definition
+ * @param[in]		sock	-	connection to encode to, -1 to count only
+ * @param[in,out]	ct	-	number of entries, incremented
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	!0	: DIS encode error
+ */
+static int
+status_stream_entries(attribute *pat, attribute_def *pdef, int sock, unsigned int *ct)
+{
+	svrattrl *encoded;
+	int rc;
+
+	for (encoded = svrcache_get(pat, pdef); encoded; encoded = encoded->al_sister) {
+		if (sock >= 0 && (rc = encode_DIS_svrattrl_entry(sock, encoded)) != 0)
+			return rc;
+		(*ct)++;
+	}
+	return 0;
+}
+
+/**
+ * @brief
+ * 		status_stream_attrib - walk the attributes status_attrib() would add
+ *		to a job status, either counting their cached entries or encoding
+ *		them to the client.
+ *
+ * @param[in]		pal	-	specific attributes to status
+ * @param[in,out]	pattr	-	attribute array of the job
+ * @param[in]		limit	-	limit on size of def array
+ * @param[in]		priv	-	user-client privilege
+ * @param[in]		sock	-	connection to encode to, -1 to count only
+ * @param[out]		ct	-	RETURN: number of entries
+ * @param[out]		bad 	-	RETURN: index of first bad attribute
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	-1	: on error (bad attribute)
+ * @retval	>0	: DIS encode error
+ */
+static int
+status_stream_attrib(svrattrl *pal, attribute *pattr, int limit, int priv, int sock, unsigned int *ct, int *bad)
+{
+	int index;
+	int nth = 0;
+	int rc = 0;
+
+	*ct = 0;
+	if (pal) { /* client specified certain attributes */
+		while (pal) {
+			++nth;
+			index = find_attr(job_attr_idx, job_attr_def, pal->al_name);
+			if (index < 0) {
+				*bad = nth;
+				return (-1);
+			}
+			if (job_attr_def[index].at_flags & priv) {
+				if ((rc = status_stream_entries(pattr + index, job_attr_def + index, sock, ct)) != 0)
+					return rc;
+			}
+			pal = (svrattrl *) GET_NEXT(pal->al_link);
+		}
+	} else { /* non specified, return all readable attributes */
+		for (index = 0; index < limit; index++) {
+			if (job_attr_def[index].at_flags & priv) {
+				if ((rc = status_stream_entries(pattr + index, job_attr_def + index, sock, ct)) != 0)
+					return rc;
 			}
 		}
 	}
 	return (0);
 }
 
+/**
+ * @brief
+ * 		status_stream - encode the status of a job straight to the client as
+ *		a reply part of its own, without building a brp_status entry.
+ * @par
+ *		Used when the client asked for EXTEND_OPT_STREAM, see req_stat_job().
+ *		The entries come from the cached encodings of the attributes, the
+ *		job status is in the DIS buffer of the connection when this returns,
+ *		and is sent by the next reply_send_status_part() or reply_send().
+ *
+ * @param[in,out]	preq	-	request structure
+ * @param[in]		objtype	-	MGR_OBJ_* type of the status
+ * @param[in]		objname	-	name of the job
+ * @param[in]		pal	-	specific attributes to status
+ * @param[in,out]	pattr	-	attribute array of the job
+ * @param[in]		limit	-	limit on size of def array
+ * @param[out]		bad	-	RETURN: index of first bad attribute
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	PBSE_NOATTR	: attribute error
+ * @retval	PBSE_SYSTEM	: encode error
+ */
+static int
+status_stream(struct batch_request *preq, int objtype, char *objname, svrattrl *pal, attribute *pattr, int limit, int *bad)
+{
+	int priv;
+	unsigned int ct;
+	unsigned int ct2;
+
+	priv = preq->rq_perm & (ATR_DFLAG_RDACC | ATR_DFLAG_SvWR);
+	resc_access_perm = priv; /* pass privilege to encode_resc() */
+
+	/* first pass counts the entries and encodes what isn't cached yet */
+	*bad = 0;
+	if (status_stream_attrib(pal, pattr, limit, priv, -1, &ct, bad) != 0)
+		return (PBSE_NOATTR);
+
+	if (encode_DIS_status_part(preq->rq_conn, objtype, objname, ct) != 0 ||
+	    status_stream_attrib(pal, pattr, limit, priv, preq->rq_conn, &ct2, bad) != 0 ||
+	    ct2 != ct)
+		return (PBSE_SYSTEM);
+	preq->rq_reply.brp_count++;
+	return (0);
+}
+
+/**
+ * @brief
+ * 		update_job_modseq - stamp the job with the next status sequence number
+ *		if any of its attributes changed since the job was last statused.
+ *
+ * @par
+ *		A changed attribute carries ATR_VFLAG_MODCACHE until svrcached()
+ *		encodes it for some client, so the flags alone cannot tell the
+ *		scheduler what changed since its own last query.  Fold them into
+ *		ji_modseq here, before any encoding, and drop the stale cached
+ *		encodings just as svrcached() would have done.
+ *		eligible_time is skipped, it is recomputed on every status.
+ *
+ * @param[in,out]	pjob	-	job to check
+ *
+ * @return	void
+ */
+void
+update_job_modseq(job *pjob)
+{
+	int i;
+	int modified = 0;
+	attribute *pattr;
+
+	for (i = 0; i < JOB_ATR_LAST; i++) {
+		if (i == JOB_ATR_eligible_time)
+			continue;
+		pattr = get_jattr(pjob, i);
+		if (pattr->at_flags & ATR_VFLAG_MODCACHE) {
+			free_svrcache(pattr);
+			pattr->at_flags &= ~ATR_VFLAG_MODCACHE;
+			modified = 1;
+		}
+	}
+	if (modified || pjob->ji_modseq == 0)
+		pjob->ji_modseq = ++server.sv_status_seq;
+}
+
 /**
  * @brief
  * 		status_job - Build the status reply for a single job, regular or Array,
@@ -249,7 +574,10 @@ status_attrib(svrattrl *pal, void *pidx, attribute_def *padef, attribute *pattr,
 int
 status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *pstathd, int *bad, int dosubjobs)
 {
-	struct brp_status *pstat;
+	struct brp_status *pstat = NULL;
+	pbs_arena *arena = NULL;
+	int objtype;
+	int rc;
 	long oldtime = 0;
 	int old_elig_flags = 0;
 	int old_atyp_flags = 0;
@@ -261,6 +589,8 @@ status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *
 		if (svr_authorize_jobreq(preq, pjob))
 			return (PBSE_PERM);
 
+	update_job_modseq(pjob);
+
 	/* calc eligible time on the fly and return, don't save. */
 	if (get_sattr_long(SVR_ATR_EligibleTimeEnable) == TRUE) {
 		if (get_jattr_long(pjob, JOB_ATR_accrue_type) == JOB_ELIGIBLE) {
@@ -277,22 +607,30 @@ status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *
 		mark_jattr_not_set(pjob, JOB_ATR_accrue_type);
 	}
 
-	/* allocate reply structure and fill in header portion */
-
-	pstat = (struct brp_status *) malloc(sizeof(struct brp_status));
-	if (pstat == NULL)
-		return (PBSE_SYSTEM);
-	CLEAR_LINK(pstat->brp_stlink);
 	if ((pjob->ji_qs.ji_svrflags & JOB_SVFLG_ArrayJob) != 0 && dosubjobs)
-		pstat->brp_objtype = MGR_OBJ_JOBARRAY_PARENT;
+		objtype = MGR_OBJ_JOBARRAY_PARENT;
 	else if ((pjob->ji_qs.ji_svrflags & JOB_SVFLG_SubJob) != 0 && dosubjobs)
-		pstat->brp_objtype = MGR_OBJ_SUBJOB;
+		objtype = MGR_OBJ_SUBJOB;
 	else
-		pstat->brp_objtype = MGR_OBJ_JOB;
-	(void) strcpy(pstat->brp_objname, pjob->ji_qs.ji_jobid);
-	CLEAR_HEAD(pstat->brp_attr);
-	append_link(pstathd, &pstat->brp_stlink, pstat);
-	preq->rq_reply.brp_count++;
+		objtype = MGR_OBJ_JOB;
+
+	/* allocate reply structure and fill in header portion */
+
+	if (!preq->rq_stream) {
+		if ((arena = status_arena(preq)) == NULL)
+			return (PBSE_SYSTEM);
+		pstat = (struct brp_status *) pbs_arena_alloc(arena, sizeof(struct brp_status));
+		if (pstat == NULL)
+			return (PBSE_SYSTEM);
+		CLEAR_HEAD(pstat->brp_attr);
+		if (pbs_arena_on_destroy(arena, svrcache_release, &pstat->brp_attr) != 0)
+			return (PBSE_SYSTEM);
+		CLEAR_LINK(pstat->brp_stlink);
+		pstat->brp_objtype = objtype;
+		(void) strcpy(pstat->brp_objname, pjob->ji_qs.ji_jobid);
+		append_link(pstathd, &pstat->brp_stlink, pstat);
+		preq->rq_reply.brp_count++;
+	}
 
 	/* Temporarily set suspend/user suspend states for the stat */
 	if (check_job_state(pjob, JOB_STATE_LTR_RUNNING)) {
@@ -307,9 +645,14 @@ status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *
 
 	/* add attributes to the status reply */
 
-	*bad = 0;
-	if (status_attrib(pal, job_attr_idx, job_attr_def, pjob->ji_wattr, JOB_ATR_LAST, preq->rq_perm, &pstat->brp_attr, bad))
-		return (PBSE_NOATTR);
+	if (preq->rq_stream) {
+		if ((rc = status_stream(preq, objtype, pjob->ji_qs.ji_jobid, pal, pjob->ji_wattr, JOB_ATR_LAST, bad)) != 0)
+			return (rc);
+	} else {
+		*bad = 0;
+		if (status_attrib(pal, job_attr_idx, job_attr_def, pjob->ji_wattr, JOB_ATR_LAST, preq->rq_perm, &pstat->brp_attr, arena, bad))
+			return (PBSE_NOATTR);
+	}
 
 	/* reset eligible time, it was calctd on the fly, real calctn only when accrue_type changes */
 
@@ -329,6 +672,41 @@ status_job(job *pjob, struct batch_request *preq, svrattrl *pal, pbs_list_head *
 	return (0);
 }
 
+/**
+ * @brief
+ * 		status_job_unchanged - add an entry without any attributes for a job
+ *		which has not changed since the sequence number given by the client
+ *		in a delta select-status request, see req_selectjobs().
+ *
+ * @param[in]		pjob	-	ptr to job to status
+ * @param[in,out]	preq	-	request structure
+ * @param[in,out]	pstathd	-	RETURN: head of list to append status to
+ *
+ * @return	int
+ * @retval	0	: success
+ * @retval	PBSE_SYSTEM	: memory allocation error
+ */
+int
+status_job_unchanged(job *pjob, struct batch_request *preq, pbs_list_head *pstathd)
+{
+	struct brp_status *pstat;
+	pbs_arena *arena;
+
+	if ((arena = status_arena(preq)) == NULL)
+		return (PBSE_SYSTEM);
+	pstat = (struct brp_status *) pbs_arena_alloc(arena, sizeof(struct brp_status));
+	if (pstat == NULL)
+		return (PBSE_SYSTEM);
+	CLEAR_LINK(pstat->brp_stlink);
+	pstat->brp_objtype = MGR_OBJ_JOB;
+	(void) strcpy(pstat->brp_objname, pjob->ji_qs.ji_jobid);
+	CLEAR_HEAD(pstat->brp_attr);
+	append_link(pstathd, &pstat->brp_stlink, pstat);
+	preq->rq_reply.brp_count++;
+
+	return (0);
+}
+
 /**
  * @brief
  * 		status_subjob - status a single subjob (of an Array Job)
@@ -352,7 +730,9 @@ int
 status_subjob(job *pjob, struct batch_request *preq, svrattrl *pal, int subj, pbs_list_head *pstathd, int *bad, int dosubjobs)
 {
 	int limit = (int) JOB_ATR_LAST;
-	struct brp_status *pstat;
+	struct brp_status *pstat = NULL;
+	pbs_arena *arena = NULL;
+	int objtype;
 	job *psubjob; /* ptr to job to status */
 	char realstate;
 	int rc = 0;
@@ -362,6 +742,7 @@ status_subjob(job *pjob, struct batch_request *preq, svrattrl *pal, int subj, pb
 	char sjst;
 	int sjsst;
 	char *objname;
+	char sjid[PBS_MAXSVRJOBID + 1];
 
 	/* see if the client is authorized to status this job */
 
@@ -372,6 +753,8 @@ status_subjob(job *pjob, struct batch_request *preq, svrattrl *pal, int subj, pb
 	if ((pjob->ji_qs.ji_svrflags & JOB_SVFLG_ArrayJob) == 0)
 		return PBSE_IVALREQ;
 
+	update_job_modseq(pjob);
+
 	/* if subjob job obj exists, use real job structure */
 
 	psubjob = get_subjob_and_state(pjob, subj, &sjst, &sjsst);
@@ -387,23 +770,33 @@ status_subjob(job *pjob, struct batch_request *preq, svrattrl *pal, int subj, pb
 	objname = create_subjob_id(pjob->ji_qs.ji_jobid, subj);
 	if (objname == NULL)
 		return PBSE_SYSTEM;
+	/* the id is in a static buffer, keep it until the status is encoded */
+	pbs_strncpy(sjid, objname, sizeof(sjid));
+	objname = sjid;
 
 	/* for the general case, we don't want to include the parent's */
 	/* array related attrbutes as they belong only to the Array    */
 	if (pal == NULL)
 		limit = JOB_ATR_array;
-	pstat = (struct brp_status *) malloc(sizeof(struct brp_status));
-	if (pstat == NULL)
-		return (PBSE_SYSTEM);
-	CLEAR_LINK(pstat->brp_stlink);
 	if (dosubjobs)
-		pstat->brp_objtype = MGR_OBJ_SUBJOB;
+		objtype = MGR_OBJ_SUBJOB;
 	else
-		pstat->brp_objtype = MGR_OBJ_JOB;
-	(void) strcpy(pstat->brp_objname, objname);
-	CLEAR_HEAD(pstat->brp_attr);
-	append_link(pstathd, &pstat->brp_stlink, pstat);
-	preq->rq_reply.brp_count++;
+		objtype = MGR_OBJ_JOB;
+	if (!preq->rq_stream) {
+		if ((arena = status_arena(preq)) == NULL)
+			return (PBSE_SYSTEM);
+		pstat = (struct brp_status *) pbs_arena_alloc(arena, sizeof(struct brp_status));
+		if (pstat == NULL)
+			return (PBSE_SYSTEM);
+		CLEAR_HEAD(pstat->brp_attr);
+		if (pbs_arena_on_destroy(arena, svrcache_release, &pstat->brp_attr) != 0)
+			return (PBSE_SYSTEM);
+		CLEAR_LINK(pstat->brp_stlink);
+		pstat->brp_objtype = objtype;
+		(void) strcpy(pstat->brp_objname, objname);
+		append_link(pstathd, &pstat->brp_stlink, pstat);
+		preq->rq_reply.brp_count++;
+	}
 
 	/* add attributes to the status reply */
 
@@ -460,7 +853,9 @@ status_subjob(job *pjob, struct batch_request *preq, svrattrl *pal, int subj, pb
 		mark_jattr_not_set(pjob, JOB_ATR_accrue_type);
 	}
 
-	if (status_attrib(pal, job_attr_idx, job_attr_def, pjob->ji_wattr, limit, preq->rq_perm, &pstat->brp_attr, bad))
+	if (preq->rq_stream)
+		rc = status_stream(preq, objtype, objname, pal, pjob->ji_wattr, limit, bad);
+	else if (status_attrib(pal, job_attr_idx, job_attr_def, pjob->ji_wattr, limit, preq->rq_perm, &pstat->brp_attr, arena, bad))
 		rc = PBSE_NOATTR;
 
 	/* Set the parent state back to what it really is */
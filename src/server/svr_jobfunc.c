@@ -84,6 +84,7 @@
 #include "acct.h"
 #include "pbs_idx.h"
 #include "pbs_nodes.h"
+#include "pbs_db.h"
 #include "svrfunc.h"
 #include "sched_cmds.h"
 #include "dis.h"
@@ -624,7 +625,7 @@ svr_setjobstate(job *pjob, char newstate, int newsubstate)
 		return 0;
 	}
 
-	return (job_save_db(pjob));
+	return (job_save_db_async(pjob));
 }
 
 /**
@@ -4682,14 +4683,216 @@ svr_saveorpurge_finjobhist(job *pjob)
 	}
 	set_idle_delete_task(presv);
 }
+/*
+ * History jobs that are due to be purged after job_history_duration are
+ * kept in a binary min-heap ordered by their history_timestamp, so that
+ * svr_clean_job_history() only looks at the jobs that are due.  The order
+ * does not depend on job_history_duration, which may be changed at any time.
+ */
+#define HISTJOB_HEAP_INC 1024
+#define SVR_CLEAN_JOBHIST_BATCH 1000 /* purges committed in one DB transaction */
+
+static job **histjob_heap = NULL; /* history jobs, oldest first */
+static int histjob_heap_cnt = 0;
+static int histjob_heap_max = 0;
+
+/* ids of the history jobs purged in the open DB transaction */
+static char (*histjob_purged)[PBS_MAXSVRJOBID + 1] = NULL;
+static int histjob_purged_cnt = 0;
+
+/**
+ * @brief
+ *	Put the job at position i of the history heap, and record the position
+ *	in the job
+ */
+static void
+histjob_heap_set(int i, job *pjob)
+{
+	histjob_heap[i] = pjob;
+	pjob->ji_histidx = i;
+}
+
+/**
+ * @brief
+ *	Move the job at position i of the history heap up or down to its place
+ */
+static void
+histjob_heap_fix(int i)
+{
+	job *pjob = histjob_heap[i];
+	int child;
+
+	while (i > 0 && pjob->ji_histtime < histjob_heap[(i - 1) / 2]->ji_histtime) {
+		histjob_heap_set(i, histjob_heap[(i - 1) / 2]);
+		i = (i - 1) / 2;
+	}
+	while ((child = 2 * i + 1) < histjob_heap_cnt) {
+		if (child + 1 < histjob_heap_cnt &&
+		    histjob_heap[child + 1]->ji_histtime < histjob_heap[child]->ji_histtime)
+			child++;
+		if (histjob_heap[child]->ji_histtime >= pjob->ji_histtime)
+			break;
+		histjob_heap_set(i, histjob_heap[child]);
+		i = child;
+	}
+	histjob_heap_set(i, pjob);
+}
+
+/**
+ * @brief
+ *	Check whether the job is a history job which is purged once it is
+ *	older than job_history_duration: a finished or expired job, or a job
+ *	moved to another server and finished there.
+ *
+ * @param[in]	pjob	-	the job
+ *
+ * @return	int
+ * @retval	1	: the job is purged after job_history_duration
+ * @retval	0	: otherwise
+ */
+static int
+histjob_expires(job *pjob)
+{
+	return ((check_job_state(pjob, JOB_STATE_LTR_MOVED) && check_job_substate(pjob, JOB_SUBSTATE_FINISHED)) ||
+		check_job_state(pjob, JOB_STATE_LTR_FINISHED) ||
+		check_job_state(pjob, JOB_STATE_LTR_EXPIRED));
+}
+
+/**
+ * @brief
+ *	Add a history job to the history heap, or move it to its new place if
+ *	its history_timestamp changed.  A job recovered without a
+ *	history_timestamp gets one set here from the time it ended; the caller
+ *	saves the job.  Jobs which are not (or no more) due to be purged after
+ *	job_history_duration are taken off the heap.
+ *
+ * @param[in,out]	pjob	-	the job
+ *
+ * @return	void
+ */
+void
+svr_histjob_index(job *pjob)
+{
+	int walltime_used;
+
+	if (!histjob_expires(pjob)) {
+		svr_histjob_unindex(pjob);
+		return;
+	}
+
+	if (!(is_jattr_set(pjob, JOB_ATR_history_timestamp))) {
+		if (check_job_state(pjob, JOB_STATE_LTR_MOVED))
+			set_jattr_l_slim(pjob, JOB_ATR_history_timestamp, time_now, SET);
+		else {
+			if (((walltime_used = get_used_wall(pjob)) == -1) ||
+			    !(is_jattr_set(pjob, JOB_ATR_stime))) {
+				log_joberr(-1, __func__,
+					   "Finished job missing start-time/walltime used, cannot clean history",
+					   pjob->ji_qs.ji_jobid);
+				svr_histjob_unindex(pjob);
+				return;
+			}
+			set_jattr_l_slim(pjob, JOB_ATR_history_timestamp,
+					 get_jattr_long(pjob, JOB_ATR_stime) + walltime_used, SET);
+		}
+	}
+	pjob->ji_histtime = get_jattr_long(pjob, JOB_ATR_history_timestamp);
+
+	if (pjob->ji_histidx >= 0) {
+		histjob_heap_fix(pjob->ji_histidx);
+		return;
+	}
+
+	if (histjob_heap_cnt == histjob_heap_max) {
+		job **tmp;
+
+		tmp = realloc(histjob_heap, (histjob_heap_max + HISTJOB_HEAP_INC) * sizeof(job *));
+		if (tmp == NULL) {
+			log_err(errno, __func__, "Out of memory, job history will not be cleaned");
+			return;
+		}
+		histjob_heap = tmp;
+		histjob_heap_max += HISTJOB_HEAP_INC;
+	}
+	histjob_heap_set(histjob_heap_cnt++, pjob);
+	histjob_heap_fix(histjob_heap_cnt - 1);
+}
+
+/**
+ * @brief
+ *	Take a job off the history heap, if on it
+ *
+ * @param[in,out]	pjob	-	the job
+ *
+ * @return	void
+ */
+void
+svr_histjob_unindex(job *pjob)
+{
+	int i = pjob->ji_histidx;
+
+	if (i < 0)
+		return;
+	pjob->ji_histidx = -1;
+	if (--histjob_heap_cnt == i)
+		return;
+	histjob_heap_set(i, histjob_heap[histjob_heap_cnt]);
+	histjob_heap_fix(i);
+}
+
+/**
+ * @brief
+ *	End the DB transaction svr_clean_job_history() purged history jobs in.
+ *	If a delete failed, the transaction can only roll back: the jobs of
+ *	the batch are then deleted again one at a time, so only the jobs whose
+ *	delete fails again are left in the database.
+ *
+ * @return	void
+ */
+static void
+histjob_purge_commit(void)
+{
+	extern char *msg_err_purgejob_db;
+	pbs_db_obj_info_t obj;
+	pbs_db_job_info_t dbjob;
+	int nfailed = 0;
+	int i;
+
+	if (pbs_db_trx_failed(svr_db_conn))
+		pbs_db_end_trx(svr_db_conn, 0);
+	else if (pbs_db_end_trx(svr_db_conn, 1) == 0) {
+		log_eventf(PBSEVENT_DEBUG3, PBS_EVENTCLASS_SERVER, LOG_DEBUG, __func__,
+			   "Deleted %d purged history jobs from the database", histjob_purged_cnt);
+		histjob_purged_cnt = 0;
+		return;
+	}
+
+	obj.pbs_db_obj_type = PBS_DB_JOB;
+	obj.pbs_db_un.pbs_db_job = &dbjob;
+	for (i = 0; i < histjob_purged_cnt; i++) {
+		strcpy(dbjob.ji_jobid, histjob_purged[i]);
+		if (pbs_db_delete_obj(svr_db_conn, &obj) == -1) {
+			log_joberr(-1, __func__, msg_err_purgejob_db, histjob_purged[i]);
+			nfailed++;
+		}
+	}
+	log_eventf(PBSEVENT_ERROR, PBS_EVENTCLASS_SERVER, LOG_ERR, __func__,
+		   "Transaction of %d purged history jobs rolled back, deleted them one at a time: %d failed",
+		   histjob_purged_cnt, nfailed);
+	histjob_purged_cnt = 0;
+}
+
 /**
  * @brief
  *		Function name: svr_clean_job_history
- * @par Purpose: Periodically checks for the history jobs in the server and
- *		 purge the history jobs whose history duration exceeds the
- *		 configured job_history_duration server attribute.
- * @par Functionality: It is a work_task and reschedule itself after 2 mins if
- *		 and only if job_history_enable is set.
+ * @par Purpose: Periodically purges the history jobs whose history duration
+ *		 exceeds the configured job_history_duration server attribute.
+ * @par Functionality: It is a work_task and reschedules itself if and only if
+ *		 job_history_enable is set, when the oldest remaining history
+ *		 job is due but at most 2 mins later.  Only the jobs that are
+ *		 due are looked at, oldest first, off the history heap.  Purges
+ *		 are deleted from the database in batches, one transaction each,
+ *		 see histjob_purge_commit().
  *		Output: None
  *
  * @param[in]	pwt	-	work_task structure
@@ -4698,126 +4901,79 @@ void
 svr_clean_job_history(struct work_task *pwt)
 {
 	job *pjob;
-	job *nxpjob = NULL;
-	int walltime_used = 0;
-
-	/*
-	 * Keep track of time spent purging jobs, interrupts purge if necessary.
-	 * Timed task in nearby future set if purge took too long.
-	 * Timed task in far future only set if this task completes.
-	 * Autotunes time between job history purges:
-	 * - raised if last purge was short
-	 * - lowered if this purge needs to be interrupted
-	 */
-
+	int in_trx = 0;
 	time_t begin_time;
 	time_t end_time;
-	static time_t time_between_tasks = SVR_CLEAN_JOBHIST_TM;
+	time_t next_time;
 
 	begin_time = time(NULL);
-	/* Initialize end_time, in case we do not get into the while loop */
 	end_time = begin_time;
 
-	/*
-	 * Traverse through the SERVER job list and find the history
-	 * jobs (job with state JOB_STATE_LTR_MOVED and JOB_STATE_LTR_FINISHED)
-	 * which exceed the configured job_history_duration value and
-	 * purge them immediately.
-	 */
-	pjob = (job *) GET_NEXT(svr_alljobs);
-
-	while (pjob != NULL) {
-		/* save the next job */
-		nxpjob = (job *) GET_NEXT(pjob->ji_alljobs);
-
-		if ((check_job_state(pjob, JOB_STATE_LTR_MOVED) && check_job_substate(pjob, JOB_SUBSTATE_FINISHED)) ||
-		    (check_job_state(pjob, JOB_STATE_LTR_FINISHED)) ||
-		    (check_job_state(pjob, JOB_STATE_LTR_EXPIRED))) {
+	/* without room for the ids of a batch, every purge commits on its own */
+	if (histjob_purged == NULL)
+		histjob_purged = malloc(SVR_CLEAN_JOBHIST_BATCH * sizeof(*histjob_purged));
 
-			if (!(is_jattr_set(pjob, JOB_ATR_history_timestamp))) {
-				if (check_job_state(pjob, JOB_STATE_LTR_MOVED))
-					set_jattr_l_slim(pjob, JOB_ATR_history_timestamp, time_now, SET);
-				else {
-					if (((walltime_used = get_used_wall(pjob)) == -1) ||
-					    !(is_jattr_set(pjob, JOB_ATR_stime))) {
-						log_err(-1, "svr_clean_job_history",
-							"Finished job missing start-time/walltime used, cannot clean history");
-						pjob = nxpjob;
-						continue;
-					}
-					set_jattr_l_slim(pjob, JOB_ATR_history_timestamp,
-							 get_jattr_long(pjob, JOB_ATR_stime) + walltime_used, SET);
-				}
-				job_save_db(pjob);
-			}
+	while (histjob_heap_cnt > 0) {
+		pjob = histjob_heap[0];
 
-			if (time_now >= (get_jattr_long(pjob, JOB_ATR_history_timestamp) + svr_history_duration)) {
-				job_purge(pjob);
-				pjob = NULL;
-			}
+		/* left history without being purged, e.g. a requeued subjob */
+		if (!histjob_expires(pjob)) {
+			svr_histjob_unindex(pjob);
+			continue;
 		}
-		/* restore the saved next in pjob */
-		pjob = nxpjob;
+		if (time_now < pjob->ji_histtime + svr_history_duration)
+			break;
+
+		if (!in_trx && histjob_purged != NULL)
+			in_trx = (pbs_db_begin_trx(svr_db_conn) == 0);
+		if (in_trx)
+			pbs_strncpy(histjob_purged[histjob_purged_cnt++], pjob->ji_qs.ji_jobid, PBS_MAXSVRJOBID + 1);
+		svr_histjob_unindex(pjob);
+		job_purge(pjob);
 
 		/* check if we spent too long hogging the pbs_server process here */
 		end_time = time(NULL);
+		if (in_trx && (histjob_purged_cnt == SVR_CLEAN_JOBHIST_BATCH || pbs_db_trx_failed(svr_db_conn) ||
+			       (end_time - begin_time) > SVR_CLEAN_JOBHIST_SECS)) {
+			histjob_purge_commit();
+			in_trx = 0;
+		}
 		if ((end_time - begin_time) > SVR_CLEAN_JOBHIST_SECS) {
-			/* Apparently the interval between history purges is too long.
-			 * reduce it using factor 0.7
-			 */
-			time_between_tasks = (floor((double) time_between_tasks * 0.7));
-
-			/* no use reducing to less than 4 * SVR_CLEAN_JOBHIST_SECS
-			 * since we'll already schedule a continuation task here
-			 */
-			if (time_between_tasks < (4 * SVR_CLEAN_JOBHIST_SECS))
-				time_between_tasks = 4 * SVR_CLEAN_JOBHIST_SECS;
-
 			/* set up another work task in near future,
 			 * but leave as much time as we spent in this routine for other work first
 			 */
 			if (!set_task(WORK_Timed,
 				      (end_time + SVR_CLEAN_JOBHIST_SECS),
 				      svr_clean_job_history, NULL)) {
-				log_err(errno,
-					"svr_clean_job_history",
+				log_err(errno, __func__,
 					"Unable to set task for clean job history");
 				/* on error to set task
-					 * just continue purging the history
-					 */
+				 * just continue purging the history
+				 */
+				begin_time = end_time;
 			} else
 				/* but if we managed to set a task in near future, return;
 				 * that task will continue where we left off
 				 */
 				return;
 		}
-	} /* end of while loop through jobs */
+	}
+	if (in_trx)
+		histjob_purge_commit();
 
 	/* We purged everything necessary in this task if we get here.
-	 * set up another work task for next time period.
+	 * set up another work task for when the oldest history job is due.
 	 */
 	if (pwt && svr_history_enable) {
-		if (!set_task(WORK_Timed,
-			      (time_now + time_between_tasks),
-			      svr_clean_job_history, NULL)) {
-			log_err(errno,
-				"svr_clean_job_history",
+		next_time = time_now + SVR_CLEAN_JOBHIST_TM;
+		if (histjob_heap_cnt > 0 &&
+		    histjob_heap[0]->ji_histtime + svr_history_duration < next_time)
+			next_time = histjob_heap[0]->ji_histtime + svr_history_duration;
+		if (!set_task(WORK_Timed, next_time, svr_clean_job_history, NULL)) {
+			log_err(errno, __func__,
 				"Unable to set task for clean job history");
 		}
 	}
-
-	/* try to move the time between tasks up again
-	 * but only if we spent less than 2/3rds of what we were allowed to spend
-	 * Note the last purge of a chain of purges will often tend to undo part of the lowering
-	 * in the earlier incomplete purges -- that's OK: 0.7*1.1 is still smaller than 1
-	 */
-
-	if ((time_between_tasks < SVR_CLEAN_JOBHIST_TM) &&
-	    ((end_time - begin_time) < floor((double) SVR_CLEAN_JOBHIST_SECS * 2 / 3))) {
-		time_between_tasks = ceil((double) time_between_tasks * 1.1);
-		if (time_between_tasks > SVR_CLEAN_JOBHIST_TM)
-			time_between_tasks = SVR_CLEAN_JOBHIST_TM;
-	}
 }
 
 /**
@@ -4890,6 +5046,7 @@ svr_histjob_update(job *pjob, char newstate, int newsubstate)
 		}
 	}
 
+	svr_histjob_index(pjob);
 	job_save_db(pjob);
 }
 
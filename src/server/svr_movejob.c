@@ -713,6 +713,9 @@ send_job(job *jobp, pbs_net_t hostaddr, int port, int move_type,
 	struct in_addr addr;
 	long tempval;
 
+	/* the job is in the database as sent, should the server restart */
+	job_save_wait(jobp);
+
 	/* if job has a script read it from database */
 	if (jobp->ji_qs.ji_svrflags & JOB_SVFLG_SCRIPT) {
 		if (svr_load_jobscript(jobp) == NULL) {
@@ -124,6 +124,7 @@ api_to_cli = {
     ATTR_max_run_soft: 'max_run_soft',
     ATTR_max_run_res_soft: 'max_run_res_soft',
     ATTR_total: 'total_jobs',
+    ATTR_status_seq: 'status_sequence',
     ATTR_comment: 'W comment=',
     ATTR_cookie: 'cookie',
     ATTR_qrank: 'queue_rank',
@@ -150,6 +150,7 @@ ATTR_max_run_res = 'max_run_res'
 ATTR_max_run_soft = 'max_run_soft'
 ATTR_max_run_res_soft = 'max_run_res_soft'
 ATTR_total = 'total_jobs'
+ATTR_status_seq = 'status_sequence'
 ATTR_comment = 'comment'
 ATTR_cookie = 'cookie'
 ATTR_qrank = 'queue_rank'
@@ -488,7 +488,7 @@ class Server(Wrappers):
         Unset server attributes
         """
         ignore_attrs = ['id', 'pbs_license', ATTR_NODE_ProvisionEnable]
-        ignore_attrs += [ATTR_status, ATTR_total, ATTR_count]
+        ignore_attrs += [ATTR_status, ATTR_total, ATTR_count, ATTR_status_seq]
         ignore_attrs += [ATTR_rescassn, ATTR_FLicenses, ATTR_SvrHost]
         ignore_attrs += [ATTR_license_count, ATTR_version, ATTR_managers]
         ignore_attrs += [ATTR_operators, ATTR_license_min]
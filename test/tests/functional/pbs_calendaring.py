@@ -358,3 +358,38 @@ class TestCalendaring(TestFunctional):
         c = "Not Running: Job would conflict with reservation or top job"
         self.server.expect(JOB, {ATTR_state: 'Q', ATTR_comment: c}, id=jid3)
         self.server.expect(JOB, {ATTR_state: 'Q', ATTR_comment: c}, id=jid4)
+
+    def test_topjob_start_time_staggered_ends(self):
+        """
+        Test that a top job's estimated start time is the end of the
+        running job which frees enough resources for it, when running jobs
+        end one after another and the job can not fit at the earlier ends.
+        """
+
+        self.scheduler.set_sched_config({'strict_ordering': 'true all'})
+        a = {'resources_available.ncpus': 4}
+        self.server.manager(MGR_CMD_SET, NODE, a, self.mom.shortname)
+        a = {'opt_backfill_fuzzy': 'off'}
+        self.server.manager(MGR_CMD_SET, SCHED, a)
+
+        jids = []
+        for walltime in [100, 200, 300, 400]:
+            a = {'Resource_List.select': '1:ncpus=1',
+                 'Resource_List.walltime': walltime}
+            j = Job(TEST_USER, attrs=a)
+            jids.append(self.server.submit(j))
+            self.server.expect(JOB, {'job_state': 'R'}, id=jids[-1])
+
+        a = {'Resource_List.select': '1:ncpus=3',
+             'Resource_List.walltime': 100}
+        j = Job(TEST_USER, attrs=a)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'Q'}, id=jid)
+        self.server.expect(JOB, 'estimated.start_time', op=SET, id=jid)
+
+        # 3 cpus are free once the third running job ends
+        job = self.server.status(JOB, id=jids[2])
+        stime = int(time.mktime(time.strptime(job[0]['stime'], '%c')))
+        job = self.server.status(JOB, id=jid)
+        est = time.strptime(job[0]['estimated.start_time'], '%c')
+        self.assertEqual(int(time.mktime(est)), stime + 300)
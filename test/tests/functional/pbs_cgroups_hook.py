@@ -3195,6 +3195,68 @@ if %s e.job.in_ms_mom():
         if self.swapctl == 'true':
             self.assertNotEqual(vmem1, vmem2)
 
+    def run_cput_job(self, script):
+        """
+        Run a job to its end and return its resources_used.cput in seconds
+        """
+        a = {'Resource_List.select': '1:ncpus=1', ATTR_k: 'oe'}
+        j = Job(TEST_USER, attrs=a)
+        j.create_script(script)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'F'}, id=jid, extend='x',
+                           offset=40, interval=2, max_attempts=60)
+        st = self.server.status(JOB, 'resources_used.cput', id=jid,
+                                extend='x')
+        h, m, sec = st[0]['resources_used.cput'].split(':')
+        return int(h) * 3600 + int(m) * 60 + int(sec)
+
+    def test_cgroup_job_sample_matches_full_scan(self):
+        """
+        Test that MoM, sampling only the processes in the job cgroups,
+        accounts the same CPU time as when it samples all of /proc, and
+        that the usage of a busy job is not taken for that of an idle one
+        """
+        self.server.manager(MGR_CMD_SET, SERVER,
+                            {'job_history_enable': 'True'})
+        self.load_config(self.cfg3 % ('', 'false', '', self.mem, '',
+                                      self.swapctl, ''))
+        busy = """#!/bin/bash
+#PBS -joe
+end=$((SECONDS + 40))
+(while [ $SECONDS -lt $end ]; do : ; done) &
+wait
+"""
+        a = {'Resource_List.select': '1:ncpus=1', ATTR_k: 'oe'}
+        idle = Job(TEST_USER, attrs=a)
+        idle.create_script(self.sleep600_job)
+        idle_id = self.server.submit(idle)
+        self.server.expect(JOB, {'job_state': 'R'}, id=idle_id)
+
+        start = int(time.time())
+        cput_cgroup = self.run_cput_job(busy)
+        self.mom.log_match('mom_get_job_sample;cgroups:', starttime=start)
+
+        st = self.server.status(JOB, 'resources_used.cput', id=idle_id)
+        h, m, sec = st[0]['resources_used.cput'].split(':')
+        idle_cput = int(h) * 3600 + int(m) * 60 + int(sec)
+        self.assertLess(idle_cput, 5, 'idle job charged %d sec' % idle_cput)
+        self.server.delete(idle_id, wait=True)
+
+        # without the hook the tasks are in no job cgroup
+        self.server.manager(MGR_CMD_SET, HOOK, {'enabled': 'False'},
+                            self.hook_name)
+        time.sleep(5)
+        start = int(time.time())
+        cput_scan = self.run_cput_job(busy)
+        self.mom.log_match('task not in a job cgroup, sampling all processes',
+                           starttime=start)
+
+        self.logger.info('cput sampled from cgroups %d sec, from /proc %d sec'
+                         % (cput_cgroup, cput_scan))
+        self.assertGreater(cput_scan, 20)
+        self.assertLessEqual(abs(cput_cgroup - cput_scan),
+                             max(5, cput_scan // 5))
+
     def test_cgroup_reserve_mem(self):
         """
         Test to verify that the mom reserve memory for OS
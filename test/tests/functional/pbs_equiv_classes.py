@@ -2127,3 +2127,44 @@ else:
                 break
         self.assertTrue(found, "%s didn't found in any sched cycle" % jidh)
         self.assertIn(jid2.split('.')[0], sched_cycle.sched_job_run)
+
+    def test_verdict_reused_across_cycles(self):
+        """
+        Test that the reason an equivalence class can not run is reused in
+        the next cycle if nothing it depends on changed, and that changing
+        the nodes makes the scheduler check the class again
+        """
+        self.server.manager(MGR_CMD_SET, SERVER,
+                            {'scheduling': 'False'})
+
+        # Eat up all but 2 cpus
+        a = {'Resource_List.select': '1:ncpus=6'}
+        (jid1, ) = self.submit_jobs(1, a)
+
+        a = {'Resource_List.select': '1:ncpus=4'}
+        jids = self.submit_jobs(3, a)
+
+        self.server.manager(MGR_CMD_SET, SERVER,
+                            {'scheduling': 'True'})
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid1)
+        self.server.expect(JOB, {'job_state': 'Q'}, id=jids[0])
+
+        # Submitting a job starts a new cycle, but does not change whether
+        # the ncpus=4 jobs can run
+        t = time.time()
+        a = {'Resource_List.select': '1:ncpus=3'}
+        (jid2, ) = self.submit_jobs(1, a)
+        self.scheduler.log_match(jids[0] + ";Equivalence class can not "
+                                 "run for the same reason as in a previous "
+                                 "cycle", starttime=t)
+        m = 'Not Running: Insufficient amount of resource: ncpus'
+        self.server.expect(JOB, {'comment': (MATCH_RE, m)}, id=jids[0])
+
+        # More cpus on the node changes the universe; the class is checked
+        # again and its first job runs
+        self.server.manager(MGR_CMD_SET, NODE,
+                            {'resources_available.ncpus': 12},
+                            id=self.mom.shortname)
+        self.server.manager(MGR_CMD_SET, SERVER,
+                            {'scheduling': 'True'})
+        self.server.expect(JOB, {'job_state': 'R'}, id=jids[0])
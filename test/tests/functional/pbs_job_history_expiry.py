@@ -0,0 +1,99 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+from tests.functional import *
+
+
+class TestJobHistoryExpiry(TestFunctional):
+    """
+    Test that history jobs are purged once they are older than
+    job_history_duration
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        a = {'resources_available.ncpus': 2}
+        self.server.manager(MGR_CMD_SET, NODE, a, id=self.mom.shortname)
+
+    def submit_finished(self):
+        """
+        Submit a short job and wait for it to be in history
+        """
+        j = Job(TEST_USER, attrs={ATTR_k: 'oe'})
+        j.set_sleep_time(1)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, {'job_state': 'F'}, id=jid, extend='x',
+                           offset=1)
+        return jid
+
+    def test_history_expires_when_due(self):
+        """
+        Test that only the history jobs older than job_history_duration
+        are purged, and that the next purge happens when the next history
+        job is due rather than a full cleanup interval later
+        """
+        a = {'job_history_enable': 'True',
+             'job_history_duration': '00:01:00'}
+        self.server.manager(MGR_CMD_SET, SERVER, a)
+        jid1 = self.submit_finished()
+        time.sleep(80)
+        jid2 = self.submit_finished()
+
+        self.server.expect(JOB, 'job_state', op=UNSET, extend='x',
+                           id=jid1, interval=5, max_attempts=40)
+        self.server.expect(JOB, {'job_state': 'F'}, id=jid2, extend='x',
+                           max_attempts=1)
+        self.server.expect(JOB, 'job_state', op=UNSET, extend='x',
+                           id=jid2, interval=5, max_attempts=12)
+
+    def test_history_expires_after_restart(self):
+        """
+        Test that history jobs recovered at server start are purged
+        once they are older than job_history_duration
+        """
+        a = {'job_history_enable': 'True',
+             'job_history_duration': '00:00:05'}
+        self.server.manager(MGR_CMD_SET, SERVER, a)
+        jid = self.submit_finished()
+        self.server.restart()
+        self.server.expect(JOB, {'job_state': 'F'}, id=jid, extend='x',
+                           max_attempts=1)
+        self.server.expect(JOB, 'job_state', op=UNSET, extend='x',
+                           id=jid, interval=5, max_attempts=30)
@@ -0,0 +1,84 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+
+from tests.functional import *
+
+
+class TestJobSaveAsync(TestFunctional):
+    """
+    Test that job saves queued to the server's DB thread recover the job
+    as it was saved last
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        a = {'resources_available.ncpus': 4}
+        self.server.manager(MGR_CMD_SET, NODE, a, id=self.mom.shortname)
+
+    def test_state_then_attr_change_restart(self):
+        """
+        Test that a job state change followed by an attribute only change
+        keeps the job state and queue after a server restart.  Starting an
+        array job changes the parent's state, then the starting subjobs
+        change only the parent's array_indices_remaining.
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        jids = []
+        for _ in range(5):
+            j = Job(TEST_USER, attrs={ATTR_J: '1-4', ATTR_k: 'oe'})
+            j.set_sleep_time(1000)
+            jids.append(self.server.submit(j))
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'True'})
+        self.server.expect(JOB, {'job_state': 'B'}, id=jids[0])
+        self.server.expect(JOB, {'job_state=R': 4}, count=True,
+                           id=jids[0], extend='t')
+
+        qname = 'workq'
+        a = {'job_state': 'Q', 'queue': qname}
+        for jid in jids[1:]:
+            self.server.expect(JOB, a, id=jid)
+        self.server.alterjob(jids[-1], {ATTR_p: '10'})
+
+        self.server.restart()
+        self.server.expect(JOB, {'job_state': 'B', 'queue': qname},
+                           id=jids[0])
+        for jid in jids[1:]:
+            self.server.expect(JOB, a, id=jid)
+        self.server.expect(JOB, {ATTR_p: '10'}, id=jids[-1])
@@ -72,3 +72,33 @@ class TestJobSortFormula(TestFunctional):
             self.assertEqual(job.split('.')[0], c.political_order[i])
 
         self.server.expect(JOB, {'job_state=R': 2})
+
+    def test_job_sort_formula_python_semantics(self):
+        """
+        Test that formulas evaluated natively by the scheduler give the
+        same answers as formulas which need to be evaluated by python
+        """
+        self.server.manager(MGR_CMD_CREATE, RSC, {'type': 'long'}, id='foo')
+        self.server.manager(MGR_CMD_SET, SCHED, {'log_events': 2047})
+
+        formulas = ['foo // 2 + foo % -3 - 2 ** 2',
+                    'min(foo, 100) // 2 + foo % -3 - 2 ** 2']
+        msg = ';Formula Evaluation = '
+        for f in formulas:
+            a = {'job_sort_formula': f, 'scheduling': 'False'}
+            self.server.manager(MGR_CMD_SET, SERVER, a, runas=ROOT_USER)
+            j = Job(TEST_USER, attrs={'Resource_List.foo': 7})
+            jid = self.server.submit(j)
+            self.scheduler.run_scheduling_cycle()
+            self.scheduler.log_match(jid + msg + '-3')
+            self.server.delete(jid, wait=True)
+
+        # Errors like division by zero result in a zero value
+        a = {'job_sort_formula': 'foo / (foo - 7)'}
+        self.server.manager(MGR_CMD_SET, SERVER, a, runas=ROOT_USER)
+        j = Job(TEST_USER, attrs={'Resource_List.foo': 7})
+        jid = self.server.submit(j)
+        self.scheduler.run_scheduling_cycle()
+        self.scheduler.log_match(jid + ';Formula evaluation for job had an '
+                                 'error.  Zero value will be used')
+        self.scheduler.log_match(jid + msg + '0')
@@ -0,0 +1,129 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+from tests.functional import *
+
+
+class TestLogAsync(TestFunctional):
+    """
+    Test daemon event logging through the log writer thread turned on
+    by PBS_LOG_ASYNC in pbs.conf
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.du.set_pbs_config(self.server.hostname,
+                               confs={'PBS_LOG_ASYNC': '1'})
+        self.server.restart()
+        self.scheduler.restart()
+
+    def test_log_async_records(self):
+        """
+        Test that the server and scheduler still log every event of a
+        job, in order, when logging asynchronously
+        """
+        t = time.time()
+        j = Job(attrs={'Resource_List.walltime': 10})
+        j.set_sleep_time(1)
+        jid = self.server.submit(j)
+        self.server.expect(JOB, 'queue', op=UNSET, id=jid)
+        self.server.log_match(jid + ';Job Queued at request of',
+                              starttime=t)
+        self.server.log_match(jid + ';Job Run at request of', starttime=t)
+        self.server.log_match(jid + ';Exit_status=0', starttime=t)
+        self.scheduler.log_match(jid + ';Job run', starttime=t)
+
+        lines = self.server.log_match(jid, allmatch=True, starttime=t)
+        msgs = [l[1] for l in lines]
+        queued = [i for i, m in enumerate(msgs)
+                  if 'Job Queued at request of' in m]
+        run = [i for i, m in enumerate(msgs) if 'Job Run at request of' in m]
+        self.assertTrue(queued and run and queued[0] < run[0])
+
+    def test_log_async_shutdown(self):
+        """
+        Test that the records logged just before the server shuts down
+        are in its log
+        """
+        t = time.time()
+        for _ in range(20):
+            self.server.submit(Job())
+        self.server.stop()
+        self.server.log_match('Server shutdown completed', starttime=t)
+        self.server.log_match('Log closed', starttime=t, max_attempts=1)
+        self.server.start()
+
+    def nthreads(self, daemon):
+        """
+        Return the number of threads of a daemon
+        """
+        cmd = ['ps', '-o', 'nlwp=', '-p', daemon.get_pid()]
+        ret = self.du.run_cmd(daemon.hostname, cmd)
+        self.assertEqual(ret['rc'], 0)
+        return int(ret['out'][0])
+
+    def test_log_async_sighup(self):
+        """
+        Test that the server and scheduler keep logging through the log
+        writer thread after SIGHUP reopens their logs
+        """
+        for daemon in [self.server, self.scheduler]:
+            nthreads = self.nthreads(daemon)
+            t = time.time()
+            self.assertTrue(daemon.signal('-HUP'))
+            daemon.log_match('Log closed', starttime=t)
+            daemon.log_match('Log opened', starttime=t)
+            self.assertEqual(self.nthreads(daemon), nthreads)
+
+        t = time.time()
+        jid = self.server.submit(Job())
+        self.server.log_match(jid + ';Job Queued at request of',
+                              starttime=t)
+        self.scheduler.log_match(jid + ';Job run', starttime=t)
+        self.assertTrue(self.server.signal('-HUP'))
+        self.server.delete(jid)
+        self.server.log_match(jid + ';Job to be deleted at request of',
+                              starttime=t)
+
+    def tearDown(self):
+        self.du.unset_pbs_config(self.server.hostname,
+                                 confs=['PBS_LOG_ASYNC'])
+        self.server.restart()
+        self.scheduler.restart()
+        TestFunctional.tearDown(self)
@@ -37,6 +37,7 @@
 # "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
 # subject to Altair's trademark licensing policies.
 
+import json
 
 from tests.functional import *
 
@@ -157,3 +158,67 @@ class TestQstat(TestFunctional):
                                       % re.escape(self.mom.shortname),
                                       qstat_out), None, "The exec host does"
                             " not contain the task slot number")
+
+    def test_qstat_f_shared_encodings(self):
+        """
+        Test that qstat -f -t of enough jobs for the reply to be sent by
+        the reply threads shows every job and subjob, the subjobs sharing
+        the cached attribute encodings of their parent, and shows the new
+        values once the cached encodings of altered jobs were replaced
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        a = {'Resource_List.walltime': '01:00:00'}
+        jids = [self.server.submit(Job(TEST_USER, attrs=a))
+                for _ in range(100)]
+        jid = self.server.submit(Job(TEST_USER, attrs={ATTR_J: '1-100'}))
+        qstat_cmd = os.path.join(self.server.pbs_conf['PBS_EXEC'],
+                                 'bin', 'qstat')
+        for walltime, count in [('01:00:00', 100), ('02:00:00', 50)]:
+            if count == 50:
+                for j in jids[:50]:
+                    self.server.alterjob(j,
+                                         {'Resource_List.walltime': walltime})
+            ret = self.du.run_cmd(self.server.hostname,
+                                  cmd=[qstat_cmd, '-f', '-t'])
+            self.assertEqual(ret['rc'], 0,
+                             'Qstat returned with non-zero exit status')
+            out = '\n'.join(ret['out'])
+            self.assertEqual(out.count('Job Id: '), 100 + 101)
+            self.assertEqual(out.count('Job Id: %s[' % jid.split('[')[0]),
+                             101)
+            self.assertEqual(out.count('Resource_List.walltime = %s' %
+                                       walltime), count)
+
+    def test_qstat_streamed(self):
+        """
+        Test that qstat, which displays the jobs as the server streams them,
+        shows the header once and the same jobs in the same order as the
+        JSON output, which is built from the whole status, with the subjobs
+        right after their parent
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        jids = [self.server.submit(Job(TEST_USER)) for _ in range(3)]
+        ajid = self.server.submit(Job(TEST_USER, attrs={ATTR_J: '1-5'}))
+        jids.append(self.server.submit(Job(TEST_USER)))
+        qstat_cmd = os.path.join(self.server.pbs_conf['PBS_EXEC'],
+                                 'bin', 'qstat')
+        ret = self.du.run_cmd(self.server.hostname, cmd=[qstat_cmd, '-t'])
+        self.assertEqual(ret['rc'], 0,
+                         'Qstat returned with non-zero exit status')
+        self.assertEqual(len([l for l in ret['out']
+                              if l.startswith('Job id')]), 1)
+        shown = [l.split()[0] for l in ret['out'][2:]]
+
+        ret = self.du.run_cmd(self.server.hostname,
+                              cmd=[qstat_cmd, '-t', '-f', '-F', 'json'])
+        self.assertEqual(ret['rc'], 0,
+                         'Qstat returned with non-zero exit status')
+        full = list(json.loads('\n'.join(ret['out']))['Jobs'])
+        self.assertEqual(len(shown), len(jids) + 6)
+        self.assertEqual([j.split('.')[0] for j in full],
+                         [j.split('.')[0] for j in shown])
+        prefix = ajid.split('[')[0]
+        i = [j.split('.')[0] for j in full].index(prefix + '[]')
+        self.assertEqual([j.split('.')[0] for j in full[i:i + 6]],
+                         [prefix + '[]'] +
+                         [prefix + '[%d]' % n for n in range(1, 6)])
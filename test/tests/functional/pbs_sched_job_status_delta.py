@@ -0,0 +1,89 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+from tests.functional import *
+
+
+class TestSchedJobStatusDelta(TestFunctional):
+    """
+    Tests for the scheduler querying only the jobs which changed since
+    its previous cycle
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        a = {'resources_available.ncpus': 1}
+        self.server.manager(MGR_CMD_SET, NODE, a, self.mom.shortname)
+        self.server.manager(MGR_CMD_SET, SCHED, {'log_events': 2047})
+
+    def test_unchanged_jobs_use_cache(self):
+        """
+        Test that jobs which did not change between cycles are taken from
+        the scheduler's cache and jobs which changed are seen with their
+        new attribute values
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        a = {'Resource_List.select': '1:ncpus=2'}
+        jid1 = self.server.submit(Job(TEST_USER, attrs=a))
+        jid2 = self.server.submit(Job(TEST_USER, attrs=a))
+
+        st = self.server.status(SERVER, 'status_sequence')[0]
+        seq = int(st['status_sequence'])
+
+        # The first cycle comments on the jobs, which changes them
+        self.scheduler.run_scheduling_cycle()
+        self.scheduler.run_scheduling_cycle()
+        self.server.expect(JOB, {'job_state': 'Q'}, id=jid1)
+        self.server.expect(JOB, {'job_state': 'Q'}, id=jid2)
+
+        t = time.time()
+        self.scheduler.run_scheduling_cycle()
+        self.scheduler.log_match('2 of 2 jobs unchanged since status sequence',
+                                 starttime=t)
+
+        st = self.server.status(SERVER, 'status_sequence')[0]
+        self.assertGreater(int(st['status_sequence']), seq)
+
+        self.server.alterjob(jid1, {'Resource_List.select': '1:ncpus=1'})
+        t = time.time()
+        self.scheduler.run_scheduling_cycle()
+        self.scheduler.log_match('1 of 2 jobs unchanged since status sequence',
+                                 starttime=t)
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid1)
+        self.server.expect(JOB, {'job_state': 'Q'}, id=jid2)
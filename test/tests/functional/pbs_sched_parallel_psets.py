@@ -0,0 +1,97 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+from tests.functional import *
+
+
+class TestSchedParallelPsets(TestFunctional):
+    """
+    Tests for the scheduler checking placement sets on its worker threads
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        self.du.set_pbs_config(self.server.hostname,
+                               confs={'PBS_SCHED_THREADS': '4'})
+        self.scheduler.restart()
+
+        a = {'type': 'string', 'flag': 'h'}
+        self.server.manager(MGR_CMD_CREATE, RSC, a, id='switch')
+        self.scheduler.add_resource('switch', apply=True)
+        a = {'resources_available.ncpus': 1}
+        self.mom.create_vnodes(a, 40, attrfunc=self.cust_attr,
+                               usenatvnode=False)
+        self.vn = self.mom.shortname + '[30]'
+        self.server.manager(MGR_CMD_SET, NODE,
+                            {'resources_available.ncpus': 4}, id=self.vn)
+        a = {'node_group_key': 'switch', 'node_group_enable': 'True'}
+        self.server.manager(MGR_CMD_SET, SERVER, a)
+
+    def cust_attr(self, name, totnodes, numnode, attrib):
+        attr = {'resources_available.switch': 'sw' + str(numnode)}
+        return {**attrib, **attr}
+
+    def tearDown(self):
+        self.du.unset_pbs_config(self.server.hostname,
+                                 confs='PBS_SCHED_THREADS')
+        self.scheduler.restart()
+        TestFunctional.tearDown(self)
+
+    def test_job_runs_in_only_fitting_pset(self):
+        """
+        Test that a job which fits into one placement set of many is
+        placed into it
+        """
+        a = {'Resource_List.select': '1:ncpus=4'}
+        jid = self.server.submit(Job(TEST_USER, attrs=a))
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid)
+        self.server.expect(JOB, {'exec_vnode': '(' + self.vn + ':ncpus=4)'},
+                           id=jid)
+
+    def test_job_fits_no_pset(self):
+        """
+        Test that a job which fits into none of many placement sets gets
+        the same reason as when the placement sets are checked serially
+        """
+        self.server.manager(MGR_CMD_SET, SCHED, {'do_not_span_psets': 'True'})
+        a = {'Resource_List.select': '1:ncpus=8'}
+        jid = self.server.submit(Job(TEST_USER, attrs=a))
+        c = "Can Never Run: can't fit in the largest placement set, " \
+            "and can't span psets"
+        self.server.expect(JOB, {'comment': c}, id=jid)
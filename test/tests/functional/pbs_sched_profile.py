@@ -0,0 +1,110 @@
+# coding: utf-8
+
+# Copyright (C) 1994-2021 Altair Engineering, Inc.
+# For more information, contact Altair at www.altair.com.
+#
+# This file is part of both the OpenPBS software ("OpenPBS")
+# and the PBS Professional ("PBS Pro") software.
+#
+# Open Source License Information:
+#
+# OpenPBS is free software. You can redistribute it and/or modify it under
+# the terms of the GNU Affero General Public License as published by the
+# Free Software Foundation, either version 3 of the License, or (at your
+# option) any later version.
+#
+# OpenPBS is distributed in the hope that it will be useful, but WITHOUT
+# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public
+# License for more details.
+#
+# You should have received a copy of the GNU Affero General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+#
+# Commercial License Information:
+#
+# PBS Pro is commercially licensed software that shares a common core with
+# the OpenPBS software.  For a copy of the commercial license terms and
+# conditions, go to: (http://www.pbspro.com/agreement.html) or contact the
+# Altair Legal Department.
+#
+# Altair's dual-license business model allows companies, individuals, and
+# organizations to create proprietary derivative works of OpenPBS and
+# distribute them - whether embedded or bundled with other software -
+# under a commercial license agreement.
+#
+# Use of Altair's trademarks, including but not limited to "PBS™",
+# "OpenPBS®", "PBS Professional®", and "PBS Pro™" and Altair's logos is
+# subject to Altair's trademark licensing policies.
+
+import json
+
+from tests.functional import *
+
+
+class TestSchedProfile(TestFunctional):
+    """
+    Test the scheduler's cycle profiler turned on by sched_profile
+    """
+
+    def setUp(self):
+        TestFunctional.setUp(self)
+        a = {'resources_available.ncpus': 1}
+        self.server.manager(MGR_CMD_SET, NODE, a, id=self.mom.shortname)
+        sched_priv = os.path.dirname(self.scheduler.sched_config_file)
+        self.prof_json = os.path.join(sched_priv, 'sched_profile.json')
+        self.prof_folded = os.path.join(sched_priv, 'sched_profile.folded')
+        for f in [self.prof_json, self.prof_folded]:
+            self.du.rm(self.server.hostname, f, sudo=True, force=True)
+
+    def test_profile_written(self):
+        """
+        Test that a cycle run with sched_profile set writes a JSON record
+        with the phases of the cycle and the jobs considered, and the
+        collapsed stacks of the cycle
+        """
+        a = {'sched_profile': 'True', 'scheduling': 'False'}
+        self.server.manager(MGR_CMD_SET, SCHED, a, id='default')
+        jid1 = self.server.submit(Job())
+        jid2 = self.server.submit(Job())
+
+        t = time.time()
+        self.scheduler.run_scheduling_cycle()
+        self.server.expect(JOB, {'job_state': 'R'}, id=jid1)
+        self.server.expect(JOB, {'job_state': 'Q'}, id=jid2)
+        self.scheduler.log_match('profile written to', starttime=t)
+
+        ret = self.du.cat(self.server.hostname, self.prof_json, sudo=True)
+        self.assertEqual(ret['rc'], 0)
+        rec = json.loads(ret['out'][-1])
+        stacks = [p['stack'] for p in rec['phases']]
+        self.assertIn('scheduling_cycle', stacks)
+        self.assertIn('scheduling_cycle;query_server', stacks)
+        self.assertIn('scheduling_cycle;main_sched_loop;is_ok_to_run',
+                      stacks)
+        self.assertEqual(rec['jobs_considered'], 2)
+        jobs = [j['jobid'] for j in rec['slowest_jobs']]
+        self.assertIn(jid1, jobs)
+        self.assertIn(jid2, jobs)
+
+        ret = self.du.cat(self.server.hostname, self.prof_folded, sudo=True)
+        self.assertEqual(ret['rc'], 0)
+        for line in ret['out']:
+            stack, usecs = line.rsplit(' ', 1)
+            self.assertTrue(stack.startswith('scheduling_cycle') or
+                            stack.startswith('worker_threads;'))
+            self.assertGreater(int(usecs), 0)
+
+    def test_profile_off(self):
+        """
+        Test that nothing is written when sched_profile is unset
+        """
+        self.server.manager(MGR_CMD_SET, SCHED, {'scheduling': 'False'},
+                            id='default')
+        self.server.submit(Job())
+        t = time.time()
+        self.scheduler.run_scheduling_cycle()
+        self.scheduler.log_match('profile written to', starttime=t,
+                                 existence=False, max_attempts=2)
+        self.assertFalse(self.du.isfile(self.server.hostname,
+                                        path=self.prof_json, sudo=True))
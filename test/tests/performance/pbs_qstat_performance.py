@@ -39,6 +39,9 @@
 
 
 import os
+import subprocess
+import time
+from threading import Event, Thread
 
 from tests.performance import *
 
@@ -152,3 +155,88 @@ class TestQstatPerformance(TestPerformance):
         Submit 1000 job and compute performace of qstat
         """
         self.submit_and_stat_jobs(1000)
+
+    def qstat_load(self, stop, opts):
+        """
+        Run qstat of all jobs in a loop until stop is set
+        Arguments :
+             stop - threading Event telling the loop to stop
+             opts - qstat options
+        """
+        qstat = os.path.join(self.server.client_conf['PBS_EXEC'],
+                             'bin', 'qstat') + ' ' + opts
+        while not stop.is_set():
+            subprocess.call(qstat, shell=True, stdout=subprocess.DEVNULL,
+                            stderr=subprocess.DEVNULL)
+
+    def qsub_latency(self, num_jobs):
+        """
+        Submit jobs one by one and return the time each qsub took
+        Arguments :
+             num_jobs - number of jobs to submit
+        """
+        qsub = os.path.join(self.server.client_conf['PBS_EXEC'],
+                            'bin', 'qsub') + ' -- /bin/sleep 1000'
+        times = []
+        for _ in range(num_jobs):
+            start = time.time()
+            ret = self.du.run_cmd(self.server.hostname, qsub,
+                                  runas=TEST_USER1, logerr=False)
+            self.assertEqual(ret['rc'], 0, "qsub failed")
+            times.append(time.time() - start)
+        return times
+
+    def qsub_latency_under_qstat_load(self, opts, name):
+        """
+        Measure qsub latency while several clients keep running qstat
+        of 5000 jobs
+        Arguments :
+             opts - qstat options
+             name - name of the results, e.g. qstat_load
+        """
+        self.server.manager(MGR_CMD_SET, SERVER, {'scheduling': 'False'})
+        self.submit_jobs(TEST_USER1, 5000)
+
+        idle = self.qsub_latency(50)
+
+        stop = Event()
+        loaders = [Thread(target=self.qstat_load, args=(stop, opts))
+                   for _ in range(8)]
+        for t in loaders:
+            t.start()
+        try:
+            loaded = self.qsub_latency(50)
+        finally:
+            stop.set()
+            for t in loaders:
+                t.join()
+
+        idle_avg = sum(idle) / len(idle)
+        loaded_avg = sum(loaded) / len(loaded)
+        self.logger.info("qsub latency idle: avg %.3f max %.3f sec" %
+                         (idle_avg, max(idle)))
+        self.logger.info("qsub latency under qstat %s load: avg %.3f "
+                         "max %.3f sec" % (opts, loaded_avg, max(loaded)))
+        self.perf_test_result(idle_avg, "qsub_latency_idle", "sec")
+        self.perf_test_result(loaded_avg, "qsub_latency_" + name, "sec")
+        self.perf_test_result(max(loaded), "qsub_latency_" + name + "_max",
+                              "sec")
+
+    @timeout(1800)
+    def test_qsub_latency_under_qstat_load(self):
+        """
+        Measure qsub latency while several clients keep running qstat -f
+        of 5000 jobs, the whole status reply being built by the server and
+        sent by its reply threads rather than its main loop.  JSON output
+        makes qstat ask for the whole reply rather than a streamed one.
+        """
+        self.qsub_latency_under_qstat_load('-f -F json', 'qstat_load')
+
+    @timeout(1800)
+    def test_qsub_latency_under_streamed_qstat_load(self):
+        """
+        Measure qsub latency while several clients keep running qstat -f
+        of 5000 jobs, the status being streamed one job per reply part,
+        each batch of parts also sent by the server's reply threads
+        """
+        self.qsub_latency_under_qstat_load('-f', 'streamed_qstat_load')